@@ -264,6 +264,25 @@ void MEM_use_lockfree_allocator(void);
  */
 void MEM_use_guarded_allocator(void);
 
+/**
+ * Sample allocations to estimate how much memory is used per allocation name, with a low overhead.
+ * On average one allocation is sampled every \a interval allocated bytes, zero disables sampling.
+ *
+ * Only allocations of the lock-free allocator made after sampling was enabled are taken into
+ * account, aligned allocations are never sampled. The guarded allocator tracks all blocks already,
+ * see #MEM_printmemlist.
+ */
+void MEM_allocation_sampling_set(size_t interval);
+bool MEM_allocation_sampling_is_enabled(void);
+
+/**
+ * Write the estimated live bytes, peak and total allocations per allocation name as a tab
+ * separated table, sorted by live bytes. Writes to the standard output when \a filepath is null.
+ *
+ * \return false when the file could not be opened.
+ */
+bool MEM_allocation_sampling_write(const char *filepath);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
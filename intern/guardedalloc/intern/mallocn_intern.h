@@ -86,6 +86,11 @@ size_t malloc_usable_size(void *ptr);
 
 /* END copied from BLI_asan.h */
 
+/* The small block allocator hides out of bounds access from memory checking tools. */
+#if defined(WITH_MEM_SMALL_ALLOC) && (defined(WITH_ASAN) || defined(WITH_MEM_VALGRIND))
+#  undef WITH_MEM_SMALL_ALLOC
+#endif
+
 #define IS_POW2(a) (((a) & ((a)-1)) == 0)
 
 /* Extra padding which needs to be applied on MemHead to make it aligned. */
@@ -117,6 +122,30 @@ size_t memory_usage_current(void);
 size_t memory_usage_peak(void);
 void memory_usage_peak_reset(void);
 
+#ifdef WITH_MEM_SMALL_ALLOC
+/** Largest block size (including the #MemHead) handled by #mem_small_alloc. */
+#  define MEM_SMALL_ALLOC_MAX_SIZE 1024
+
+/**
+ * Allocate a block of at least \a size bytes from the thread caching small block allocator.
+ * Returns null when the allocation failed, the caller should fall back to #malloc then.
+ */
+void *mem_small_alloc(size_t size);
+/** Free a block allocated with #mem_small_alloc, this may be called from any thread. */
+void mem_small_free(void *ptr);
+/** Memory reserved by the small block allocator, including unused blocks. */
+size_t mem_small_alloc_reserved(void);
+size_t mem_small_alloc_heaps_num(void);
+#endif
+
+/**
+ * Decide whether an allocation of \a len bytes is sampled. When it is, \a r_weight is set to the
+ * number of bytes the sample stands for, which has to be passed to the functions below.
+ */
+bool memory_sampling_sample(size_t len, size_t *r_weight);
+void memory_sampling_block_alloc(const char *name, size_t len, size_t weight);
+void memory_sampling_block_free(const char *name, size_t len, size_t weight);
+
 /**
  * Clear the listbase of allocated memory blocks.
  *
@@ -230,6 +259,15 @@ void MEM_guarded_name_ptr_set(void *vmemh, const char *str);
 
 #ifdef __cplusplus
 }
+
+#  include <atomic>
+
+/**
+ * True when allocations of the lock-free allocator are sampled, see #memory_sampling_sample.
+ * Checked for every allocation, so it's read with relaxed ordering. Allocations that happen
+ * just after sampling has been enabled or disabled on another thread may or may not be sampled.
+ */
+extern std::atomic<bool> memory_sampling_enabled;
 #endif
 
 #endif /* __MALLOCN_INTERN_H__ */
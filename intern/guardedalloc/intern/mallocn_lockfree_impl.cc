@@ -9,6 +9,7 @@
  */
 
 #include <stdarg.h>
+#include <stddef.h> /* offsetof */
 #include <stdio.h> /* printf */
 #include <stdlib.h>
 #include <string.h> /* memcpy */
@@ -42,19 +43,89 @@ typedef struct MemHeadAligned {
 static_assert(MEM_MIN_CPP_ALIGNMENT <= alignof(MemHeadAligned), "Bad alignment of MemHeadAligned");
 static_assert(MEM_MIN_CPP_ALIGNMENT <= sizeof(MemHeadAligned), "Bad size of MemHeadAligned");
 
+/** Header in front of the #MemHead of blocks picked by allocation sampling. */
+typedef struct MemHeadSampled {
+  const char *name;
+  size_t weight;
+  MemHead head;
+} MemHeadSampled;
+static_assert(MEM_MIN_CPP_ALIGNMENT <= sizeof(MemHeadSampled) - sizeof(MemHead),
+              "Bad size of MemHeadSampled");
+
 static bool malloc_debug_memset = false;
 
 static void (*error_callback)(const char *) = nullptr;
 
 enum {
   MEMHEAD_ALIGN_FLAG = 1,
+  /** Block allocated by #mem_small_alloc. */
+  MEMHEAD_SMALL_FLAG = 2,
 };
+/** Block picked by allocation sampling, stored in the highest bit to keep it out of the way. */
+#define MEMHEAD_SAMPLED_FLAG (~(~size_t(0) >> 1))
 
 #define MEMHEAD_FROM_PTR(ptr) (((MemHead *)ptr) - 1)
 #define PTR_FROM_MEMHEAD(memhead) (memhead + 1)
 #define MEMHEAD_ALIGNED_FROM_PTR(ptr) (((MemHeadAligned *)ptr) - 1)
 #define MEMHEAD_IS_ALIGNED(memhead) ((memhead)->len & size_t(MEMHEAD_ALIGN_FLAG))
-#define MEMHEAD_LEN(memhead) ((memhead)->len & ~size_t(MEMHEAD_ALIGN_FLAG))
+#define MEMHEAD_IS_SMALL(memhead) ((memhead)->len & size_t(MEMHEAD_SMALL_FLAG))
+#define MEMHEAD_IS_SAMPLED(memhead) ((memhead)->len & MEMHEAD_SAMPLED_FLAG)
+#define MEMHEAD_SAMPLED_FROM_PTR(ptr) \
+  ((MemHeadSampled *)((char *)MEMHEAD_FROM_PTR(ptr) - offsetof(MemHeadSampled, head)))
+#define MEMHEAD_LEN(memhead) \
+  ((memhead)->len & ~(size_t(MEMHEAD_ALIGN_FLAG | MEMHEAD_SMALL_FLAG) | MEMHEAD_SAMPLED_FLAG))
+
+/**
+ * Allocate a block that is tracked by allocation sampling, with a #MemHeadSampled in front.
+ */
+static MemHead *memhead_alloc_sampled(const size_t len,
+                                      const bool clear,
+                                      const char *str,
+                                      const size_t weight)
+{
+  const size_t size = len + sizeof(MemHeadSampled);
+  MemHeadSampled *memh_sampled = static_cast<MemHeadSampled *>(clear ? calloc(1, size) :
+                                                                       malloc(size));
+  if (UNLIKELY(memh_sampled == nullptr)) {
+    return nullptr;
+  }
+  memh_sampled->name = str;
+  memh_sampled->weight = weight;
+  memory_sampling_block_alloc(str, len, weight);
+  return &memh_sampled->head;
+}
+
+/**
+ * Allocate memory for a block of \a len bytes and its #MemHead, using the small block allocator
+ * when possible. \a r_flag is set to the flag that has to be stored in the #MemHead.
+ */
+static MemHead *memhead_alloc(const size_t len,
+                              const bool clear,
+                              const char *str,
+                              size_t *r_flag)
+{
+  if (UNLIKELY(memory_sampling_enabled.load(std::memory_order_relaxed))) {
+    size_t weight;
+    if (memory_sampling_sample(len, &weight)) {
+      *r_flag = MEMHEAD_SAMPLED_FLAG;
+      return memhead_alloc_sampled(len, clear, str, weight);
+    }
+  }
+  const size_t size = len + sizeof(MemHead);
+#ifdef WITH_MEM_SMALL_ALLOC
+  if (size <= MEM_SMALL_ALLOC_MAX_SIZE) {
+    if (void *block = mem_small_alloc(size)) {
+      if (clear) {
+        memset(block, 0, size);
+      }
+      *r_flag = size_t(MEMHEAD_SMALL_FLAG);
+      return static_cast<MemHead *>(block);
+    }
+  }
+#endif
+  *r_flag = 0;
+  return static_cast<MemHead *>(clear ? calloc(1, size) : malloc(size));
+}
 
 #ifdef __GNUC__
 __attribute__((format(printf, 1, 2)))
@@ -110,6 +181,16 @@ void MEM_lockfree_freeN(void *vmemh)
     MemHeadAligned *memh_aligned = MEMHEAD_ALIGNED_FROM_PTR(vmemh);
     aligned_free(MEMHEAD_REAL_PTR(memh_aligned));
   }
+#ifdef WITH_MEM_SMALL_ALLOC
+  else if (MEMHEAD_IS_SMALL(memh)) {
+    mem_small_free(memh);
+  }
+#endif
+  else if (UNLIKELY(MEMHEAD_IS_SAMPLED(memh))) {
+    MemHeadSampled *memh_sampled = MEMHEAD_SAMPLED_FROM_PTR(vmemh);
+    memory_sampling_block_free(memh_sampled->name, len, memh_sampled->weight);
+    free(memh_sampled);
+  }
   else {
     free(memh);
   }
@@ -217,10 +298,11 @@ void *MEM_lockfree_callocN(size_t len, const char *str)
 
   len = SIZET_ALIGN_4(len);
 
-  memh = (MemHead *)calloc(1, len + sizeof(MemHead));
+  size_t flag;
+  memh = memhead_alloc(len, true, str, &flag);
 
   if (LIKELY(memh)) {
-    memh->len = len;
+    memh->len = len | flag;
     memory_usage_block_alloc(len);
 
     return PTR_FROM_MEMHEAD(memh);
@@ -259,7 +341,8 @@ void *MEM_lockfree_mallocN(size_t len, const char *str)
 #endif
   len = SIZET_ALIGN_4(len);
 
-  memh = (MemHead *)malloc(len + sizeof(MemHead));
+  size_t flag;
+  memh = memhead_alloc(len, false, str, &flag);
 
   if (LIKELY(memh)) {
 
@@ -277,7 +360,7 @@ void *MEM_lockfree_mallocN(size_t len, const char *str)
 #endif /* WITH_MEM_VALGRIND */
     }
 
-    memh->len = len;
+    memh->len = len | flag;
     memory_usage_block_alloc(len);
 
     return PTR_FROM_MEMHEAD(memh);
@@ -417,6 +500,11 @@ void MEM_lockfree_printmemlist_stats()
 {
   printf("\ntotal memory len: %.3f MB\n", double(memory_usage_current()) / double(1024 * 1024));
   printf("peak memory len: %.3f MB\n", double(memory_usage_peak()) / double(1024 * 1024));
+#ifdef WITH_MEM_SMALL_ALLOC
+  printf("small blocks reserved: %.3f MB in %u thread caches\n",
+         double(mem_small_alloc_reserved()) / double(1024 * 1024),
+         uint(mem_small_alloc_heaps_num()));
+#endif
   printf(
       "\nFor more detailed per-block statistics run Blender with memory debugging command line "
       "argument.\n");
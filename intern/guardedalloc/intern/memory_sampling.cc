@@ -0,0 +1,238 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup intern_mem
+ *
+ * Sampling of allocations of the lock-free allocator, to find out which allocation names hold
+ * most memory without the cost of tracking every block.
+ *
+ * Allocated bytes are sampled like a Poisson process: the distances between sampled bytes are
+ * exponentially distributed with the interval as mean, so that allocation patterns that repeat
+ * with a fixed size don't skew the result. An allocation is sampled when it contains a sampled
+ * byte, which happens with the probability `1 - exp(-len / interval)`. Every sample is weighted
+ * with its size divided by that probability, which gives an unbiased estimate of the live and
+ * total bytes per allocation name. Blocks much larger than the interval are nearly always sampled
+ * and counted with about their actual size.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "MEM_guardedalloc.h"
+#include "mallocn_intern.h"
+
+#include "../../source/blender/blenlib/BLI_strict_flags.h"
+
+std::atomic<bool> memory_sampling_enabled = false;
+
+namespace {
+
+struct NameStats {
+  /** Estimated bytes and blocks that are currently allocated. */
+  size_t live_bytes = 0;
+  size_t live_blocks = 0;
+  /** Highest estimate of the live bytes. */
+  size_t peak_bytes = 0;
+  /** Estimated bytes and blocks allocated since sampling was enabled. */
+  size_t total_bytes = 0;
+  size_t total_blocks = 0;
+};
+
+/**
+ * Global state. It's never destructed, because sampled blocks may be freed after static variables
+ * have been destructed. Containers here may use `new`, which is implemented with the allocator
+ * itself when building with `WITH_CXX_GUARDEDALLOC`, see #thread_in_sampling.
+ */
+struct Global {
+  std::mutex mutex;
+  /** Statistics by allocation name. Names are static strings, so the pointer is the key. */
+  std::unordered_map<const char *, NameStats> stats_by_name;
+  /** Read without locking the mutex when sampling. */
+  std::atomic<size_t> interval = 0;
+};
+
+Global &get_global()
+{
+  alignas(Global) static char global_buffer[sizeof(Global)];
+  static Global *global = new (global_buffer) Global();
+  return *global;
+}
+
+/** Bytes to allocate on this thread before the next sample is taken. */
+thread_local size_t thread_bytes_until_sample = 0;
+thread_local uint32_t thread_random_state = 0;
+/** Avoids sampling allocations made while updating the statistics. */
+thread_local bool thread_in_sampling = false;
+
+size_t next_sample_distance(const size_t interval)
+{
+  uint32_t &state = thread_random_state;
+  if (state == 0) {
+    /* Use the address of the thread local variable as seed, it differs between threads. */
+    state = uint32_t(uintptr_t(&state) >> 4) | 1u;
+  }
+  /* Xorshift, good enough to spread the samples. The state is never zero. */
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  /* Exponentially distributed distance with the interval as mean, using a uniform value in
+   * (0, 1). */
+  const double uniform = double(state) / 4294967296.0;
+  return size_t(-std::log(uniform) * double(interval)) + 1;
+}
+
+/** Number of bytes a sample of a block with the given size stands for. */
+size_t sample_weight(const size_t len, const size_t interval)
+{
+  /* Empty blocks are never sampled, avoid dividing by zero anyway. */
+  const double size = double(std::max<size_t>(len, 1));
+  /* Probability that the block contains a sampled byte, `1 - exp(-size / interval)`. */
+  const double probability = -std::expm1(-size / double(interval));
+  return size_t(std::llround(size / probability));
+}
+
+/** Number of blocks a sample of a block with the given size stands for. */
+size_t sample_blocks(const size_t len, const size_t weight)
+{
+  return std::max<size_t>(weight / std::max<size_t>(len, 1), 1);
+}
+
+}  // namespace
+
+bool memory_sampling_sample(const size_t len, size_t *r_weight)
+{
+  if (thread_in_sampling) {
+    return false;
+  }
+  if (thread_bytes_until_sample > len) {
+    thread_bytes_until_sample -= len;
+    return false;
+  }
+  const size_t interval = get_global().interval.load(std::memory_order_relaxed);
+  if (interval == 0) {
+    return false;
+  }
+  if (thread_random_state == 0) {
+    /* Choose the first sample position of this thread, to avoid always sampling its first
+     * allocation. */
+    thread_bytes_until_sample = next_sample_distance(interval);
+    if (thread_bytes_until_sample > len) {
+      thread_bytes_until_sample -= len;
+      return false;
+    }
+  }
+  thread_bytes_until_sample = next_sample_distance(interval);
+  *r_weight = sample_weight(len, interval);
+  return true;
+}
+
+void memory_sampling_block_alloc(const char *name, const size_t len, const size_t weight)
+{
+  Global &global = get_global();
+  thread_in_sampling = true;
+  {
+    std::lock_guard lock{global.mutex};
+    NameStats &stats = global.stats_by_name[name];
+    stats.live_bytes += weight;
+    stats.live_blocks += sample_blocks(len, weight);
+    stats.peak_bytes = std::max(stats.peak_bytes, stats.live_bytes);
+    stats.total_bytes += weight;
+    stats.total_blocks += sample_blocks(len, weight);
+  }
+  thread_in_sampling = false;
+}
+
+void memory_sampling_block_free(const char *name, const size_t len, const size_t weight)
+{
+  Global &global = get_global();
+  std::lock_guard lock{global.mutex};
+  /* Names are never removed from the map, look up without inserting to avoid allocating. */
+  const auto it = global.stats_by_name.find(name);
+  assert(it != global.stats_by_name.end());
+  NameStats &stats = it->second;
+  stats.live_bytes -= weight;
+  stats.live_blocks -= sample_blocks(len, weight);
+}
+
+void MEM_allocation_sampling_set(const size_t interval)
+{
+  Global &global = get_global();
+  global.interval = interval;
+  memory_sampling_enabled.store(interval != 0, std::memory_order_relaxed);
+}
+
+bool MEM_allocation_sampling_is_enabled()
+{
+  return get_global().interval != 0;
+}
+
+bool MEM_allocation_sampling_write(const char *filepath)
+{
+  Global &global = get_global();
+
+  /* Copy the statistics, merging names that are equal but stored in different places. */
+  thread_in_sampling = true;
+  std::unordered_map<std::string, NameStats> stats_by_name;
+  size_t interval;
+  {
+    std::lock_guard lock{global.mutex};
+    interval = global.interval;
+    for (const auto &item : global.stats_by_name) {
+      NameStats &stats = stats_by_name[item.first ? item.first : "<unnamed>"];
+      stats.live_bytes += item.second.live_bytes;
+      stats.live_blocks += item.second.live_blocks;
+      stats.peak_bytes += item.second.peak_bytes;
+      stats.total_bytes += item.second.total_bytes;
+      stats.total_blocks += item.second.total_blocks;
+    }
+  }
+  std::vector<std::pair<std::string, NameStats>> sorted_stats(stats_by_name.begin(),
+                                                              stats_by_name.end());
+  std::sort(sorted_stats.begin(), sorted_stats.end(), [](const auto &a, const auto &b) {
+    if (a.second.live_bytes != b.second.live_bytes) {
+      return a.second.live_bytes > b.second.live_bytes;
+    }
+    return a.second.peak_bytes > b.second.peak_bytes;
+  });
+  thread_in_sampling = false;
+
+  FILE *file = filepath ? fopen(filepath, "w") : stdout;
+  if (file == nullptr) {
+    return false;
+  }
+  fprintf(file,
+          "# Memory allocation sampling, interval " SIZET_FORMAT " bytes.\n",
+          SIZET_ARG(interval));
+  fprintf(file, "# Values are estimates, the peak is taken per name.\n");
+  fprintf(file, "live_bytes\tlive_blocks\tpeak_bytes\ttotal_bytes\ttotal_blocks\tname\n");
+  for (const auto &item : sorted_stats) {
+    const NameStats &stats = item.second;
+    fprintf(file,
+            SIZET_FORMAT "\t" SIZET_FORMAT "\t" SIZET_FORMAT "\t" SIZET_FORMAT "\t" SIZET_FORMAT
+                         "\t%s\n",
+            SIZET_ARG(stats.live_bytes),
+            SIZET_ARG(stats.live_blocks),
+            SIZET_ARG(stats.peak_bytes),
+            SIZET_ARG(stats.total_bytes),
+            SIZET_ARG(stats.total_blocks),
+            item.first.c_str());
+  }
+  if (filepath) {
+    fclose(file);
+  }
+  else {
+    fflush(file);
+  }
+  return true;
+}
@@ -0,0 +1,385 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup intern_mem
+ *
+ * Thread caching allocator for small memory blocks, used by the lock-free allocator.
+ *
+ * Blocks are grouped in size classes. Every thread owns a #Heap, which takes the blocks of each
+ * size class from aligned chunks that store the heap they belong to in their header. Allocating
+ * and freeing on the same thread does not need any synchronization. Blocks freed by another
+ * thread are pushed on an atomic list of the owning heap. The owner processes that list when it
+ * has to take a block from a new or unused part of a chunk, and at least every
+ * #remote_collect_interval allocations and frees, so that memory freed by other threads is reused
+ * while the owner keeps running. Chunks are given back to the system once all their blocks are
+ * freed, except for the last one of a size class.
+ *
+ * Heaps are never destructed. When a thread exits its heap is put in a list of idle heaps which is
+ * reused by the next new thread, so that blocks that outlive their thread are still valid. Blocks
+ * of idle heaps are freed directly while holding the global mutex.
+ */
+
+/* Included first, because it disables the small block allocator for some builds. */
+#include "MEM_guardedalloc.h"
+#include "mallocn_intern.h"
+
+#ifdef WITH_MEM_SMALL_ALLOC
+
+#  include <array>
+#  include <atomic>
+#  include <cassert>
+#  include <cstdint>
+#  include <mutex>
+#  include <new>
+
+#  include "../../source/blender/blenlib/BLI_strict_flags.h"
+
+namespace {
+
+/** Size of the memory chunks blocks are taken from, chunks are aligned to their size. */
+constexpr size_t chunk_size = 64 * 1024;
+/** Size of the #Chunk header, a full cache line to keep the first block aligned. */
+constexpr size_t chunk_header_size = 64;
+/** Number of allocations and frees on the owning thread after which remote blocks are freed. */
+constexpr uint32_t remote_collect_interval = 1024;
+
+/**
+ * Block sizes, including the #MemHead. Classes are 16 bytes apart for the most common small
+ * sizes and get coarser for larger sizes to limit the number of partially used chunks.
+ */
+constexpr std::array<uint16_t, 20> size_classes = {
+    16, 32, 48, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384, 448, 512, 640, 768, 896, 1024};
+constexpr size_t size_classes_num = size_classes.size();
+
+static_assert(size_classes.back() == MEM_SMALL_ALLOC_MAX_SIZE);
+
+/** Lookup table from the size in multiples of 16 bytes (rounded up) to the size class. */
+constexpr std::array<uint8_t, MEM_SMALL_ALLOC_MAX_SIZE / 16 + 1> size_class_table = []() {
+  std::array<uint8_t, MEM_SMALL_ALLOC_MAX_SIZE / 16 + 1> table{};
+  size_t size_class = 0;
+  for (size_t i = 0; i < table.size(); i++) {
+    while (size_classes[size_class] < i * 16) {
+      size_class++;
+    }
+    table[i] = uint8_t(size_class);
+  }
+  return table;
+}();
+
+struct FreeBlock {
+  FreeBlock *next;
+};
+
+struct Heap;
+
+struct Chunk {
+  Heap *heap;
+  uint32_t size_class;
+  /** Number of allocated blocks. */
+  uint32_t used_num;
+  /** Freed blocks of this chunk, only accessed by the thread owning the heap. */
+  FreeBlock *free_blocks;
+  /** Start of the memory at the end of the chunk that was never used for a block. */
+  char *unused_begin;
+  /** Neighbors in the list of chunks with available blocks of the heap. */
+  Chunk *prev;
+  Chunk *next;
+  bool is_available;
+};
+static_assert(sizeof(Chunk) <= chunk_header_size);
+
+/**
+ * Per thread cache. Align to cache line size to avoid false sharing of the remote free list.
+ */
+struct alignas(128) Heap {
+  /** Chunks with available blocks for every size class, only accessed by the owning thread. */
+  std::array<Chunk *, size_classes_num> available_chunks{};
+  /** Countdown to the next collection of the remote blocks, only accessed by the owning thread. */
+  uint32_t ops_until_collect = remote_collect_interval;
+  /** Blocks freed by other threads, of any size class. */
+  std::atomic<FreeBlock *> remote_free_blocks = nullptr;
+  /**
+   * True when the thread owning the heap has exited. The heap can then be accessed by any thread
+   * while the global mutex is locked.
+   */
+  std::atomic<bool> is_idle = false;
+  /** Next heap in the list of idle heaps. */
+  Heap *next_idle = nullptr;
+};
+
+/**
+ * Global state. It's never destructed, because blocks may be freed by threads that exit after
+ * static variables have been destructed. Nothing here uses `new`, which may be implemented with
+ * the allocator itself when building with `WITH_CXX_GUARDEDALLOC`.
+ */
+struct Global {
+  std::mutex mutex;
+  /** Heaps of threads that have exited, ready to be reused. */
+  Heap *idle_heaps = nullptr;
+  std::atomic<size_t> chunks_num = 0;
+  std::atomic<size_t> heaps_num = 0;
+};
+
+Global &get_global()
+{
+  alignas(Global) static char global_buffer[sizeof(Global)];
+  static Global *global = new (global_buffer) Global();
+  return *global;
+}
+
+/** The heap of this thread. Trivially destructible, so it can be accessed during thread exit. */
+thread_local Heap *thread_heap = nullptr;
+/** Set once the heap of this thread has been released, no new heap is taken after that. */
+thread_local bool thread_heap_released = false;
+
+Chunk *chunk_from_block(const void *block)
+{
+  return reinterpret_cast<Chunk *>(uintptr_t(block) & ~uintptr_t(chunk_size - 1));
+}
+
+void heap_add_available_chunk(Heap &heap, Chunk *chunk)
+{
+  Chunk *&first = heap.available_chunks[chunk->size_class];
+  chunk->prev = nullptr;
+  chunk->next = first;
+  if (first != nullptr) {
+    first->prev = chunk;
+  }
+  first = chunk;
+  chunk->is_available = true;
+}
+
+void heap_remove_available_chunk(Heap &heap, Chunk *chunk)
+{
+  if (chunk->prev != nullptr) {
+    chunk->prev->next = chunk->next;
+  }
+  else {
+    heap.available_chunks[chunk->size_class] = chunk->next;
+  }
+  if (chunk->next != nullptr) {
+    chunk->next->prev = chunk->prev;
+  }
+  chunk->is_available = false;
+}
+
+Chunk *heap_new_chunk(Heap &heap, const size_t size_class)
+{
+  Chunk *chunk = static_cast<Chunk *>(aligned_malloc(chunk_size, chunk_size));
+  if (UNLIKELY(chunk == nullptr)) {
+    return nullptr;
+  }
+  chunk->heap = &heap;
+  chunk->size_class = uint32_t(size_class);
+  chunk->used_num = 0;
+  chunk->free_blocks = nullptr;
+  chunk->unused_begin = reinterpret_cast<char *>(chunk) + chunk_header_size;
+  heap_add_available_chunk(heap, chunk);
+  get_global().chunks_num.fetch_add(1, std::memory_order_relaxed);
+  return chunk;
+}
+
+/** Free a block on the thread owning its heap. */
+void heap_free_block(Heap &heap, FreeBlock *block)
+{
+  Chunk *chunk = chunk_from_block(block);
+  block->next = chunk->free_blocks;
+  chunk->free_blocks = block;
+  chunk->used_num--;
+
+  if (chunk->used_num == 0) {
+    /* Keep the last chunk of a size class, to avoid allocating a new chunk every time when a
+     * single block is allocated and freed repeatedly. */
+    const bool is_last = chunk->is_available && chunk->prev == nullptr && chunk->next == nullptr;
+    if (!is_last) {
+      if (chunk->is_available) {
+        heap_remove_available_chunk(heap, chunk);
+      }
+      aligned_free(chunk);
+      get_global().chunks_num.fetch_sub(1, std::memory_order_relaxed);
+      return;
+    }
+  }
+  if (!chunk->is_available) {
+    heap_add_available_chunk(heap, chunk);
+  }
+}
+
+/** Free the blocks that were freed by other threads. */
+bool heap_collect_remote_free_blocks(Heap &heap)
+{
+  /* Check first without writing, to not take the cache line from threads pushing blocks. */
+  if (heap.remote_free_blocks.load(std::memory_order_relaxed) == nullptr) {
+    return false;
+  }
+  FreeBlock *block = heap.remote_free_blocks.exchange(nullptr, std::memory_order_acquire);
+  if (block == nullptr) {
+    return false;
+  }
+  while (block != nullptr) {
+    FreeBlock *next = block->next;
+    heap_free_block(heap, block);
+    block = next;
+  }
+  return true;
+}
+
+/** Collect the remote blocks every #remote_collect_interval operations of the owning thread. */
+void heap_tick(Heap &heap)
+{
+  if (UNLIKELY(--heap.ops_until_collect == 0)) {
+    heap.ops_until_collect = remote_collect_interval;
+    heap_collect_remote_free_blocks(heap);
+  }
+}
+
+/**
+ * Gives the heap of the thread back to the global list when the thread exits.
+ */
+struct HeapReleaser {
+  ~HeapReleaser()
+  {
+    if (thread_heap != nullptr) {
+      Global &global = get_global();
+      std::lock_guard lock{global.mutex};
+      /* Mark the heap as idle before collecting the remote blocks, see #mem_small_free. */
+      thread_heap->is_idle = true;
+      heap_collect_remote_free_blocks(*thread_heap);
+      thread_heap->next_idle = global.idle_heaps;
+      global.idle_heaps = thread_heap;
+      thread_heap = nullptr;
+    }
+    thread_heap_released = true;
+  }
+};
+thread_local HeapReleaser heap_releaser;
+
+Heap *get_thread_heap()
+{
+  if (LIKELY(thread_heap != nullptr)) {
+    return thread_heap;
+  }
+  if (thread_heap_released) {
+    return nullptr;
+  }
+  /* Using the releaser makes sure it is constructed, so that its destructor runs on exit. */
+  (void)&heap_releaser;
+
+  Global &global = get_global();
+  {
+    std::lock_guard lock{global.mutex};
+    if (global.idle_heaps != nullptr) {
+      thread_heap = global.idle_heaps;
+      global.idle_heaps = thread_heap->next_idle;
+      thread_heap->is_idle = false;
+      return thread_heap;
+    }
+  }
+  void *heap_memory = aligned_malloc(sizeof(Heap), alignof(Heap));
+  if (UNLIKELY(heap_memory == nullptr)) {
+    return nullptr;
+  }
+  thread_heap = new (heap_memory) Heap();
+  global.heaps_num.fetch_add(1, std::memory_order_relaxed);
+  return thread_heap;
+}
+
+}  // namespace
+
+void *mem_small_alloc(const size_t size)
+{
+  assert(size <= MEM_SMALL_ALLOC_MAX_SIZE);
+  Heap *heap = get_thread_heap();
+  if (UNLIKELY(heap == nullptr)) {
+    return nullptr;
+  }
+  const size_t size_class = size_class_table[(size + 15) / 16];
+  const size_t block_size = size_classes[size_class];
+
+  /* Collecting may free chunks, so do it before a chunk is chosen. */
+  heap_tick(*heap);
+  Chunk *chunk = heap->available_chunks[size_class];
+  if (chunk == nullptr || chunk->free_blocks == nullptr) {
+    /* Reuse blocks freed by other threads before taking unused memory or a new chunk. */
+    if (heap_collect_remote_free_blocks(*heap)) {
+      chunk = heap->available_chunks[size_class];
+    }
+  }
+  if (chunk == nullptr) {
+    chunk = heap_new_chunk(*heap, size_class);
+    if (UNLIKELY(chunk == nullptr)) {
+      return nullptr;
+    }
+  }
+
+  void *block;
+  if (chunk->free_blocks != nullptr) {
+    block = chunk->free_blocks;
+    chunk->free_blocks = chunk->free_blocks->next;
+  }
+  else {
+    block = chunk->unused_begin;
+    chunk->unused_begin += block_size;
+  }
+  chunk->used_num++;
+
+  const char *chunk_end = reinterpret_cast<const char *>(chunk) + chunk_size;
+  if (chunk->free_blocks == nullptr && chunk_end - chunk->unused_begin < ptrdiff_t(block_size)) {
+    /* The chunk is full. */
+    heap_remove_available_chunk(*heap, chunk);
+  }
+  return block;
+}
+
+void mem_small_free(void *ptr)
+{
+  FreeBlock *block = static_cast<FreeBlock *>(ptr);
+  Heap &heap = *chunk_from_block(block)->heap;
+
+  if (&heap == thread_heap) {
+    heap_free_block(heap, block);
+    heap_tick(heap);
+    return;
+  }
+
+  if (UNLIKELY(heap.is_idle.load(std::memory_order_relaxed))) {
+    Global &global = get_global();
+    std::lock_guard lock{global.mutex};
+    if (heap.is_idle) {
+      heap_free_block(heap, block);
+      return;
+    }
+  }
+
+  /* The block belongs to another thread. Only the owner removes blocks from this list and it
+   * always takes the whole list at once, so there is no ABA problem. */
+  FreeBlock *head = heap.remote_free_blocks.load(std::memory_order_relaxed);
+  do {
+    block->next = head;
+  } while (!heap.remote_free_blocks.compare_exchange_weak(head, block));
+
+  /* The owning thread may have exited after the check above and collected its remote blocks
+   * before the block was added, collect them here in that case so they are not kept until the
+   * heap is reused. */
+  if (UNLIKELY(heap.is_idle)) {
+    Global &global = get_global();
+    std::lock_guard lock{global.mutex};
+    if (heap.is_idle) {
+      heap_collect_remote_free_blocks(heap);
+    }
+  }
+}
+
+size_t mem_small_alloc_reserved()
+{
+  return get_global().chunks_num.load(std::memory_order_relaxed) * chunk_size;
+}
+
+size_t mem_small_alloc_heaps_num()
+{
+  return get_global().heaps_num.load(std::memory_order_relaxed);
+}
+
+#endif /* WITH_MEM_SMALL_ALLOC */
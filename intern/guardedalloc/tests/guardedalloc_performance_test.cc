@@ -0,0 +1,92 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0 */
+
+#include "testing/testing.h"
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_timeit.hh"
+
+#include "guardedalloc_test_base.h"
+
+/* Allocation micro-benchmarks for the lock-free allocator. Compare builds with and without
+ * `WITH_MEM_SMALL_ALLOC` to measure the thread caching small block allocator. */
+
+namespace {
+
+constexpr int blocks_num = 1000000;
+
+void alloc_free_same_thread(const size_t len)
+{
+  std::vector<void *> blocks(blocks_num);
+  for (void *&mem : blocks) {
+    mem = MEM_mallocN(len, __func__);
+  }
+  for (void *mem : blocks) {
+    MEM_freeN(mem);
+  }
+}
+
+void alloc_free_many_threads(const size_t len, const int threads_num)
+{
+  std::vector<std::thread> threads;
+  for (int i = 0; i < threads_num; i++) {
+    threads.emplace_back([len]() { alloc_free_same_thread(len); });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+}
+
+/** One thread allocates, the other frees, like a producer and consumer of small objects. */
+void alloc_free_cross_thread(const size_t len)
+{
+  std::vector<void *> blocks(blocks_num);
+  /* Both threads run at the same time, so blocks are freed while the producer is allocating. */
+  std::atomic<int> produced_num = 0;
+  std::thread producer([&]() {
+    for (int i = 0; i < blocks_num; i++) {
+      blocks[i] = MEM_mallocN(len, __func__);
+      produced_num.store(i + 1, std::memory_order_release);
+    }
+  });
+  std::thread consumer([&]() {
+    for (int i = 0; i < blocks_num; i++) {
+      while (produced_num.load(std::memory_order_acquire) <= i) {
+        std::this_thread::yield();
+      }
+      MEM_freeN(blocks[i]);
+    }
+  });
+  producer.join();
+  consumer.join();
+}
+
+}  // namespace
+
+TEST_F(LockFreeAllocatorTest, AllocPerformance)
+{
+  const int threads_num = int(std::max(2u, std::thread::hardware_concurrency()));
+  for (const size_t len : {8, 32, 100, 500}) {
+    printf("\n%d blocks of %d bytes\n", blocks_num, int(len));
+    {
+      SCOPED_TIMER("same thread");
+      alloc_free_same_thread(len);
+    }
+    {
+      SCOPED_TIMER("same thread, " + std::to_string(threads_num) + " threads");
+      alloc_free_many_threads(len, threads_num);
+    }
+    {
+      SCOPED_TIMER("free on other thread");
+      alloc_free_cross_thread(len);
+    }
+  }
+}
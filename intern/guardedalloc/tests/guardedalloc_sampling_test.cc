@@ -0,0 +1,96 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0 */
+
+#include "testing/testing.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "MEM_guardedalloc.h"
+
+#include "guardedalloc_test_base.h"
+
+namespace {
+
+/** Read the snapshot line of the given allocation name, empty when it's not found. */
+std::string FindSnapshotLine(const char *filepath, const char *name)
+{
+  FILE *file = fopen(filepath, "r");
+  if (file == nullptr) {
+    return "";
+  }
+  const std::string suffix = std::string("\t") + name + "\n";
+  std::string result;
+  char line[1024];
+  while (fgets(line, sizeof(line), file)) {
+    const std::string line_str = line;
+    if (line_str.size() > suffix.size() &&
+        line_str.compare(line_str.size() - suffix.size(), suffix.size(), suffix) == 0)
+    {
+      result = line_str;
+      break;
+    }
+  }
+  fclose(file);
+  return result;
+}
+
+}  // namespace
+
+TEST_F(LockFreeAllocatorTest, AllocationSampling)
+{
+  const std::string filepath = ::testing::TempDir() + "guardedalloc_sampling_test.txt";
+
+  MEM_allocation_sampling_set(1024);
+  EXPECT_TRUE(MEM_allocation_sampling_is_enabled());
+
+  /* Large blocks are always sampled. */
+  void *large = MEM_mallocN(1024 * 1024, "sampling_test_large");
+  std::vector<void *> small;
+  for (int i = 0; i < 10000; i++) {
+    small.push_back(MEM_mallocN(60, "sampling_test_small"));
+  }
+
+  ASSERT_TRUE(MEM_allocation_sampling_write(filepath.c_str()));
+  size_t live_bytes = 0, live_blocks = 0, peak_bytes = 0;
+  EXPECT_EQ(sscanf(FindSnapshotLine(filepath.c_str(), "sampling_test_large").c_str(),
+                   "%zu\t%zu\t%zu",
+                   &live_bytes,
+                   &live_blocks,
+                   &peak_bytes),
+            3);
+  EXPECT_EQ(live_bytes, 1024 * 1024);
+  EXPECT_EQ(live_blocks, 1);
+
+  /* The estimate of the small blocks should be close to the real size. */
+  EXPECT_EQ(sscanf(FindSnapshotLine(filepath.c_str(), "sampling_test_small").c_str(),
+                   "%zu\t%zu\t%zu",
+                   &live_bytes,
+                   &live_blocks,
+                   &peak_bytes),
+            3);
+  EXPECT_GT(live_bytes, 10000 * 60 / 2);
+  EXPECT_LT(live_bytes, 10000 * 60 * 2);
+
+  /* Sampled blocks are still handled when sampling is disabled. */
+  MEM_allocation_sampling_set(0);
+  EXPECT_FALSE(MEM_allocation_sampling_is_enabled());
+  MEM_freeN(large);
+  for (void *mem : small) {
+    MEM_freeN(mem);
+  }
+
+  ASSERT_TRUE(MEM_allocation_sampling_write(filepath.c_str()));
+  EXPECT_EQ(sscanf(FindSnapshotLine(filepath.c_str(), "sampling_test_large").c_str(),
+                   "%zu\t%zu\t%zu",
+                   &live_bytes,
+                   &live_blocks,
+                   &peak_bytes),
+            3);
+  EXPECT_EQ(live_bytes, 0);
+  EXPECT_EQ(peak_bytes, 1024 * 1024);
+  remove(filepath.c_str());
+}
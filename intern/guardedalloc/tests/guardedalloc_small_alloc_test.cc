@@ -0,0 +1,158 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0 */
+
+#include "testing/testing.h"
+
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "MEM_guardedalloc.h"
+
+#include "../intern/mallocn_intern.h"
+
+#include "guardedalloc_test_base.h"
+
+/* These tests exercise the small block allocator when built with `WITH_MEM_SMALL_ALLOC`,
+ * they are valid for the plain lock-free allocator too. */
+
+namespace {
+
+/** Fill the block with a pattern depending on its size, to detect overlapping blocks. */
+void *AllocFilled(const size_t len)
+{
+  unsigned char *mem = (unsigned char *)MEM_mallocN(len, __func__);
+  memset(mem, int(len & 0xff), len);
+  return mem;
+}
+
+void CheckFilledAndFree(void *mem, const size_t len)
+{
+  EXPECT_EQ(MEM_allocN_len(mem), (len + 3) & ~size_t(3));
+  const unsigned char *data = (const unsigned char *)mem;
+  for (size_t i = 0; i < len; i++) {
+    EXPECT_EQ(data[i], (unsigned char)(len & 0xff));
+  }
+  MEM_freeN(mem);
+}
+
+}  // namespace
+
+TEST_F(LockFreeAllocatorTest, SmallAllocSizes)
+{
+  const size_t blocks_num = MEM_get_memory_blocks_in_use();
+  const size_t mem_in_use = MEM_get_memory_in_use();
+
+  std::vector<void *> blocks;
+  for (size_t len = 0; len < 2048; len++) {
+    blocks.push_back(AllocFilled(len));
+  }
+  EXPECT_EQ(MEM_get_memory_blocks_in_use(), blocks_num + blocks.size());
+  for (size_t len = 0; len < 2048; len++) {
+    CheckFilledAndFree(blocks[len], len);
+  }
+
+  EXPECT_EQ(MEM_get_memory_blocks_in_use(), blocks_num);
+  EXPECT_EQ(MEM_get_memory_in_use(), mem_in_use);
+}
+
+TEST_F(LockFreeAllocatorTest, SmallAllocCalloc)
+{
+  for (int iter = 0; iter < 4; iter++) {
+    std::vector<void *> blocks;
+    for (size_t len = 1; len < 600; len += 7) {
+      /* Dirty blocks first, so the calloc below reuses non-zero memory. */
+      blocks.push_back(AllocFilled(len));
+    }
+    for (void *mem : blocks) {
+      MEM_freeN(mem);
+    }
+    for (size_t len = 1; len < 600; len += 7) {
+      const unsigned char *mem = (const unsigned char *)MEM_callocN(len, __func__);
+      for (size_t i = 0; i < len; i++) {
+        EXPECT_EQ(mem[i], 0);
+      }
+      MEM_freeN((void *)mem);
+    }
+  }
+}
+
+TEST_F(LockFreeAllocatorTest, SmallAllocFreeOnOtherThread)
+{
+  const size_t blocks_num = MEM_get_memory_blocks_in_use();
+  constexpr int threads_num = 4;
+  constexpr int blocks_per_thread = 10000;
+
+  /* In the first round every thread allocates blocks. In the second round the threads reuse the
+   * idle heaps of the first round: they allocate new blocks while freeing the blocks of the
+   * previous round allocated by the next thread, whose heap may be idle or in use again. The
+   * blocks of the second round are freed after all threads exited. */
+  std::vector<void *> blocks[2][threads_num];
+  for (int round = 0; round < 2; round++) {
+    std::vector<std::thread> threads;
+    for (int thread_i = 0; thread_i < threads_num; thread_i++) {
+      threads.emplace_back([&, round, thread_i]() {
+        for (int i = 0; i < blocks_per_thread; i++) {
+          blocks[round][thread_i].push_back(AllocFilled(size_t(i % 300)));
+          if (round == 1) {
+            CheckFilledAndFree(blocks[0][(thread_i + 1) % threads_num][i], size_t(i % 300));
+          }
+        }
+      });
+    }
+    for (std::thread &thread : threads) {
+      thread.join();
+    }
+  }
+  for (int thread_i = 0; thread_i < threads_num; thread_i++) {
+    for (int i = 0; i < blocks_per_thread; i++) {
+      CheckFilledAndFree(blocks[1][thread_i][i], size_t(i % 300));
+    }
+  }
+
+  EXPECT_EQ(MEM_get_memory_blocks_in_use(), blocks_num);
+}
+
+TEST_F(LockFreeAllocatorTest, SmallAllocFreeOnOtherThreadWhileOwnerRuns)
+{
+  const size_t blocks_num = MEM_get_memory_blocks_in_use();
+  constexpr int shared_blocks_num = 50000;
+
+  /* The owner thread keeps allocating while another thread frees its blocks, so the blocks go
+   * through the remote free list of a heap that is in use and have to be collected by the owner
+   * without running out of blocks of that size class. */
+  std::vector<void *> shared_blocks;
+  std::atomic<bool> shared_blocks_freed = false;
+  std::thread owner([&]() {
+#ifdef WITH_MEM_SMALL_ALLOC
+    const size_t reserved_before = mem_small_alloc_reserved();
+#endif
+    for (int i = 0; i < shared_blocks_num; i++) {
+      shared_blocks.push_back(AllocFilled(100));
+    }
+    std::thread freeing_thread([&]() {
+      for (void *mem : shared_blocks) {
+        CheckFilledAndFree(mem, 100);
+      }
+      shared_blocks_freed = true;
+    });
+    /* Only use another size class, which keeps allocating from the same chunk. */
+    int iterations_after_free = 0;
+    while (iterations_after_free < 10000) {
+      if (shared_blocks_freed) {
+        iterations_after_free++;
+      }
+      CheckFilledAndFree(AllocFilled(20), 20);
+    }
+    freeing_thread.join();
+#ifdef WITH_MEM_SMALL_ALLOC
+    /* All chunks of the shared blocks are given back, except for the last one. */
+    EXPECT_LT(mem_small_alloc_reserved(), reserved_before + 256 * 1024);
+#endif
+  });
+  owner.join();
+
+  EXPECT_EQ(MEM_get_memory_blocks_in_use(), blocks_num);
+}
@@ -2760,6 +2760,9 @@ class USERPREF_PT_experimental_debugging(ExperimentalPanel, Panel):
                 ({"property": "use_asset_indexing"}, None),
                 ({"property": "use_viewport_debug"}, None),
                 ({"property": "use_eevee_debug"}, None),
+                ({"property": "use_blend_file_mmap_sharing"}, None),
+                ({"property": "use_lazy_linked_data"}, None),
+                ({"property": "use_incremental_autosave"}, None),
             ),
         )
 
@@ -4,6 +4,9 @@
 
 #pragma once
 
+#include <atomic>
+#include <mutex>
+
 #include "BLI_sub_frame.hh"
 
 #include "BKE_bake_items.hh"
@@ -14,6 +17,7 @@ struct NodesModifierData;
 struct Main;
 struct Object;
 struct Scene;
+struct TaskPool;
 
 namespace blender::bke::bake {
 
@@ -34,9 +38,23 @@ enum class CacheStatus {
  */
 struct FrameCache {
   SubFrame frame;
-  BakeState state;
+  /**
+   * The state is reference counted, because frames that are loaded lazily may be freed again
+   * while evaluations still use them. Null if the frame has not been loaded yet.
+   */
+  std::shared_ptr<const BakeState> state;
   /** Used when the baked data is loaded lazily. */
   std::optional<std::string> meta_path;
+  /**
+   * Protects #state while the baked data is loaded lazily, which may happen on a background thread
+   * when the frame is prefetched. Lazily loaded frames should only be accessed with
+   * #NodeBakeCache::ensure_frame_loaded.
+   */
+  std::mutex load_mutex;
+  /** Approximate memory used by #state when it has been loaded lazily. */
+  int64_t loaded_memory = 0;
+  /** True while a background task that loads this frame is queued or running. */
+  std::atomic<bool> prefetch_pending = false;
 };
 
 /**
@@ -62,9 +80,42 @@ struct NodeBakeCache {
   /** Used to avoid checking if a bake exists many times. */
   bool failed_finding_bake = false;
 
+  /**
+   * Protects the prefetch state below, because the same cache may be evaluated by multiple
+   * depsgraphs at the same time.
+   */
+  std::mutex prefetch_mutex;
+  /** Loads frames in the background before they are needed, see #prefetch_frames. */
+  TaskPool *prefetch_pool = nullptr;
+  /** Index of the frame that was last passed to #prefetch_frames. */
+  std::atomic<int> prefetch_frame_index = -1;
+  /** True if the frames were last requested in descending order. */
+  bool prefetch_backwards = false;
+  /** Frames outside of the prefetch range are freed when all loaded frames use more memory. */
+  int64_t prefetch_memory_budget = int64_t(4) * 1024 * 1024 * 1024;
+
+  NodeBakeCache() = default;
+  ~NodeBakeCache();
+
   /** Range spanning from the first to the last baked frame. */
   IndexRange frame_range() const;
 
+  /**
+   * Load the baked data of the frame from disk, unless it is loaded already. If the frame is
+   * currently being prefetched, this waits until the data is available.
+   * \return The state of the frame, which stays valid when the frame is freed in the meantime.
+   *   Null if loading failed.
+   */
+  std::shared_ptr<const BakeState> ensure_frame_loaded(FrameCache &frame_cache);
+
+  /**
+   * Start loading the frames around the given frame in the background, so that they are
+   * available when playback reaches them. Frames that are far away are freed again when the
+   * loaded frames use too much memory. Frames in the direct neighborhood of the given frame are
+   * never freed, so this must be called with the frame that is currently evaluated.
+   */
+  void prefetch_frames(int frame_index);
+
   void reset();
 };
 
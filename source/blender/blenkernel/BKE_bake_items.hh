@@ -38,9 +38,15 @@ struct BakeState {
 /** Same as above, but does not own the bake items. */
 struct BakeStateRef {
   Map<int, const BakeItem *> items_by_id;
+  /**
+   * Optional shared ownership of the referenced state. It keeps the items alive when the state is
+   * owned by a cache that may free it while it is still in use.
+   */
+  std::shared_ptr<const BakeState> owner;
 
   BakeStateRef() = default;
   BakeStateRef(const BakeState &bake_state);
+  BakeStateRef(std::shared_ptr<const BakeState> bake_state);
 };
 
 class GeometryBakeItem : public BakeItem {
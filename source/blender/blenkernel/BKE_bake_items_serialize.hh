@@ -4,8 +4,10 @@
 
 #pragma once
 
+#include "BLI_array.hh"
 #include "BLI_fileops.hh"
 #include "BLI_function_ref.hh"
+#include "BLI_implicit_sharing_ptr.hh"
 #include "BLI_serialize.hh"
 
 #include "BKE_bake_items.hh"
@@ -24,6 +26,19 @@ struct BlobSlice {
   static std::optional<BlobSlice> deserialize(const io::serialize::DictionaryValue &io_slice);
 };
 
+/**
+ * Encoding that is used for array data when it is written. Every blob stores how it has been
+ * encoded, so the setting does not have to be known when reading.
+ */
+enum class BlobCompression {
+  None,
+  /**
+   * Compress the data with zstd. Arrays of multi-byte values are byte-shuffled and delta-encoded
+   * before, which makes e.g. float attributes compress much better.
+   */
+  Zstd,
+};
+
 /**
  * Abstract base class for loading binary data.
  */
@@ -35,6 +50,13 @@ class BlobReader {
    */
   [[nodiscard]] virtual bool read(const BlobSlice &slice, void *r_data) const = 0;
 
+  /**
+   * Access the data of the given slice without copying it, if the reader supports that.
+   * \return Shared ownership of the data, or none if it has to be loaded with #read instead.
+   */
+  [[nodiscard]] virtual std::optional<ImplicitSharingInfoAndData> read_mapped(
+      const BlobSlice &slice) const;
+
   /**
    * Provides an #istream that can be used to read the data from the given slice.
    * \return True on success, otherwise false.
@@ -62,6 +84,11 @@ class BlobWriter {
    */
   virtual BlobSlice write_as_stream(StringRef file_extension,
                                     FunctionRef<void(std::ostream &)> fn);
+
+  /**
+   * Encoding that should be used for array data written with #BlobWriteSharing.
+   */
+  virtual BlobCompression compression() const;
 };
 
 /**
@@ -93,11 +120,44 @@ class BlobWriteSharing : NonCopyable, NonMovable {
    * Remembers where data was stored based on the hash of the data. This allows us to skip writing
    * the same array again if it has the same hash.
    */
-  Map<uint64_t, BlobSlice> slice_by_content_hash_;
+  Map<uint64_t, std::shared_ptr<io::serialize::DictionaryValue>> io_data_by_content_hash_;
+
+  /** Size of the data passed to #write_deduplicated before and after deduplication/encoding. */
+  int64_t total_input_bytes_ = 0;
+  int64_t total_written_bytes_ = 0;
+
+  /**
+   * An array that has been written for a frame. When data is compressed, arrays of the next frame
+   * may be stored as difference to it, because e.g. positions of a simulation often change only
+   * slightly from one frame to the next. Only arrays written with the same #BlobWriteSharing,
+   * i.e. in the same bake, are used as base.
+   */
+  struct FrameBlob {
+    /** Keeps the data alive. It is shared with the written geometry if possible, or a copy. */
+    ImplicitSharingPtr<ImplicitSharingInfo> sharing_info;
+    Span<uint8_t> data;
+    /** Hash of the data, stored with arrays that use it as base to detect changed files. */
+    uint64_t content_hash;
+    int64_t element_size;
+    std::shared_ptr<io::serialize::DictionaryValue> io_data;
+    /** Number of blobs that have to be decoded before this one can be decoded. */
+    int delta_chain_length;
+  };
+  Vector<FrameBlob> prev_frame_blobs_;
+  Vector<FrameBlob> current_frame_blobs_;
 
  public:
   ~BlobWriteSharing();
 
+  int64_t total_input_bytes() const
+  {
+    return total_input_bytes_;
+  }
+  int64_t total_written_bytes() const
+  {
+    return total_written_bytes_;
+  }
+
   /**
    * Check if the data referenced by `sharing_info` has been written before. If yes, return the
    * identifier for the previously written data. Otherwise, write the data now and store the
@@ -112,9 +172,26 @@ class BlobWriteSharing : NonCopyable, NonMovable {
    * Checks if the given data was written before. If it was, it's not written again, but a
    * reference to the previously written data is returned. If the data is new, it's written now.
    * Its hash is remembered so that the same data won't be written again.
+   * \param element_size: Size of the values in the array, which allows filtering the data before
+   *   it is compressed. Use 1 if the data should not be filtered.
+   * \param sharing_info: Optional owner of the data. The next frame can then be delta-encoded
+   *   against the data without keeping a copy of it.
    */
   [[nodiscard]] std::shared_ptr<io::serialize::DictionaryValue> write_deduplicated(
-      BlobWriter &writer, const void *data, int64_t size_in_bytes);
+      BlobWriter &writer,
+      const void *data,
+      int64_t size_in_bytes,
+      int64_t element_size = 1,
+      const ImplicitSharingInfo *sharing_info = nullptr);
+
+  /**
+   * Called after all data of a frame has been written. Arrays of the next frame may then be
+   * delta-encoded against arrays of the finished frame.
+   */
+  void finish_frame();
+
+ private:
+  const FrameBlob *find_delta_base(Span<uint8_t> data, int64_t element_size) const;
 };
 
 /**
@@ -142,6 +219,12 @@ class BlobReadSharing : NonCopyable, NonMovable {
   [[nodiscard]] std::optional<ImplicitSharingInfoAndData> read_shared(
       const io::serialize::DictionaryValue &io_data,
       FunctionRef<std::optional<ImplicitSharingInfoAndData>()> read_fn) const;
+
+  /**
+   * Forget all data that is not used anywhere else anymore, so that it is freed. This should be
+   * called after freeing read data, otherwise it is kept alive by this cache.
+   */
+  void remove_unused() const;
 };
 
 /**
@@ -149,13 +232,20 @@ class BlobReadSharing : NonCopyable, NonMovable {
  */
 class DiskBlobReader : public BlobReader {
  private:
+  struct FileMapping;
+
   const std::string blobs_dir_;
   mutable std::mutex mutex_;
   mutable Map<std::string, std::unique_ptr<fstream>> open_input_streams_;
+  /** Memory-mapped blob files, each with one user owned by this reader. May contain null. */
+  mutable Map<std::string, FileMapping *> mapped_files_;
 
  public:
   DiskBlobReader(std::string blobs_dir);
+  ~DiskBlobReader();
   [[nodiscard]] bool read(const BlobSlice &slice, void *r_data) const override;
+  [[nodiscard]] std::optional<ImplicitSharingInfoAndData> read_mapped(
+      const BlobSlice &slice) const override;
 };
 
 /**
@@ -174,14 +264,19 @@ class DiskBlobWriter : public BlobWriter {
   int64_t current_offset_ = 0;
   /** Used to generate file names for bake data that is stored in independent files. */
   int independent_file_count_ = 0;
+  BlobCompression compression_;
 
  public:
-  DiskBlobWriter(std::string blob_dir, std::string base_name);
+  DiskBlobWriter(std::string blob_dir,
+                 std::string base_name,
+                 BlobCompression compression = BlobCompression::None);
 
   BlobSlice write(const void *data, int64_t size) override;
 
   BlobSlice write_as_stream(StringRef file_extension,
                             FunctionRef<void(std::ostream &)> fn) override;
+
+  BlobCompression compression() const override;
 };
 
 void serialize_bake(const BakeState &bake_state,
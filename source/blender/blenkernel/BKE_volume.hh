@@ -28,10 +28,30 @@ struct VolumeGridVector;
 namespace blender::bke::bake {
 struct BakeMaterialsList;
 }
+namespace blender::bke::volume_grid::file_cache {
+struct CacheStats;
+}
 
 /* Module */
 
 void BKE_volumes_init();
+void BKE_volumes_exit();
+
+/**
+ * Set the memory budget in bytes for grids loaded from VDB files, zero means no limit.
+ */
+void BKE_volumes_file_cache_memory_budget_set(int64_t budget);
+/**
+ * Use delayed loading for grids loaded from VDB files, so that voxels are only read from the file
+ * when they are accessed. Off by default.
+ */
+void BKE_volumes_file_cache_delay_load_set(bool delay_load);
+bool BKE_volumes_file_cache_delay_load_get();
+/**
+ * Get statistics about the cache of grids loaded from VDB files. Everything is zero when building
+ * without OpenVDB.
+ */
+blender::bke::volume_grid::file_cache::CacheStats BKE_volumes_file_cache_stats_get();
 
 /* Data-block Management */
 
@@ -133,6 +153,8 @@ struct VolumeRuntime {
 
   /** Current frame in sequence for evaluated volume. */
   int frame = 0;
+  /** Scene frame that #frame has been computed for, used to find the upcoming frames. */
+  int scene_frame = 0;
 
   /* Names for scalar grids which would need to be merged to recompose the velocity grid. */
   char velocity_x_grid[64] = "";
@@ -19,7 +19,9 @@
 #  include "BKE_volume_enums.hh"
 #  include "BKE_volume_grid_type_traits.hh"
 
+#  include "BLI_bounds_types.hh"
 #  include "BLI_implicit_sharing_ptr.hh"
+#  include "BLI_math_vector_types.hh"
 #  include "BLI_string_ref.hh"
 
 #  include "openvdb_fwd.hh"
@@ -203,6 +205,14 @@ class VolumeGridData : public ImplicitSharingMixin {
    */
   openvdb::GridClass grid_class() const;
 
+  /**
+   * Bounds of the active voxels aligned to leaf nodes, in object space. When the tree is not
+   * loaded yet, the bounds are derived from the statistics that OpenVDB stores in the meta-data of
+   * grids written to files, so that the tree does not have to be loaded only to get the bounds.
+   * Both ways give the same result.
+   */
+  std::optional<Bounds<float3>> bounds() const;
+
   /**
    * True if the grid is fully loaded (including the meta-data, transform and tree).
    */
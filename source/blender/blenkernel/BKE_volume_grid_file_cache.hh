@@ -8,6 +8,33 @@
  * \ingroup bke
  */
 
+#include <cstdint>
+
+namespace blender::bke::volume_grid::file_cache {
+
+/**
+ * Statistics of the cache, e.g. to tune the memory budget. This is available without OpenVDB, so
+ * that it can be displayed in any build. See #BKE_volumes_file_cache_stats_get.
+ */
+struct CacheStats {
+  /** Memory budget in bytes, zero if there is no limit. */
+  int64_t memory_budget = 0;
+  /** Memory used by all loaded trees in the cache, including the ones that are in use. */
+  int64_t memory_usage = 0;
+  int64_t cached_grids_num = 0;
+  int64_t loaded_grids_num = 0;
+  /** Number of requested grids that were in the cache already. */
+  int64_t hits_num = 0;
+  /** Number of requested grids that had to be added to the cache. */
+  int64_t misses_num = 0;
+  /** Number of grids that have been removed to stay within the memory budget. */
+  int64_t evicted_grids_num = 0;
+  /** Number of files that have been loaded in the background. */
+  int64_t prefetched_files_num = 0;
+};
+
+}  // namespace blender::bke::volume_grid::file_cache
+
 #ifdef WITH_OPENVDB
 
 #  include "BLI_vector.hh"
@@ -49,11 +76,44 @@ struct GridsFromFile {
  */
 GridsFromFile get_all_grids_from_file(StringRef file_path, int simplify_level = 0);
 
+/**
+ * Load all grids of the file including their trees and leaf buffers on a background thread, so
+ * that they are ready when they are needed later, e.g. for the upcoming frames of a volume
+ * sequence. Nothing is loaded when the cache already exceeds its memory budget.
+ */
+void prefetch_grids_from_file(StringRef file_path, int simplify_level = 0);
+
+/**
+ * Cancel background loading and wait until the running loading tasks are done.
+ */
+void stop_prefetching();
+
 /**
  * Remove all cached volume grids that are currently not referenced outside of the cache.
  */
 void unload_unused();
 
+/**
+ * Set the amount of memory that may be used by loaded trees in the cache. When it is exceeded,
+ * grids that are not referenced outside of the cache are removed, least recently used first.
+ * Zero disables the limit. By default, half of the system memory is used.
+ */
+void set_memory_budget(int64_t budget);
+
+/**
+ * Use OpenVDB's delayed loading for grids that are loaded afterwards. Leaf buffers are then only
+ * read from the file when they are accessed, which is faster when e.g. only the topology is
+ * needed, but may be slow on network drives. Off by default. Delay loaded leaf buffers are only
+ * counted for the memory budget once they are read by #prefetch_grids_from_file.
+ */
+void set_delay_load(bool delay_load);
+bool get_delay_load();
+
+/**
+ * Get statistics about the cache, e.g. to tune the memory budget.
+ */
+CacheStats get_stats();
+
 }  // namespace blender::bke::volume_grid::file_cache
 
 #endif
@@ -6,6 +6,8 @@
 
 #include "BKE_bake_geometry_nodes_modifier.hh"
 #include "BKE_collection.hh"
+#include "BKE_geometry_set.hh"
+#include "BKE_instances.hh"
 #include "BKE_main.hh"
 
 #include "DNA_modifier_types.h"
@@ -15,6 +17,9 @@
 #include "BLI_fileops.hh"
 #include "BLI_path_util.h"
 #include "BLI_string.h"
+#include "BLI_task.h"
+
+#include "MEM_guardedalloc.h"
 
 #include "MOD_nodes.hh"
 
@@ -32,12 +37,202 @@ void BakeNodeCache::reset()
   new (this) BakeNodeCache();
 }
 
+/** Number of frames that are prefetched in playback direction. */
+static constexpr int prefetch_frames_ahead = 10;
+/** Number of frames that are prefetched against the playback direction, e.g. for scrubbing. */
+static constexpr int prefetch_frames_behind = 3;
+
+NodeBakeCache::~NodeBakeCache()
+{
+  if (this->prefetch_pool) {
+    BLI_task_pool_cancel(this->prefetch_pool);
+    BLI_task_pool_free(this->prefetch_pool);
+  }
+}
+
 void NodeBakeCache::reset()
 {
   std::destroy_at(this);
   new (this) NodeBakeCache();
 }
 
+static int64_t estimate_geometry_memory(const GeometrySet &geometry)
+{
+  int64_t memory = 0;
+  if (const Instances *instances = geometry.get_instances()) {
+    for (const InstanceReference &reference : instances->references()) {
+      if (reference.type() == InstanceReference::Type::GeometrySet) {
+        memory += estimate_geometry_memory(reference.geometry_set());
+      }
+    }
+  }
+  for (const GeometryComponent *component : geometry.get_components()) {
+    const std::optional<AttributeAccessor> attributes = component->attributes();
+    if (!attributes) {
+      continue;
+    }
+    attributes->for_all([&](const AttributeIDRef & /*id*/, const AttributeMetaData &meta_data) {
+      if (const CPPType *type = custom_data_type_to_cpp_type(meta_data.data_type)) {
+        memory += int64_t(attributes->domain_size(meta_data.domain)) * type->size();
+      }
+      return true;
+    });
+  }
+  return memory;
+}
+
+/** Approximate memory used by the baked data, only taking geometry attributes into account. */
+static int64_t estimate_bake_state_memory(const BakeState &state)
+{
+  int64_t memory = 0;
+  for (const std::unique_ptr<BakeItem> &item : state.items_by_id.values()) {
+    if (const auto *geometry_item = dynamic_cast<const GeometryBakeItem *>(item.get())) {
+      memory += estimate_geometry_memory(geometry_item->geometry);
+    }
+  }
+  return memory;
+}
+
+std::shared_ptr<const BakeState> NodeBakeCache::ensure_frame_loaded(FrameCache &frame_cache)
+{
+  std::lock_guard lock{frame_cache.load_mutex};
+  if (frame_cache.state) {
+    return frame_cache.state;
+  }
+  if (!this->blobs_dir) {
+    return nullptr;
+  }
+  if (!frame_cache.meta_path) {
+    return nullptr;
+  }
+  DiskBlobReader blob_reader{*this->blobs_dir};
+  fstream meta_file{*frame_cache.meta_path};
+  std::optional<BakeState> bake_state = deserialize_bake(
+      meta_file, blob_reader, *this->blob_sharing);
+  if (!bake_state.has_value()) {
+    return nullptr;
+  }
+  frame_cache.loaded_memory = estimate_bake_state_memory(*bake_state);
+  frame_cache.state = std::make_shared<const BakeState>(std::move(*bake_state));
+  return frame_cache.state;
+}
+
+struct FramePrefetchTask {
+  FrameCache *frame_cache;
+  int frame_index;
+};
+
+static void prefetch_frame_task(TaskPool *__restrict pool, void *taskdata)
+{
+  NodeBakeCache &bake_cache = *static_cast<NodeBakeCache *>(BLI_task_pool_user_data(pool));
+  const FramePrefetchTask &task = *static_cast<const FramePrefetchTask *>(taskdata);
+  /* Skip frames that are not needed anymore, because the playhead moved on in the meantime. */
+  const int distance = std::abs(task.frame_index - bake_cache.prefetch_frame_index);
+  if (distance <= prefetch_frames_ahead && !BLI_task_pool_current_canceled(pool)) {
+    bake_cache.ensure_frame_loaded(*task.frame_cache);
+  }
+  task.frame_cache->prefetch_pending = false;
+}
+
+static void prefetch_frame_task_free(TaskPool *__restrict /*pool*/, void *taskdata)
+{
+  MEM_delete(static_cast<FramePrefetchTask *>(taskdata));
+}
+
+/**
+ * Free lazily loaded frames outside of the given range, starting with the ones furthest away,
+ * until the loaded frames fit into the memory budget. Evaluations that still use a freed frame
+ * keep its state alive until they are done.
+ */
+static void free_distant_frames(NodeBakeCache &bake_cache,
+                                const int frame_index,
+                                const IndexRange keep_range)
+{
+  int64_t loaded_memory = 0;
+  Vector<int> freeable_frames;
+  for (const int i : bake_cache.frames.index_range()) {
+    FrameCache &frame_cache = *bake_cache.frames[i];
+    std::unique_lock lock{frame_cache.load_mutex, std::try_to_lock};
+    if (!lock.owns_lock()) {
+      /* The frame is being loaded right now. */
+      continue;
+    }
+    if (!frame_cache.meta_path || !frame_cache.state) {
+      continue;
+    }
+    loaded_memory += frame_cache.loaded_memory;
+    if (!keep_range.contains(i)) {
+      freeable_frames.append(i);
+    }
+  }
+  if (loaded_memory <= bake_cache.prefetch_memory_budget) {
+    return;
+  }
+  std::sort(freeable_frames.begin(), freeable_frames.end(), [&](const int a, const int b) {
+    return std::abs(a - frame_index) > std::abs(b - frame_index);
+  });
+  for (const int i : freeable_frames) {
+    if (loaded_memory <= bake_cache.prefetch_memory_budget) {
+      break;
+    }
+    FrameCache &frame_cache = *bake_cache.frames[i];
+    std::lock_guard lock{frame_cache.load_mutex};
+    loaded_memory -= frame_cache.loaded_memory;
+    frame_cache.state.reset();
+    frame_cache.loaded_memory = 0;
+  }
+  /* The read sharing references all loaded arrays, which would keep them alive otherwise. */
+  bake_cache.blob_sharing->remove_unused();
+}
+
+void NodeBakeCache::prefetch_frames(const int frame_index)
+{
+  if (!this->blobs_dir) {
+    /* The frames are not loaded lazily. */
+    return;
+  }
+  std::lock_guard lock{this->prefetch_mutex};
+  const int prev_frame_index = this->prefetch_frame_index.exchange(frame_index);
+  if (prev_frame_index == frame_index) {
+    return;
+  }
+  if (prev_frame_index != -1) {
+    this->prefetch_backwards = frame_index < prev_frame_index;
+  }
+  const int ahead = this->prefetch_backwards ? prefetch_frames_behind : prefetch_frames_ahead;
+  const int behind = this->prefetch_backwards ? prefetch_frames_ahead : prefetch_frames_behind;
+  const IndexRange prefetch_range = IndexRange::from_begin_end_inclusive(
+                                        frame_index - behind, frame_index + ahead)
+                                        .intersect(this->frames.index_range());
+
+  free_distant_frames(*this, frame_index, prefetch_range);
+
+  if (!this->prefetch_pool) {
+    this->prefetch_pool = BLI_task_pool_create_background(this, TASK_PRIORITY_LOW);
+  }
+  /* Queue the frames in the order in which they will be needed. */
+  const int direction = this->prefetch_backwards ? -1 : 1;
+  for (const int offset : IndexRange(1, std::max(ahead, behind))) {
+    for (const int i : {frame_index + direction * offset, frame_index - direction * offset}) {
+      if (!prefetch_range.contains(i)) {
+        continue;
+      }
+      FrameCache &frame_cache = *this->frames[i];
+      if (!frame_cache.meta_path) {
+        continue;
+      }
+      if (frame_cache.prefetch_pending.exchange(true)) {
+        continue;
+      }
+      BLI_task_pool_push(this->prefetch_pool,
+                         prefetch_frame_task,
+                         MEM_new<FramePrefetchTask>(__func__, FramePrefetchTask{&frame_cache, i}),
+                         true,
+                         prefetch_frame_task_free);
+    }
+  }
+}
+
 IndexRange NodeBakeCache::frame_range() const
 {
   if (this->frames.is_empty()) {
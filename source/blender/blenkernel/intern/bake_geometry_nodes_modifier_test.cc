@@ -0,0 +1,147 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include "testing/testing.h"
+
+#include "BKE_attribute.hh"
+#include "BKE_bake_geometry_nodes_modifier.hh"
+#include "BKE_bake_items_paths.hh"
+#include "BKE_geometry_set.hh"
+#include "BKE_idtype.hh"
+#include "BKE_pointcloud.hh"
+
+#include "BLI_fileops.hh"
+#include "BLI_path_util.h"
+#include "BLI_threads.h"
+
+#include "DNA_pointcloud_types.h"
+
+namespace blender::bke::bake::tests {
+
+class BakeGeometryNodesModifierTest : public ::testing::Test {
+ public:
+  static void SetUpTestSuite()
+  {
+    BKE_idtype_init();
+    BLI_threadapi_init();
+  }
+
+  static void TearDownTestSuite()
+  {
+    BLI_threadapi_exit();
+  }
+
+  void TearDown() override
+  {
+    BLI_delete(bake_dir().c_str(), true, true);
+  }
+
+  static std::string bake_dir()
+  {
+    return testing::TempDir() + "bake_geometry_nodes_modifier_test" + SEP_STR;
+  }
+};
+
+static BakeState create_frame_state(const int frame)
+{
+  PointCloud *pointcloud = BKE_pointcloud_new_nomain(1000);
+  pointcloud->positions_for_write().fill(float3(frame, 0.0f, 0.0f));
+  BakeState bake_state;
+  bake_state.items_by_id.add_new(
+      0, std::make_unique<GeometryBakeItem>(GeometrySet::from_pointcloud(pointcloud)));
+  return bake_state;
+}
+
+static const PointCloud &get_pointcloud(const BakeState &bake_state)
+{
+  const auto &item = dynamic_cast<const GeometryBakeItem &>(*bake_state.items_by_id.lookup(0));
+  return *item.geometry.get_pointcloud();
+}
+
+/** Frame that the state has been created for by #create_frame_state. */
+static int get_frame(const BakeState &bake_state)
+{
+  return int(get_pointcloud(bake_state).positions().last().x);
+}
+
+/** Write all frames to disk and set up the cache to load them lazily, like a baked modifier. */
+static void write_baked_frames(NodeBakeCache &bake_cache, const int frames_num)
+{
+  const std::string blobs_dir = BakeGeometryNodesModifierTest::bake_dir() + "blobs";
+  const std::string meta_dir = BakeGeometryNodesModifierTest::bake_dir() + "meta";
+  BlobWriteSharing blob_sharing;
+  for (const int frame : IndexRange(frames_num)) {
+    const std::string frame_file_name = frame_to_file_name(SubFrame(frame));
+    char meta_path[FILE_MAX];
+    BLI_path_join(
+        meta_path, sizeof(meta_path), meta_dir.c_str(), (frame_file_name + ".json").c_str());
+    BLI_file_ensure_parent_dir_exists(meta_path);
+    DiskBlobWriter blob_writer{blobs_dir, frame_file_name};
+    fstream meta_file{meta_path, std::ios::out};
+    serialize_bake(create_frame_state(frame), blob_writer, blob_sharing, meta_file);
+  }
+
+  for (const MetaFile &meta_file : find_sorted_meta_files(meta_dir)) {
+    auto frame_cache = std::make_unique<FrameCache>();
+    frame_cache->frame = meta_file.frame;
+    frame_cache->meta_path = meta_file.path;
+    bake_cache.frames.append(std::move(frame_cache));
+  }
+  bake_cache.blobs_dir = blobs_dir;
+  bake_cache.blob_sharing = std::make_unique<BlobReadSharing>();
+}
+
+TEST_F(BakeGeometryNodesModifierTest, load_evict_and_reload_frames)
+{
+  const int frames_num = 30;
+  NodeBakeCache bake_cache;
+  write_baked_frames(bake_cache, frames_num);
+  ASSERT_EQ(bake_cache.frames.size(), frames_num);
+  /* Free all frames that are not close to the prefetched frame. */
+  bake_cache.prefetch_memory_budget = 0;
+
+  FrameCache &first_frame_cache = *bake_cache.frames.first();
+  std::shared_ptr<const BakeState> first_state = bake_cache.ensure_frame_loaded(
+      first_frame_cache);
+  ASSERT_NE(first_state, nullptr);
+  EXPECT_EQ(get_frame(*first_state), 0);
+  /* Used like an evaluation that still references the frame. */
+  BakeStateRef first_state_ref{first_state};
+  const ImplicitSharingInfo *positions_sharing_info =
+      get_pointcloud(*first_state).attributes().lookup("position").sharing_info;
+  ASSERT_NE(positions_sharing_info, nullptr);
+  positions_sharing_info->add_weak_user();
+
+  /* Jumping to the end frees the first frame, but the state stays valid while it is used. */
+  bake_cache.prefetch_frames(frames_num - 1);
+  {
+    std::lock_guard lock{first_frame_cache.load_mutex};
+    EXPECT_EQ(first_frame_cache.state, nullptr);
+  }
+  first_state.reset();
+  EXPECT_FALSE(positions_sharing_info->is_expired());
+  const auto &first_item = dynamic_cast<const GeometryBakeItem &>(
+      *first_state_ref.items_by_id.lookup(0));
+  EXPECT_EQ(first_item.geometry.get_pointcloud()->positions().first().x, 0.0f);
+  first_state_ref = {};
+
+  /* The frame is loaded again when it is needed. */
+  std::shared_ptr<const BakeState> reloaded_state = bake_cache.ensure_frame_loaded(
+      first_frame_cache);
+  ASSERT_NE(reloaded_state, nullptr);
+  EXPECT_EQ(get_frame(*reloaded_state), 0);
+  reloaded_state.reset();
+
+  /* Once the frame is freed again without users, the read sharing does not keep its data. */
+  bake_cache.prefetch_frames(frames_num - 2);
+  EXPECT_TRUE(positions_sharing_info->is_expired());
+  positions_sharing_info->remove_weak_user_and_delete_if_last();
+
+  const std::shared_ptr<const BakeState> last_state = bake_cache.ensure_frame_loaded(
+      *bake_cache.frames.last());
+  ASSERT_NE(last_state, nullptr);
+  EXPECT_EQ(get_frame(*last_state), frames_num - 1);
+}
+
+}  // namespace blender::bke::bake::tests
@@ -165,4 +165,12 @@ BakeStateRef::BakeStateRef(const BakeState &bake_state)
   }
 }
 
+BakeStateRef::BakeStateRef(std::shared_ptr<const BakeState> bake_state)
+{
+  if (bake_state) {
+    *this = BakeStateRef(*bake_state);
+    this->owner = std::move(bake_state);
+  }
+}
+
 }  // namespace blender::bke::bake
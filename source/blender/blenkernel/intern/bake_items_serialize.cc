@@ -14,8 +14,11 @@
 
 #include "BLI_endian_defines.h"
 #include "BLI_endian_switch.h"
+#include "BLI_fileops.h"
 #include "BLI_math_matrix_types.hh"
+#include "BLI_mmap.h"
 #include "BLI_path_util.h"
+#include "BLI_task.hh"
 
 #include "DNA_material_types.h"
 #include "DNA_volume_types.h"
@@ -23,9 +26,17 @@
 #include "RNA_access.hh"
 #include "RNA_enum_types.hh"
 
+#include <atomic>
+#include <cstring>
+#include <fcntl.h>
 #include <fmt/format.h>
 #include <sstream>
 #include <xxhash.h>
+#include <zstd.h>
+
+#ifndef WIN32
+#  include <unistd.h>
+#endif
 
 #ifdef WITH_OPENVDB
 #  include <openvdb/io/Stream.h>
@@ -34,11 +45,31 @@
 #  include "BKE_volume_grid.hh"
 #endif
 
+/**
+ * Reference uncompressed blobs in memory-mapped files instead of copying them. This is disabled
+ * on Windows, where files that are mapped can't be replaced when baking again.
+ */
+#ifndef WIN32
+#  define USE_BLOB_MMAP
+#endif
+
 namespace blender::bke::bake {
 
 using namespace io::serialize;
 using DictionaryValuePtr = std::shared_ptr<DictionaryValue>;
 
+/** Smaller blobs are always stored uncompressed, because there is not much to gain. */
+static constexpr int64_t blob_compression_min_size = 1024;
+/** Data is compressed in independent chunks, so that they can be (de)compressed in parallel. */
+static constexpr int64_t blob_compression_chunk_size = 4 * 1024 * 1024;
+static constexpr int blob_compression_level = 3;
+/** Blobs are aligned in the file, so that they can be used directly when it is memory-mapped. */
+static constexpr int64_t blob_alignment = 16;
+/** Maximum number of delta-encoded blobs that have to be decoded to load a single array. */
+static constexpr int max_delta_chain_length = 8;
+/** Number of bytes that are compared to find a good base for delta-encoding an array. */
+static constexpr int64_t delta_base_sample_size = 4096;
+
 std::shared_ptr<DictionaryValue> BlobSlice::serialize() const
 {
   auto io_slice = std::make_shared<DictionaryValue>();
@@ -84,8 +115,67 @@ bool BlobReader::read_as_stream(const BlobSlice &slice, FunctionRef<bool(std::is
   return true;
 }
 
+std::optional<ImplicitSharingInfoAndData> BlobReader::read_mapped(
+    const BlobSlice & /*slice*/) const
+{
+  return std::nullopt;
+}
+
+BlobCompression BlobWriter::compression() const
+{
+  return BlobCompression::None;
+}
+
+/**
+ * A copy-on-write memory mapping of a blob file. It is kept alive by the #DiskBlobReader that
+ * created it and by all arrays that reference the mapped memory directly.
+ */
+struct DiskBlobReader::FileMapping : public ImplicitSharingMixin {
+  BLI_mmap_file *mmap_file;
+
+  FileMapping(BLI_mmap_file *mmap_file) : mmap_file(mmap_file) {}
+
+ private:
+  void delete_self() override
+  {
+    BLI_mmap_free(mmap_file);
+    MEM_delete(this);
+  }
+};
+
+/**
+ * Sharing-info for one array referenced in a mapped blob file. Since the mapping is
+ * copy-on-write, the array can also be modified in place once it has a single user.
+ */
+class MappedBlobSharingInfo : public ImplicitSharingInfo {
+ private:
+  const ImplicitSharingInfo &mapping_;
+
+ public:
+  MappedBlobSharingInfo(const ImplicitSharingInfo &mapping) : mapping_(mapping)
+  {
+    mapping_.add_user();
+  }
+
+ private:
+  void delete_self_with_data() override
+  {
+    mapping_.remove_user_and_delete_if_last();
+    MEM_delete(this);
+  }
+};
+
 DiskBlobReader::DiskBlobReader(std::string blobs_dir) : blobs_dir_(std::move(blobs_dir)) {}
 
+DiskBlobReader::~DiskBlobReader()
+{
+  for (FileMapping *mapping : mapped_files_.values()) {
+    if (mapping) {
+      mapping->remove_user_and_delete_if_last();
+    }
+  }
+}
+
 [[nodiscard]] bool DiskBlobReader::read(const BlobSlice &slice, void *r_data) const
 {
   if (slice.range.is_empty()) {
@@ -107,21 +197,79 @@ DiskBlobReader::DiskBlobReader(std::string blobs_dir) : blobs_dir_(std::move(blo
   return true;
 }
 
-DiskBlobWriter::DiskBlobWriter(std::string blob_dir, std::string base_name)
-    : blob_dir_(std::move(blob_dir)), base_name_(std::move(base_name))
+std::optional<ImplicitSharingInfoAndData> DiskBlobReader::read_mapped(
+    const BlobSlice &slice) const
+{
+#ifdef USE_BLOB_MMAP
+  if (slice.range.is_empty()) {
+    return std::nullopt;
+  }
+
+  char blob_path[FILE_MAX];
+  BLI_path_join(blob_path, sizeof(blob_path), blobs_dir_.c_str(), slice.name.c_str());
+
+  std::lock_guard lock{mutex_};
+  const FileMapping *mapping = mapped_files_.lookup_or_add_cb_as(
+      blob_path, [&]() -> FileMapping * {
+        const int file = BLI_open(blob_path, O_BINARY | O_RDONLY, 0);
+        if (file == -1) {
+          return nullptr;
+        }
+        BLI_mmap_file *mmap_file = BLI_mmap_open_copy_on_write(file);
+        /* The mapping stays valid after the file is closed. */
+        close(file);
+        if (mmap_file == nullptr) {
+          return nullptr;
+        }
+        return MEM_new<FileMapping>(__func__, mmap_file);
+      });
+  if (mapping == nullptr) {
+    return std::nullopt;
+  }
+  if (slice.range.one_after_last() > int64_t(BLI_mmap_get_length(mapping->mmap_file))) {
+    return std::nullopt;
+  }
+  const void *data = POINTER_OFFSET(BLI_mmap_get_pointer(mapping->mmap_file),
+                                    slice.range.start());
+  return ImplicitSharingInfoAndData{MEM_new<MappedBlobSharingInfo>(__func__, *mapping), data};
+#else
+  UNUSED_VARS(slice);
+  return std::nullopt;
+#endif
+}
+
+DiskBlobWriter::DiskBlobWriter(std::string blob_dir,
+                               std::string base_name,
+                               const BlobCompression compression)
+    : blob_dir_(std::move(blob_dir)), base_name_(std::move(base_name)), compression_(compression)
 {
   blob_name_ = base_name_ + ".blob";
 }
 
+BlobCompression DiskBlobWriter::compression() const
+{
+  return compression_;
+}
+
 BlobSlice DiskBlobWriter::write(const void *data, const int64_t size)
 {
   if (!blob_stream_.is_open()) {
     char blob_path[FILE_MAX];
     BLI_path_join(blob_path, sizeof(blob_path), blob_dir_.c_str(), blob_name_.c_str());
     BLI_file_ensure_parent_dir_exists(blob_path);
+    /* Remove the old file instead of overwriting it, because it may still be memory-mapped by a
+     * #DiskBlobReader. */
+    BLI_delete(blob_path, false, false);
     blob_stream_.open(blob_path, std::ios::out | std::ios::binary);
   }
 
+  const int64_t padding = (blob_alignment - current_offset_ % blob_alignment) % blob_alignment;
+  if (padding > 0) {
+    const char zeros[blob_alignment] = {0};
+    blob_stream_.write(zeros, padding);
+    current_offset_ += padding;
+  }
+
   const int64_t old_offset = current_offset_;
   blob_stream_.write(static_cast<const char *>(data), size);
   current_offset_ += size;
@@ -189,13 +337,368 @@ DictionaryValuePtr BlobWriteSharing::write_implicitly_shared(
       });
 }
 
+/**
+ * Store the n-th byte of all elements next to each other, each as difference to the same byte of
+ * the previous element. Neighboring values in attribute arrays are often similar, so this results
+ * in long runs of small bytes that compress much better than the original data.
+ */
+static void shuffle_delta_encode(const Span<uint8_t> src,
+                                 const int64_t element_size,
+                                 MutableSpan<uint8_t> dst)
+{
+  const int64_t elements_num = src.size() / element_size;
+  threading::parallel_for(IndexRange(elements_num), 64 * 1024, [&](const IndexRange range) {
+    for (const int64_t byte : IndexRange(element_size)) {
+      uint8_t *plane = dst.data() + byte * elements_num;
+      for (const int64_t i : range) {
+        const uint8_t prev = i == 0 ? 0 : src[(i - 1) * element_size + byte];
+        plane[i] = src[i * element_size + byte] - prev;
+      }
+    }
+  });
+  /* Trailing bytes that don't form a full element are copied unchanged. */
+  const int64_t tail_start = elements_num * element_size;
+  dst.drop_front(tail_start).copy_from(src.drop_front(tail_start));
+}
+
+static void shuffle_delta_decode(const Span<uint8_t> src,
+                                 const int64_t element_size,
+                                 MutableSpan<uint8_t> dst)
+{
+  const int64_t elements_num = src.size() / element_size;
+  threading::parallel_for(IndexRange(element_size), 1, [&](const IndexRange range) {
+    for (const int64_t byte : range) {
+      const uint8_t *plane = src.data() + byte * elements_num;
+      uint8_t value = 0;
+      for (const int64_t i : IndexRange(elements_num)) {
+        value += plane[i];
+        dst[i * element_size + byte] = value;
+      }
+    }
+  });
+  const int64_t tail_start = elements_num * element_size;
+  dst.drop_front(tail_start).copy_from(src.drop_front(tail_start));
+}
+
+/**
+ * Compress the data as a sequence of independent zstd frames, which is still a valid zstd stream.
+ * \return The compressed data, or none if compression failed.
+ */
+static std::optional<Vector<uint8_t>> compress_zstd(const Span<uint8_t> data)
+{
+  const int64_t chunks_num = divide_ceil_ul(data.size(), blob_compression_chunk_size);
+  Array<Vector<uint8_t>> compressed_chunks(chunks_num);
+  std::atomic<bool> failed = false;
+  threading::parallel_for(compressed_chunks.index_range(), 1, [&](const IndexRange range) {
+    for (const int64_t chunk_i : range) {
+      const Span<uint8_t> chunk = data.slice_safe(chunk_i * blob_compression_chunk_size,
+                                                  blob_compression_chunk_size);
+      Vector<uint8_t> &compressed = compressed_chunks[chunk_i];
+      compressed.resize(ZSTD_compressBound(chunk.size()));
+      const size_t compressed_size = ZSTD_compress(compressed.data(),
+                                                   compressed.size(),
+                                                   chunk.data(),
+                                                   chunk.size(),
+                                                   blob_compression_level);
+      if (ZSTD_isError(compressed_size)) {
+        failed = true;
+        continue;
+      }
+      compressed.resize(compressed_size);
+    }
+  });
+  if (failed) {
+    return std::nullopt;
+  }
+  Vector<uint8_t> result;
+  for (const Vector<uint8_t> &compressed : compressed_chunks) {
+    result.extend(compressed);
+  }
+  return result;
+}
+
+[[nodiscard]] static bool decompress_zstd(const Span<uint8_t> src, MutableSpan<uint8_t> dst)
+{
+  /* Find the independent frames first, so that they can be decompressed in parallel. */
+  Vector<std::pair<Span<uint8_t>, IndexRange>> frames;
+  int64_t src_offset = 0;
+  int64_t dst_offset = 0;
+  while (src_offset < src.size()) {
+    const Span<uint8_t> remaining = src.drop_front(src_offset);
+    const size_t frame_size = ZSTD_findFrameCompressedSize(remaining.data(), remaining.size());
+    if (ZSTD_isError(frame_size)) {
+      return false;
+    }
+    const unsigned long long content_size = ZSTD_getFrameContentSize(remaining.data(),
+                                                                     remaining.size());
+    if (ELEM(content_size, ZSTD_CONTENTSIZE_UNKNOWN, ZSTD_CONTENTSIZE_ERROR)) {
+      return false;
+    }
+    if (dst_offset + int64_t(content_size) > dst.size()) {
+      return false;
+    }
+    frames.append({remaining.take_front(frame_size), IndexRange(dst_offset, content_size)});
+    src_offset += frame_size;
+    dst_offset += content_size;
+  }
+  if (dst_offset != dst.size()) {
+    return false;
+  }
+
+  std::atomic<bool> failed = false;
+  threading::parallel_for(frames.index_range(), 1, [&](const IndexRange range) {
+    for (const int64_t frame_i : range) {
+      const auto &[frame, dst_range] = frames[frame_i];
+      const size_t decompressed_size = ZSTD_decompress(
+          dst.slice(dst_range).data(), dst_range.size(), frame.data(), frame.size());
+      if (decompressed_size != size_t(dst_range.size())) {
+        failed = true;
+      }
+    }
+  });
+  return !failed;
+}
+
+static std::string content_hash_to_string(const uint64_t hash)
+{
+  return fmt::format("{:016x}", hash);
+}
+
+static void xor_bytes(const Span<uint8_t> a, const Span<uint8_t> b, MutableSpan<uint8_t> dst)
+{
+  threading::parallel_for(dst.index_range(), 256 * 1024, [&](const IndexRange range) {
+    for (const int64_t i : range) {
+      dst[i] = a[i] ^ b[i];
+    }
+  });
+}
+
+/**
+ * Write the data with the encoding requested by the writer.
+ * \param base_data: Optional data of the same size that the data is stored relative to. This
+ *   works well when the base is a similar array, e.g. the same attribute in the previous frame.
+ * \param io_base: Identifier of the base data, which is needed to decode the written data.
+ * \param base_hash: Hash of the base data, used to detect when the base has been overwritten
+ *   since, e.g. because a frame has been deleted or baked again.
+ * \return Identifier of the written data, including the information required to decode it.
+ */
+static DictionaryValuePtr write_blob_encoded(BlobWriter &writer,
+                                             const void *data,
+                                             const int64_t size_in_bytes,
+                                             const int64_t element_size,
+                                             const void *base_data = nullptr,
+                                             const DictionaryValuePtr &io_base = {},
+                                             const uint64_t base_hash = 0)
+{
+  if (writer.compression() == BlobCompression::Zstd &&
+      size_in_bytes >= blob_compression_min_size)
+  {
+    const bool use_filter = element_size > 1;
+    Span<uint8_t> raw_data{static_cast<const uint8_t *>(data), size_in_bytes};
+    Array<uint8_t> delta_data;
+    if (base_data) {
+      /* Bytes that did not change become zero, which compresses very well. */
+      delta_data.reinitialize(size_in_bytes);
+      xor_bytes(raw_data, {static_cast<const uint8_t *>(base_data), size_in_bytes}, delta_data);
+      raw_data = delta_data;
+    }
+    Array<uint8_t> filtered_data;
+    if (use_filter) {
+      filtered_data.reinitialize(size_in_bytes);
+      shuffle_delta_encode(raw_data, element_size, filtered_data);
+      raw_data = filtered_data;
+    }
+    const std::optional<Vector<uint8_t>> compressed_data = compress_zstd(raw_data);
+    /* Store incompressible data as is, so that it can still be loaded without a copy. */
+    if (compressed_data && compressed_data->size() < size_in_bytes) {
+      DictionaryValuePtr io_data =
+          writer.write(compressed_data->data(), compressed_data->size()).serialize();
+      io_data->append_str("codec", "zstd");
+      io_data->append_int("raw_size", size_in_bytes);
+      if (use_filter) {
+        io_data->append_str("filter", "shuffle_delta");
+        io_data->append_int("element_size", element_size);
+      }
+      if (base_data) {
+        io_data->append("base", io_base);
+        io_data->append_str("base_hash", content_hash_to_string(base_hash));
+      }
+      return io_data;
+    }
+  }
+  return writer.write(data, size_in_bytes).serialize();
+}
+
+/**
+ * Read data that has been written with #write_blob_encoded.
+ */
+[[nodiscard]] static bool read_blob_decoded(const BlobReader &blob_reader,
+                                            const DictionaryValue &io_data,
+                                            const int64_t size_in_bytes,
+                                            void *r_data)
+{
+  const std::optional<BlobSlice> slice = BlobSlice::deserialize(io_data);
+  if (!slice) {
+    return false;
+  }
+  const std::optional<StringRefNull> codec = io_data.lookup_str("codec");
+  if (!codec) {
+    if (slice->range.size() != size_in_bytes) {
+      return false;
+    }
+    return blob_reader.read(*slice, r_data);
+  }
+  if (*codec != "zstd") {
+    return false;
+  }
+  if (io_data.lookup_int("raw_size") != size_in_bytes) {
+    return false;
+  }
+  Array<uint8_t> compressed_data(slice->range.size(), NoInitialization());
+  if (!blob_reader.read(*slice, compressed_data.data())) {
+    return false;
+  }
+  MutableSpan<uint8_t> dst{static_cast<uint8_t *>(r_data), size_in_bytes};
+  const std::optional<StringRefNull> filter = io_data.lookup_str("filter");
+  if (!filter) {
+    if (!decompress_zstd(compressed_data, dst)) {
+      return false;
+    }
+  }
+  else {
+    const int64_t element_size = io_data.lookup_int("element_size").value_or(0);
+    if (*filter != "shuffle_delta" || element_size <= 1) {
+      return false;
+    }
+    Array<uint8_t> filtered_data(size_in_bytes, NoInitialization());
+    if (!decompress_zstd(compressed_data, filtered_data)) {
+      return false;
+    }
+    shuffle_delta_decode(filtered_data, element_size, dst);
+  }
+  if (const DictionaryValue *io_base = io_data.lookup_dict("base")) {
+    Array<uint8_t> base_data(size_in_bytes, NoInitialization());
+    if (!read_blob_decoded(blob_reader, *io_base, size_in_bytes, base_data.data())) {
+      return false;
+    }
+    /* The base is stored with another frame, which may have been changed independently. Fail
+     * instead of decoding wrong data in that case. */
+    const std::optional<StringRefNull> base_hash = io_data.lookup_str("base_hash");
+    if (!base_hash ||
+        *base_hash != content_hash_to_string(XXH3_64bits(base_data.data(), size_in_bytes)))
+    {
+      return false;
+    }
+    xor_bytes(dst, base_data, dst);
+  }
+  return true;
+}
+
+static int get_delta_chain_length(const DictionaryValue &io_data)
+{
+  int length = 0;
+  for (const DictionaryValue *io_base = io_data.lookup_dict("base"); io_base;
+       io_base = io_base->lookup_dict("base"))
+  {
+    length++;
+  }
+  return length;
+}
+
+/**
+ * Find the array of the previous frame that is most similar to the given data, judged by the
+ * number of equal bytes in a sample. Returns null if no array is similar enough for a delta to
+ * compress better than the data itself.
+ */
+const BlobWriteSharing::FrameBlob *BlobWriteSharing::find_delta_base(
+    const Span<uint8_t> data, const int64_t element_size) const
+{
+  /* Use an odd step, so that all bytes within the elements are sampled. */
+  const int64_t step = std::max<int64_t>(1, data.size() / delta_base_sample_size) | 1;
+  const int64_t samples_num = (data.size() + step - 1) / step;
+  int64_t zero_bytes = 0;
+  for (int64_t i = 0; i < data.size(); i += step) {
+    zero_bytes += data[i] == 0;
+  }
+
+  const FrameBlob *best_base = nullptr;
+  int64_t best_equal_bytes = std::max(zero_bytes, samples_num / 4);
+  for (const FrameBlob &base : prev_frame_blobs_) {
+    if (base.data.size() != data.size() || base.element_size != element_size) {
+      continue;
+    }
+    if (base.delta_chain_length >= max_delta_chain_length) {
+      continue;
+    }
+    int64_t equal_bytes = 0;
+    for (int64_t i = 0; i < data.size(); i += step) {
+      equal_bytes += data[i] == base.data[i];
+    }
+    if (equal_bytes > best_equal_bytes) {
+      best_base = &base;
+      best_equal_bytes = equal_bytes;
+    }
+  }
+  return best_base;
+}
+
 std::shared_ptr<io::serialize::DictionaryValue> BlobWriteSharing::write_deduplicated(
-    BlobWriter &writer, const void *data, const int64_t size_in_bytes)
+    BlobWriter &writer,
+    const void *data,
+    const int64_t size_in_bytes,
+    const int64_t element_size,
+    const ImplicitSharingInfo *sharing_info)
 {
+  total_input_bytes_ += size_in_bytes;
+  const Span<uint8_t> bytes{static_cast<const uint8_t *>(data), size_in_bytes};
+  const bool use_delta = writer.compression() != BlobCompression::None &&
+                         size_in_bytes >= blob_compression_min_size;
   const uint64_t content_hash = XXH3_64bits(data, size_in_bytes);
-  const BlobSlice slice = slice_by_content_hash_.lookup_or_add_cb(
-      content_hash, [&]() { return writer.write(data, size_in_bytes); });
-  return slice.serialize();
+  const DictionaryValuePtr &stored_io_data = io_data_by_content_hash_.lookup_or_add_cb(
+      content_hash, [&]() {
+        const FrameBlob *base = use_delta ? this->find_delta_base(bytes, element_size) : nullptr;
+        DictionaryValuePtr io_data = write_blob_encoded(writer,
+                                                        data,
+                                                        size_in_bytes,
+                                                        element_size,
+                                                        base ? base->data.data() : nullptr,
+                                                        base ? base->io_data : nullptr,
+                                                        base ? base->content_hash : 0);
+        total_written_bytes_ += io_data->lookup_int("size").value_or(0);
+        return io_data;
+      });
+  const int delta_chain_length = use_delta ? get_delta_chain_length(*stored_io_data) :
+                                              max_delta_chain_length;
+  /* Only keep arrays that can still be used as base for the next frame. */
+  if (delta_chain_length < max_delta_chain_length) {
+    FrameBlob frame_blob{
+        {}, {}, content_hash, element_size, stored_io_data, delta_chain_length};
+    if (sharing_info) {
+      sharing_info->add_user();
+      frame_blob.sharing_info = ImplicitSharingPtr<ImplicitSharingInfo>(sharing_info);
+      frame_blob.data = bytes;
+    }
+    else {
+      void *data_copy = MEM_mallocN(size_in_bytes, __func__);
+      memcpy(data_copy, data, size_in_bytes);
+      frame_blob.sharing_info = ImplicitSharingPtr<ImplicitSharingInfo>(
+          implicit_sharing::info_for_mem_free(data_copy));
+      frame_blob.data = {static_cast<const uint8_t *>(data_copy), size_in_bytes};
+    }
+    current_frame_blobs_.append(std::move(frame_blob));
+  }
+  /* Return a copy, because the caller may add more information. */
+  auto io_data = std::make_shared<DictionaryValue>();
+  for (const DictionaryValue::Item &item : stored_io_data->elements()) {
+    io_data->append(item.first, item.second);
+  }
+  return io_data;
+}
+
+void BlobWriteSharing::finish_frame()
+{
+  prev_frame_blobs_ = std::move(current_frame_blobs_);
+  current_frame_blobs_.clear();
 }
 
 std::optional<ImplicitSharingInfoAndData> BlobReadSharing::read_shared(
@@ -224,6 +727,19 @@ std::optional<ImplicitSharingInfoAndData> BlobReadSharing::read_shared(
   return data;
 }
 
+void BlobReadSharing::remove_unused() const
+{
+  std::lock_guard lock{mutex_};
+  runtime_by_stored_.remove_if([](const auto &item) {
+    /* New users can only be added by #read_shared while the mutex is locked. */
+    if (item.value.sharing_info->strong_users() > 1) {
+      return false;
+    }
+    item.value.sharing_info->remove_user_and_delete_if_last();
+    return true;
+  });
+}
+
 static StringRefNull get_endian_io_name(const int endian)
 {
   if (endian == L_ENDIAN) {
@@ -272,9 +788,12 @@ static std::shared_ptr<DictionaryValue> write_blob_raw_data_with_endian(
     BlobWriter &blob_writer,
     BlobWriteSharing &blob_sharing,
     const void *data,
-    const int64_t size_in_bytes)
+    const int64_t size_in_bytes,
+    const int64_t element_size,
+    const ImplicitSharingInfo *sharing_info)
 {
-  auto io_data = blob_sharing.write_deduplicated(blob_writer, data, size_in_bytes);
+  auto io_data = blob_sharing.write_deduplicated(
+      blob_writer, data, size_in_bytes, element_size, sharing_info);
   if (ENDIAN_ORDER == B_ENDIAN) {
     io_data->append_str("endian", get_endian_io_name(ENDIAN_ORDER));
   }
@@ -290,14 +809,7 @@ static std::shared_ptr<DictionaryValue> write_blob_raw_data_with_endian(
                                                          const int64_t elements_num,
                                                          void *r_data)
 {
-  const std::optional<BlobSlice> slice = BlobSlice::deserialize(io_data);
-  if (!slice) {
-    return false;
-  }
-  if (slice->range.size() != element_size * elements_num) {
-    return false;
-  }
-  if (!blob_reader.read(*slice, r_data)) {
+  if (!read_blob_decoded(blob_reader, io_data, element_size * elements_num, r_data)) {
     return false;
   }
   const StringRefNull stored_endian = io_data.lookup_str("endian").value_or("little");
@@ -324,12 +836,14 @@ static std::shared_ptr<DictionaryValue> write_blob_raw_data_with_endian(
 }
 
 /** Write bytes ignoring endianness. */
-static std::shared_ptr<DictionaryValue> write_blob_raw_bytes(BlobWriter &blob_writer,
-                                                             BlobWriteSharing &blob_sharing,
-                                                             const void *data,
-                                                             const int64_t size_in_bytes)
+static std::shared_ptr<DictionaryValue> write_blob_raw_bytes(
+    BlobWriter &blob_writer,
+    BlobWriteSharing &blob_sharing,
+    const void *data,
+    const int64_t size_in_bytes,
+    const ImplicitSharingInfo *sharing_info = nullptr)
 {
-  return blob_sharing.write_deduplicated(blob_writer, data, size_in_bytes);
+  return blob_sharing.write_deduplicated(blob_writer, data, size_in_bytes, 1, sharing_info);
 }
 
 /** Read bytes ignoring endianness. */
@@ -338,27 +852,23 @@ static std::shared_ptr<DictionaryValue> write_blob_raw_bytes(BlobWriter &blob_wr
                                               const int64_t bytes_num,
                                               void *r_data)
 {
-  const std::optional<BlobSlice> slice = BlobSlice::deserialize(io_data);
-  if (!slice) {
-    return false;
-  }
-  if (slice->range.size() != bytes_num) {
-    return false;
-  }
-  return blob_reader.read(*slice, r_data);
+  return read_blob_decoded(blob_reader, io_data, bytes_num, r_data);
 }
 
-static std::shared_ptr<DictionaryValue> write_blob_simple_gspan(BlobWriter &blob_writer,
-                                                                BlobWriteSharing &blob_sharing,
-                                                                const GSpan data)
+static std::shared_ptr<DictionaryValue> write_blob_simple_gspan(
+    BlobWriter &blob_writer,
+    BlobWriteSharing &blob_sharing,
+    const GSpan data,
+    const ImplicitSharingInfo *sharing_info)
 {
   const CPPType &type = data.type();
   BLI_assert(type.is_trivial());
   if (type.size() == 1 || type.is<ColorGeometry4b>()) {
-    return write_blob_raw_bytes(blob_writer, blob_sharing, data.data(), data.size_in_bytes());
+    return write_blob_raw_bytes(
+        blob_writer, blob_sharing, data.data(), data.size_in_bytes(), sharing_info);
   }
   return write_blob_raw_data_with_endian(
-      blob_writer, blob_sharing, data.data(), data.size_in_bytes());
+      blob_writer, blob_sharing, data.data(), data.size_in_bytes(), type.size(), sharing_info);
 }
 
 [[nodiscard]] static bool read_blob_simple_gspan(const BlobReader &blob_reader,
@@ -400,7 +910,43 @@ static std::shared_ptr<DictionaryValue> write_blob_shared_simple_gspan(
     const ImplicitSharingInfo *sharing_info)
 {
   return blob_sharing.write_implicitly_shared(
-      sharing_info, [&]() { return write_blob_simple_gspan(blob_writer, blob_sharing, data); });
+      sharing_info,
+      [&]() { return write_blob_simple_gspan(blob_writer, blob_sharing, data, sharing_info); });
+}
+
+/**
+ * Reference the data of an array directly in the storage if it does not have to be decoded or
+ * converted in any way.
+ */
+static std::optional<ImplicitSharingInfoAndData> read_blob_mapped(const BlobReader &blob_reader,
+                                                                  const DictionaryValue &io_data,
+                                                                  const CPPType &cpp_type,
+                                                                  const int size)
+{
+  if (io_data.lookup("codec")) {
+    return std::nullopt;
+  }
+  const StringRefNull stored_endian = io_data.lookup_str("endian").value_or("little");
+  if (stored_endian != get_endian_io_name(ENDIAN_ORDER)) {
+    return std::nullopt;
+  }
+  const std::optional<BlobSlice> slice = BlobSlice::deserialize(io_data);
+  if (!slice) {
+    return std::nullopt;
+  }
+  if (slice->range.size() != size * cpp_type.size()) {
+    return std::nullopt;
+  }
+  std::optional<ImplicitSharingInfoAndData> data = blob_reader.read_mapped(*slice);
+  if (!data) {
+    return std::nullopt;
+  }
+  if (uintptr_t(data->data) % cpp_type.alignment() != 0) {
+    /* Blobs written by older versions may not be aligned. */
+    data->sharing_info->remove_user_and_delete_if_last();
+    return std::nullopt;
+  }
+  return data;
 }
 
 [[nodiscard]] static const void *read_blob_shared_simple_gspan(
@@ -414,6 +960,11 @@ static std::shared_ptr<DictionaryValue> write_blob_shared_simple_gspan(
   const char *func = __func__;
   const std::optional<ImplicitSharingInfoAndData> sharing_info_and_data = blob_sharing.read_shared(
       io_data, [&]() -> std::optional<ImplicitSharingInfoAndData> {
+        if (std::optional<ImplicitSharingInfoAndData> mapped_data = read_blob_mapped(
+                blob_reader, io_data, cpp_type, size))
+        {
+          return mapped_data;
+        }
         void *data_mem = MEM_mallocN_aligned(size * cpp_type.size(), cpp_type.alignment(), func);
         if (!read_blob_simple_gspan(blob_reader, io_data, {cpp_type, data_mem, size})) {
           MEM_freeN(data_mem);
@@ -1349,6 +1900,7 @@ void serialize_bake(const BakeState &bake_state,
     io::serialize::DictionaryValue &io_item = *io_items.append_dict(std::to_string(item.key));
     serialize_bake_item(*item.value, blob_writer, blob_sharing, io_item);
   }
+  blob_sharing.finish_frame();
 
   io::serialize::JsonFormatter formatter;
   formatter.serialize(r_stream, io_root);
@@ -0,0 +1,275 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include "testing/testing.h"
+
+#include <sstream>
+
+#include "BKE_attribute.hh"
+#include "BKE_bake_items.hh"
+#include "BKE_bake_items_serialize.hh"
+#include "BKE_geometry_set.hh"
+#include "BKE_idtype.hh"
+#include "BKE_pointcloud.hh"
+
+#include "BLI_fileops.h"
+#include "BLI_path_util.h"
+#include "BLI_serialize.hh"
+
+#include "DNA_pointcloud_types.h"
+
+namespace blender::bke::bake::tests {
+
+class BakeItemsSerializeTest : public ::testing::Test {
+ public:
+  static void SetUpTestSuite()
+  {
+    BKE_idtype_init();
+  }
+
+  static void TearDownTestSuite() {}
+
+  void TearDown() override
+  {
+    BLI_delete(blobs_dir().c_str(), true, true);
+  }
+
+  static std::string blobs_dir()
+  {
+    return testing::TempDir() + "bake_items_serialize_test" + SEP_STR;
+  }
+
+  /** Write the state with its own blob file, like a frame of a bake. */
+  static std::string write_frame(const BakeState &bake_state,
+                                 const StringRef frame_name,
+                                 const BlobCompression compression,
+                                 BlobWriteSharing &blob_sharing)
+  {
+    DiskBlobWriter blob_writer{blobs_dir(), frame_name, compression};
+    std::ostringstream stream;
+    serialize_bake(bake_state, blob_writer, blob_sharing, stream);
+    return stream.str();
+  }
+
+  static std::optional<BakeState> read_frame(const std::string &meta)
+  {
+    const DiskBlobReader blob_reader{blobs_dir()};
+    const BlobReadSharing blob_sharing;
+    std::istringstream stream{meta};
+    return deserialize_bake(stream, blob_reader, blob_sharing);
+  }
+};
+
+/** Point cloud with float, int and byte attributes that are large enough to be compressed. */
+static BakeState create_pointcloud_state(const int points_num, const int frame)
+{
+  PointCloud *pointcloud = BKE_pointcloud_new_nomain(points_num);
+  MutableSpan<float3> positions = pointcloud->positions_for_write();
+  MutableAttributeAccessor attributes = pointcloud->attributes_for_write();
+  SpanAttributeWriter<float> floats = attributes.lookup_or_add_for_write_only_span<float>(
+      "float", AttrDomain::Point);
+  SpanAttributeWriter<int> ints = attributes.lookup_or_add_for_write_only_span<int>(
+      "int", AttrDomain::Point);
+  SpanAttributeWriter<int8_t> bytes = attributes.lookup_or_add_for_write_only_span<int8_t>(
+      "byte", AttrDomain::Point);
+  for (const int i : IndexRange(points_num)) {
+    positions[i] = float3(i * 0.01f, (i % 100) * 0.1f + frame * 0.001f, 0.0f);
+    floats.span[i] = i * 0.5f + frame;
+    ints.span[i] = i / 7 - frame;
+    bytes.span[i] = int8_t(i % 5);
+  }
+  floats.finish();
+  ints.finish();
+  bytes.finish();
+
+  BakeState bake_state;
+  bake_state.items_by_id.add_new(
+      0, std::make_unique<GeometryBakeItem>(GeometrySet::from_pointcloud(pointcloud)));
+  return bake_state;
+}
+
+template<typename T>
+static void expect_attribute_eq(const AttributeAccessor &a,
+                                const AttributeAccessor &b,
+                                const StringRef name)
+{
+  const VArraySpan<T> a_values = *a.lookup<T>(name, AttrDomain::Point);
+  const VArraySpan<T> b_values = *b.lookup<T>(name, AttrDomain::Point);
+  ASSERT_FALSE(a_values.is_empty());
+  EXPECT_EQ_ARRAY(a_values.data(), b_values.data(), a_values.size());
+}
+
+static void expect_pointcloud_state_eq(const BakeState &a, const BakeState &b)
+{
+  const auto *a_item = dynamic_cast<const GeometryBakeItem *>(a.items_by_id.lookup(0).get());
+  const auto *b_item = dynamic_cast<const GeometryBakeItem *>(b.items_by_id.lookup(0).get());
+  ASSERT_NE(a_item, nullptr);
+  ASSERT_NE(b_item, nullptr);
+  const PointCloud *a_pointcloud = a_item->geometry.get_pointcloud();
+  const PointCloud *b_pointcloud = b_item->geometry.get_pointcloud();
+  ASSERT_NE(a_pointcloud, nullptr);
+  ASSERT_NE(b_pointcloud, nullptr);
+  ASSERT_EQ(a_pointcloud->totpoint, b_pointcloud->totpoint);
+  const AttributeAccessor a_attributes = a_pointcloud->attributes();
+  const AttributeAccessor b_attributes = b_pointcloud->attributes();
+  expect_attribute_eq<float3>(a_attributes, b_attributes, "position");
+  expect_attribute_eq<float>(a_attributes, b_attributes, "float");
+  expect_attribute_eq<int>(a_attributes, b_attributes, "int");
+  expect_attribute_eq<int8_t>(a_attributes, b_attributes, "byte");
+}
+
+TEST_F(BakeItemsSerializeTest, round_trip_attributes)
+{
+  for (const BlobCompression compression : {BlobCompression::None, BlobCompression::Zstd}) {
+    const BakeState bake_state = create_pointcloud_state(10000, 0);
+    BlobWriteSharing blob_sharing;
+    const std::string meta = write_frame(bake_state, "frame", compression, blob_sharing);
+    if (compression == BlobCompression::Zstd) {
+      EXPECT_LT(blob_sharing.total_written_bytes(), blob_sharing.total_input_bytes());
+    }
+    else {
+      EXPECT_EQ(blob_sharing.total_written_bytes(), blob_sharing.total_input_bytes());
+    }
+
+    /* The reader is freed before the data is compared, mapped data has to stay valid. */
+    const std::optional<BakeState> read_state = read_frame(meta);
+    ASSERT_TRUE(read_state.has_value());
+    expect_pointcloud_state_eq(bake_state, *read_state);
+  }
+}
+
+TEST_F(BakeItemsSerializeTest, round_trip_small_arrays)
+{
+  /* Arrays below the compression threshold are stored uncompressed in any case. */
+  for (const BlobCompression compression : {BlobCompression::None, BlobCompression::Zstd}) {
+    const BakeState bake_state = create_pointcloud_state(7, 0);
+    BlobWriteSharing blob_sharing;
+    const std::string meta = write_frame(bake_state, "frame", compression, blob_sharing);
+    const std::optional<BakeState> read_state = read_frame(meta);
+    ASSERT_TRUE(read_state.has_value());
+    expect_pointcloud_state_eq(bake_state, *read_state);
+  }
+}
+
+/** Number of blobs that have to be decoded before the attribute of the written frame. */
+static int attribute_delta_chain_length(const std::string &meta, const StringRef name)
+{
+  io::serialize::JsonFormatter formatter;
+  std::istringstream stream{meta};
+  const std::unique_ptr<io::serialize::Value> io_root_value = formatter.deserialize(stream);
+  const io::serialize::DictionaryValue *io_pointcloud = io_root_value->as_dictionary_value()
+                                                            ->lookup_dict("items")
+                                                            ->lookup_dict("0")
+                                                            ->lookup_dict("data")
+                                                            ->lookup_dict("pointcloud");
+  for (const auto &io_attribute_value : io_pointcloud->lookup_array("attributes")->elements()) {
+    const io::serialize::DictionaryValue *io_attribute = io_attribute_value->as_dictionary_value();
+    if (io_attribute->lookup_str("name") != name) {
+      continue;
+    }
+    int length = 0;
+    for (const io::serialize::DictionaryValue *io_data = io_attribute->lookup_dict("data");
+         (io_data = io_data->lookup_dict("base"));)
+    {
+      length++;
+    }
+    return length;
+  }
+  return -1;
+}
+
+TEST_F(BakeItemsSerializeTest, round_trip_delta_chains)
+{
+  const int points_num = 10000;
+  const int frames_num = 20;
+  /* Longest chain of arrays that are delta-encoded against the previous frame. */
+  const int max_delta_chain_length = 8;
+
+  Vector<std::string> metas;
+  {
+    BlobWriteSharing blob_sharing;
+    for (const int frame : IndexRange(frames_num)) {
+      /* The state is freed after writing, the next frame can still be encoded against it. */
+      const BakeState bake_state = create_pointcloud_state(points_num, frame);
+      metas.append(write_frame(
+          bake_state, "frame_" + std::to_string(frame), BlobCompression::Zstd, blob_sharing));
+    }
+  }
+
+  for (const int frame : IndexRange(frames_num)) {
+    /* Only the positions change slightly from frame to frame. */
+    EXPECT_EQ(attribute_delta_chain_length(metas[frame], "position"),
+              frame % (max_delta_chain_length + 1));
+    const std::optional<BakeState> read_state = read_frame(metas[frame]);
+    ASSERT_TRUE(read_state.has_value());
+    expect_pointcloud_state_eq(create_pointcloud_state(points_num, frame), *read_state);
+  }
+}
+
+TEST_F(BakeItemsSerializeTest, changed_delta_base)
+{
+  const int points_num = 10000;
+  std::string meta;
+  {
+    BlobWriteSharing blob_sharing;
+    write_frame(
+        create_pointcloud_state(points_num, 0), "frame_0", BlobCompression::Zstd, blob_sharing);
+    meta = write_frame(
+        create_pointcloud_state(points_num, 1), "frame_1", BlobCompression::Zstd, blob_sharing);
+  }
+  ASSERT_EQ(attribute_delta_chain_length(meta, "position"), 1);
+  ASSERT_TRUE(read_frame(meta).has_value());
+
+  /* Bake the first frame again with different data of the same size, so that the offsets of the
+   * arrays in the blob file stay the same. */
+  {
+    BlobWriteSharing blob_sharing;
+    write_frame(
+        create_pointcloud_state(points_num, 5), "frame_0", BlobCompression::Zstd, blob_sharing);
+  }
+  /* The point cloud of the second frame can't be decoded anymore, which has to be detected
+   * instead of loading wrong positions. */
+  const std::optional<BakeState> read_state = read_frame(meta);
+  ASSERT_TRUE(read_state.has_value());
+  const auto *item = dynamic_cast<const GeometryBakeItem *>(
+      read_state->items_by_id.lookup(0).get());
+  ASSERT_NE(item, nullptr);
+  EXPECT_EQ(item->geometry.get_pointcloud(), nullptr);
+}
+
+#ifndef WIN32
+TEST_F(BakeItemsSerializeTest, read_mapped)
+{
+  Array<int> values(1000);
+  for (const int i : values.index_range()) {
+    values[i] = i * 3;
+  }
+  BlobSlice slice;
+  {
+    DiskBlobWriter blob_writer{blobs_dir(), "mapped"};
+    /* Write an odd number of bytes first, the next blob has to be aligned anyway. */
+    const char padding[3] = {1, 2, 3};
+    blob_writer.write(padding, sizeof(padding));
+    slice = blob_writer.write(values.data(), values.as_span().size_in_bytes());
+  }
+  EXPECT_EQ(slice.range.start() % 16, 0);
+
+  std::optional<ImplicitSharingInfoAndData> mapped;
+  {
+    const DiskBlobReader blob_reader{blobs_dir()};
+    mapped = blob_reader.read_mapped(slice);
+  }
+  /* The mapping is kept alive by the returned sharing info. */
+  ASSERT_TRUE(mapped.has_value());
+  ASSERT_NE(mapped->sharing_info, nullptr);
+  EXPECT_EQ_ARRAY(static_cast<const int *>(mapped->data), values.data(), values.size());
+  mapped->sharing_info->remove_user_and_delete_if_last();
+
+  /* Slices outside of the file can't be mapped. */
+  const DiskBlobReader blob_reader{blobs_dir()};
+  EXPECT_FALSE(blob_reader.read_mapped({slice.name, {slice.range.start(), 1 << 20}}).has_value());
+}
+#endif
+
+}  // namespace blender::bke::bake::tests
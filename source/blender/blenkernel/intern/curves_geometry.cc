@@ -1548,8 +1548,8 @@ void CurvesGeometry::blend_read(BlendDataReader &reader)
   CustomData_blend_read(&reader, &this->curve_data, this->curve_num);
 
   if (this->curve_offsets) {
-    this->runtime->curve_offsets_sharing_info = BLO_read_shared(
-        &reader, &this->curve_offsets, [&]() {
+    this->runtime->curve_offsets_sharing_info = BLO_read_shared_trivial_array(
+        &reader, &this->curve_offsets, this->curve_num + 1, [&]() {
           BLO_read_int32_array(&reader, this->curve_num + 1, &this->curve_offsets);
           return implicit_sharing::info_for_mem_free(this->curve_offsets);
         });
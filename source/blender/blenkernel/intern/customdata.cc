@@ -44,6 +44,7 @@
 #include "BLT_translation.hh"
 
 #include "BKE_anonymous_attribute_id.hh"
+#include "BKE_attribute.hh"
 #include "BKE_customdata.hh"
 #include "BKE_customdata_file.h"
 #include "BKE_deform.hh"
@@ -64,6 +65,7 @@
 
 using blender::Array;
 using blender::BitVector;
+using blender::CPPType;
 using blender::float2;
 using blender::ImplicitSharingInfo;
 using blender::IndexRange;
@@ -5482,6 +5484,18 @@ void CustomData_blend_read(BlendDataReader *reader, CustomData *data, const int
     layer->sharing_info = nullptr;
 
     if (CustomData_verify_versions(data, i)) {
+      if (const CPPType *cpp_type = blender::bke::custom_data_type_to_cpp_type(
+              eCustomDataType(layer->type)))
+      {
+        /* Generic attribute arrays are used as they are stored, so they may be referenced
+         * directly in a memory-mapped file. */
+        layer->sharing_info = BLO_read_shared_mapped(
+            reader, &layer->data, cpp_type->size() * size_t(count), cpp_type->alignment());
+        if (layer->sharing_info) {
+          i++;
+          continue;
+        }
+      }
       layer->sharing_info = BLO_read_shared(
           reader, &layer->data, [&]() -> const ImplicitSharingInfo * {
             blend_read_layer_data(reader, *layer, count);
@@ -40,8 +40,10 @@
 #include "BLI_math_rotation.h"
 #include "BLI_math_vector.h"
 #include "BLI_string.h"
+#include "BLI_task.hh"
 #include "BLI_time.h"
 #include "BLI_utildefines.h"
+#include "BLI_vector.hh"
 
 #include "BLT_translation.hh"
 
@@ -86,6 +88,8 @@
 #  include "LzmaLib.h"
 #endif
 
+#include <zstd.h>
+
 #define PTCACHE_DATA_FROM(data, type, from) \
   if (data[type]) { \
     memcpy(data[type], from, ptcache_data_size[type]); \
@@ -124,8 +128,7 @@ static int ptcache_extra_datasize[] = {
 
 /* forward declarations */
 static int ptcache_file_compressed_read(PTCacheFile *pf, uchar *result, uint len);
-static int ptcache_file_compressed_write(
-    PTCacheFile *pf, uchar *in, uint in_len, uchar *out, int mode);
+static int ptcache_file_compressed_write(PTCacheFile *pf, const uchar *in, uint in_len, int mode);
 static int ptcache_file_write(PTCacheFile *pf, const void *f, uint tot, uint size);
 static int ptcache_file_read(PTCacheFile *pf, void *f, uint tot, uint size);
 
@@ -686,7 +689,6 @@ static int ptcache_dynamicpaint_write(PTCacheFile *pf, void *dp_v)
   if (surface->format != MOD_DPAINT_SURFACE_F_IMAGESEQ && surface->data) {
     int total_points = surface->data->total_points;
     uint in_len;
-    uchar *out;
 
     /* cache type */
     ptcache_file_write(pf, &surface->type, 1, sizeof(int));
@@ -704,11 +706,8 @@ static int ptcache_dynamicpaint_write(PTCacheFile *pf, void *dp_v)
       return 0;
     }
 
-    out = (uchar *)MEM_callocN(LZO_OUT_LEN(in_len), "pointcache_lzo_buffer");
-
     ptcache_file_compressed_write(
-        pf, (uchar *)surface->data->type_data, in_len, out, cache_compress);
-    MEM_freeN(out);
+        pf, (const uchar *)surface->data->type_data, in_len, cache_compress);
   }
   return 1;
 }
@@ -1508,125 +1507,191 @@ static void ptcache_file_close(PTCacheFile *pf)
   }
 }
 
-static int ptcache_file_compressed_read(PTCacheFile *pf, uchar *result, uint len)
-{
-  int r = 0;
+/**
+ * A single array of a frame, stored as a compression byte followed by the array data, which may
+ * be compressed. Blocks are encoded and decoded in memory, so that the arrays of a frame can be
+ * (de)compressed in parallel while the file itself is read and written sequentially.
+ */
+struct PTCacheBlock {
+  /** 0 for uncompressed data, 1 for LZO, 2 for LZMA and 3 for Zstandard. */
   uchar compressed = 0;
-  size_t in_len;
-#ifdef WITH_LZO
-  size_t out_len = len;
-#endif
-  uchar *in;
-  uchar *props = static_cast<uchar *>(MEM_callocN(sizeof(char[16]), "tmp"));
-
-  ptcache_file_read(pf, &compressed, 1, sizeof(uchar));
-  if (compressed) {
-    uint size;
-    ptcache_file_read(pf, &size, 1, sizeof(uint));
-    in_len = size_t(size);
-    if (in_len == 0) {
-      /* do nothing */
-    }
-    else {
-      in = (uchar *)MEM_callocN(sizeof(uchar) * in_len, "pointcache_compressed_buffer");
-      ptcache_file_read(pf, in, in_len, sizeof(uchar));
-#ifdef WITH_LZO
-      if (compressed == 1) {
-        r = lzo1x_decompress_safe(in, (lzo_uint)in_len, result, (lzo_uint *)&out_len, nullptr);
-      }
-#endif
-#ifdef WITH_LZMA
-      if (compressed == 2) {
-        size_t sizeOfIt;
-        size_t leni = in_len, leno = len;
-        ptcache_file_read(pf, &size, 1, sizeof(uint));
-        sizeOfIt = size_t(size);
-        ptcache_file_read(pf, props, sizeOfIt, sizeof(uchar));
-        r = LzmaUncompress(result, &leno, in, &leni, props, sizeOfIt);
-      }
-#endif
-      MEM_freeN(in);
-    }
-  }
-  else {
-    ptcache_file_read(pf, result, len, sizeof(uchar));
-  }
-
-  MEM_freeN(props);
+  /** Uncompressed data, only used when writing. */
+  const uchar *raw = nullptr;
+  uint raw_len = 0;
+  /** Compressed data. */
+  blender::Vector<uchar> data;
+  /** Properties of the LZMA encoder, needed for decoding. */
+  blender::Vector<uchar> props;
+};
 
-  return r;
-}
-static int ptcache_file_compressed_write(
-    PTCacheFile *pf, uchar *in, uint in_len, uchar *out, int mode)
+static void ptcache_block_encode(const uchar *in, uint in_len, int mode, PTCacheBlock &block)
 {
-  int r = 0;
-  uchar compressed = 0;
+  block.compressed = 0;
+  block.raw = in;
+  block.raw_len = in_len;
   size_t out_len = 0;
-  uchar *props = static_cast<uchar *>(MEM_callocN(sizeof(char[16]), "tmp"));
-  size_t sizeOfIt = 5;
 
   (void)mode; /* unused when building w/o compression */
 
 #ifdef WITH_LZO
-  out_len = LZO_OUT_LEN(in_len);
   if (mode == PTCACHE_COMPRESS_LZO) {
     LZO_HEAP_ALLOC(wrkmem, LZO1X_MEM_COMPRESS);
 
-    r = lzo1x_1_compress(in, (lzo_uint)in_len, out, (lzo_uint *)&out_len, wrkmem);
-    if (!(r == LZO_E_OK) || (out_len >= in_len)) {
-      compressed = 0;
-    }
-    else {
-      compressed = 1;
+    /* LZO doesn't check the size of the output buffer, so it has to fit the worst case. */
+    block.data.resize(LZO_OUT_LEN(in_len));
+    out_len = block.data.size();
+    int r = lzo1x_1_compress(
+        in, (lzo_uint)in_len, block.data.data(), (lzo_uint *)&out_len, wrkmem);
+    if ((r == LZO_E_OK) && (out_len < in_len)) {
+      block.compressed = 1;
     }
   }
 #endif
 #ifdef WITH_LZMA
   if (mode == PTCACHE_COMPRESS_LZMA) {
-
-    r = LzmaCompress(out,
-                     &out_len,
-                     in,
-                     in_len, /* Assume `sizeof(char) == 1`. */
-                     props,
-                     &sizeOfIt,
-                     5,
-                     1 << 24,
-                     3,
-                     0,
-                     2,
-                     32,
-                     2);
-
-    if (!(r == SZ_OK) || (out_len >= in_len)) {
-      compressed = 0;
-    }
-    else {
-      compressed = 2;
+    size_t sizeOfIt = 5;
+    block.props.resize(16);
+    block.data.resize(in_len);
+    out_len = block.data.size();
+    int r = LzmaCompress(block.data.data(),
+                         &out_len,
+                         in,
+                         in_len, /* Assume `sizeof(char) == 1`. */
+                         block.props.data(),
+                         &sizeOfIt,
+                         5,
+                         1 << 24,
+                         3,
+                         0,
+                         2,
+                         32,
+                         2);
+    if ((r == SZ_OK) && (out_len < in_len)) {
+      block.compressed = 2;
+      block.props.resize(sizeOfIt);
     }
   }
 #endif
+  if (mode == PTCACHE_COMPRESS_ZSTD) {
+    /* Only compressed data that is smaller than the input is stored. */
+    block.data.resize(in_len);
+    out_len = ZSTD_compress(block.data.data(), in_len, in, in_len, ZSTD_CLEVEL_DEFAULT);
+    if (!ZSTD_isError(out_len) && (out_len < in_len)) {
+      block.compressed = 3;
+    }
+  }
 
-  ptcache_file_write(pf, &compressed, 1, sizeof(uchar));
-  if (compressed) {
-    uint size = out_len;
-    ptcache_file_write(pf, &size, 1, sizeof(uint));
-    ptcache_file_write(pf, out, out_len, sizeof(uchar));
+  if (block.compressed) {
+    block.data.resize(out_len);
   }
   else {
-    ptcache_file_write(pf, in, in_len, sizeof(uchar));
+    block.data.clear_and_shrink();
   }
+}
 
-  if (compressed == 2) {
-    uint size = sizeOfIt;
-    ptcache_file_write(pf, &sizeOfIt, 1, sizeof(uint));
-    ptcache_file_write(pf, props, size, sizeof(uchar));
+static bool ptcache_file_block_write(PTCacheFile *pf, const PTCacheBlock &block)
+{
+  if (!ptcache_file_write(pf, &block.compressed, 1, sizeof(uchar))) {
+    return false;
+  }
+  if (!block.compressed) {
+    return block.raw_len == 0 || ptcache_file_write(pf, block.raw, block.raw_len, sizeof(uchar));
   }
 
-  MEM_freeN(props);
+  uint size = uint(block.data.size());
+  if (!ptcache_file_write(pf, &size, 1, sizeof(uint)) ||
+      !ptcache_file_write(pf, block.data.data(), size, sizeof(uchar)))
+  {
+    return false;
+  }
+  if (block.compressed == 2) {
+    uint props_size = uint(block.props.size());
+    if (!ptcache_file_write(pf, &props_size, 1, sizeof(uint)) ||
+        !ptcache_file_write(pf, block.props.data(), props_size, sizeof(uchar)))
+    {
+      return false;
+    }
+  }
+  return true;
+}
 
+/**
+ * Read a block from the file. Uncompressed data is read directly into \a result, compressed data
+ * is kept in the block to be decoded with #ptcache_block_decode.
+ */
+static bool ptcache_file_block_read(PTCacheFile *pf, uchar *result, uint len, PTCacheBlock &block)
+{
+  if (!ptcache_file_read(pf, &block.compressed, 1, sizeof(uchar))) {
+    return false;
+  }
+  if (!block.compressed) {
+    return len == 0 || ptcache_file_read(pf, result, len, sizeof(uchar));
+  }
+
+  uint size;
+  if (!ptcache_file_read(pf, &size, 1, sizeof(uint))) {
+    return false;
+  }
+  block.data.resize(size);
+  if (size > 0 && !ptcache_file_read(pf, block.data.data(), size, sizeof(uchar))) {
+    return false;
+  }
+  if (block.compressed == 2) {
+    uint props_size;
+    if (!ptcache_file_read(pf, &props_size, 1, sizeof(uint))) {
+      return false;
+    }
+    block.props.resize(props_size);
+    if (!ptcache_file_read(pf, block.props.data(), props_size, sizeof(uchar))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static int ptcache_block_decode(const PTCacheBlock &block, uchar *result, uint len)
+{
+  int r = 0;
+  if (!block.compressed || block.data.is_empty()) {
+    return r;
+  }
+#ifdef WITH_LZO
+  if (block.compressed == 1) {
+    size_t out_len = len;
+    r = lzo1x_decompress_safe(
+        block.data.data(), (lzo_uint)block.data.size(), result, (lzo_uint *)&out_len, nullptr);
+  }
+#endif
+#ifdef WITH_LZMA
+  if (block.compressed == 2) {
+    size_t leni = block.data.size(), leno = len;
+    r = LzmaUncompress(
+        result, &leno, block.data.data(), &leni, block.props.data(), block.props.size());
+  }
+#endif
+  if (block.compressed == 3) {
+    const size_t out_len = ZSTD_decompress(result, len, block.data.data(), block.data.size());
+    r = ZSTD_isError(out_len) || out_len != len;
+  }
   return r;
 }
+
+static int ptcache_file_compressed_read(PTCacheFile *pf, uchar *result, uint len)
+{
+  PTCacheBlock block;
+  if (!ptcache_file_block_read(pf, result, len, block)) {
+    return 1;
+  }
+  return ptcache_block_decode(block, result, len);
+}
+
+static int ptcache_file_compressed_write(PTCacheFile *pf, const uchar *in, uint in_len, int mode)
+{
+  PTCacheBlock block;
+  ptcache_block_encode(in, in_len, mode, block);
+  return !ptcache_file_block_write(pf, block);
+}
+
 static int ptcache_file_read(PTCacheFile *pf, void *f, uint tot, uint size)
 {
   return (fread(f, size, tot, pf->fp) == tot);
@@ -1648,20 +1713,6 @@ static int ptcache_file_data_read(PTCacheFile *pf)
 
   return 1;
 }
-static int ptcache_file_data_write(PTCacheFile *pf)
-{
-  int i;
-
-  for (i = 0; i < BPHYS_TOT_DATA; i++) {
-    if ((pf->data_types & (1 << i)) &&
-        !ptcache_file_write(pf, pf->cur[i], 1, ptcache_data_size[i]))
-    {
-      return 0;
-    }
-  }
-
-  return 1;
-}
 static int ptcache_file_header_begin_read(PTCacheFile *pf)
 {
   uint typeflag = 0;
@@ -1966,12 +2017,29 @@ static PTCacheMem *ptcache_disk_frame_to_mem(PTCacheID *pid, int cfra)
     ptcache_data_alloc(pm);
 
     if (pf->flag & PTCACHE_TYPEFLAG_COMPRESS) {
+      /* Arrays are stored one after another, read them in bulk and decompress them in
+       * parallel. */
+      PTCacheBlock blocks[BPHYS_TOT_DATA];
       for (i = 0; i < BPHYS_TOT_DATA; i++) {
         uint out_len = pm->totpoint * ptcache_data_size[i];
-        if (pf->data_types & (1 << i)) {
-          ptcache_file_compressed_read(pf, (uchar *)(pm->data[i]), out_len);
+        if ((pf->data_types & (1 << i)) &&
+            !ptcache_file_block_read(pf, (uchar *)(pm->data[i]), out_len, blocks[i]))
+        {
+          error = 1;
+          break;
         }
       }
+      if (!error) {
+        blender::threading::parallel_for(
+            blender::IndexRange(BPHYS_TOT_DATA), 1, [&](const blender::IndexRange range) {
+              for (const int64_t type : range) {
+                uint out_len = pm->totpoint * ptcache_data_size[type];
+                if (pf->data_types & (1 << type)) {
+                  ptcache_block_decode(blocks[type], (uchar *)(pm->data[type]), out_len);
+                }
+              }
+            });
+      }
     }
     else {
       void *cur[BPHYS_TOT_DATA];
@@ -2054,38 +2122,31 @@ static int ptcache_mem_frame_to_disk(PTCacheID *pid, PTCacheMem *pm)
     pf->flag |= PTCACHE_TYPEFLAG_EXTRADATA;
   }
 
-  if (pid->cache->compression) {
-    pf->flag |= PTCACHE_TYPEFLAG_COMPRESS;
-  }
+  /* Always store the data as one block per array (which may or may not be compressed), instead
+   * of interleaving the data of all arrays per point. This way every array is read and written
+   * with a single call. The interleaved layout is still supported when reading older files. */
+  pf->flag |= PTCACHE_TYPEFLAG_COMPRESS;
 
   if (!ptcache_file_header_begin_write(pf) || !pid->write_header(pf)) {
     error = 1;
   }
 
   if (!error) {
-    if (pid->cache->compression) {
-      for (i = 0; i < BPHYS_TOT_DATA; i++) {
-        if (pm->data[i]) {
-          uint in_len = pm->totpoint * ptcache_data_size[i];
-          uchar *out = (uchar *)MEM_callocN(LZO_OUT_LEN(in_len) * 4, "pointcache_lzo_buffer");
-          ptcache_file_compressed_write(
-              pf, (uchar *)(pm->data[i]), in_len, out, pid->cache->compression);
-          MEM_freeN(out);
-        }
-      }
-    }
-    else {
-      void *cur[BPHYS_TOT_DATA];
-      BKE_ptcache_mem_pointers_init(pm, cur);
-      ptcache_file_pointers_init(pf);
-
-      for (i = 0; i < pm->totpoint; i++) {
-        ptcache_data_copy(cur, pf->cur);
-        if (!ptcache_file_data_write(pf)) {
-          error = 1;
-          break;
-        }
-        BKE_ptcache_mem_pointers_incr(cur);
+    PTCacheBlock blocks[BPHYS_TOT_DATA];
+    blender::threading::parallel_for(
+        blender::IndexRange(BPHYS_TOT_DATA), 1, [&](const blender::IndexRange range) {
+          for (const int64_t type : range) {
+            if (pm->data[type]) {
+              uint in_len = pm->totpoint * ptcache_data_size[type];
+              ptcache_block_encode(
+                  (const uchar *)(pm->data[type]), in_len, pid->cache->compression, blocks[type]);
+            }
+          }
+        });
+    for (i = 0; i < BPHYS_TOT_DATA; i++) {
+      if (pm->data[i] && !ptcache_file_block_write(pf, blocks[i])) {
+        error = 1;
+        break;
       }
     }
   }
@@ -2101,16 +2162,9 @@ static int ptcache_mem_frame_to_disk(PTCacheID *pid, PTCacheMem *pm)
       ptcache_file_write(pf, &extra->type, 1, sizeof(uint));
       ptcache_file_write(pf, &extra->totdata, 1, sizeof(uint));
 
-      if (pid->cache->compression) {
-        uint in_len = extra->totdata * ptcache_extra_datasize[extra->type];
-        uchar *out = (uchar *)MEM_callocN(LZO_OUT_LEN(in_len) * 4, "pointcache_lzo_buffer");
-        ptcache_file_compressed_write(
-            pf, (uchar *)(extra->data), in_len, out, pid->cache->compression);
-        MEM_freeN(out);
-      }
-      else {
-        ptcache_file_write(pf, extra->data, extra->totdata, ptcache_extra_datasize[extra->type]);
-      }
+      uint in_len = extra->totdata * ptcache_extra_datasize[extra->type];
+      ptcache_file_compressed_write(
+          pf, (const uchar *)(extra->data), in_len, pid->cache->compression);
     }
   }
 
@@ -30,6 +30,7 @@
 #include "BLI_string_ref.hh"
 #include "BLI_task.hh"
 #include "BLI_utildefines.h"
+#include "BLI_vector.hh"
 
 #include "BKE_anim_data.hh"
 #include "BKE_bake_data_block_id.hh"
@@ -134,6 +135,58 @@ void BKE_volumes_init()
 #endif
 }
 
+void BKE_volumes_exit()
+{
+#ifdef WITH_OPENVDB
+  namespace file_cache = blender::bke::volume_grid::file_cache;
+  file_cache::stop_prefetching();
+  const file_cache::CacheStats stats = file_cache::get_stats();
+  CLOG_INFO(&LOG,
+            1,
+            "Grid file cache: %lld hits, %lld misses, %lld evicted, %lld files prefetched",
+            (long long)stats.hits_num,
+            (long long)stats.misses_num,
+            (long long)stats.evicted_grids_num,
+            (long long)stats.prefetched_files_num);
+#endif
+}
+
+void BKE_volumes_file_cache_memory_budget_set(const int64_t budget)
+{
+#ifdef WITH_OPENVDB
+  blender::bke::volume_grid::file_cache::set_memory_budget(budget);
+#else
+  UNUSED_VARS(budget);
+#endif
+}
+
+void BKE_volumes_file_cache_delay_load_set(const bool delay_load)
+{
+#ifdef WITH_OPENVDB
+  blender::bke::volume_grid::file_cache::set_delay_load(delay_load);
+#else
+  UNUSED_VARS(delay_load);
+#endif
+}
+
+bool BKE_volumes_file_cache_delay_load_get()
+{
+#ifdef WITH_OPENVDB
+  return blender::bke::volume_grid::file_cache::get_delay_load();
+#else
+  return false;
+#endif
+}
+
+blender::bke::volume_grid::file_cache::CacheStats BKE_volumes_file_cache_stats_get()
+{
+#ifdef WITH_OPENVDB
+  return blender::bke::volume_grid::file_cache::get_stats();
+#else
+  return {};
+#endif
+}
+
 /* Volume datablock */
 
 static void volume_init_data(ID *id)
@@ -173,6 +226,7 @@ static void volume_copy_data(Main * /*bmain*/,
 #endif
 
   volume_dst->runtime->frame = volume_src->runtime->frame;
+  volume_dst->runtime->scene_frame = volume_src->runtime->scene_frame;
   STRNCPY(volume_dst->runtime->velocity_x_grid, volume_src->runtime->velocity_x_grid);
   STRNCPY(volume_dst->runtime->velocity_y_grid, volume_src->runtime->velocity_y_grid);
   STRNCPY(volume_dst->runtime->velocity_z_grid, volume_src->runtime->velocity_z_grid);
@@ -326,7 +380,11 @@ void *BKE_volume_add(Main *bmain, const char *name)
 
 /* Sequence */
 
-static int volume_sequence_frame(const Depsgraph *depsgraph, const Volume *volume)
+/**
+ * Frame of the sequence file that is used at the given scene frame, taking the sequence mode into
+ * account.
+ */
+static int volume_sequence_frame_at(const Volume *volume, const int scene_frame)
 {
   if (!volume->is_sequence) {
     return 0;
@@ -337,7 +395,6 @@ static int volume_sequence_frame(const Depsgraph *depsgraph, const Volume *volum
     return 0;
   }
 
-  const int scene_frame = DEG_get_ctime(depsgraph);
   const VolumeSequenceMode mode = (VolumeSequenceMode)volume->sequence_mode;
   const int frame_duration = volume->frame_duration;
   const int frame_start = volume->frame_start;
@@ -392,8 +449,16 @@ static int volume_sequence_frame(const Depsgraph *depsgraph, const Volume *volum
   return frame;
 }
 
+static int volume_sequence_frame(const Depsgraph *depsgraph, const Volume *volume)
+{
+  return volume_sequence_frame_at(volume, int(DEG_get_ctime(depsgraph)));
+}
+
 #ifdef WITH_OPENVDB
-static void volume_filepath_get(const Main *bmain, const Volume *volume, char r_filepath[FILE_MAX])
+static void volume_filepath_get(const Main *bmain,
+                                const Volume *volume,
+                                const int frame,
+                                char r_filepath[FILE_MAX])
 {
   BLI_strncpy(r_filepath, volume->filepath, FILE_MAX);
   BLI_path_abs(r_filepath, ID_BLEND_PATH(bmain, &volume->id));
@@ -402,7 +467,7 @@ static void volume_filepath_get(const Main *bmain, const Volume *volume, char r_
   if (volume->is_sequence && BLI_path_frame_get(r_filepath, &path_frame, &path_digits)) {
     char ext[32];
     BLI_path_frame_strip(r_filepath, ext, sizeof(ext));
-    BLI_path_frame(r_filepath, FILE_MAX, volume->runtime->frame, path_digits);
+    BLI_path_frame(r_filepath, FILE_MAX, frame, path_digits);
     BLI_path_extension_ensure(r_filepath, FILE_MAX, ext);
   }
 }
@@ -410,6 +475,33 @@ static void volume_filepath_get(const Main *bmain, const Volume *volume, char r_
 
 /* File Load */
 
+#ifdef WITH_OPENVDB
+/**
+ * Number of upcoming frames of a volume sequence that are loaded in the background.
+ */
+static constexpr int volume_sequence_prefetch_frames_num = 3;
+
+static void volume_sequence_prefetch(const Main *bmain, const Volume *volume)
+{
+  /* Map the upcoming scene frames to files, so that e.g. ping-pong sequences prefetch the files
+   * that are played backwards and extended sequences don't prefetch anything past their end. */
+  blender::Vector<int, volume_sequence_prefetch_frames_num> frames;
+  for (int i = 1; i <= volume_sequence_prefetch_frames_num; i++) {
+    const int frame = volume_sequence_frame_at(volume, volume->runtime->scene_frame + i);
+    if (frame != VOLUME_FRAME_NONE && frame != volume->runtime->frame && !frames.contains(frame)) {
+      frames.append(frame);
+    }
+  }
+  for (const int frame : frames) {
+    char filepath[FILE_MAX];
+    volume_filepath_get(bmain, volume, frame, filepath);
+    if (BLI_exists(filepath)) {
+      blender::bke::volume_grid::file_cache::prefetch_grids_from_file(filepath);
+    }
+  }
+}
+#endif
+
 bool BKE_volume_is_loaded(const Volume *volume)
 {
 #ifdef WITH_OPENVDB
@@ -493,7 +585,7 @@ bool BKE_volume_load(const Volume *volume, const Main *bmain)
   /* Get absolute file path at current frame. */
   const char *volume_name = volume->id.name + 2;
   char filepath[FILE_MAX];
-  volume_filepath_get(bmain, volume, filepath);
+  volume_filepath_get(bmain, volume, volume->runtime->frame, filepath);
 
   CLOG_INFO(&LOG, 1, "Volume %s: load %s", volume_name, filepath);
 
@@ -530,6 +622,12 @@ bool BKE_volume_load(const Volume *volume, const Main *bmain)
 
   STRNCPY(grids.filepath, filepath);
 
+  /* Read the next frames of the sequence in the background, so that playback does not have to
+   * wait for the files to be loaded. */
+  if (volume->is_sequence) {
+    volume_sequence_prefetch(bmain, volume);
+  }
+
   return grids.error_msg.empty();
 #else
   UNUSED_VARS(bmain, volume);
@@ -606,9 +704,7 @@ std::optional<blender::Bounds<blender::float3>> BKE_volume_min_max(const Volume
     std::optional<blender::Bounds<blender::float3>> result;
     for (const int i : IndexRange(BKE_volume_num_grids(volume))) {
       const blender::bke::VolumeGridData *volume_grid = BKE_volume_grid_get(volume, i);
-      blender::bke::VolumeTreeAccessToken tree_token;
-      result = blender::bounds::merge(result,
-                                      BKE_volume_grid_bounds(volume_grid->grid_ptr(tree_token)));
+      result = blender::bounds::merge(result, volume_grid->bounds());
     }
     return result;
   }
@@ -721,6 +817,7 @@ void BKE_volume_eval_geometry(Depsgraph *depsgraph, Volume *volume)
 
   /* TODO: can we avoid modifier re-evaluation when frame did not change? */
   int frame = volume_sequence_frame(depsgraph, volume);
+  volume->runtime->scene_frame = int(DEG_get_ctime(depsgraph));
   if (frame != volume->runtime->frame) {
     BKE_volume_unload(volume);
     volume->runtime->frame = frame;
@@ -733,6 +830,7 @@ void BKE_volume_eval_geometry(Depsgraph *depsgraph, Volume *volume)
       BKE_volume_unload(volume_orig);
       volume_orig->runtime->frame = volume->runtime->frame;
     }
+    volume_orig->runtime->scene_frame = volume->runtime->scene_frame;
   }
 }
 
@@ -1044,19 +1142,6 @@ float BKE_volume_simplify_factor(const Depsgraph *depsgraph)
 
 #ifdef WITH_OPENVDB
 
-std::optional<blender::Bounds<float3>> BKE_volume_grid_bounds(openvdb::GridBase::ConstPtr grid)
-{
-  /* TODO: we can get this from grid metadata in some cases? */
-  openvdb::CoordBBox coordbbox;
-  if (!grid->baseTree().evalLeafBoundingBox(coordbbox)) {
-    return std::nullopt;
-  }
-
-  openvdb::BBoxd bbox = grid->transform().indexToWorld(coordbbox);
-
-  return blender::Bounds<float3>{float3(bbox.min().asPointer()), float3(bbox.max().asPointer())};
-}
-
 openvdb::GridBase::ConstPtr BKE_volume_grid_shallow_transform(openvdb::GridBase::ConstPtr grid,
                                                               const blender::float4x4 &transform)
 {
@@ -198,6 +198,50 @@ openvdb::GridClass VolumeGridData::grid_class() const
   return grid_->getGridClass();
 }
 
+/**
+ * Align the bounds of active voxels to the leaf nodes and transform them to object space.
+ *
+ * Files only store the bounds of the active voxels, but not of the leaf nodes which may contain
+ * inactive voxels only (as used by #evalLeafBoundingBox). Computing the bounds from the active
+ * voxels in both cases makes the result independent of whether the tree is loaded.
+ */
+static std::optional<Bounds<float3>> leaf_aligned_bounds(const openvdb::GridBase &grid,
+                                                         const openvdb::CoordBBox &voxel_bbox)
+{
+  if (voxel_bbox.empty()) {
+    return std::nullopt;
+  }
+  const int leaf_dim = openvdb::FloatTree::LeafNodeType::DIM;
+  const openvdb::CoordBBox coordbbox(
+      voxel_bbox.min() & ~(leaf_dim - 1),
+      (voxel_bbox.max() & ~(leaf_dim - 1)).offsetBy(leaf_dim - 1));
+  const openvdb::BBoxd bbox = grid.transform().indexToWorld(coordbbox);
+  return Bounds<float3>{float3(bbox.min().asPointer()), float3(bbox.max().asPointer())};
+}
+
+std::optional<Bounds<float3>> VolumeGridData::bounds() const
+{
+  std::lock_guard lock{mutex_};
+  if (!tree_loaded_ && meta_data_loaded_ && transform_loaded_) {
+    const openvdb::Vec3IMetadata::ConstPtr min_meta = grid_->getMetadata<openvdb::Vec3IMetadata>(
+        openvdb::GridBase::META_FILE_BBOX_MIN);
+    const openvdb::Vec3IMetadata::ConstPtr max_meta = grid_->getMetadata<openvdb::Vec3IMetadata>(
+        openvdb::GridBase::META_FILE_BBOX_MAX);
+    if (min_meta && max_meta) {
+      return leaf_aligned_bounds(
+          *grid_, openvdb::CoordBBox(openvdb::Coord(min_meta->value()),
+                                     openvdb::Coord(max_meta->value())));
+    }
+  }
+  /* Only the topology of the tree is needed here, the leaf buffers are not accessed. */
+  this->ensure_grid_loaded();
+  openvdb::CoordBBox voxel_bbox;
+  if (!grid_->baseTree().evalActiveVoxelBoundingBox(voxel_bbox)) {
+    return std::nullopt;
+  }
+  return leaf_aligned_bounds(*grid_, voxel_bbox);
+}
+
 bool VolumeGridData::is_reloadable() const
 {
   return bool(lazy_load_grid_);
@@ -8,11 +8,39 @@
 #  include "BKE_volume_openvdb.hh"
 
 #  include "BLI_map.hh"
+#  include "BLI_set.hh"
+#  include "BLI_system.h"
+#  include "BLI_task.h"
+
+#  include "CLG_log.h"
+
+#  include <algorithm>
+#  include <atomic>
 
 #  include <openvdb/openvdb.h>
 
+static CLG_LogRef LOG = {"bke.volume_grid_file_cache"};
+
 namespace blender::bke::volume_grid::file_cache {
 
+/**
+ * A grid at a specific simplify level.
+ */
+struct CachedGrid {
+  GVolumeGrid grid;
+  /**
+   * Memory used by the grid once its tree is loaded, zero before that. This is set by the lazy
+   * load function of the grid, so that the cache does not have to lock the grid to find out
+   * whether the tree is loaded. It's shared because the grid may outlive the cache entry. Changes
+   * are added to #GlobalCache::memory_usage as well.
+   */
+  std::shared_ptr<std::atomic<int64_t>> tree_memory;
+  /**
+   * Value of #GlobalCache::use_clock when the grid was requested last.
+   */
+  uint64_t last_use = 0;
+};
+
 /**
  * Cache for a single grid stored in a file.
  */
@@ -25,7 +53,7 @@ struct GridCache {
   /**
    * Cached simplify levels.
    */
-  Map<int, GVolumeGrid> grid_by_simplify_level;
+  Map<int, CachedGrid> grid_by_simplify_level;
 };
 
 /**
@@ -62,6 +90,37 @@ struct FileCache {
 struct GlobalCache {
   std::mutex mutex;
   Map<std::string, FileCache> file_map;
+  /**
+   * Maximum memory used by loaded trees before unused grids are removed. Zero means no limit.
+   */
+  int64_t memory_budget = int64_t(BLI_system_memory_max_in_megabytes()) * 1024 * 1024 / 2;
+  /**
+   * Sum of #CachedGrid::tree_memory of all cached grids. It's updated by the lazy load functions
+   * of the grids without locking the cache, so that checking the budget does not have to iterate
+   * over all grids.
+   */
+  std::atomic<int64_t> memory_usage = 0;
+  /**
+   * Read leaf buffers from the file only when they are accessed, see #set_delay_load.
+   */
+  std::atomic<bool> delay_load = false;
+  /**
+   * Increased every time a grid is requested, used to find the least recently used grids.
+   */
+  uint64_t use_clock = 0;
+  /**
+   * Pool for loading files in the background, created when it's first needed.
+   */
+  TaskPool *prefetch_pool = nullptr;
+  /**
+   * Files that are queued or currently loaded in the background.
+   */
+  Set<std::string> prefetch_pending;
+
+  int64_t hits_num = 0;
+  int64_t misses_num = 0;
+  int64_t evicted_grids_num = 0;
+  int64_t prefetched_files_num = 0;
 };
 
 /**
@@ -130,9 +189,9 @@ static FileCache &get_file_cache(const StringRef file_path)
 static openvdb::GridBase::Ptr load_single_grid_from_disk(const StringRef file_path,
                                                          const StringRef grid_name)
 {
-  /* Disable delay loading and file copying, this has poor performance
-   * on network drivers. */
-  const bool delay_load = false;
+  /* File copying is disabled, because it has poor performance on network drives. Without it,
+   * delay loaded leaf buffers are read from the original file. */
+  const bool delay_load = get_global_cache().delay_load.load(std::memory_order_relaxed);
 
   openvdb::io::File file(file_path);
   file.setCopyMaxBytes(0);
@@ -140,31 +199,55 @@ static openvdb::GridBase::Ptr load_single_grid_from_disk(const StringRef file_pa
   return file.readGrid(grid_name);
 }
 
+/**
+ * Update the memory used by a loaded tree and the total memory usage of the cache.
+ */
+static void set_tree_memory(std::atomic<int64_t> &tree_memory, const int64_t memory)
+{
+  const int64_t old_memory = tree_memory.exchange(memory, std::memory_order_relaxed);
+  get_global_cache().memory_usage.fetch_add(memory - old_memory, std::memory_order_relaxed);
+}
+
 /**
  * Checks if there is already a cached grid for the parameters and creates it otherwise. This does
  * not load the tree, because that is done on-demand.
  */
-static GVolumeGrid get_cached_grid(const StringRef file_path,
-                                   GridCache &grid_cache,
-                                   const int simplify_level)
+static const CachedGrid &get_cached_grid(const StringRef file_path,
+                                         GridCache &grid_cache,
+                                         const int simplify_level)
 {
-  if (GVolumeGrid *grid = grid_cache.grid_by_simplify_level.lookup_ptr(simplify_level)) {
-    return *grid;
+  GlobalCache &global_cache = get_global_cache();
+  if (CachedGrid *cached_grid = grid_cache.grid_by_simplify_level.lookup_ptr(simplify_level)) {
+    cached_grid->last_use = ++global_cache.use_clock;
+    global_cache.hits_num++;
+    return *cached_grid;
   }
+  global_cache.misses_num++;
+  auto tree_memory = std::make_shared<std::atomic<int64_t>>(0);
   /* A callback that actually loads the full grid including the tree when it's accessed. */
   auto load_grid_fn = [file_path = std::string(file_path),
                        grid_name = std::string(grid_cache.meta_data_grid->getName()),
-                       simplify_level]() {
+                       simplify_level,
+                       tree_memory]() {
+    openvdb::GridBase::Ptr grid;
     if (simplify_level == 0) {
-      return load_single_grid_from_disk(file_path, grid_name);
+      grid = load_single_grid_from_disk(file_path, grid_name);
+    }
+    else {
+      /* Build the simplified grid from the main grid. */
+      const GVolumeGrid main_grid = get_grid_from_file(file_path, grid_name, 0);
+      const VolumeGridType grid_type = main_grid->grid_type();
+      const float resolution_factor = 1.0f / (1 << simplify_level);
+      VolumeTreeAccessToken tree_token;
+      grid = BKE_volume_grid_create_with_changed_resolution(
+          grid_type, main_grid->grid(tree_token), resolution_factor);
+    }
+    if (grid) {
+      /* With delay loading, only the resident leaf buffers are counted. Leaf buffers that are
+       * read from the file later on access are not, unless they are read by prefetching. */
+      set_tree_memory(*tree_memory, int64_t(grid->memUsage()));
     }
-    /* Build the simplified grid from the main grid. */
-    const GVolumeGrid main_grid = get_grid_from_file(file_path, grid_name, 0);
-    const VolumeGridType grid_type = main_grid->grid_type();
-    const float resolution_factor = 1.0f / (1 << simplify_level);
-    VolumeTreeAccessToken tree_token;
-    return BKE_volume_grid_create_with_changed_resolution(
-        grid_type, main_grid->grid(tree_token), resolution_factor);
+    return grid;
   };
   /* This allows the returned grid to already contain meta-data and transforms, even if the tree is
    * not loaded yet. */
@@ -176,9 +259,85 @@ static GVolumeGrid get_cached_grid(const StringRef file_path,
   }
   VolumeGridData *grid_data = MEM_new<VolumeGridData>(
       __func__, load_grid_fn, meta_data_and_transform_grid);
-  GVolumeGrid grid{grid_data};
-  grid_cache.grid_by_simplify_level.add(simplify_level, grid);
-  return grid;
+  grid_cache.grid_by_simplify_level.add_new(
+      simplify_level,
+      CachedGrid{GVolumeGrid(grid_data), std::move(tree_memory), ++global_cache.use_clock});
+  return grid_cache.grid_by_simplify_level.lookup(simplify_level);
+}
+
+/**
+ * Remove the cached grid from the cache and from the total memory usage.
+ */
+static void remove_cached_grid(GlobalCache &global_cache,
+                               GridCache &grid_cache,
+                               const int simplify_level)
+{
+  const CachedGrid cached_grid = grid_cache.grid_by_simplify_level.pop(simplify_level);
+  global_cache.memory_usage.fetch_sub(cached_grid.tree_memory->exchange(0),
+                                      std::memory_order_relaxed);
+}
+
+/**
+ * Remove the least recently used grids that are not referenced outside of the cache until the
+ * memory used by loaded trees fits into the budget again.
+ *
+ * The memory of trees that have been unloaded with #VolumeGridData::unload_tree_if_possible is
+ * still counted, because checking that would require locking every grid. This only makes the
+ * eviction a bit too eager.
+ */
+static void enforce_memory_budget(GlobalCache &global_cache)
+{
+  /* Assumes that the cache is locked already. */
+  BLI_assert(!global_cache.mutex.try_lock());
+  if (global_cache.memory_budget <= 0 ||
+      global_cache.memory_usage.load(std::memory_order_relaxed) <= global_cache.memory_budget)
+  {
+    return;
+  }
+
+  struct EvictionCandidate {
+    GridCache *grid_cache;
+    int simplify_level;
+    uint64_t last_use;
+  };
+  Vector<EvictionCandidate> candidates;
+  for (FileCache &file_cache : global_cache.file_map.values()) {
+    for (GridCache &grid_cache : file_cache.grids) {
+      for (const auto item : grid_cache.grid_by_simplify_level.items()) {
+        if (item.value.tree_memory->load(std::memory_order_relaxed) > 0 &&
+            item.value.grid->is_mutable())
+        {
+          candidates.append({&grid_cache, item.key, item.value.last_use});
+        }
+      }
+    }
+  }
+
+  std::sort(candidates.begin(),
+            candidates.end(),
+            [](const EvictionCandidate &a, const EvictionCandidate &b) {
+              return a.last_use < b.last_use;
+            });
+  int64_t evicted_num = 0;
+  for (const EvictionCandidate &candidate : candidates) {
+    if (global_cache.memory_usage.load(std::memory_order_relaxed) <= global_cache.memory_budget) {
+      break;
+    }
+    remove_cached_grid(global_cache, *candidate.grid_cache, candidate.simplify_level);
+    evicted_num++;
+  }
+  if (evicted_num == 0) {
+    /* All loaded grids are in use. */
+    return;
+  }
+  global_cache.evicted_grids_num += evicted_num;
+  const int64_t memory_usage = global_cache.memory_usage.load(std::memory_order_relaxed);
+  CLOG_INFO(&LOG,
+            1,
+            "Evicted %lld grids, %lld MB of %lld MB used",
+            (long long)evicted_num,
+            (long long)(memory_usage / (1024 * 1024)),
+            (long long)(global_cache.memory_budget / (1024 * 1024)));
 }
 
 GVolumeGrid get_grid_from_file(const StringRef file_path,
@@ -187,9 +346,10 @@ GVolumeGrid get_grid_from_file(const StringRef file_path,
 {
   GlobalCache &global_cache = get_global_cache();
   std::lock_guard lock{global_cache.mutex};
+  enforce_memory_budget(global_cache);
   FileCache &file_cache = get_file_cache(file_path);
   if (GridCache *grid_cache = file_cache.grid_cache_by_name(grid_name)) {
-    return get_cached_grid(file_path, *grid_cache, simplify_level);
+    return get_cached_grid(file_path, *grid_cache, simplify_level).grid;
   }
   return {};
 }
@@ -199,6 +359,7 @@ GridsFromFile get_all_grids_from_file(const StringRef file_path, const int simpl
   GridsFromFile result;
   GlobalCache &global_cache = get_global_cache();
   std::lock_guard lock{global_cache.mutex};
+  enforce_memory_budget(global_cache);
   FileCache &file_cache = get_file_cache(file_path);
 
   if (!file_cache.error_message.empty()) {
@@ -207,21 +368,150 @@ GridsFromFile get_all_grids_from_file(const StringRef file_path, const int simpl
   }
   result.file_meta_data = std::make_shared<openvdb::MetaMap>(file_cache.meta_data);
   for (GridCache &grid_cache : file_cache.grids) {
-    result.grids.append(get_cached_grid(file_path, grid_cache, simplify_level));
+    result.grids.append(get_cached_grid(file_path, grid_cache, simplify_level).grid);
   }
   return result;
 }
 
+struct PrefetchTask {
+  std::string file_path;
+  int simplify_level;
+};
+
+static void prefetch_task_run(TaskPool *__restrict pool, void *taskdata)
+{
+  const PrefetchTask &task = *static_cast<const PrefetchTask *>(taskdata);
+  GlobalCache &global_cache = get_global_cache();
+  if (!BLI_task_pool_current_canceled(pool)) {
+    /* Copies keep the grids referenced, so that they are not evicted while they are loaded. */
+    Vector<CachedGrid> cached_grids;
+    {
+      std::lock_guard lock{global_cache.mutex};
+      enforce_memory_budget(global_cache);
+      FileCache &file_cache = get_file_cache(task.file_path);
+      for (GridCache &grid_cache : file_cache.grids) {
+        cached_grids.append(get_cached_grid(task.file_path, grid_cache, task.simplify_level));
+      }
+    }
+    for (const CachedGrid &cached_grid : cached_grids) {
+      if (BLI_task_pool_current_canceled(pool)) {
+        break;
+      }
+      /* Accessing the grid loads the tree. With delay loading, that's only the topology, so the
+       * leaf buffers are read explicitly. */
+      VolumeTreeAccessToken tree_token;
+      const openvdb::GridBase &vdb_grid = cached_grid.grid->grid(tree_token);
+      vdb_grid.baseTree().readNonresidentBuffers();
+      set_tree_memory(*cached_grid.tree_memory, int64_t(vdb_grid.memUsage()));
+    }
+  }
+  std::lock_guard lock{global_cache.mutex};
+  global_cache.prefetch_pending.remove(task.file_path);
+  global_cache.prefetched_files_num++;
+}
+
+static void prefetch_task_free(TaskPool *__restrict /*pool*/, void *taskdata)
+{
+  MEM_delete(static_cast<PrefetchTask *>(taskdata));
+}
+
+void prefetch_grids_from_file(const StringRef file_path, const int simplify_level)
+{
+  GlobalCache &global_cache = get_global_cache();
+  std::lock_guard lock{global_cache.mutex};
+  if (global_cache.prefetch_pending.contains_as(file_path)) {
+    return;
+  }
+  if (global_cache.memory_budget > 0 &&
+      global_cache.memory_usage.load(std::memory_order_relaxed) >= global_cache.memory_budget)
+  {
+    return;
+  }
+  global_cache.prefetch_pending.add_as(file_path);
+  if (global_cache.prefetch_pool == nullptr) {
+    global_cache.prefetch_pool = BLI_task_pool_create_background(nullptr, TASK_PRIORITY_LOW);
+  }
+  BLI_task_pool_push(global_cache.prefetch_pool,
+                     prefetch_task_run,
+                     MEM_new<PrefetchTask>(__func__, PrefetchTask{file_path, simplify_level}),
+                     true,
+                     prefetch_task_free);
+}
+
+void stop_prefetching()
+{
+  GlobalCache &global_cache = get_global_cache();
+  TaskPool *pool;
+  {
+    std::lock_guard lock{global_cache.mutex};
+    pool = global_cache.prefetch_pool;
+    global_cache.prefetch_pool = nullptr;
+  }
+  if (pool == nullptr) {
+    return;
+  }
+  /* The cache must not be locked here, because the running tasks need it to finish. */
+  BLI_task_pool_cancel(pool);
+  BLI_task_pool_free(pool);
+}
+
 void unload_unused()
 {
   GlobalCache &global_cache = get_global_cache();
   std::lock_guard lock{global_cache.mutex};
   for (FileCache &file_cache : global_cache.file_map.values()) {
     for (GridCache &grid_cache : file_cache.grids) {
-      grid_cache.grid_by_simplify_level.remove_if(
-          [&](const auto &item) { return item.value->is_mutable(); });
+      Vector<int> unused_simplify_levels;
+      for (const auto item : grid_cache.grid_by_simplify_level.items()) {
+        if (item.value.grid->is_mutable()) {
+          unused_simplify_levels.append(item.key);
+        }
+      }
+      for (const int simplify_level : unused_simplify_levels) {
+        remove_cached_grid(global_cache, grid_cache, simplify_level);
+      }
+    }
+  }
+}
+
+void set_memory_budget(const int64_t budget)
+{
+  GlobalCache &global_cache = get_global_cache();
+  std::lock_guard lock{global_cache.mutex};
+  global_cache.memory_budget = std::max<int64_t>(budget, 0);
+  enforce_memory_budget(global_cache);
+}
+
+void set_delay_load(const bool delay_load)
+{
+  get_global_cache().delay_load.store(delay_load, std::memory_order_relaxed);
+}
+
+bool get_delay_load()
+{
+  return get_global_cache().delay_load.load(std::memory_order_relaxed);
+}
+
+CacheStats get_stats()
+{
+  GlobalCache &global_cache = get_global_cache();
+  std::lock_guard lock{global_cache.mutex};
+  CacheStats stats;
+  stats.memory_budget = global_cache.memory_budget;
+  stats.memory_usage = global_cache.memory_usage.load(std::memory_order_relaxed);
+  for (const FileCache &file_cache : global_cache.file_map.values()) {
+    for (const GridCache &grid_cache : file_cache.grids) {
+      for (const CachedGrid &cached_grid : grid_cache.grid_by_simplify_level.values()) {
+        stats.cached_grids_num++;
+        stats.loaded_grids_num += cached_grid.tree_memory->load(std::memory_order_relaxed) > 0;
+      }
     }
   }
+  stats.hits_num = global_cache.hits_num;
+  stats.misses_num = global_cache.misses_num;
+  stats.evicted_grids_num = global_cache.evicted_grids_num;
+  stats.prefetched_files_num = global_cache.prefetched_files_num;
+  return stats;
 }
 
 }  // namespace blender::bke::volume_grid::file_cache
@@ -90,6 +90,8 @@ enum {
 };
 #define BVH_RAYCAST_DEFAULT (BVH_RAYCAST_WATERTIGHT)
 #define BVH_RAYCAST_DIST_MAX (FLT_MAX / 2.0f)
+/** Number of rays or points traversed together by the packet queries. */
+#define BVH_RAYCAST_PACKET_SIZE 8
 
 /**
  * Callback must update nearest in case it finds a nearest result.
@@ -221,6 +223,20 @@ int BLI_bvhtree_find_nearest(const BVHTree *tree,
                              BVHTree_NearestPointCallback callback,
                              void *userdata);
 
+/**
+ * Find the nearest node for many points at once, the points are traversed through the tree in
+ * packets of #BVH_RAYCAST_PACKET_SIZE. Results are best when nearby points are next to each other.
+ *
+ * \param nearest: Array of \a points_num results, `dist_sq` has to be initialized
+ * like the nearest passed to #BLI_bvhtree_find_nearest.
+ */
+void BLI_bvhtree_find_nearest_packet(const BVHTree *tree,
+                                     const float (*co)[3],
+                                     int points_num,
+                                     BVHTreeNearest *nearest,
+                                     BVHTree_NearestPointCallback callback,
+                                     void *userdata);
+
 /**
  * Find the first node nearby.
  * Favors speed over quality since it doesn't find the best target node.
@@ -272,6 +288,25 @@ void BLI_bvhtree_ray_cast_all(const BVHTree *tree,
                               BVHTree_RayCastCallback callback,
                               void *userdata);
 
+/**
+ * Cast many rays at once, the rays are traversed through the tree in packets of
+ * #BVH_RAYCAST_PACKET_SIZE, which is faster than #BLI_bvhtree_ray_cast_ex for coherent rays
+ * (rays with nearby origins and similar directions, e.g. from neighboring points).
+ *
+ * \param hits: Array of \a rays_num hits, the index and distance have to be initialized
+ * like the hit passed to #BLI_bvhtree_ray_cast_ex.
+ * \note Rays with a non-zero \a radius are cast one by one.
+ */
+void BLI_bvhtree_ray_cast_packet(const BVHTree *tree,
+                                 const float (*co)[3],
+                                 const float (*dir)[3],
+                                 int rays_num,
+                                 float radius,
+                                 BVHTreeRayHit *hits,
+                                 BVHTree_RayCastCallback callback,
+                                 void *userdata,
+                                 int flag);
+
 float BLI_bvhtree_bb_raycast(const float bv[6],
                              const float light_start[3],
                              const float light_end[3],
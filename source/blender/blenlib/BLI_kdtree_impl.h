@@ -62,6 +62,22 @@ void BLI_kdtree_nd_(range_search_cb)(
     bool (*search_cb)(void *user_data, int index, const float co[KD_DIMS], float dist_sq),
     void *user_data);
 
+/**
+ * Batch versions of the queries above that process many coordinates on multiple threads.
+ */
+void BLI_kdtree_nd_(find_nearest_batch)(const KDTree *tree,
+                                        const float (*co)[KD_DIMS],
+                                        uint co_len,
+                                        KDTreeNearest *r_nearest) ATTR_NONNULL(1);
+void BLI_kdtree_nd_(range_search_batch_cb)(
+    const KDTree *tree,
+    const float (*co)[KD_DIMS],
+    uint co_len,
+    float range,
+    bool (*search_cb)(
+        void *user_data, int query_index, int index, const float co[KD_DIMS], float dist_sq),
+    void *user_data) ATTR_NONNULL(1, 5);
+
 int BLI_kdtree_nd_(calc_duplicates_fast)(const KDTree *tree,
                                          float range,
                                          bool use_index_order,
@@ -111,6 +127,29 @@ inline void BLI_kdtree_nd_(range_search_cb_cpp)(const KDTree *tree,
       const_cast<Fn *>(&fn));
 }
 
+template<typename Fn>
+inline void BLI_kdtree_nd_(range_search_batch_cb_cpp)(const KDTree *tree,
+                                                      const float (*co)[KD_DIMS],
+                                                      const uint co_len,
+                                                      float distance,
+                                                      const Fn &fn)
+{
+  BLI_kdtree_nd_(range_search_batch_cb)(
+      tree,
+      co,
+      co_len,
+      distance,
+      [](void *user_data,
+         const int query_index,
+         const int index,
+         const float *co,
+         const float dist_sq) {
+        const Fn &fn = *static_cast<const Fn *>(user_data);
+        return fn(query_index, index, co, dist_sq);
+      },
+      const_cast<Fn *>(&fn));
+}
+
 template<typename Fn>
 inline int BLI_kdtree_nd_(find_nearest_cb_cpp)(const KDTree *tree,
                                                const float co[KD_DIMS],
@@ -28,6 +28,7 @@
 #include "BLI_alloca.h"
 #include "BLI_heap_simple.h"
 #include "BLI_kdopbvh.h"
+#include "BLI_math_bits.h"
 #include "BLI_math_geom.h"
 #include "BLI_stack.h"
 #include "BLI_task.h"
@@ -400,6 +401,70 @@ static void refit_kdop_hull(const BVHTree *tree, BVHNode *node, int start, int e
   }
 }
 
+/* Ranges of leafs larger than this have their hull computed in parallel,
+ * this only happens for the few branches on the top levels of the tree. */
+#define KDOPBVH_REFIT_PARALLEL_LEAF_THRESHOLD 65536
+#define KDOPBVH_REFIT_BLOCK_SIZE 4096
+
+typedef struct BVHRefitHullData {
+  const BVHTree *tree;
+  int start;
+  int end;
+} BVHRefitHullData;
+
+static void refit_kdop_hull_join(const BVHTree *tree, float *__restrict bv, const float *bv_other)
+{
+  axis_t axis_iter;
+  for (axis_iter = tree->start_axis; axis_iter < tree->stop_axis; axis_iter++) {
+    bv[(2 * axis_iter)] = min_ff(bv[(2 * axis_iter)], bv_other[(2 * axis_iter)]);
+    bv[(2 * axis_iter) + 1] = max_ff(bv[(2 * axis_iter) + 1], bv_other[(2 * axis_iter) + 1]);
+  }
+}
+
+static void refit_kdop_hull_task_cb(void *__restrict userdata,
+                                    const int block,
+                                    const TaskParallelTLS *__restrict tls)
+{
+  const BVHRefitHullData *data = userdata;
+  float *bv = tls->userdata_chunk;
+  const int start = data->start + block * KDOPBVH_REFIT_BLOCK_SIZE;
+  const int end = min_ii(start + KDOPBVH_REFIT_BLOCK_SIZE, data->end);
+
+  for (int j = start; j < end; j++) {
+    refit_kdop_hull_join(data->tree, bv, data->tree->nodes[j]->bv);
+  }
+}
+
+static void refit_kdop_hull_reduce(const void *__restrict userdata,
+                                   void *__restrict chunk_join,
+                                   void *__restrict chunk)
+{
+  const BVHRefitHullData *data = userdata;
+  refit_kdop_hull_join(data->tree, chunk_join, chunk);
+}
+
+/**
+ * Same as #refit_kdop_hull, splitting the leafs in blocks that are joined in parallel.
+ */
+static void refit_kdop_hull_parallel(const BVHTree *tree, BVHNode *node, int start, int end)
+{
+  BVHRefitHullData data = {
+      .tree = tree,
+      .start = start,
+      .end = end,
+  };
+  const int blocks_num = (end - start + KDOPBVH_REFIT_BLOCK_SIZE - 1) / KDOPBVH_REFIT_BLOCK_SIZE;
+
+  node_minmax_init(tree, node);
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.userdata_chunk = node->bv;
+  settings.userdata_chunk_size = sizeof(float) * tree->axis;
+  settings.func_reduce = refit_kdop_hull_reduce;
+  BLI_task_parallel_range(0, blocks_num, &data, refit_kdop_hull_task_cb, &settings);
+}
+
 /**
  * Only supports x,y,z axis in the moment
  * but we should use a plain and simple function here for speed sake.
@@ -713,7 +778,12 @@ static void non_recursive_bvh_div_nodes_task_cb(void *__restrict userdata,
 
   /* This calculates the bounding box of this branch
    * and chooses the largest axis as the axis to divide leafs */
-  refit_kdop_hull(data->tree, parent, parent_leafs_begin, parent_leafs_end);
+  if (parent_leafs_end - parent_leafs_begin > KDOPBVH_REFIT_PARALLEL_LEAF_THRESHOLD) {
+    refit_kdop_hull_parallel(data->tree, parent, parent_leafs_begin, parent_leafs_end);
+  }
+  else {
+    refit_kdop_hull(data->tree, parent, parent_leafs_begin, parent_leafs_end);
+  }
   split_axis = get_largest_axis(parent->bv);
 
   /* Save split axis (this can be used on ray-tracing to speedup the query time) */
@@ -1714,6 +1784,125 @@ int BLI_bvhtree_find_nearest(const BVHTree *tree,
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name BLI_bvhtree_find_nearest_packet
+ *
+ * Same as #BLI_bvhtree_ray_cast_packet for nearest point queries,
+ * the points are traversed in packets of #BVH_RAYCAST_PACKET_SIZE.
+ *
+ * \{ */
+
+typedef struct BVHNearestPacketData {
+  const BVHTree *tree;
+
+  BVHTree_NearestPointCallback callback;
+  void *userdata;
+
+  int points_num;
+  const float (*co)[3];
+
+  float proj[3][BVH_RAYCAST_PACKET_SIZE];
+  /** Copy of `nearest[i].dist_sq`, unused lanes are set to -FLT_MAX so they are never tested. */
+  float dist_sq[BVH_RAYCAST_PACKET_SIZE];
+
+  BVHTreeNearest *nearest;
+} BVHNearestPacketData;
+
+/**
+ * Returns the bit mask of the points for which the bounding box of the node
+ * is closer than their current nearest result.
+ */
+static uint nearest_packet_test(const BVHNearestPacketData *data, const float bv[6])
+{
+  uint mask = 0;
+  for (int i = 0; i < BVH_RAYCAST_PACKET_SIZE; i++) {
+    const float dx = data->proj[0][i] - clamp_f(data->proj[0][i], bv[0], bv[1]);
+    const float dy = data->proj[1][i] - clamp_f(data->proj[1][i], bv[2], bv[3]);
+    const float dz = data->proj[2][i] - clamp_f(data->proj[2][i], bv[4], bv[5]);
+    const float dist_sq = dx * dx + dy * dy + dz * dz;
+    mask |= (uint)(dist_sq < data->dist_sq[i]) << i;
+  }
+  return mask;
+}
+
+static void dfs_find_nearest_packet(BVHNearestPacketData *data, BVHNode *node, uint mask)
+{
+  mask &= nearest_packet_test(data, node->bv);
+  if (mask == 0) {
+    return;
+  }
+
+  if (node->node_num == 0) {
+    for (int i = 0; i < data->points_num; i++) {
+      if ((mask & (1u << i)) == 0) {
+        continue;
+      }
+      BVHTreeNearest *nearest = &data->nearest[i];
+      if (data->callback) {
+        data->callback(data->userdata, node->index, data->co[i], nearest);
+      }
+      else {
+        const float proj[3] = {data->proj[0][i], data->proj[1][i], data->proj[2][i]};
+        nearest->index = node->index;
+        nearest->dist_sq = calc_nearest_point_squared(proj, node, nearest->co);
+      }
+      data->dist_sq[i] = nearest->dist_sq;
+    }
+  }
+  else {
+    /* Same heuristic as #dfs_find_nearest_dfs, using the first active point of the packet. */
+    const int lead = (int)bitscan_forward_uint(mask);
+    if (data->proj[node->main_axis][lead] <= node->children[0]->bv[node->main_axis * 2 + 1]) {
+      for (int i = 0; i != node->node_num; i++) {
+        dfs_find_nearest_packet(data, node->children[i], mask);
+      }
+    }
+    else {
+      for (int i = node->node_num - 1; i >= 0; i--) {
+        dfs_find_nearest_packet(data, node->children[i], mask);
+      }
+    }
+  }
+}
+
+void BLI_bvhtree_find_nearest_packet(const BVHTree *tree,
+                                     const float (*co)[3],
+                                     const int points_num,
+                                     BVHTreeNearest *nearest,
+                                     BVHTree_NearestPointCallback callback,
+                                     void *userdata)
+{
+  BVHNode *root = tree->nodes[tree->leaf_num];
+  if (root == NULL) {
+    return;
+  }
+
+  BVHNearestPacketData data;
+  data.tree = tree;
+  data.callback = callback;
+  data.userdata = userdata;
+
+  for (int packet_start = 0; packet_start < points_num; packet_start += BVH_RAYCAST_PACKET_SIZE)
+  {
+    data.points_num = min_ii(points_num - packet_start, BVH_RAYCAST_PACKET_SIZE);
+    data.co = &co[packet_start];
+    data.nearest = &nearest[packet_start];
+
+    for (int i = 0; i < BVH_RAYCAST_PACKET_SIZE; i++) {
+      const bool is_used = i < data.points_num;
+      /* Only the first three axes are used by the box test, which are the X, Y and Z axes. */
+      for (int axis = 0; axis < 3; axis++) {
+        data.proj[axis][i] = is_used ? data.co[i][axis] : 0.0f;
+      }
+      data.dist_sq[i] = is_used ? data.nearest[i].dist_sq : -FLT_MAX;
+    }
+
+    dfs_find_nearest_packet(&data, root, (1u << data.points_num) - 1);
+  }
+}
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name BLI_bvhtree_find_nearest_first
  * \{ */
@@ -2119,6 +2308,169 @@ void BLI_bvhtree_ray_cast_all(const BVHTree *tree,
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name BLI_bvhtree_ray_cast_packet
+ *
+ * Rays are traversed in packets of #BVH_RAYCAST_PACKET_SIZE. Every node is loaded once per
+ * packet and tested against all rays that are still active in it. The ray data is stored as
+ * structure of arrays so the box test is a fixed length loop the compiler can vectorize.
+ *
+ * \{ */
+
+typedef struct BVHRayPacketData {
+  const BVHTree *tree;
+
+  BVHTree_RayCastCallback callback;
+  void *userdata;
+
+  int rays_num;
+
+  float origin[3][BVH_RAYCAST_PACKET_SIZE];
+  float idot_axis[3][BVH_RAYCAST_PACKET_SIZE];
+  /** Copy of `rays[i].hit.dist`, unused lanes are set to -FLT_MAX so they never hit. */
+  float hit_dist[BVH_RAYCAST_PACKET_SIZE];
+
+  BVHRayCastData rays[BVH_RAYCAST_PACKET_SIZE];
+} BVHRayPacketData;
+
+/**
+ * Test all rays of the packet against the bounding box of the node.
+ * Returns the bit mask of the rays that hit it, the distances are written to \a r_dist.
+ */
+static uint ray_packet_nearest_hit(const BVHRayPacketData *data,
+                                   const float bv[6],
+                                   float r_dist[BVH_RAYCAST_PACKET_SIZE])
+{
+  uint mask = 0;
+  for (int i = 0; i < BVH_RAYCAST_PACKET_SIZE; i++) {
+    const float t1x = (bv[0] - data->origin[0][i]) * data->idot_axis[0][i];
+    const float t2x = (bv[1] - data->origin[0][i]) * data->idot_axis[0][i];
+    const float t1y = (bv[2] - data->origin[1][i]) * data->idot_axis[1][i];
+    const float t2y = (bv[3] - data->origin[1][i]) * data->idot_axis[1][i];
+    const float t1z = (bv[4] - data->origin[2][i]) * data->idot_axis[2][i];
+    const float t2z = (bv[5] - data->origin[2][i]) * data->idot_axis[2][i];
+
+    const float t_near = max_fff(min_ff(t1x, t2x), min_ff(t1y, t2y), min_ff(t1z, t2z));
+    const float t_far = min_fff(max_ff(t1x, t2x), max_ff(t1y, t2y), max_ff(t1z, t2z));
+
+    r_dist[i] = t_near;
+    mask |= (uint)((t_near <= t_far) & (t_far >= 0.0f) & (t_near < data->hit_dist[i])) << i;
+  }
+  return mask;
+}
+
+static void dfs_raycast_packet(BVHRayPacketData *data, const BVHNode *node, uint mask)
+{
+  float dist[BVH_RAYCAST_PACKET_SIZE];
+
+  mask &= ray_packet_nearest_hit(data, node->bv, dist);
+  if (mask == 0) {
+    return;
+  }
+
+  if (node->node_num == 0) {
+    for (int i = 0; i < data->rays_num; i++) {
+      if ((mask & (1u << i)) == 0) {
+        continue;
+      }
+      BVHRayCastData *ray_data = &data->rays[i];
+      if (data->callback) {
+        data->callback(data->userdata, node->index, &ray_data->ray, &ray_data->hit);
+      }
+      else {
+        ray_data->hit.index = node->index;
+        ray_data->hit.dist = dist[i];
+        madd_v3_v3v3fl(ray_data->hit.co, ray_data->ray.origin, ray_data->ray.direction, dist[i]);
+      }
+      data->hit_dist[i] = ray_data->hit.dist;
+    }
+  }
+  else {
+    /* The rays of a packet are expected to be coherent,
+     * so the first active ray picks the loop direction for all of them. */
+    const BVHRayCastData *lead = &data->rays[bitscan_forward_uint(mask)];
+    if (lead->ray_dot_axis[node->main_axis] > 0.0f) {
+      for (int i = 0; i != node->node_num; i++) {
+        dfs_raycast_packet(data, node->children[i], mask);
+      }
+    }
+    else {
+      for (int i = node->node_num - 1; i >= 0; i--) {
+        dfs_raycast_packet(data, node->children[i], mask);
+      }
+    }
+  }
+}
+
+void BLI_bvhtree_ray_cast_packet(const BVHTree *tree,
+                                 const float (*co)[3],
+                                 const float (*dir)[3],
+                                 const int rays_num,
+                                 float radius,
+                                 BVHTreeRayHit *hits,
+                                 BVHTree_RayCastCallback callback,
+                                 void *userdata,
+                                 int flag)
+{
+  BVHNode *root = tree->nodes[tree->leaf_num];
+  if (root == NULL) {
+    return;
+  }
+
+  if (radius != 0.0f) {
+    /* The packet box test doesn't support a ray radius, cast the rays one by one. */
+    for (int i = 0; i < rays_num; i++) {
+      BLI_bvhtree_ray_cast_ex(tree, co[i], dir[i], radius, &hits[i], callback, userdata, flag);
+    }
+    return;
+  }
+
+  BVHRayPacketData data;
+  data.tree = tree;
+  data.callback = callback;
+  data.userdata = userdata;
+
+  for (int packet_start = 0; packet_start < rays_num; packet_start += BVH_RAYCAST_PACKET_SIZE) {
+    data.rays_num = min_ii(rays_num - packet_start, BVH_RAYCAST_PACKET_SIZE);
+
+    for (int i = 0; i < BVH_RAYCAST_PACKET_SIZE; i++) {
+      if (i >= data.rays_num) {
+        for (int axis = 0; axis < 3; axis++) {
+          data.origin[axis][i] = 0.0f;
+          data.idot_axis[axis][i] = 0.0f;
+        }
+        data.hit_dist[i] = -FLT_MAX;
+        continue;
+      }
+      BVHRayCastData *ray_data = &data.rays[i];
+      BLI_ASSERT_UNIT_V3(dir[packet_start + i]);
+
+      ray_data->tree = tree;
+      ray_data->callback = callback;
+      ray_data->userdata = userdata;
+      copy_v3_v3(ray_data->ray.origin, co[packet_start + i]);
+      copy_v3_v3(ray_data->ray.direction, dir[packet_start + i]);
+      ray_data->ray.radius = 0.0f;
+      bvhtree_ray_cast_data_precalc(ray_data, flag);
+      memcpy(&ray_data->hit, &hits[packet_start + i], sizeof(ray_data->hit));
+
+      for (int axis = 0; axis < 3; axis++) {
+        data.origin[axis][i] = ray_data->ray.origin[axis];
+        data.idot_axis[axis][i] = ray_data->idot_axis[axis];
+      }
+      data.hit_dist[i] = ray_data->hit.dist;
+    }
+
+    dfs_raycast_packet(&data, root, (1u << data.rays_num) - 1);
+
+    for (int i = 0; i < data.rays_num; i++) {
+      memcpy(&hits[packet_start + i], &data.rays[i].hit, sizeof(data.rays[i].hit));
+    }
+  }
+}
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name BLI_bvhtree_range_query
  *
@@ -11,9 +11,19 @@
 
 #include "BLI_filereader.h"
 #include "BLI_math_base.h"
+#include "BLI_task.h"
 
 #include "MEM_guardedalloc.h"
 
+/**
+ * Number of frames decompressed in one batch per scheduler thread when a read misses the cache.
+ * Files written by Blender use frames of roughly 1 MB, so this bounds the cache to a few MB per
+ * thread while still giving every thread enough work when reading sequentially.
+ */
+#define ZSTD_FRAMES_PER_THREAD 2
+/** Upper bound for the number of frames in one batch, regardless of the number of threads. */
+#define ZSTD_FRAMES_BATCH_MAX 64
+
 typedef struct {
   FileReader reader;
 
@@ -28,8 +38,11 @@ typedef struct {
     size_t *compressed_ofs;
     size_t *uncompressed_ofs;
 
+    /** Decompressed content of the frames `[cached_frame, cached_frame + cached_frames_num)`,
+     * stored contiguously. */
     char *cached_content;
     int cached_frame;
+    int cached_frames_num;
   } seek;
 } ZstdReader;
 
@@ -153,24 +166,97 @@ static int zstd_frame_from_pos(ZstdReader *zstd, size_t pos)
   return low;
 }
 
-/* Ensure that the currently loaded frame is the correct one. */
+typedef struct ZstdDecompressBatch {
+  const ZstdReader *zstd;
+  int first_frame;
+  const char *compressed_data;
+  char *uncompressed_data;
+  /** Set when any frame of the batch failed to decompress. */
+  bool error;
+} ZstdDecompressBatch;
+
+typedef struct ZstdDecompressTLS {
+  /** Created lazily, so that threads which don't get any frame don't allocate a context. */
+  ZSTD_DCtx *ctx;
+} ZstdDecompressTLS;
+
+static void zstd_decompress_frame_fn(void *__restrict userdata,
+                                     const int iter,
+                                     const TaskParallelTLS *__restrict tls)
+{
+  ZstdDecompressBatch *batch = userdata;
+  ZstdDecompressTLS *data = tls->userdata_chunk;
+  const ZstdReader *zstd = batch->zstd;
+  const int frame = batch->first_frame + iter;
+
+  if (data->ctx == NULL) {
+    data->ctx = ZSTD_createDCtx();
+  }
+
+  const size_t *compressed_ofs = zstd->seek.compressed_ofs;
+  const size_t *uncompressed_ofs = zstd->seek.uncompressed_ofs;
+  const size_t compressed_size = compressed_ofs[frame + 1] - compressed_ofs[frame];
+  const size_t uncompressed_size = uncompressed_ofs[frame + 1] - uncompressed_ofs[frame];
+
+  size_t res = ZSTD_decompressDCtx(
+      data->ctx,
+      batch->uncompressed_data + (uncompressed_ofs[frame] - uncompressed_ofs[batch->first_frame]),
+      uncompressed_size,
+      batch->compressed_data + (compressed_ofs[frame] - compressed_ofs[batch->first_frame]),
+      compressed_size);
+  if (ZSTD_isError(res) || res < uncompressed_size) {
+    /* Only ever set to true, so the race between threads is harmless. */
+    batch->error = true;
+  }
+}
+
+static void zstd_decompress_frame_free_fn(const void *__restrict UNUSED(userdata),
+                                          void *__restrict chunk)
+{
+  ZstdDecompressTLS *data = chunk;
+  if (data->ctx != NULL) {
+    ZSTD_freeDCtx(data->ctx);
+    data->ctx = NULL;
+  }
+}
+
+/**
+ * Ensure that the given frame is part of the cached content and return its decompressed data.
+ *
+ * On a cache miss, a batch of frames starting at the requested one is read from the base reader
+ * with a single read, and the frames are then decompressed in parallel. Since frames of the
+ * seekable format are independent, this gives a near-linear speedup for sequential reading of
+ * large files, which is the common access pattern when loading a `.blend` file.
+ */
 static const char *zstd_ensure_cache(ZstdReader *zstd, int frame)
 {
-  if (zstd->seek.cached_frame == frame) {
+  const size_t *compressed_ofs = zstd->seek.compressed_ofs;
+  const size_t *uncompressed_ofs = zstd->seek.uncompressed_ofs;
+
+  if (zstd->seek.cached_content != NULL && frame >= zstd->seek.cached_frame &&
+      frame < zstd->seek.cached_frame + zstd->seek.cached_frames_num)
+  {
     /* Cached frame matches, so just return it. */
-    return zstd->seek.cached_content;
+    return zstd->seek.cached_content +
+           (uncompressed_ofs[frame] - uncompressed_ofs[zstd->seek.cached_frame]);
   }
 
-  /* Cached frame doesn't match, so discard it and cache the wanted one instead. */
+  /* Cached frames don't match, so discard them and cache the wanted ones instead. */
   MEM_SAFE_FREE(zstd->seek.cached_content);
+  zstd->seek.cached_frame = -1;
+  zstd->seek.cached_frames_num = 0;
 
-  size_t compressed_size = zstd->seek.compressed_ofs[frame + 1] - zstd->seek.compressed_ofs[frame];
-  size_t uncompressed_size = zstd->seek.uncompressed_ofs[frame + 1] -
-                             zstd->seek.uncompressed_ofs[frame];
+  const int batch_size = min_ii(
+      max_ii(BLI_task_scheduler_num_threads() * ZSTD_FRAMES_PER_THREAD, 1), ZSTD_FRAMES_BATCH_MAX);
+  const int frames_num = min_ii(batch_size, zstd->seek.frames_num - frame);
+  const int end_frame = frame + frames_num;
+
+  const size_t compressed_size = compressed_ofs[end_frame] - compressed_ofs[frame];
+  const size_t uncompressed_size = uncompressed_ofs[end_frame] - uncompressed_ofs[frame];
 
   char *uncompressed_data = MEM_mallocN(uncompressed_size, __func__);
   char *compressed_data = MEM_mallocN(compressed_size, __func__);
-  if (zstd->base->seek(zstd->base, zstd->seek.compressed_ofs[frame], SEEK_SET) < 0 ||
+  if (zstd->base->seek(zstd->base, compressed_ofs[frame], SEEK_SET) < 0 ||
       zstd->base->read(zstd->base, compressed_data, compressed_size) < compressed_size)
   {
     MEM_freeN(compressed_data);
@@ -178,15 +264,39 @@ static const char *zstd_ensure_cache(ZstdReader *zstd, int frame)
     return NULL;
   }
 
-  size_t res = ZSTD_decompressDCtx(
-      zstd->ctx, uncompressed_data, uncompressed_size, compressed_data, compressed_size);
+  ZstdDecompressBatch batch = {
+      .zstd = zstd,
+      .first_frame = frame,
+      .compressed_data = compressed_data,
+      .uncompressed_data = uncompressed_data,
+      .error = false,
+  };
+
+  if (frames_num == 1) {
+    /* Avoid the threading overhead and reuse the reader's own context. */
+    size_t res = ZSTD_decompressDCtx(
+        zstd->ctx, uncompressed_data, uncompressed_size, compressed_data, compressed_size);
+    batch.error = ZSTD_isError(res) || res < uncompressed_size;
+  }
+  else {
+    ZstdDecompressTLS tls_data = {NULL};
+    TaskParallelSettings settings;
+    BLI_parallel_range_settings_defaults(&settings);
+    settings.min_iter_per_thread = 1;
+    settings.userdata_chunk = &tls_data;
+    settings.userdata_chunk_size = sizeof(tls_data);
+    settings.func_free = zstd_decompress_frame_free_fn;
+    BLI_task_parallel_range(0, frames_num, &batch, zstd_decompress_frame_fn, &settings);
+  }
+
   MEM_freeN(compressed_data);
-  if (ZSTD_isError(res) || res < uncompressed_size) {
+  if (batch.error) {
     MEM_freeN(uncompressed_data);
     return NULL;
   }
 
   zstd->seek.cached_frame = frame;
+  zstd->seek.cached_frames_num = frames_num;
   zstd->seek.cached_content = uncompressed_data;
   return uncompressed_data;
 }
@@ -10,6 +10,7 @@
 
 #include "BLI_kdtree_impl.h"
 #include "BLI_math_base.h"
+#include "BLI_task.h"
 #include "BLI_utildefines.h"
 
 #include <string.h>
@@ -50,6 +51,13 @@ struct KDTree {
 
 #define KD_NODE_UNSET ((uint)-1)
 
+/** Sub-trees with at least this many nodes are balanced in a separate task. */
+#define KD_BALANCE_TASK_NODES_MIN 8192
+/** Number of queries that are processed by one thread in the batch queries. */
+#define KD_BATCH_GRAIN_SIZE 256
+/** Number of bits of the spatial keys used to reorder queries in the batch queries. */
+#define KD_BATCH_SORT_BITS 16
+
 /**
  * When set we know all values are unbalanced,
  * otherwise clear them when re-balancing: see #62210.
@@ -139,17 +147,40 @@ void BLI_kdtree_nd_(insert)(KDTree *tree, int index, const float co[KD_DIMS])
 #endif
 }
 
-static uint kdtree_balance(KDTreeNode *nodes, uint nodes_len, uint axis, const uint ofs)
+/**
+ * Index of the node that #kdtree_balance puts at the root of a sub-tree, which is known before
+ * the sub-tree is balanced.
+ */
+static uint kdtree_balance_root(const uint nodes_len, const uint ofs)
+{
+  if (nodes_len == 0) {
+    return KD_NODE_UNSET;
+  }
+  return nodes_len / 2 + ofs;
+}
+
+typedef struct KDTreeBalanceTask {
+  KDTreeNode *nodes;
+  uint nodes_len;
+  uint axis;
+  uint ofs;
+} KDTreeBalanceTask;
+
+static void kdtree_balance_task(TaskPool *__restrict pool, void *taskdata);
+
+/**
+ * \param pool: When not null, large sub-trees are balanced in parallel by pushing them to the
+ * pool.
+ */
+static void kdtree_balance(
+    TaskPool *pool, KDTreeNode *nodes, uint nodes_len, uint axis, const uint ofs)
 {
   KDTreeNode *node;
   float co;
   uint left, right, median, i, j;
 
-  if (nodes_len <= 0) {
-    return KD_NODE_UNSET;
-  }
-  else if (nodes_len == 1) {
-    return 0 + ofs;
+  if (nodes_len <= 1) {
+    return;
   }
 
   /* Quick-sort style sorting around median. */
@@ -188,11 +219,31 @@ static uint kdtree_balance(KDTreeNode *nodes, uint nodes_len, uint axis, const u
   node = &nodes[median];
   node->d = axis;
   axis = (axis + 1) % KD_DIMS;
-  node->left = kdtree_balance(nodes, median, axis, ofs);
-  node->right = kdtree_balance(
-      nodes + median + 1, (nodes_len - (median + 1)), axis, (median + 1) + ofs);
 
-  return median + ofs;
+  const uint left_len = median;
+  const uint right_len = nodes_len - (median + 1);
+  node->left = kdtree_balance_root(left_len, ofs);
+  node->right = kdtree_balance_root(right_len, (median + 1) + ofs);
+
+  /* Both halves are independent, so the left one can be balanced by another thread. */
+  if (pool && left_len >= KD_BALANCE_TASK_NODES_MIN) {
+    KDTreeBalanceTask *task = MEM_mallocN(sizeof(*task), __func__);
+    task->nodes = nodes;
+    task->nodes_len = left_len;
+    task->axis = axis;
+    task->ofs = ofs;
+    BLI_task_pool_push(pool, kdtree_balance_task, task, true, NULL);
+  }
+  else {
+    kdtree_balance(pool, nodes, left_len, axis, ofs);
+  }
+  kdtree_balance(pool, nodes + median + 1, right_len, axis, (median + 1) + ofs);
+}
+
+static void kdtree_balance_task(TaskPool *__restrict pool, void *taskdata)
+{
+  const KDTreeBalanceTask *task = (const KDTreeBalanceTask *)taskdata;
+  kdtree_balance(pool, task->nodes, task->nodes_len, task->axis, task->ofs);
 }
 
 void BLI_kdtree_nd_(balance)(KDTree *tree)
@@ -204,7 +255,16 @@ void BLI_kdtree_nd_(balance)(KDTree *tree)
     }
   }
 
-  tree->root = kdtree_balance(tree->nodes, tree->nodes_len, 0, 0);
+  tree->root = kdtree_balance_root(tree->nodes_len, 0);
+  if (tree->nodes_len >= KD_BALANCE_TASK_NODES_MIN * 2) {
+    TaskPool *pool = BLI_task_pool_create(NULL, TASK_PRIORITY_HIGH);
+    kdtree_balance(pool, tree->nodes, tree->nodes_len, 0, 0);
+    BLI_task_pool_work_and_wait(pool);
+    BLI_task_pool_free(pool);
+  }
+  else {
+    kdtree_balance(NULL, tree->nodes, tree->nodes_len, 0, 0);
+  }
 
 #ifndef NDEBUG
   tree->is_balanced = true;
@@ -800,6 +860,205 @@ finally:
   }
 }
 
+/* -------------------------------------------------------------------- */
+/** \name Batch Queries
+ *
+ * Run many queries at once on multiple threads. The queries are reordered along a space filling
+ * curve first, so that queries that are processed after each other traverse similar parts of the
+ * tree, which makes better use of the CPU cache.
+ * \{ */
+
+/**
+ * Order the coordinates by their position on a Z-order curve through their bounds. This uses a
+ * counting sort on coarse keys, which is enough to group nearby queries and has linear cost.
+ */
+static uint *kdtree_batch_spatial_order(const float (*co)[KD_DIMS], const uint co_len)
+{
+  const uint axis_bits = KD_BATCH_SORT_BITS / KD_DIMS;
+  const uint axis_cells = 1u << axis_bits;
+  const uint keys_num = 1u << (axis_bits * KD_DIMS);
+
+  float min[KD_DIMS], max[KD_DIMS], scale[KD_DIMS];
+  copy_vn_vn(min, co[0]);
+  copy_vn_vn(max, co[0]);
+  for (uint i = 1; i < co_len; i++) {
+    for (uint j = 0; j < KD_DIMS; j++) {
+      min[j] = min_ff(min[j], co[i][j]);
+      max[j] = max_ff(max[j], co[i][j]);
+    }
+  }
+  for (uint j = 0; j < KD_DIMS; j++) {
+    scale[j] = (max[j] > min[j]) ? (float)axis_cells / (max[j] - min[j]) : 0.0f;
+  }
+
+  uint *keys = MEM_mallocN(sizeof(uint) * co_len, __func__);
+  uint *offsets = MEM_callocN(sizeof(uint) * (keys_num + 1), __func__);
+  for (uint i = 0; i < co_len; i++) {
+    uint cells[KD_DIMS];
+    for (uint j = 0; j < KD_DIMS; j++) {
+      const float cell = (co[i][j] - min[j]) * scale[j];
+      /* Also handles NaN. */
+      cells[j] = (cell > 0.0f) ? min_uu((uint)cell, axis_cells - 1) : 0;
+    }
+    uint key = 0;
+    for (uint bit = 0; bit < axis_bits; bit++) {
+      for (uint j = 0; j < KD_DIMS; j++) {
+        key |= ((cells[j] >> bit) & 1u) << (bit * KD_DIMS + j);
+      }
+    }
+    keys[i] = key;
+    offsets[key + 1]++;
+  }
+  for (uint key = 0; key < keys_num; key++) {
+    offsets[key + 1] += offsets[key];
+  }
+
+  uint *order = MEM_mallocN(sizeof(uint) * co_len, __func__);
+  for (uint i = 0; i < co_len; i++) {
+    order[offsets[keys[i]]++] = i;
+  }
+
+  MEM_freeN(keys);
+  MEM_freeN(offsets);
+  return order;
+}
+
+static void kdtree_batch_settings(TaskParallelSettings *settings, const uint co_len)
+{
+  BLI_parallel_range_settings_defaults(settings);
+  settings->min_iter_per_thread = KD_BATCH_GRAIN_SIZE;
+  settings->use_threading = co_len > KD_BATCH_GRAIN_SIZE;
+}
+
+typedef struct KDTreeFindNearestBatchData {
+  const KDTree *tree;
+  const float (*co)[KD_DIMS];
+  const uint *order;
+  KDTreeNearest *r_nearest;
+} KDTreeFindNearestBatchData;
+
+static void kdtree_find_nearest_batch_fn(void *__restrict userdata,
+                                         const int iter,
+                                         const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const KDTreeFindNearestBatchData *data = (const KDTreeFindNearestBatchData *)userdata;
+  const uint query_index = data->order[iter];
+  KDTreeNearest *nearest = &data->r_nearest[query_index];
+  if (BLI_kdtree_nd_(find_nearest)(data->tree, data->co[query_index], nearest) == -1) {
+    nearest->index = -1;
+  }
+}
+
+/**
+ * Find the nearest point for every coordinate in \a co, using multiple threads.
+ *
+ * \param r_nearest: An array with \a co_len elements. The index of an element is -1 when the
+ * tree is empty.
+ */
+void BLI_kdtree_nd_(find_nearest_batch)(const KDTree *tree,
+                                        const float (*co)[KD_DIMS],
+                                        const uint co_len,
+                                        KDTreeNearest *r_nearest)
+{
+#ifndef NDEBUG
+  BLI_assert(tree->is_balanced == true);
+#endif
+
+  if (co_len == 0) {
+    return;
+  }
+
+  KDTreeFindNearestBatchData data;
+  data.tree = tree;
+  data.co = co;
+  data.order = kdtree_batch_spatial_order(co, co_len);
+  data.r_nearest = r_nearest;
+
+  TaskParallelSettings settings;
+  kdtree_batch_settings(&settings, co_len);
+  BLI_task_parallel_range(0, (int)co_len, &data, kdtree_find_nearest_batch_fn, &settings);
+
+  MEM_freeN((void *)data.order);
+}
+
+typedef struct KDTreeRangeSearchBatchData {
+  const KDTree *tree;
+  const float (*co)[KD_DIMS];
+  const uint *order;
+  float range;
+  bool (*search_cb)(
+      void *user_data, int query_index, int index, const float co[KD_DIMS], float dist_sq);
+  void *user_data;
+} KDTreeRangeSearchBatchData;
+
+typedef struct KDTreeRangeSearchBatchQuery {
+  const KDTreeRangeSearchBatchData *data;
+  int query_index;
+} KDTreeRangeSearchBatchQuery;
+
+static bool kdtree_range_search_batch_cb(void *user_data,
+                                         const int index,
+                                         const float co[KD_DIMS],
+                                         const float dist_sq)
+{
+  const KDTreeRangeSearchBatchQuery *query = (const KDTreeRangeSearchBatchQuery *)user_data;
+  return query->data->search_cb(
+      query->data->user_data, query->query_index, index, co, dist_sq);
+}
+
+static void kdtree_range_search_batch_fn(void *__restrict userdata,
+                                         const int iter,
+                                         const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const KDTreeRangeSearchBatchData *data = (const KDTreeRangeSearchBatchData *)userdata;
+  KDTreeRangeSearchBatchQuery query;
+  query.data = data;
+  query.query_index = (int)data->order[iter];
+  BLI_kdtree_nd_(range_search_cb)(
+      data->tree, data->co[query.query_index], data->range, kdtree_range_search_batch_cb, &query);
+}
+
+/**
+ * Run #BLI_kdtree_3d_range_search_cb for every coordinate in \a co, using multiple threads.
+ *
+ * \param search_cb: Called for every node in \a range of the query with the given index. It is
+ * called from multiple threads at the same time, but calls for the same query come from a single
+ * thread. A false return value stops the search for that query.
+ */
+void BLI_kdtree_nd_(range_search_batch_cb)(
+    const KDTree *tree,
+    const float (*co)[KD_DIMS],
+    const uint co_len,
+    const float range,
+    bool (*search_cb)(
+        void *user_data, int query_index, int index, const float co[KD_DIMS], float dist_sq),
+    void *user_data)
+{
+#ifndef NDEBUG
+  BLI_assert(tree->is_balanced == true);
+#endif
+
+  if (co_len == 0) {
+    return;
+  }
+
+  KDTreeRangeSearchBatchData data;
+  data.tree = tree;
+  data.co = co;
+  data.order = kdtree_batch_spatial_order(co, co_len);
+  data.range = range;
+  data.search_cb = search_cb;
+  data.user_data = user_data;
+
+  TaskParallelSettings settings;
+  kdtree_batch_settings(&settings, co_len);
+  BLI_task_parallel_range(0, (int)co_len, &data, kdtree_range_search_batch_fn, &settings);
+
+  MEM_freeN((void *)data.order);
+}
+
+/** \} */
+
 /**
  * Use when we want to loop over nodes ordered by index.
  * Requires indices to be aligned with nodes.
@@ -134,3 +134,85 @@ TEST(kdopbvh, OptimalFindNearest_500)
 {
   find_nearest_points_test(500, 1.0, 1000, 12, true);
 }
+
+/**
+ * Compare the packet queries against the same queries done one by one.
+ * The point count is large enough to use the parallel hull computation while balancing.
+ */
+static void packet_queries_test(int points_len, int queries_len, int random_seed)
+{
+  RNG *rng = BLI_rng_new(random_seed);
+  BVHTree *tree = BLI_bvhtree_new(points_len, 0.0, 4, 6);
+
+  /* Insert small boxes, so the rays have something to hit. */
+  float(*points)[2][3] = (float(*)[2][3])MEM_mallocN(sizeof(float[2][3]) * points_len, __func__);
+  for (int i = 0; i < points_len; i++) {
+    BLI_rng_get_float_unit_v3(rng, points[i][0]);
+    copy_v3_v3(points[i][1], points[i][0]);
+    add_v3_fl(points[i][1], 0.01f);
+    BLI_bvhtree_insert(tree, i, points[i][0], 2);
+  }
+  BLI_bvhtree_balance(tree);
+
+  float(*co)[3] = (float(*)[3])MEM_mallocN(sizeof(float[3]) * queries_len, __func__);
+  float(*dir)[3] = (float(*)[3])MEM_mallocN(sizeof(float[3]) * queries_len, __func__);
+  BVHTreeRayHit *hits = (BVHTreeRayHit *)MEM_mallocN(sizeof(BVHTreeRayHit) * queries_len,
+                                                     __func__);
+  BVHTreeNearest *nearest = (BVHTreeNearest *)MEM_mallocN(sizeof(BVHTreeNearest) * queries_len,
+                                                          __func__);
+  for (int i = 0; i < queries_len; i++) {
+    BLI_rng_get_float_unit_v3(rng, co[i]);
+    mul_v3_fl(co[i], 2.0f);
+    negate_v3_v3(dir[i], co[i]);
+    normalize_v3(dir[i]);
+    hits[i].index = -1;
+    hits[i].dist = BVH_RAYCAST_DIST_MAX;
+    nearest[i].index = -1;
+    nearest[i].dist_sq = FLT_MAX;
+  }
+
+  BLI_bvhtree_ray_cast_packet(tree,
+                              (const float(*)[3])co,
+                              (const float(*)[3])dir,
+                              queries_len,
+                              0.0f,
+                              hits,
+                              nullptr,
+                              nullptr,
+                              BVH_RAYCAST_DEFAULT);
+  BLI_bvhtree_find_nearest_packet(
+      tree, (const float(*)[3])co, queries_len, nearest, nullptr, nullptr);
+
+  for (int i = 0; i < queries_len; i++) {
+    BVHTreeRayHit hit;
+    hit.index = -1;
+    hit.dist = BVH_RAYCAST_DIST_MAX;
+    BLI_bvhtree_ray_cast(tree, co[i], dir[i], 0.0f, &hit, nullptr, nullptr);
+    EXPECT_EQ(hit.index, hits[i].index);
+    EXPECT_FLOAT_EQ(hit.dist, hits[i].dist);
+
+    BVHTreeNearest expected;
+    expected.index = -1;
+    expected.dist_sq = FLT_MAX;
+    BLI_bvhtree_find_nearest(tree, co[i], &expected, nullptr, nullptr);
+    EXPECT_EQ(expected.index, nearest[i].index);
+    EXPECT_FLOAT_EQ(expected.dist_sq, nearest[i].dist_sq);
+  }
+
+  BLI_bvhtree_free(tree);
+  BLI_rng_free(rng);
+  MEM_freeN(points);
+  MEM_freeN(co);
+  MEM_freeN(dir);
+  MEM_freeN(hits);
+  MEM_freeN(nearest);
+}
+
+TEST(kdopbvh, PacketQueries_13)
+{
+  packet_queries_test(500, 13, 1234);
+}
+TEST(kdopbvh, PacketQueries_1000)
+{
+  packet_queries_test(100000, 1000, 12);
+}
@@ -4,7 +4,11 @@
 
 #include "testing/testing.h"
 
+#include "BLI_array.hh"
 #include "BLI_kdtree.h"
+#include "BLI_math_vector.hh"
+#include "BLI_rand.hh"
+#include "BLI_vector.hh"
 
 #include <cmath>
 
@@ -63,3 +67,85 @@ TEST(kdtree, Deduplicate)
 {
   deduplicate_test();
 }
+
+static KDTree_3d *build_random_tree(const blender::Span<blender::float3> positions)
+{
+  KDTree_3d *tree = BLI_kdtree_3d_new(positions.size());
+  for (const int i : positions.index_range()) {
+    BLI_kdtree_3d_insert(tree, i, positions[i]);
+  }
+  BLI_kdtree_3d_balance(tree);
+  return tree;
+}
+
+static blender::Vector<blender::float3> random_positions(const int size, const uint32_t seed)
+{
+  blender::RandomNumberGenerator rng(seed);
+  blender::Vector<blender::float3> positions(size);
+  for (blender::float3 &position : positions) {
+    position = rng.get_unit_float3() * rng.get_float();
+  }
+  return positions;
+}
+
+TEST(kdtree, FindNearestBatch)
+{
+  /* Large enough to balance the tree on multiple threads. */
+  const blender::Vector<blender::float3> positions = random_positions(50000, 0);
+  const blender::Vector<blender::float3> queries = random_positions(2000, 1);
+  KDTree_3d *tree = build_random_tree(positions);
+
+  blender::Vector<KDTreeNearest_3d> nearest(queries.size());
+  BLI_kdtree_3d_find_nearest_batch(tree,
+                                   reinterpret_cast<const float(*)[3]>(queries.data()),
+                                   uint(queries.size()),
+                                   nearest.data());
+  for (const int i : queries.index_range()) {
+    KDTreeNearest_3d expected;
+    EXPECT_EQ(BLI_kdtree_3d_find_nearest(tree, queries[i], &expected), nearest[i].index);
+    EXPECT_EQ(expected.dist, nearest[i].dist);
+  }
+  BLI_kdtree_3d_free(tree);
+}
+
+TEST(kdtree, RangeSearchBatch)
+{
+  const blender::Vector<blender::float3> positions = random_positions(50000, 2);
+  const blender::Vector<blender::float3> queries = random_positions(500, 3);
+  KDTree_3d *tree = build_random_tree(positions);
+  const float range = 0.05f;
+
+  /* All calls for the same query come from the same thread. */
+  blender::Array<int> found_num(queries.size(), 0);
+  BLI_kdtree_3d_range_search_batch_cb_cpp(
+      tree,
+      reinterpret_cast<const float(*)[3]>(queries.data()),
+      uint(queries.size()),
+      range,
+      [&](const int query_index, const int /*index*/, const float * /*co*/, float /*dist_sq*/) {
+        found_num[query_index]++;
+        return true;
+      });
+  for (const int i : queries.index_range()) {
+    int expected = 0;
+    for (const blender::float3 &position : positions) {
+      if (blender::math::distance_squared(position, queries[i]) <= range * range) {
+        expected++;
+      }
+    }
+    EXPECT_EQ(found_num[i], expected);
+  }
+  BLI_kdtree_3d_free(tree);
+}
+
+TEST(kdtree, FindNearestBatchEmpty)
+{
+  KDTree_3d *tree = BLI_kdtree_3d_new(0);
+  BLI_kdtree_3d_balance(tree);
+  const float queries[2][3] = {{0.0f, 0.0f, 0.0f}, {1.0f, 0.0f, 0.0f}};
+  KDTreeNearest_3d nearest[2];
+  BLI_kdtree_3d_find_nearest_batch(tree, queries, 2, nearest);
+  EXPECT_EQ(nearest[0].index, -1);
+  EXPECT_EQ(nearest[1].index, -1);
+  BLI_kdtree_3d_free(tree);
+}
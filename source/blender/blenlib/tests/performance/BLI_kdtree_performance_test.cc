@@ -0,0 +1,87 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0 */
+
+#include "testing/testing.h"
+
+#include "BLI_array.hh"
+#include "BLI_kdtree.h"
+#include "BLI_rand.hh"
+#include "BLI_task.hh"
+#include "BLI_timeit.hh"
+
+using namespace blender;
+
+/* Compare building the tree and finding the nearest point for every query one by one with the
+ * batch query API. */
+
+static Array<float3> random_positions(const int size, const uint32_t seed)
+{
+  RandomNumberGenerator rng(seed);
+  Array<float3> positions(size);
+  for (float3 &position : positions) {
+    position = float3(rng.get_float(), rng.get_float(), rng.get_float());
+  }
+  return positions;
+}
+
+static void kdtree_benchmark(const int points_num, const int queries_num)
+{
+  const Array<float3> positions = random_positions(points_num, 0);
+  const Array<float3> queries = random_positions(queries_num, 1);
+  printf("\n%d points, %d queries\n", points_num, queries_num);
+
+  KDTree_3d *tree = BLI_kdtree_3d_new(uint(points_num));
+  for (const int i : positions.index_range()) {
+    BLI_kdtree_3d_insert(tree, i, positions[i]);
+  }
+  {
+    SCOPED_TIMER("balance");
+    BLI_kdtree_3d_balance(tree);
+  }
+
+  Array<KDTreeNearest_3d> nearest_single(queries_num);
+  {
+    SCOPED_TIMER("find_nearest");
+    for (const int i : queries.index_range()) {
+      BLI_kdtree_3d_find_nearest(tree, queries[i], &nearest_single[i]);
+    }
+  }
+  Array<KDTreeNearest_3d> nearest_threaded(queries_num);
+  {
+    SCOPED_TIMER("find_nearest (parallel_for)");
+    threading::parallel_for(queries.index_range(), 256, [&](const IndexRange range) {
+      for (const int i : range) {
+        BLI_kdtree_3d_find_nearest(tree, queries[i], &nearest_threaded[i]);
+      }
+    });
+  }
+  Array<KDTreeNearest_3d> nearest_batch(queries_num);
+  {
+    SCOPED_TIMER("find_nearest_batch");
+    BLI_kdtree_3d_find_nearest_batch(tree,
+                                     reinterpret_cast<const float(*)[3]>(queries.data()),
+                                     uint(queries_num),
+                                     nearest_batch.data());
+  }
+  for (const int i : queries.index_range()) {
+    EXPECT_EQ(nearest_single[i].index, nearest_batch[i].index);
+  }
+
+  BLI_kdtree_3d_free(tree);
+}
+
+TEST(kdtree_performance, FindNearest_100k)
+{
+  kdtree_benchmark(100000, 100000);
+}
+
+TEST(kdtree_performance, FindNearest_1M)
+{
+  kdtree_benchmark(1000000, 1000000);
+}
+
+TEST(kdtree_performance, FindNearest_5M)
+{
+  kdtree_benchmark(5000000, 5000000);
+}
@@ -30,6 +30,8 @@
 
 #pragma once
 
+#include <type_traits>
+
 /* for SDNA_TYPE_FROM_STRUCT() macro */
 #include "dna_type_offsets.h"
 
@@ -311,6 +313,42 @@ const blender::ImplicitSharingInfo *BLO_read_shared(
   return sharing_info;
 }
 
+/**
+ * Try to reference an array of trivial data directly in the memory-mapped file, instead of
+ * reading a copy of it. This is only possible for large arrays in uncompressed files that don't
+ * need any conversion, when memory-mapped data sharing is enabled in the preferences.
+ *
+ * \param size: The expected size of the array in bytes.
+ * \param alignment: The required alignment of the array.
+ * \return The sharing-info owning the referenced data (with a user added for the caller) and
+ * the data pointer is updated to the mapped memory, or null if the data has to be read normally.
+ */
+const blender::ImplicitSharingInfo *BLO_read_shared_mapped(BlendDataReader *reader,
+                                                           void **data_ptr,
+                                                           size_t size,
+                                                           size_t alignment);
+
+/**
+ * Same as #BLO_read_shared, but for arrays of trivial types that are used exactly as they are
+ * stored in the file. When possible, the array is referenced directly in the memory-mapped file
+ * (see #BLO_read_shared_mapped), otherwise \a read_fn is called to read it.
+ */
+template<typename T>
+const blender::ImplicitSharingInfo *BLO_read_shared_trivial_array(
+    BlendDataReader *reader,
+    T **data_ptr,
+    const int64_t size,
+    blender::FunctionRef<const blender::ImplicitSharingInfo *()> read_fn)
+{
+  static_assert(std::is_trivially_copyable_v<T>);
+  if (const blender::ImplicitSharingInfo *sharing_info = BLO_read_shared_mapped(
+          reader, reinterpret_cast<void **>(data_ptr), sizeof(T) * size_t(size), alignof(T)))
+  {
+    return sharing_info;
+  }
+  return BLO_read_shared(reader, data_ptr, read_fn);
+}
+
 int BLO_read_fileversion_get(BlendDataReader *reader);
 bool BLO_read_requires_endian_switch(BlendDataReader *reader);
 bool BLO_read_data_is_undo(BlendDataReader *reader);
@@ -9,6 +9,7 @@
  * \brief external `writefile.cc` function prototypes.
  */
 
+struct BlendFileIncrementalStore;
 struct BlendThumbnail;
 struct Main;
 struct MemFile;
@@ -60,3 +61,30 @@ extern bool BLO_write_file(Main *mainvar,
 extern bool BLO_write_file_mem(Main *mainvar, MemFile *compare, MemFile *current, int write_flags);
 
 /** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name BLO Incremental Write File API
+ *
+ * Write files that only contain the data that changed since the previous save, appended to the
+ * file written by that save. Unchanged data is detected by comparing hashes of the data written
+ * for every ID with the previous save, so only those hashes are kept in memory.
+ * Files written this way can only be read by #BLO_read_from_file, use for auto-save only.
+ * \{ */
+
+BlendFileIncrementalStore *BLO_write_incremental_store_new();
+void BLO_write_incremental_store_free(BlendFileIncrementalStore *store);
+
+/**
+ * Save \a mainvar to \a filepath, only appending the data that changed since the last save
+ * using the same \a store. The whole file is written again when \a filepath changed or when
+ * too much of the file is taken by data from older saves.
+ *
+ * \return Success.
+ */
+extern bool BLO_write_file_incremental(Main *mainvar,
+                                       const char *filepath,
+                                       int write_flags,
+                                       BlendFileIncrementalStore *store,
+                                       ReportList *reports);
+
+/** \} */
@@ -6,6 +6,7 @@
  * \ingroup blenloader
  */
 
+#include <algorithm>
 #include <cctype> /* for isdigit. */
 #include <cerrno>
 #include <climits>
@@ -41,20 +42,24 @@
 #include "DNA_packedFile_types.h"
 #include "DNA_sdna_types.h"
 #include "DNA_sound_types.h"
+#include "DNA_userdef_types.h"
 #include "DNA_vfont_types.h"
 #include "DNA_volume_types.h"
 #include "DNA_workspace_types.h"
 
 #include "MEM_guardedalloc.h"
 
+#include "BLI_array.hh"
 #include "BLI_blenlib.h"
 #include "BLI_endian_defines.h"
 #include "BLI_endian_switch.h"
 #include "BLI_ghash.h"
+#include "BLI_implicit_sharing.hh"
 #include "BLI_linklist.h"
 #include "BLI_map.hh"
 #include "BLI_memarena.h"
 #include "BLI_mempool.h"
+#include "BLI_mmap.h"
 #include "BLI_threads.h"
 #include "BLI_time.h"
 
@@ -105,6 +110,8 @@
 
 #include "readfile.hh"
 
+#include <xxhash.h>
+
 /* Make preferences read-only. */
 #define U (*((const UserDef *)&U))
 
@@ -167,6 +174,18 @@
  */
 #define USE_BHEAD_READ_ON_DEMAND
 
+/**
+ * Reference large arrays directly in a copy-on-write memory mapping of uncompressed files,
+ * instead of copying them (see #BLO_read_shared_mapped). Requires reading data on demand, since
+ * the data of such blocks is only read when it is not referenced from the mapping.
+ *
+ * \note Disabled on WIN32 because a mapped file cannot be replaced there, which would break
+ * saving over a library that is still in use.
+ */
+#if defined(USE_BHEAD_READ_ON_DEMAND) && !defined(WIN32)
+#  define USE_MMAP_DATA_SHARING
+#endif
+
 /** Use #GHash for #BHead name-based lookups (speeds up linking). */
 #define USE_GHASH_BHEAD
 
@@ -242,6 +261,16 @@ struct NewAddress {
 
   /** `nr` is "user count" for data, and ID code for libdata. */
   int nr;
+
+#ifdef USE_MMAP_DATA_SHARING
+  /**
+   * Data block that has not been read yet, because it may be referenced in the memory-mapped
+   * file instead. It is only read when it's accessed with a regular lookup.
+   */
+  BHead *deferred_bhead = nullptr;
+  /** Owns one user of the data referenced in the memory-mapped file, once it was requested. */
+  const blender::ImplicitSharingInfo *mapped_sharing_info = nullptr;
+#endif
 };
 
 struct OldNewMap {
@@ -301,13 +330,31 @@ static void *oldnewmap_liblookup(OldNewMap *onm, const void *addr, const bool is
   return nullptr;
 }
 
+#ifdef USE_MMAP_DATA_SHARING
+static void oldnewmap_insert_deferred(OldNewMap *onm, const void *oldaddr, BHead *bhead)
+{
+  if (oldaddr == nullptr) {
+    return;
+  }
+
+  NewAddress new_addr{nullptr, 0};
+  new_addr.deferred_bhead = bhead;
+  onm->map.add_overwrite(oldaddr, new_addr);
+}
+#endif
+
 static void oldnewmap_clear(OldNewMap *onm)
 {
   /* Free unused data. */
   for (NewAddress &new_addr : onm->map.values()) {
-    if (new_addr.nr == 0) {
+    if (new_addr.nr == 0 && new_addr.newp != nullptr) {
       MEM_freeN(new_addr.newp);
     }
+#ifdef USE_MMAP_DATA_SHARING
+    if (new_addr.mapped_sharing_info) {
+      new_addr.mapped_sharing_info->remove_user_and_delete_if_last();
+    }
+#endif
   }
   onm->map.clear_and_shrink();
 }
@@ -319,6 +366,104 @@ static void oldnewmap_free(OldNewMap *onm)
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name Memory-Mapped Data Sharing
+ * \{ */
+
+#ifdef USE_MMAP_DATA_SHARING
+
+/** Data blocks smaller than this are always copied, referencing them is not worth it. */
+#  define MMAP_DATA_SHARING_MIN_SIZE (64 * 1024)
+/** Same as #MMAP_DATA_SHARING_MIN_SIZE for library files, where any block of a page or more is
+ * worth referencing to avoid reading data that is never used. */
+#  define MMAP_DATA_SHARING_LIBRARY_MIN_SIZE (4 * 1024)
+
+/**
+ * A copy-on-write memory mapping of a blend-file. It is kept alive by the #FileData that created
+ * it and by all the data that is referenced directly from the mapped memory, which may outlive
+ * the #FileData.
+ */
+struct BlendFileMapping : public blender::ImplicitSharingMixin {
+  BLI_mmap_file *mmap_file;
+  /** Smaller data blocks are always read as a copy. */
+  int64_t min_block_size;
+
+  BlendFileMapping(BLI_mmap_file *mmap_file, const int64_t min_block_size)
+      : mmap_file(mmap_file), min_block_size(min_block_size)
+  {
+  }
+
+  /** Get the data of a #BHead that was not read yet, or null if it is out of bounds. */
+  void *data_for_bhead(const BHead *bhead) const
+  {
+    const BHeadN *bheadn = BHEADN_FROM_BHEAD(bhead);
+    BLI_assert(!bheadn->has_data);
+    const size_t offset = size_t(bheadn->file_offset);
+    if (offset + size_t(bhead->len) > BLI_mmap_get_length(mmap_file)) {
+      return nullptr;
+    }
+    return POINTER_OFFSET(BLI_mmap_get_pointer(mmap_file), offset);
+  }
+
+ private:
+  void delete_self() override
+  {
+    BLI_mmap_free(mmap_file);
+    MEM_delete(this);
+  }
+};
+
+/**
+ * Sharing-info for one array referenced in a #BlendFileMapping. Since the mapping is
+ * copy-on-write, the array can also be modified in place once it has a single user.
+ */
+class MappedDataSharingInfo : public blender::ImplicitSharingInfo {
+ private:
+  const BlendFileMapping &mapping_;
+
+ public:
+  MappedDataSharingInfo(const BlendFileMapping &mapping) : mapping_(mapping)
+  {
+    mapping_.add_user();
+  }
+
+ private:
+  void delete_self_with_data() override
+  {
+    mapping_.remove_user_and_delete_if_last();
+    MEM_delete(this);
+  }
+};
+
+/**
+ * Open a mapping of the file if data sharing with it is enabled in the preferences.
+ *
+ * Library files can use a lower size threshold: linked data is usually not modified, and data of
+ * linked data-blocks that is never used (e.g. objects in excluded collections) is then never paged
+ * in at all, which makes reading linked data effectively lazy.
+ */
+static BlendFileMapping *blend_file_mapping_open(const int filedes, const bool is_library)
+{
+  int64_t min_block_size;
+  if (USER_EXPERIMENTAL_TEST(&U, use_blend_file_mmap_sharing)) {
+    min_block_size = is_library ? MMAP_DATA_SHARING_LIBRARY_MIN_SIZE : MMAP_DATA_SHARING_MIN_SIZE;
+  }
+  else if (is_library && USER_EXPERIMENTAL_TEST(&U, use_lazy_linked_data)) {
+    min_block_size = MMAP_DATA_SHARING_LIBRARY_MIN_SIZE;
+  }
+  else {
+    return nullptr;
+  }
+  BLI_mmap_file *mmap_file = BLI_mmap_open_copy_on_write(filedes);
+  if (mmap_file == nullptr) {
+    return nullptr;
+  }
+  return MEM_new<BlendFileMapping>(__func__, mmap_file, min_block_size);
+}
+#endif
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name Helper Functions
  * \{ */
@@ -1058,6 +1203,223 @@ static int *read_file_thumbnail(FileData *fd)
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name Incremental File Reading
+ *
+ * Reads the blend-file data stored in an incremental file (see #IncrementalFileHeader) as if it
+ * was a regular file.
+ * \{ */
+
+struct IncrementalFileReader {
+  FileReader reader;
+
+  FileReader *base;
+  /** Size of the blend-file data. */
+  uint64_t data_len;
+  blender::Array<IncrementalFileChunk> chunks;
+  /** Start of each chunk in the blend-file data, followed by the total size of all chunks. */
+  blender::Array<uint64_t> chunk_starts;
+};
+
+static int64_t incremental_read(FileReader *reader, void *buffer, size_t size)
+{
+  IncrementalFileReader *incremental = reinterpret_cast<IncrementalFileReader *>(reader);
+  char *buffer_step = static_cast<char *>(buffer);
+
+  const uint64_t end = std::min(uint64_t(reader->offset) + size, incremental->data_len);
+  while (uint64_t(reader->offset) < end) {
+    /* Find the chunk containing the current position. */
+    const uint64_t *chunk_start_next = std::upper_bound(incremental->chunk_starts.begin(),
+                                                        incremental->chunk_starts.end(),
+                                                        uint64_t(reader->offset));
+    const int64_t chunk_index = (chunk_start_next - incremental->chunk_starts.begin()) - 1;
+    const IncrementalFileChunk &chunk = incremental->chunks[chunk_index];
+    const uint64_t offset_in_chunk = reader->offset - incremental->chunk_starts[chunk_index];
+    const uint64_t read_len = std::min(chunk.len - offset_in_chunk, end - reader->offset);
+
+    FileReader *base = incremental->base;
+    if (base->seek(base, off64_t(chunk.offset + offset_in_chunk), SEEK_SET) < 0 ||
+        base->read(base, buffer_step, read_len) != int64_t(read_len))
+    {
+      break;
+    }
+    buffer_step += read_len;
+    reader->offset += read_len;
+  }
+
+  return buffer_step - static_cast<char *>(buffer);
+}
+
+static off64_t incremental_seek(FileReader *reader, off64_t offset, int whence)
+{
+  IncrementalFileReader *incremental = reinterpret_cast<IncrementalFileReader *>(reader);
+
+  off64_t new_pos;
+  if (whence == SEEK_CUR) {
+    new_pos = reader->offset + offset;
+  }
+  else if (whence == SEEK_SET) {
+    new_pos = offset;
+  }
+  else if (whence == SEEK_END) {
+    new_pos = off64_t(incremental->data_len) + offset;
+  }
+  else {
+    return -1;
+  }
+
+  if (new_pos < 0 || uint64_t(new_pos) > incremental->data_len) {
+    return -1;
+  }
+
+  reader->offset = new_pos;
+  return reader->offset;
+}
+
+static void incremental_close(FileReader *reader)
+{
+  IncrementalFileReader *incremental = reinterpret_cast<IncrementalFileReader *>(reader);
+  incremental->base->close(incremental->base);
+  MEM_delete(incremental);
+}
+
+/** Size of the blocks read while looking for the footer of the last complete save. */
+#define INCREMENTAL_FOOTER_SEARCH_SIZE (1 << 16)
+
+/**
+ * Read the manifest of the save ending with \a footer at \a footer_offset. Fails when the footer
+ * is not part of a completely written save.
+ */
+static bool incremental_read_manifest(FileReader *base,
+                                      const int64_t footer_offset,
+                                      const IncrementalFileFooter &footer,
+                                      IncrementalFileManifest &r_manifest,
+                                      blender::Array<IncrementalFileChunk> &r_chunks)
+{
+  using namespace blender;
+
+  if (memcmp(footer.magic, BLEND_INCREMENTAL_FILE_FOOTER_MAGIC, sizeof(footer.magic)) != 0 ||
+      footer.manifest_offset < sizeof(IncrementalFileHeader) ||
+      footer.manifest_offset + sizeof(IncrementalFileManifest) > uint64_t(footer_offset))
+  {
+    return false;
+  }
+  IncrementalFileManifest manifest;
+  if (base->seek(base, off64_t(footer.manifest_offset), SEEK_SET) < 0 ||
+      base->read(base, &manifest, sizeof(manifest)) != sizeof(manifest))
+  {
+    return false;
+  }
+  /* The footer directly follows the chunks of the manifest. */
+  const uint64_t chunks_size = uint64_t(footer_offset) - footer.manifest_offset - sizeof(manifest);
+  if (manifest.chunks_num != chunks_size / sizeof(IncrementalFileChunk) ||
+      chunks_size % sizeof(IncrementalFileChunk) != 0)
+  {
+    return false;
+  }
+  Array<IncrementalFileChunk> chunks(int64_t(manifest.chunks_num));
+  if (base->read(base, chunks.data(), int64_t(chunks_size)) != int64_t(chunks_size)) {
+    return false;
+  }
+  const uint64_t manifest_hash = XXH3_64bits_withSeed(
+      chunks.data(), size_t(chunks_size), XXH3_64bits(&manifest, sizeof(manifest)));
+  if (manifest_hash != footer.manifest_hash) {
+    return false;
+  }
+  r_manifest = manifest;
+  r_chunks = std::move(chunks);
+  return true;
+}
+
+/**
+ * Find the manifest of the last complete save. An interrupted save may have left incomplete data
+ * after it, which is skipped by searching backwards for a valid footer.
+ */
+static bool incremental_find_manifest(FileReader *base,
+                                      IncrementalFileManifest &r_manifest,
+                                      blender::Array<IncrementalFileChunk> &r_chunks)
+{
+  using namespace blender;
+
+  constexpr int64_t footer_size = sizeof(IncrementalFileFooter);
+  constexpr int64_t min_offset = sizeof(IncrementalFileHeader);
+  const int64_t file_size = int64_t(base->seek(base, 0, SEEK_END));
+  if (file_size < min_offset + footer_size) {
+    return false;
+  }
+
+  Array<char> buffer(INCREMENTAL_FOOTER_SEARCH_SIZE + footer_size);
+  /* Footers are aligned to 8 bytes. */
+  int64_t footer_offset = (file_size - footer_size) & ~int64_t(7);
+  while (footer_offset >= min_offset) {
+    /* Read all possible footer positions of a block at once. */
+    const int64_t block_start = std::max(min_offset,
+                                         footer_offset - INCREMENTAL_FOOTER_SEARCH_SIZE);
+    const int64_t block_len = footer_offset + footer_size - block_start;
+    if (base->seek(base, off64_t(block_start), SEEK_SET) < 0 ||
+        base->read(base, buffer.data(), block_len) != block_len)
+    {
+      return false;
+    }
+    for (; footer_offset >= block_start; footer_offset -= 8) {
+      IncrementalFileFooter footer;
+      memcpy(&footer, &buffer[footer_offset - block_start], footer_size);
+      if (incremental_read_manifest(base, footer_offset, footer, r_manifest, r_chunks)) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+/**
+ * Create a #FileReader for the blend-file data in an incremental file, which takes ownership of
+ * \a base on success.
+ */
+static FileReader *blo_filereader_new_incremental(FileReader *base)
+{
+  using namespace blender;
+
+  IncrementalFileHeader header;
+  if (base->seek(base, 0, SEEK_SET) < 0 ||
+      base->read(base, &header, sizeof(header)) != sizeof(header) ||
+      memcmp(header.magic, BLEND_INCREMENTAL_FILE_MAGIC, sizeof(header.magic)) != 0)
+  {
+    return nullptr;
+  }
+
+  IncrementalFileManifest manifest;
+  Array<IncrementalFileChunk> chunks;
+  if (!incremental_find_manifest(base, manifest, chunks)) {
+    return nullptr;
+  }
+
+  Array<uint64_t> chunk_starts(chunks.size() + 1);
+  uint64_t chunk_start = 0;
+  for (const int64_t i : chunks.index_range()) {
+    chunk_starts[i] = chunk_start;
+    chunk_start += chunks[i].len;
+  }
+  chunk_starts.last() = chunk_start;
+  if (chunk_start < manifest.data_len) {
+    return nullptr;
+  }
+
+  IncrementalFileReader *incremental = MEM_new<IncrementalFileReader>(__func__);
+  incremental->base = base;
+  incremental->data_len = manifest.data_len;
+  incremental->chunks = std::move(chunks);
+  incremental->chunk_starts = std::move(chunk_starts);
+
+  incremental->reader.read = incremental_read;
+  incremental->reader.seek = incremental_seek;
+  incremental->reader.close = incremental_close;
+
+  return &incremental->reader;
+}
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name File Data API
  * \{ */
@@ -1158,7 +1520,8 @@ static FileData *blo_decode_and_check(FileData *fd, ReportList *reports)
 
 static FileData *blo_filedata_from_file_descriptor(const char *filepath,
                                                    BlendFileReadReport *reports,
-                                                   int filedes)
+                                                   int filedes,
+                                                   const bool is_library)
 {
   char header[7];
   FileReader *rawfile = BLI_filereader_new_file(filedes);
@@ -1184,6 +1547,8 @@ static FileData *blo_filedata_from_file_descriptor(const char *filepath,
   /* Rewind the file after reading the header. */
   rawfile->seek(rawfile, 0, SEEK_SET);
 
+  BlendFileMapping *mapping = nullptr;
+
   /* Check if we have a regular file. */
   if (memcmp(header, "BLENDER", sizeof(header)) == 0) {
     /* Try opening the file with memory-mapped IO. */
@@ -1193,6 +1558,13 @@ static FileData *blo_filedata_from_file_descriptor(const char *filepath,
       file = rawfile;
       rawfile = nullptr;
     }
+#ifdef USE_MMAP_DATA_SHARING
+    else {
+      mapping = blend_file_mapping_open(filedes, is_library);
+    }
+#else
+    UNUSED_VARS(is_library);
+#endif
   }
   else if (BLI_file_magic_is_gzip(header)) {
     file = BLI_filereader_new_gzip(rawfile);
@@ -1206,6 +1578,12 @@ static FileData *blo_filedata_from_file_descriptor(const char *filepath,
       rawfile = nullptr; /* The `Zstd` #FileReader takes ownership of `rawfile`. */
     }
   }
+  else if (memcmp(header, BLEND_INCREMENTAL_FILE_MAGIC, sizeof(header)) == 0) {
+    file = blo_filereader_new_incremental(rawfile);
+    if (file != nullptr) {
+      rawfile = nullptr; /* The incremental #FileReader takes ownership of `rawfile`. */
+    }
+  }
 
   /* Clean up `rawfile` if it wasn't taken over. */
   if (rawfile != nullptr) {
@@ -1218,11 +1596,14 @@ static FileData *blo_filedata_from_file_descriptor(const char *filepath,
 
   FileData *fd = filedata_new(reports);
   fd->file = file;
+  fd->mapping = mapping;
 
   return fd;
 }
 
-static FileData *blo_filedata_from_file_open(const char *filepath, BlendFileReadReport *reports)
+static FileData *blo_filedata_from_file_open(const char *filepath,
+                                            BlendFileReadReport *reports,
+                                            const bool is_library = false)
 {
   errno = 0;
   const int file = BLI_open(filepath, O_BINARY | O_RDONLY, 0);
@@ -1234,12 +1615,14 @@ static FileData *blo_filedata_from_file_open(const char *filepath, BlendFileRead
                 errno ? strerror(errno) : RPT_("unknown error reading file"));
     return nullptr;
   }
-  return blo_filedata_from_file_descriptor(filepath, reports, file);
+  return blo_filedata_from_file_descriptor(filepath, reports, file, is_library);
 }
 
-FileData *blo_filedata_from_file(const char *filepath, BlendFileReadReport *reports)
+static FileData *blo_filedata_from_file_ex(const char *filepath,
+                                          BlendFileReadReport *reports,
+                                          const bool is_library)
 {
-  FileData *fd = blo_filedata_from_file_open(filepath, reports);
+  FileData *fd = blo_filedata_from_file_open(filepath, reports, is_library);
   if (fd != nullptr) {
     /* needed for library_append and read_libraries */
     STRNCPY(fd->relabase, filepath);
@@ -1249,6 +1632,16 @@ FileData *blo_filedata_from_file(const char *filepath, BlendFileReadReport *repo
   return nullptr;
 }
 
+FileData *blo_filedata_from_file(const char *filepath, BlendFileReadReport *reports)
+{
+  return blo_filedata_from_file_ex(filepath, reports, false);
+}
+
+FileData *blo_filedata_from_library_file(const char *filepath, BlendFileReadReport *reports)
+{
+  return blo_filedata_from_file_ex(filepath, reports, true);
+}
+
 /**
  * Same as blo_filedata_from_file(), but does not reads DNA data, only header.
  * Use it for light access (e.g. thumbnail reading).
@@ -1330,6 +1723,13 @@ void blo_filedata_free(FileData *fd)
 #endif
   fd->file->close(fd->file);
 
+#ifdef USE_MMAP_DATA_SHARING
+  if (fd->mapping) {
+    /* Data referenced in the mapped file keeps the mapping alive. */
+    fd->mapping->remove_user_and_delete_if_last();
+  }
+#endif
+
   if (fd->filesdna) {
     DNA_sdna_free(fd->filesdna);
   }
@@ -1422,16 +1822,32 @@ short BLO_version_from_file(const char *filepath)
 /** \name Old/New Pointer Map
  * \{ */
 
+static void *datamap_lookup_and_inc(FileData *fd, const void *adr, const bool increase_users)
+{
+#ifdef USE_MMAP_DATA_SHARING
+  if (fd->mapping) {
+    NewAddress *entry = fd->datamap->map.lookup_ptr(adr);
+    if (entry && entry->newp == nullptr && entry->deferred_bhead) {
+      /* The data is accessed without going through #BLO_read_shared_mapped, so a regular copy
+       * is needed now. */
+      entry->newp = read_struct(fd, entry->deferred_bhead, "Data from mapped file");
+      entry->deferred_bhead = nullptr;
+    }
+  }
+#endif
+  return oldnewmap_lookup_and_inc(fd->datamap, adr, increase_users);
+}
+
 /* Only direct data-blocks. */
 static void *newdataadr(FileData *fd, const void *adr)
 {
-  return oldnewmap_lookup_and_inc(fd->datamap, adr, true);
+  return datamap_lookup_and_inc(fd, adr, true);
 }
 
 /* Only direct data-blocks. */
 static void *newdataadr_no_us(FileData *fd, const void *adr)
 {
-  return oldnewmap_lookup_and_inc(fd->datamap, adr, false);
+  return datamap_lookup_and_inc(fd, adr, false);
 }
 
 void *blo_read_get_new_globaldata_address(FileData *fd, const void *adr)
@@ -1446,7 +1862,7 @@ static void *newpackedadr(FileData *fd, const void *adr)
     return oldnewmap_lookup_and_inc(fd->packedmap, adr, true);
   }
 
-  return oldnewmap_lookup_and_inc(fd->datamap, adr, true);
+  return datamap_lookup_and_inc(fd, adr, true);
 }
 
 /* only lib data */
@@ -2487,6 +2903,18 @@ static BHead *read_data_into_datamap(FileData *fd, BHead *bhead, const char *all
     }
 #endif
 
+#ifdef USE_MMAP_DATA_SHARING
+    if (fd->mapping && bhead->len >= fd->mapping->min_block_size &&
+        !BHEADN_FROM_BHEAD(bhead)->has_data && !(fd->flags & FD_FLAGS_SWITCH_ENDIAN) &&
+        fd->compflags[bhead->SDNAnr] == SDNA_CMP_EQUAL)
+    {
+      /* The data may be used directly from the mapped file, only read it when needed. */
+      oldnewmap_insert_deferred(fd->datamap, bhead->old, bhead);
+      bhead = blo_bhead_next(fd, bhead);
+      continue;
+    }
+#endif
+
     void *data = read_struct(fd, bhead, allocname);
     if (data) {
       oldnewmap_insert(fd->datamap, bhead->old, data, 0);
@@ -4630,7 +5058,8 @@ static FileData *read_library_file_data(FileData *basefd,
                      mainptr->curlib->runtime.filepath_abs,
                      mainptr->curlib->filepath,
                      library_parent_filepath(mainptr->curlib));
-    fd = blo_filedata_from_file(mainptr->curlib->runtime.filepath_abs, basefd->reports);
+    fd = blo_filedata_from_library_file(mainptr->curlib->runtime.filepath_abs,
+                                        basefd->reports);
   }
 
   if (fd) {
@@ -5047,6 +5476,42 @@ void blo_read_shared_impl(
   *r_sharing_info = read_fn();
 }
 
+const blender::ImplicitSharingInfo *BLO_read_shared_mapped(BlendDataReader *reader,
+                                                           void **data_ptr,
+                                                           const size_t size,
+                                                           const size_t alignment)
+{
+#ifdef USE_MMAP_DATA_SHARING
+  FileData *fd = reader->fd;
+  if (fd->mapping == nullptr || *data_ptr == nullptr || size == 0) {
+    return nullptr;
+  }
+  NewAddress *entry = fd->datamap->map.lookup_ptr(*data_ptr);
+  if (entry == nullptr || entry->deferred_bhead == nullptr) {
+    /* Not a deferred data block, or it has been read already. */
+    return nullptr;
+  }
+  const BHead *bhead = entry->deferred_bhead;
+  if (size_t(bhead->len) < size) {
+    /* Let the regular reading code deal with invalid data. */
+    return nullptr;
+  }
+  void *data = fd->mapping->data_for_bhead(bhead);
+  if (data == nullptr || uintptr_t(data) % alignment != 0) {
+    return nullptr;
+  }
+  if (entry->mapped_sharing_info == nullptr) {
+    entry->mapped_sharing_info = MEM_new<MappedDataSharingInfo>(__func__, *fd->mapping);
+  }
+  entry->mapped_sharing_info->add_user();
+  *data_ptr = data;
+  return entry->mapped_sharing_info;
+#else
+  UNUSED_VARS(reader, data_ptr, size, alignment);
+  return nullptr;
+#endif
+}
+
 bool BLO_read_data_is_undo(BlendDataReader *reader)
 {
   return (reader->fd->flags & FD_FLAGS_IS_MEMFILE);
@@ -23,6 +23,7 @@
 #include "BLO_readfile.hh"
 
 struct BlendFileData;
+struct BlendFileMapping;
 struct BlendFileReadParams;
 struct BlendFileReadReport;
 struct BLOCacheStorage;
@@ -61,6 +62,13 @@ struct FileData {
 
   FileReader *file;
 
+  /**
+   * Copy-on-write memory mapping of the file, used to reference large arrays directly in the
+   * mapped memory instead of copying them (see #BLO_read_shared_mapped). Only set for
+   * uncompressed files when enabled in the preferences.
+   */
+  BlendFileMapping *mapping;
+
   /** Whether we are undoing (< 0) or redoing (> 0), used to choose which 'unchanged' flag to use
    * to detect unchanged data from memfile. */
   int undo_direction; /* eUndoStepDir */
@@ -143,6 +151,46 @@ struct FileData {
 
 #define SIZEOFBLENDERHEADER 12
 
+/**
+ * Incremental files, written by #BLO_write_file_incremental, store the regular blend-file data
+ * split into chunks that can be anywhere in the file. Consecutive saves then only have to append
+ * the chunks that changed, a new manifest and a footer. The file is never modified otherwise, so
+ * the last save with a complete footer stays readable when writing is interrupted. The layout is:
+ * - #IncrementalFileHeader.
+ * - For every save:
+ *   - Chunk data, in any order, padded to 8 bytes.
+ *   - A #IncrementalFileManifest followed by #IncrementalFileManifest.chunks_num
+ *     #IncrementalFileChunk.
+ *   - #IncrementalFileFooter.
+ *
+ * Values are stored in the byte order of the machine, these files are only meant for auto-save.
+ */
+#define BLEND_INCREMENTAL_FILE_MAGIC "BLENDINC"
+#define BLEND_INCREMENTAL_FILE_FOOTER_MAGIC "BLENDEND"
+
+struct IncrementalFileHeader {
+  char magic[8];
+};
+
+struct IncrementalFileManifest {
+  /** Size of the blend-file data. */
+  uint64_t data_len;
+  uint64_t chunks_num;
+};
+
+struct IncrementalFileChunk {
+  uint64_t offset;
+  uint64_t len;
+};
+
+/** Written after the manifest once everything else is on disk, aligned to 8 bytes. */
+struct IncrementalFileFooter {
+  uint64_t manifest_offset;
+  /** Hash of the manifest and its chunks, to detect footers that weren't written completely. */
+  uint64_t manifest_hash;
+  char magic[8];
+};
+
 /***/
 void blo_join_main(ListBase *mainlist);
 void blo_split_main(ListBase *mainlist, Main *main);
@@ -155,6 +203,11 @@ BlendFileData *blo_read_file_internal(FileData *fd, const char *filepath) ATTR_N
  * cannot be called with relative paths anymore!
  */
 FileData *blo_filedata_from_file(const char *filepath, BlendFileReadReport *reports);
+/**
+ * Same as #blo_filedata_from_file, for files that linked data is read from. This allows reading
+ * the data of linked data-blocks lazily (see the "Lazy Linked Data" experimental option).
+ */
+FileData *blo_filedata_from_library_file(const char *filepath, BlendFileReadReport *reports);
 FileData *blo_filedata_from_memory(const void *mem, int memsize, BlendFileReadReport *reports);
 FileData *blo_filedata_from_memfile(MemFile *memfile,
                                     const BlendFileReadParams *params,
@@ -87,6 +87,7 @@
 #include "DNA_key_types.h"
 #include "DNA_sdna_types.h"
 
+#include "BLI_array.hh"
 #include "BLI_bitmap.h"
 #include "BLI_blenlib.h"
 #include "BLI_endian_defines.h"
@@ -94,9 +95,12 @@
 #include "BLI_implicit_sharing.hh"
 #include "BLI_link_utils.h"
 #include "BLI_linklist.h"
+#include "BLI_map.hh"
 #include "BLI_math_base.h"
 #include "BLI_mempool.h"
+#include "BLI_task.hh"
 #include "BLI_threads.h"
+#include "BLI_vector.hh"
 
 #include "MEM_guardedalloc.h" /* MEM_freeN */
 
@@ -126,6 +130,7 @@
 
 #include "readfile.hh"
 
+#include <xxhash.h>
 #include <zstd.h>
 
 /* Make preferences read-only. */
@@ -142,6 +147,9 @@
 
 #define ZSTD_COMPRESSION_LEVEL 3
 
+/** Number of IDs serialized per thread before their data is appended to the file in order. */
+#define WRITE_THREADED_IDS_PER_THREAD 4
+
 static CLG_LogRef LOG = {"blo.writefile"};
 
 /** Use if we want to store how many bytes have been written to the file. */
@@ -166,6 +174,11 @@ class WriteWrap {
 
   /** Buffer output (we only want when output isn't already buffered). */
   bool use_buf = true;
+  /**
+   * Flush the buffer at the end of every ID, in buffers of the same size as undo steps. IDs that
+   * didn't change are then always written with identical #write calls.
+   */
+  bool use_id_chunks = false;
 };
 
 class RawWriteWrap : public WriteWrap {
@@ -395,6 +408,16 @@ bool ZstdWriteWrap::write(const void *buf, size_t buf_len)
 /** \name Write Data Type & Functions
  * \{ */
 
+/**
+ * Data written for a single ID on a worker thread, see #write_ids_threaded.
+ */
+struct WriteDataRecording {
+  /** All data passed to #mywrite, in order. */
+  blender::Vector<uchar> data;
+  /** Size of each #mywrite call, replaying them gives exactly the same buffering. */
+  blender::Vector<size_t> write_lens;
+};
+
 struct WriteData {
   const SDNA *sdna;
 
@@ -429,6 +452,12 @@ struct WriteData {
    * Will be nullptr for UNDO.
    */
   WriteWrap *ww;
+
+  /**
+   * When set, all data is recorded here instead of being written,
+   * to be replayed into the main #WriteData later.
+   */
+  WriteDataRecording *recording;
 };
 
 struct BlendWriter {
@@ -444,7 +473,7 @@ static WriteData *writedata_new(WriteWrap *ww)
   wd->ww = ww;
 
   if ((ww == nullptr) || (ww->use_buf)) {
-    if (ww == nullptr) {
+    if ((ww == nullptr) || ww->use_id_chunks) {
       wd->buffer.max_size = MEM_BUFFER_SIZE;
       wd->buffer.chunk_size = MEM_CHUNK_SIZE;
     }
@@ -458,6 +487,17 @@ static WriteData *writedata_new(WriteWrap *ww)
   return wd;
 }
 
+static WriteData *writedata_new_for_recording(const WriteData *wd_main,
+                                              WriteDataRecording *recording)
+{
+  WriteData *wd = MEM_new<WriteData>(__func__);
+
+  wd->sdna = wd_main->sdna;
+  wd->recording = recording;
+
+  return wd;
+}
+
 static void writedata_do_write(WriteData *wd, const void *mem, size_t memlen)
 {
   if ((wd == nullptr) || wd->error || (mem == nullptr) || memlen < 1) {
@@ -526,6 +566,12 @@ static void mywrite(WriteData *wd, const void *adr, size_t len)
     return;
   }
 
+  if (wd->recording) {
+    wd->recording->data.extend(blender::Span(static_cast<const uchar *>(adr), int64_t(len)));
+    wd->recording->write_lens.append(len);
+    return;
+  }
+
 #ifdef USE_WRITE_DATA_LEN
   wd->write_len += len;
 #endif
@@ -564,6 +610,18 @@ static void mywrite(WriteData *wd, const void *adr, size_t len)
   }
 }
 
+/**
+ * Write data previously recorded for an ID, see #WriteDataRecording.
+ */
+static void mywrite_replay(WriteData *wd, const WriteDataRecording &recording)
+{
+  const uchar *data = recording.data.data();
+  for (const size_t len : recording.write_lens) {
+    mywrite(wd, data, len);
+    data += len;
+  }
+}
+
 /**
  * BeGiN initializer for mywrite
  * \param ww: File write wrapper.
@@ -641,7 +699,7 @@ static void mywrite_id_begin(WriteData *wd, ID *id)
 /**
  * Start writing of data related to a single ID.
  *
- * Only does something when storing an undo step.
+ * Only does something when storing an undo step, or when the #WriteWrap uses ID chunks.
  */
 static void mywrite_id_end(WriteData *wd, ID * /*id*/)
 {
@@ -651,6 +709,9 @@ static void mywrite_id_end(WriteData *wd, ID * /*id*/)
     mywrite_flush(wd);
     wd->mem.current_id_session_uid = MAIN_ID_SESSION_UID_UNSET;
   }
+  else if (wd->ww && wd->ww->use_id_chunks) {
+    mywrite_flush(wd);
+  }
 }
 
 /** \} */
@@ -1202,6 +1263,89 @@ static int write_id_direct_linked_data_process_cb(LibraryIDLinkCallbackData *cb_
   return IDWALK_RET_NOP;
 }
 
+/**
+ * Whether IDs of this type can be serialized from multiple threads at once. Only types whose
+ * writing code was checked to only modify data owned by the written ID are listed, other types
+ * are written on the main thread. Scenes for example may sync their view layers while written.
+ */
+static bool write_id_type_supports_threading(const IDTypeInfo *id_type)
+{
+  switch (ID_Type(id_type->id_code)) {
+    case ID_AC:
+    case ID_CA:
+    case ID_CU_LEGACY:
+    case ID_CV:
+    case ID_IM:
+    case ID_LA:
+    case ID_LP:
+    case ID_LT:
+    case ID_MA:
+    case ID_MB:
+    case ID_ME:
+    case ID_NT:
+    case ID_OB:
+    case ID_PT:
+    case ID_SPK:
+    case ID_TE:
+    case ID_VO:
+      return true;
+    default:
+      return false;
+  }
+}
+
+static void write_id(WriteData *wd, BLO_Write_IDBuffer *id_buffer, ID *id)
+{
+  BlendWriter writer = {wd};
+
+  id_buffer_init_from_id(id_buffer, id, wd->use_memfile);
+
+  if (id_buffer->id_type->blend_write != nullptr) {
+    id_buffer->id_type->blend_write(&writer, static_cast<ID *>(id_buffer->temp_id), id);
+  }
+}
+
+/**
+ * Serialize all given IDs (of the same type) in parallel, each into its own recording, and
+ * append those to the file in the given order. The result is identical to writing them one after
+ * the other on a single thread.
+ */
+static void write_ids_threaded(WriteData *wd,
+                               BLO_Write_IDBuffer *id_buffer,
+                               const blender::Span<ID *> ids)
+{
+  using namespace blender;
+  BLI_assert(!wd->use_memfile);
+
+  if (ids.size() == 1) {
+    mywrite_id_begin(wd, ids[0]);
+    write_id(wd, id_buffer, ids[0]);
+    mywrite_id_end(wd, ids[0]);
+    return;
+  }
+
+  const IDTypeInfo *id_type = id_buffer->id_type;
+  Array<WriteDataRecording> recordings(ids.size());
+  threading::parallel_for(ids.index_range(), 1, [&](const IndexRange range) {
+    BLO_Write_IDBuffer *thread_id_buffer = BLO_write_allocate_id_buffer();
+    id_buffer_init_for_id_type(thread_id_buffer, id_type);
+    for (const int64_t i : range) {
+      WriteData *thread_wd = writedata_new_for_recording(wd, &recordings[i]);
+      write_id(thread_wd, thread_id_buffer, ids[i]);
+      writedata_free(thread_wd);
+    }
+    BLO_write_destroy_id_buffer(&thread_id_buffer);
+  });
+
+  for (const int64_t i : ids.index_range()) {
+    mywrite_id_begin(wd, ids[i]);
+    mywrite_replay(wd, recordings[i]);
+    mywrite_id_end(wd, ids[i]);
+    /* Release memory as soon as possible, recordings of big IDs can be large. */
+    recordings[i] = {};
+  }
+}
+
 /**
  * When #MemFile arguments are non-null, this is a file-safe to memory.
  *
@@ -1288,6 +1432,7 @@ static bool write_file_handle(Main *mainvar,
    * if needed, without duplicating whole code. */
   Main *bmain = mainvar;
   BLO_Write_IDBuffer *id_buffer = BLO_write_allocate_id_buffer();
+  const int64_t threads_num = BLI_system_thread_count();
   do {
     ListBase *lbarray[INDEX_ID_MAX];
     int a = set_listbasepointers(bmain, lbarray);
@@ -1301,6 +1446,12 @@ static bool write_file_handle(Main *mainvar,
       const IDTypeInfo *id_type = BKE_idtype_get_info_from_id(id);
       id_buffer_init_for_id_type(id_buffer, id_type);
 
+      /* When saving to disk, IDs are serialized in parallel in batches, undo steps need to be
+       * written in order to reuse unchanged chunks from the previous step. */
+      const bool use_threading = !wd->use_memfile && threads_num > 1 &&
+                                 write_id_type_supports_threading(id_type);
+      blender::Vector<ID *> ids_threaded;
+
       for (; id; id = static_cast<ID *>(id->next)) {
         /* We should never attempt to write non-regular IDs
          * (i.e. all kind of temp/runtime ones). */
@@ -1349,17 +1500,29 @@ static bool write_file_handle(Main *mainvar,
               bmain, id, write_id_direct_linked_data_process_cb, nullptr, IDWALK_READONLY);
         }
 
+        if (use_threading && !do_override) {
+          ids_threaded.append(id);
+          if (ids_threaded.size() >= threads_num * WRITE_THREADED_IDS_PER_THREAD) {
+            write_ids_threaded(wd, id_buffer, ids_threaded);
+            ids_threaded.clear();
+          }
+          continue;
+        }
+
+        /* Override operations storage modifies shared data, such IDs are always written from the
+         * main thread, after the ones preceding them. */
+        if (!ids_threaded.is_empty()) {
+          write_ids_threaded(wd, id_buffer, ids_threaded);
+          ids_threaded.clear();
+        }
+
         if (do_override) {
           BKE_lib_override_library_operations_store_start(bmain, override_storage, id);
         }
 
         mywrite_id_begin(wd, id);
 
-        id_buffer_init_from_id(id_buffer, id, wd->use_memfile);
-
-        if (id_type->blend_write != nullptr) {
-          id_type->blend_write(&writer, static_cast<ID *>(id_buffer->temp_id), id);
-        }
+        write_id(wd, id_buffer, id);
 
         if (do_override) {
           BKE_lib_override_library_operations_store_end(override_storage, id);
@@ -1368,6 +1531,10 @@ static bool write_file_handle(Main *mainvar,
         mywrite_id_end(wd, id);
       }
 
+      if (!ids_threaded.is_empty()) {
+        write_ids_threaded(wd, id_buffer, ids_threaded);
+      }
+
       mywrite_flush(wd);
     }
   } while ((bmain != override_storage) && (bmain = override_storage));
@@ -1644,6 +1811,203 @@ static bool BLO_write_file_impl(Main *mainvar,
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name Incremental File Writing (Private)
+ * \{ */
+
+/** Rewrite the whole file when it becomes this many times larger than the data it contains. */
+#define INCREMENTAL_FILE_REWRITE_FACTOR 3
+
+/** Identifies the content of a chunk of blend-file data. */
+struct IncrementalChunkKey {
+  uint64_t hash_low;
+  uint64_t hash_high;
+  uint64_t len;
+
+  uint64_t hash() const
+  {
+    return hash_low;
+  }
+
+  friend bool operator==(const IncrementalChunkKey &a, const IncrementalChunkKey &b)
+  {
+    return a.hash_low == b.hash_low && a.hash_high == b.hash_high && a.len == b.len;
+  }
+};
+
+struct BlendFileIncrementalStore {
+  /** Offset in the file of the chunks used by the last successful save. */
+  blender::Map<IncrementalChunkKey, uint64_t> chunk_offsets;
+
+  /** The file written by the last successful save. */
+  char filepath[FILE_MAX] = "";
+  /** Size of #filepath, new chunks are appended at the end. */
+  uint64_t file_size = 0;
+  /** Size of the blend-file data of the last successful save. */
+  uint64_t data_len = 0;
+};
+
+static void incremental_store_reset(BlendFileIncrementalStore *store)
+{
+  store->chunk_offsets.clear();
+  store->filepath[0] = '\0';
+  store->file_size = 0;
+  store->data_len = 0;
+}
+
+static bool incremental_file_write_all(int file, const void *data, size_t len)
+{
+  const char *data_step = static_cast<const char *>(data);
+  while (len > 0) {
+    /* Writes may be shorter than requested, e.g. when interrupted by a signal. */
+    const int64_t written_len = ::write(file, data_step, uint(std::min<size_t>(len, INT_MAX)));
+    if (written_len < 0 && errno == EINTR) {
+      continue;
+    }
+    if (written_len <= 0) {
+      return false;
+    }
+    data_step += written_len;
+    len -= size_t(written_len);
+  }
+  return true;
+}
+
+/** Make sure everything written so far is on disk, before data depending on it is written. */
+static bool incremental_file_sync(int file)
+{
+#ifdef WIN32
+  return _commit(file) == 0;
+#else
+  return fsync(file) == 0;
+#endif
+}
+
+/**
+ * Appends the chunks of blend-file data that are not in the file yet, and records where all
+ * chunks of the data are. The data is flushed at the end of every ID, so IDs that did not change
+ * since the previous save result in identical chunks that don't have to be written again.
+ */
+class IncrementalWriteWrap : public WriteWrap {
+ public:
+  const BlendFileIncrementalStore &store;
+  int file;
+  /** End of the file, new chunks are written there. */
+  uint64_t file_size;
+  uint64_t data_len = 0;
+  /** Offset in the file of every chunk of the new data. */
+  blender::Map<IncrementalChunkKey, uint64_t> chunk_offsets;
+  blender::Vector<IncrementalFileChunk> manifest_chunks;
+
+  IncrementalWriteWrap(const BlendFileIncrementalStore &store, int file, uint64_t file_size)
+      : store(store), file(file), file_size(file_size)
+  {
+    use_id_chunks = true;
+  }
+
+  /** The file is opened by the caller, which may append to an existing file. */
+  bool open(const char * /*filepath*/) override
+  {
+    return true;
+  }
+  bool close() override
+  {
+    return this->flush();
+  }
+  bool write(const void *buf, size_t buf_len) override;
+
+  /** Write the new chunks that are still in the buffer. */
+  bool flush();
+
+ private:
+  /** Group consecutive new chunks into larger writes. */
+  blender::Vector<uchar> write_buffer;
+};
+
+bool IncrementalWriteWrap::write(const void *buf, size_t buf_len)
+{
+  using namespace blender;
+
+  const XXH128_hash_t hash = XXH3_128bits(buf, buf_len);
+  const IncrementalChunkKey key = {hash.low64, hash.high64, buf_len};
+  data_len += buf_len;
+
+  uint64_t offset;
+  if (const uint64_t *offset_written = store.chunk_offsets.lookup_ptr(key)) {
+    offset = *offset_written;
+  }
+  else if (const uint64_t *offset_new = chunk_offsets.lookup_ptr(key)) {
+    offset = *offset_new;
+  }
+  else {
+    offset = file_size;
+    file_size += buf_len;
+    if (write_buffer.size() + int64_t(buf_len) > ZSTD_BUFFER_SIZE && !this->flush()) {
+      return false;
+    }
+    write_buffer.extend(Span(static_cast<const uchar *>(buf), int64_t(buf_len)));
+  }
+  chunk_offsets.add(key, offset);
+  manifest_chunks.append({offset, buf_len});
+  return true;
+}
+
+bool IncrementalWriteWrap::flush()
+{
+  const bool ok = incremental_file_write_all(
+      file, write_buffer.data(), size_t(write_buffer.size()));
+  write_buffer.clear();
+  return ok;
+}
+
+/**
+ * Write the manifest of the data written by \a wrap and the footer that makes it visible to
+ * readers. Everything before the footer is synced to disk first, so a crash never leaves a footer
+ * pointing to incomplete data.
+ */
+static bool incremental_file_finish(IncrementalWriteWrap &wrap)
+{
+  if (!wrap.flush()) {
+    return false;
+  }
+
+  /* Footers are aligned, so readers can find them when an interrupted save left data after the
+   * last complete one. */
+  const uint64_t padding_len = (8 - wrap.file_size % 8) % 8;
+  const uint64_t padding = 0;
+  if (!incremental_file_write_all(wrap.file, &padding, size_t(padding_len))) {
+    return false;
+  }
+  wrap.file_size += padding_len;
+
+  IncrementalFileManifest manifest;
+  manifest.data_len = wrap.data_len;
+  manifest.chunks_num = uint64_t(wrap.manifest_chunks.size());
+  const size_t chunks_size = size_t(wrap.manifest_chunks.as_span().size_in_bytes());
+
+  IncrementalFileFooter footer;
+  footer.manifest_offset = wrap.file_size;
+  footer.manifest_hash = XXH3_64bits_withSeed(
+      wrap.manifest_chunks.data(), chunks_size, XXH3_64bits(&manifest, sizeof(manifest)));
+  memcpy(footer.magic, BLEND_INCREMENTAL_FILE_FOOTER_MAGIC, sizeof(footer.magic));
+
+  if (!incremental_file_write_all(wrap.file, &manifest, sizeof(manifest)) ||
+      !incremental_file_write_all(wrap.file, wrap.manifest_chunks.data(), chunks_size) ||
+      !incremental_file_sync(wrap.file))
+  {
+    return false;
+  }
+  if (!incremental_file_write_all(wrap.file, &footer, sizeof(footer)) ||
+      !incremental_file_sync(wrap.file))
+  {
+    return false;
+  }
+  wrap.file_size += sizeof(manifest) + chunks_size + sizeof(footer);
+  return true;
+}
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name File Writing (Public)
  * \{ */
@@ -1674,6 +2038,91 @@ bool BLO_write_file_mem(Main *mainvar, MemFile *compare, MemFile *current, int w
   return (err == 0);
 }
 
+BlendFileIncrementalStore *BLO_write_incremental_store_new()
+{
+  return MEM_new<BlendFileIncrementalStore>(__func__);
+}
+
+void BLO_write_incremental_store_free(BlendFileIncrementalStore *store)
+{
+  MEM_delete(store);
+}
+
+bool BLO_write_file_incremental(Main *mainvar,
+                                const char *filepath,
+                                const int write_flags,
+                                BlendFileIncrementalStore *store,
+                                ReportList *reports)
+{
+  BLI_assert(!BLI_path_is_rel(filepath));
+
+  const bool use_rewrite = !STREQ(store->filepath, filepath) || !BLI_exists(filepath) ||
+                           store->file_size > store->data_len * INCREMENTAL_FILE_REWRITE_FACTOR;
+  if (use_rewrite) {
+    incremental_store_reset(store);
+  }
+
+  /* Like regular saves, write a new file to a temporary path so we keep the original in case of
+   * a crash. Existing files are only appended to, the previous save stays readable until the
+   * footer of the new one is written. */
+  char tempname[FILE_MAX + 1];
+  SNPRINTF(tempname, "%s@", filepath);
+  const char *write_filepath = use_rewrite ? tempname : filepath;
+
+  const int file = use_rewrite ?
+                       BLI_open(write_filepath, O_BINARY | O_WRONLY | O_CREAT | O_TRUNC, 0666) :
+                       BLI_open(write_filepath, O_BINARY | O_WRONLY, 0);
+  if (file == -1) {
+    BKE_reportf(reports,
+                RPT_ERROR,
+                "Cannot open file %s for writing: %s",
+                write_filepath,
+                strerror(errno));
+    return false;
+  }
+
+  write_file_main_validate_pre(mainvar, reports);
+
+  bool ok = true;
+  uint64_t file_size = store->file_size;
+  if (use_rewrite) {
+    IncrementalFileHeader header;
+    memcpy(header.magic, BLEND_INCREMENTAL_FILE_MAGIC, sizeof(header.magic));
+    ok = incremental_file_write_all(file, &header, sizeof(header));
+    file_size = sizeof(header);
+  }
+  else {
+    ok = BLI_lseek(file, int64_t(file_size), SEEK_SET) == int64_t(file_size);
+  }
+
+  IncrementalWriteWrap wrap(*store, file, file_size);
+  ok = ok && !write_file_handle(mainvar, &wrap, nullptr, nullptr, write_flags, false, nullptr);
+  ok = ok && incremental_file_finish(wrap);
+  ok = (::close(file) != -1) && ok;
+
+  if (ok && use_rewrite) {
+    ok = BLI_rename_overwrite(tempname, filepath) == 0;
+  }
+  if (!ok) {
+    BKE_reportf(reports, RPT_ERROR, "Cannot write file %s: %s", filepath, strerror(errno));
+    if (use_rewrite) {
+      remove(tempname);
+    }
+    /* The file may now end with incomplete data, start from scratch on the next save. */
+    incremental_store_reset(store);
+    return false;
+  }
+
+  store->chunk_offsets = std::move(wrap.chunk_offsets);
+  STRNCPY(store->filepath, filepath);
+  store->file_size = wrap.file_size;
+  store->data_len = wrap.data_len;
+
+  write_file_main_validate_post(mainvar, reports);
+
+  return true;
+}
+
 /*
  * API to handle writing IDs while clearing some of their runtime data.
  */
@@ -1857,13 +2306,22 @@ void BLO_write_shared(BlendWriter *writer,
       if (memfile.shared_storage == nullptr) {
         memfile.shared_storage = MEM_new<MemFileSharedStorage>(__func__);
       }
-      if (memfile.shared_storage->map.add(data, sharing_info)) {
+      const blender::ImplicitSharingInfo *&stored_sharing_info =
+          memfile.shared_storage->map.lookup_or_add(data, nullptr);
+      if (stored_sharing_info == nullptr) {
         /* The undo-step takes (shared) ownership of the data, which also makes it immutable. */
         sharing_info->add_user();
+        stored_sharing_info = sharing_info;
         /* This size is an estimate, but good enough to count data with many users less. */
         memfile.size += approximate_size_in_bytes / sharing_info->strong_users();
         return;
       }
+      if (stored_sharing_info == sharing_info) {
+        /* The same data is used by multiple data-blocks (e.g. duplicated geometry), it is already
+         * owned by the undo-step and can be found by its address when reading. Writing it again
+         * would serialize and compare all of it on every undo push. */
+        return;
+      }
     }
   }
   write_fn();
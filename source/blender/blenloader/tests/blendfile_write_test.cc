@@ -0,0 +1,274 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+#include "blendfile_loading_base_test.h"
+
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "BKE_customdata.hh"
+#include "BKE_global.hh"
+#include "BKE_lib_id.hh"
+#include "BKE_main.hh"
+
+#include "BLI_fileops.h"
+#include "BLI_listbase.h"
+#include "BLI_math_vector_types.hh"
+#include "BLI_path_util.h"
+#include "BLI_threads.h"
+
+#include "BLO_readfile.hh"
+#include "BLO_undofile.hh"
+#include "BLO_writefile.hh"
+
+#include "DNA_ID.h"
+#include "DNA_mesh_types.h"
+#include "DNA_object_types.h"
+
+class BlendfileWriteTest : public BlendfileLoadingBaseTest {
+ protected:
+  std::string temp_filepath() const
+  {
+    return testing::TempDir() + "blendfile_write_test.blend";
+  }
+
+  /* Add copies of the meshes and objects, so that there are enough IDs of the same type to be
+   * written in parallel. */
+  void add_id_copies(const int copies_num)
+  {
+    Main *bmain = bfile->main;
+    for (ListBase *lb : {&bmain->meshes, &bmain->objects}) {
+      ID *last_id = static_cast<ID *>(lb->last);
+      for (int i = 0; i < copies_num; i++) {
+        LISTBASE_FOREACH (ID *, id, lb) {
+          BKE_id_copy(bmain, id);
+          if (id == last_id) {
+            break;
+          }
+        }
+      }
+    }
+  }
+
+  std::vector<char> write_and_read_bytes(const int write_flags)
+  {
+    const std::string filepath = temp_filepath();
+    BlendFileWriteParams params{};
+    EXPECT_TRUE(BLO_write_file(bfile->main, filepath.c_str(), write_flags, &params, nullptr));
+    std::ifstream file(filepath, std::ios::binary);
+    std::vector<char> bytes{std::istreambuf_iterator<char>(file),
+                            std::istreambuf_iterator<char>()};
+    BLI_delete(filepath.c_str(), false, false);
+    return bytes;
+  }
+};
+
+TEST_F(BlendfileWriteTest, ThreadedWriteMatchesSerial)
+{
+  if (!blendfile_load("modifier_stack" SEP_STR "array_test.blend")) {
+    return;
+  }
+  add_id_copies(16);
+
+  for (const int write_flags : {0, int(G_FILE_COMPRESS)}) {
+    BLI_system_num_threads_override_set(1);
+    const std::vector<char> serial_bytes = write_and_read_bytes(write_flags);
+    BLI_system_num_threads_override_set(8);
+    const std::vector<char> threaded_bytes = write_and_read_bytes(write_flags);
+    BLI_system_num_threads_override_set(0);
+
+    EXPECT_FALSE(serial_bytes.empty());
+    EXPECT_TRUE(serial_bytes == threaded_bytes) << "write flags: " << write_flags;
+  }
+}
+
+TEST_F(BlendfileWriteTest, ThreadedWriteKeepsOrder)
+{
+  if (!blendfile_load("modifier_stack" SEP_STR "array_test.blend")) {
+    return;
+  }
+  add_id_copies(16);
+
+  /* Give every object a different location, to detect data written for the wrong object. */
+  Main *bmain = bfile->main;
+  std::vector<std::string> object_names;
+  std::vector<std::string> mesh_names;
+  LISTBASE_FOREACH (Object *, object, &bmain->objects) {
+    object->loc[0] = float(object_names.size());
+    object_names.push_back(object->id.name);
+  }
+  LISTBASE_FOREACH (ID *, id, &bmain->meshes) {
+    mesh_names.push_back(id->name);
+  }
+
+  const std::string filepath = temp_filepath();
+  BlendFileWriteParams params{};
+  BLI_system_num_threads_override_set(8);
+  const bool written = BLO_write_file(bmain, filepath.c_str(), 0, &params, nullptr);
+  BLI_system_num_threads_override_set(0);
+  ASSERT_TRUE(written);
+
+  BlendFileReadReport bf_reports = {};
+  BlendFileData *read_data = BLO_read_from_file(filepath.c_str(), BLO_READ_SKIP_NONE, &bf_reports);
+  BLI_delete(filepath.c_str(), false, false);
+  ASSERT_NE(read_data, nullptr);
+
+  /* IDs are read in the order they were written, which has to match the order in the #Main. */
+  std::vector<std::string> read_object_names;
+  std::vector<std::string> read_mesh_names;
+  LISTBASE_FOREACH (const Object *, object, &read_data->main->objects) {
+    EXPECT_EQ(object->loc[0], float(read_object_names.size())) << object->id.name;
+    read_object_names.push_back(object->id.name);
+  }
+  LISTBASE_FOREACH (const ID *, id, &read_data->main->meshes) {
+    read_mesh_names.push_back(id->name);
+  }
+  EXPECT_EQ(read_object_names, object_names);
+  EXPECT_EQ(read_mesh_names, mesh_names);
+
+  BLO_blendfiledata_free(read_data);
+}
+
+/* Number of bytes serialized into the undo step, without the data it took ownership of. */
+static int64_t memfile_written_size(const MemFile &memfile)
+{
+  int64_t size = 0;
+  LISTBASE_FOREACH (const MemFileChunk *, chunk, &memfile.chunks) {
+    size += int64_t(chunk->size);
+  }
+  return size;
+}
+
+TEST_F(BlendfileWriteTest, MemfileUndoSharedArrays)
+{
+  if (!blendfile_load("modifier_stack" SEP_STR "array_test.blend")) {
+    return;
+  }
+  using namespace blender;
+  Main *bmain = bfile->main;
+
+  /* A mesh with enough vertices for its positions to dominate the size of the undo step. */
+  const int verts_num = 100000;
+  Mesh *mesh = static_cast<Mesh *>(BKE_id_new(bmain, ID_ME, "SharedPositions"));
+  mesh->verts_num = verts_num;
+  CustomData_add_layer_named(
+      &mesh->vert_data, CD_PROP_FLOAT3, CD_CONSTRUCT, verts_num, "position");
+  MutableSpan<float3> positions = mesh->vert_positions_for_write();
+  for (const int i : positions.index_range()) {
+    positions[i] = float3(float(i), 0.0f, 0.0f);
+  }
+
+  MemFile memfile_single = {};
+  ASSERT_TRUE(BLO_write_file_mem(bmain, nullptr, &memfile_single, 0));
+
+  /* The copy shares the positions with the original mesh. */
+  Mesh *mesh_copy = reinterpret_cast<Mesh *>(BKE_id_copy(bmain, &mesh->id));
+  ASSERT_EQ(mesh_copy->vert_positions().data(), mesh->vert_positions().data());
+  const std::string mesh_name = mesh->id.name + 2;
+  const std::string mesh_copy_name = mesh_copy->id.name + 2;
+
+  MemFile memfile = {};
+  ASSERT_TRUE(BLO_write_file_mem(bmain, nullptr, &memfile, 0));
+  ASSERT_NE(memfile.shared_storage, nullptr);
+  EXPECT_TRUE(memfile.shared_storage->map.contains(mesh->vert_positions().data()));
+
+  /* The undo step owns the positions already, the second user does not write them again. */
+  EXPECT_LT(memfile_written_size(memfile) - memfile_written_size(memfile_single),
+            int64_t(positions.size_in_bytes() / 2));
+
+  /* Both meshes get the positions back from the undo step. */
+  Main *old_main = BKE_main_new();
+  BlendFileReadParams params{};
+  params.skip_flags = BLO_READ_SKIP_USERDEF;
+  BlendFileData *read_data = BLO_read_from_memfile(
+      old_main, BKE_main_blendfile_path(bmain), &memfile, &params, nullptr);
+  BKE_main_free(old_main);
+  ASSERT_NE(read_data, nullptr);
+
+  const Mesh *read_mesh = static_cast<const Mesh *>(
+      BLI_findstring(&read_data->main->meshes, mesh_name.c_str(), offsetof(ID, name) + 2));
+  const Mesh *read_mesh_copy = static_cast<const Mesh *>(
+      BLI_findstring(&read_data->main->meshes, mesh_copy_name.c_str(), offsetof(ID, name) + 2));
+  ASSERT_NE(read_mesh, nullptr);
+  ASSERT_NE(read_mesh_copy, nullptr);
+  EXPECT_EQ(read_mesh_copy->vert_positions().data(), read_mesh->vert_positions().data());
+  EXPECT_EQ(read_mesh_copy->vert_positions().size(), verts_num);
+  EXPECT_EQ(read_mesh_copy->vert_positions().last(), float3(float(verts_num - 1), 0.0f, 0.0f));
+
+  BLO_blendfiledata_free(read_data);
+  BLO_memfile_free(&memfile);
+  BLO_memfile_free(&memfile_single);
+}
+
+TEST_F(BlendfileWriteTest, IncrementalWriteRoundTrip)
+{
+  if (!blendfile_load("modifier_stack" SEP_STR "array_test.blend")) {
+    return;
+  }
+  const std::string filepath = temp_filepath();
+  BlendFileIncrementalStore *store = BLO_write_incremental_store_new();
+
+  Main *bmain = bfile->main;
+  ASSERT_TRUE(BLO_write_file_incremental(bmain, filepath.c_str(), 0, store, nullptr));
+  const size_t full_size = BLI_file_size(filepath.c_str());
+
+  /* Change some data, the second save only appends what changed. */
+  Object *object = static_cast<Object *>(bmain->objects.first);
+  ASSERT_NE(object, nullptr);
+  const std::string object_name = object->id.name;
+  object->loc[0] += 1.5f;
+  const float new_loc_x = object->loc[0];
+  const int objects_num = BLI_listbase_count(&bmain->objects) + 1;
+  BKE_id_copy(bmain, &object->id);
+
+  ASSERT_TRUE(BLO_write_file_incremental(bmain, filepath.c_str(), 0, store, nullptr));
+  EXPECT_LT(BLI_file_size(filepath.c_str()), full_size * 2);
+  BLO_write_incremental_store_free(store);
+
+  /* Recover the file, it has to contain the latest changes. */
+  BlendFileReadReport bf_reports = {};
+  BlendFileData *recovered = BLO_read_from_file(filepath.c_str(), BLO_READ_SKIP_NONE, &bf_reports);
+  BLI_delete(filepath.c_str(), false, false);
+  ASSERT_NE(recovered, nullptr);
+
+  EXPECT_EQ(BLI_listbase_count(&recovered->main->objects), objects_num);
+  const Object *recovered_object = static_cast<const Object *>(
+      BLI_findstring(&recovered->main->objects, object_name.c_str(), offsetof(ID, name)));
+  ASSERT_NE(recovered_object, nullptr);
+  EXPECT_EQ(recovered_object->loc[0], new_loc_x);
+
+  BLO_blendfiledata_free(recovered);
+}
+
+TEST_F(BlendfileWriteTest, IncrementalWriteInterrupted)
+{
+  if (!blendfile_load("modifier_stack" SEP_STR "array_test.blend")) {
+    return;
+  }
+  const std::string filepath = temp_filepath();
+  BlendFileIncrementalStore *store = BLO_write_incremental_store_new();
+
+  Main *bmain = bfile->main;
+  const int objects_num = BLI_listbase_count(&bmain->objects);
+  ASSERT_TRUE(BLO_write_file_incremental(bmain, filepath.c_str(), 0, store, nullptr));
+  BLO_write_incremental_store_free(store);
+
+  /* Simulate a save that was interrupted after writing part of its data, including something
+   * that looks like the start of a footer. */
+  {
+    std::ofstream file(filepath, std::ios::binary | std::ios::app);
+    const std::string garbage = std::string(100003, 'x') + "BLENDEND" + std::string(5, 'y');
+    file.write(garbage.data(), std::streamsize(garbage.size()));
+  }
+
+  /* The previous save is still recovered. */
+  BlendFileReadReport bf_reports = {};
+  BlendFileData *recovered = BLO_read_from_file(filepath.c_str(), BLO_READ_SKIP_NONE, &bf_reports);
+  BLI_delete(filepath.c_str(), false, false);
+  ASSERT_NE(recovered, nullptr);
+  EXPECT_EQ(BLI_listbase_count(&recovered->main->objects), objects_num);
+
+  BLO_blendfiledata_free(recovered);
+}
@@ -551,7 +551,7 @@ void DepsgraphNodeBuilder::tag_previously_tagged_nodes()
     if (operation_node == nullptr) {
       continue;
     }
-    operation_node->flag |= DEPSOP_FLAG_NEEDS_UPDATE;
+    operation_node->tag_needs_update(graph_);
   }
 }
 
@@ -166,6 +166,7 @@ void Depsgraph::clear_id_nodes()
   }
   /* Clear containers. */
   id_hash.clear();
+  updated_operations.clear();
   id_nodes.clear();
   /* Clear physics relation caches. */
   clear_physics_relations(this);
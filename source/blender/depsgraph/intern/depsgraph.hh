@@ -117,6 +117,10 @@ struct Depsgraph {
   /* Nodes which have been tagged as "directly modified". */
   Set<OperationNode *> entry_tags;
 
+  /* Operations which were tagged with DEPSOP_FLAG_NEEDS_UPDATE, so that the evaluation does not
+   * need to look at all operations. Might contain operations which were evaluated since. */
+  Vector<OperationNode *> updated_operations;
+
   /* Convenience Data ................... */
 
   /* XXX: should be collected after building (if actually needed?) */
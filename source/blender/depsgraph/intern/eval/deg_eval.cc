@@ -10,12 +10,19 @@
 
 #include "intern/eval/deg_eval.h"
 
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+#include "BLI_array.hh"
 #include "BLI_compiler_attrs.h"
 #include "BLI_function_ref.hh"
 #include "BLI_gsqueue.h"
 #include "BLI_task.h"
 #include "BLI_time.h"
 #include "BLI_utildefines.h"
+#include "BLI_vector.hh"
 
 #include "BKE_global.hh"
 
@@ -77,29 +84,129 @@ enum class EvaluationStage {
   SINGLE_THREADED_WORKAROUND,
 };
 
+/* Operations which are ready to be evaluated, ordered by their priority.
+ *
+ * A task is pushed to the pool for every operation added to the queue, and every task evaluates
+ * the most important operation at the time it starts. This way the operations on the critical
+ * path are started first, instead of in the order they happened to become ready.
+ *
+ * To avoid all threads waiting for the same lock, the queue is split into shards. Threads push to
+ * their own shard and pop from it too, unless another shard they look at has a more important
+ * operation. The order is therefore only approximately by priority. */
+class ReadyQueue {
+  struct alignas(64) Shard {
+    std::mutex mutex;
+    /* Binary heap with the highest priority operation first. */
+    Vector<OperationNode *> heap;
+    /* Priority of the first operation in the heap, negative when it is empty. Read without
+     * locking to choose the shard to pop from. */
+    std::atomic<float> top_priority = -1.0f;
+  };
+  Array<Shard> shards_;
+
+  static bool compare(const OperationNode *a, const OperationNode *b)
+  {
+    return a->priority < b->priority;
+  }
+
+  int64_t local_shard_index() const
+  {
+    return int64_t(std::hash<std::thread::id>()(std::this_thread::get_id()) %
+                   size_t(shards_.size()));
+  }
+
+  static void update_top_priority(Shard &shard)
+  {
+    shard.top_priority.store(shard.heap.is_empty() ? -1.0f : shard.heap.first()->priority,
+                             std::memory_order_relaxed);
+  }
+
+ public:
+  ReadyQueue() : shards_(std::max(1, BLI_task_scheduler_num_threads())) {}
+
+  void push(OperationNode *node)
+  {
+    Shard &shard = shards_[this->local_shard_index()];
+    std::lock_guard lock{shard.mutex};
+    shard.heap.append(node);
+    std::push_heap(shard.heap.begin(), shard.heap.end(), compare);
+    update_top_priority(shard);
+  }
+
+  OperationNode *pop()
+  {
+    /* Look at a different other shard every time, so all of them are visited eventually. */
+    static thread_local int64_t other_shard_counter = 0;
+    const int64_t local_index = this->local_shard_index();
+    while (true) {
+      int64_t index = local_index;
+      float priority = shards_[index].top_priority.load(std::memory_order_relaxed);
+      const int64_t other_index = (local_index + 1 + other_shard_counter++) % shards_.size();
+      const float other_priority = shards_[other_index].top_priority.load(
+          std::memory_order_relaxed);
+      if (other_priority > priority) {
+        index = other_index;
+        priority = other_priority;
+      }
+      if (priority < 0.0f) {
+        /* Both are empty, there is a ready operation for every task, so find it elsewhere. */
+        for (const int64_t i : shards_.index_range()) {
+          const float shard_priority = shards_[i].top_priority.load(std::memory_order_relaxed);
+          if (shard_priority > priority) {
+            index = i;
+            priority = shard_priority;
+          }
+        }
+      }
+      Shard &shard = shards_[index];
+      std::lock_guard lock{shard.mutex};
+      if (shard.heap.is_empty()) {
+        /* Another thread was faster. */
+        continue;
+      }
+      std::pop_heap(shard.heap.begin(), shard.heap.end(), compare);
+      OperationNode *node = shard.heap.pop_last();
+      update_top_priority(shard);
+      return node;
+    }
+  }
+};
+
 struct DepsgraphEvalState {
   Depsgraph *graph;
   bool do_stats;
   EvaluationStage stage;
   bool need_update_pending_parents = true;
   bool need_single_thread_pass = false;
+  ReadyQueue ready_queue;
 };
 
+void update_operation_cost(OperationNode *operation_node, const double time)
+{
+  /* Smooth the timing over multiple evaluations, to be less sensitive to outliers. */
+  if (operation_node->cost_estimate == 0.0f) {
+    operation_node->cost_estimate = float(time);
+  }
+  else {
+    operation_node->cost_estimate = operation_node->cost_estimate * 0.75f + float(time) * 0.25f;
+  }
+}
+
 void evaluate_node(const DepsgraphEvalState *state, OperationNode *operation_node)
 {
   ::Depsgraph *depsgraph = reinterpret_cast<::Depsgraph *>(state->graph);
 
   /* Sanity checks. */
   BLI_assert_msg(!operation_node->is_noop(), "NOOP nodes should not actually be scheduled");
-  /* Perform operation. */
+  /* Perform operation. The timing is always measured, it is used to prioritize operations in the
+   * next evaluation. */
+  const double start_time = BLI_time_now_seconds();
+  operation_node->evaluate(depsgraph);
+  const double time = BLI_time_now_seconds() - start_time;
   if (state->do_stats) {
-    const double start_time = BLI_time_now_seconds();
-    operation_node->evaluate(depsgraph);
-    operation_node->stats.current_time += BLI_time_now_seconds() - start_time;
-  }
-  else {
-    operation_node->evaluate(depsgraph);
+    operation_node->stats.current_time += time;
   }
+  update_operation_cost(operation_node, time);
 
   /* Clear the flag early on, allowing partial updates without re-evaluating the same node multiple
    * times.
@@ -108,18 +215,25 @@ void evaluate_node(const DepsgraphEvalState *state, OperationNode *operation_nod
   operation_node->flag &= ~DEPSOP_FLAG_CLEAR_ON_EVAL;
 }
 
-void deg_task_run_func(TaskPool *pool, void *taskdata)
+void schedule_operation_task(TaskPool *pool, DepsgraphEvalState *state, OperationNode *node)
+{
+  state->ready_queue.push(node);
+  BLI_task_pool_push(pool, deg_task_run_func, nullptr, false, nullptr);
+}
+
+void deg_task_run_func(TaskPool *pool, void * /*taskdata*/)
 {
   void *userdata_v = BLI_task_pool_user_data(pool);
   DepsgraphEvalState *state = (DepsgraphEvalState *)userdata_v;
 
-  /* Evaluate node. */
-  OperationNode *operation_node = reinterpret_cast<OperationNode *>(taskdata);
+  /* Evaluate the most important node which is ready, not necessarily the one this task was pushed
+   * for. */
+  OperationNode *operation_node = state->ready_queue.pop();
   evaluate_node(state, operation_node);
 
   /* Schedule children. */
   schedule_children(state, operation_node, [&](OperationNode *node) {
-    BLI_task_pool_push(pool, deg_task_run_func, node, false, nullptr);
+    schedule_operation_task(pool, state, node);
   });
 }
 
@@ -186,6 +300,65 @@ void calculate_pending_parents_if_needed(DepsgraphEvalState *state)
   state->need_update_pending_parents = false;
 }
 
+/* Relation between two operations which are both to be evaluated, the child has to wait for the
+ * parent. */
+bool is_relation_between_updated_operations(const Relation *rel)
+{
+  if (rel->from->type != NodeType::OPERATION || rel->to->type != NodeType::OPERATION) {
+    return false;
+  }
+  if (rel->flag & RELATION_FLAG_CYCLIC) {
+    return false;
+  }
+  const OperationNode *from = (const OperationNode *)rel->from;
+  const OperationNode *to = (const OperationNode *)rel->to;
+  return (from->flag & DEPSOP_FLAG_NEEDS_UPDATE) && (to->flag & DEPSOP_FLAG_NEEDS_UPDATE);
+}
+
+/* Calculate the priority of all operations which are to be evaluated: the estimated cost of the
+ * operation itself plus the most expensive chain of updated operations depending on it.
+ *
+ * Operations are visited in reverse topological order, starting with the ones without updated
+ * children. The custom flags are used to count children which are not visited yet. */
+void calculate_priorities(Depsgraph *graph)
+{
+  /* Forget about operations which were evaluated since they were tagged. */
+  graph->updated_operations.remove_if([](OperationNode *node) {
+    if (node->flag & DEPSOP_FLAG_NEEDS_UPDATE) {
+      return false;
+    }
+    node->in_updated_operations = false;
+    return true;
+  });
+
+  Vector<OperationNode *> stack;
+  for (OperationNode *node : graph->updated_operations) {
+    node->priority = node->cost_estimate;
+    node->custom_flags = 0;
+    for (const Relation *rel : node->outlinks) {
+      if (is_relation_between_updated_operations(rel)) {
+        node->custom_flags++;
+      }
+    }
+    if (node->custom_flags == 0) {
+      stack.append(node);
+    }
+  }
+  while (!stack.is_empty()) {
+    const OperationNode *node = stack.pop_last();
+    for (const Relation *rel : node->inlinks) {
+      if (!is_relation_between_updated_operations(rel)) {
+        continue;
+      }
+      OperationNode *parent = (OperationNode *)rel->from;
+      parent->priority = std::max(parent->priority, parent->cost_estimate + node->priority);
+      if (--parent->custom_flags == 0) {
+        stack.append(parent);
+      }
+    }
+  }
+}
+
 void initialize_execution(DepsgraphEvalState *state, Depsgraph *graph)
 {
   /* Clear tags and other things which needs to be clear. */
@@ -194,6 +367,7 @@ void initialize_execution(DepsgraphEvalState *state, Depsgraph *graph)
       node->stats.reset_current();
     }
   }
+  calculate_priorities(graph);
 }
 
 bool is_metaball_object_operation(const OperationNode *operation_node)
@@ -317,9 +491,8 @@ void evaluate_graph_threaded_stage(DepsgraphEvalState *state,
 
   calculate_pending_parents_if_needed(state);
 
-  schedule_graph(state, [&](OperationNode *node) {
-    BLI_task_pool_push(task_pool, deg_task_run_func, node, false, nullptr);
-  });
+  schedule_graph(state,
+                 [&](OperationNode *node) { schedule_operation_task(task_pool, state, node); });
   BLI_task_pool_work_and_wait(task_pool);
 }
 
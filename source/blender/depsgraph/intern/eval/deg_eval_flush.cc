@@ -116,7 +116,8 @@ inline void flush_handle_id_node(IDNode *id_node)
 }
 
 /* TODO(sergey): We can reduce number of arguments here. */
-inline void flush_handle_component_node(IDNode *id_node,
+inline void flush_handle_component_node(Depsgraph *graph,
+                                        IDNode *id_node,
                                         ComponentNode *comp_node,
                                         FlushQueue *queue)
 {
@@ -142,7 +143,7 @@ inline void flush_handle_component_node(IDNode *id_node,
       if (is_geometry_component && op->opcode == OperationCode::VISIBILITY) {
         continue;
       }
-      op->flag |= DEPSOP_FLAG_NEEDS_UPDATE;
+      op->tag_needs_update(graph);
     }
   }
   /* when some target changes bone, we might need to re-run the
@@ -348,12 +349,12 @@ void deg_graph_flush_updates(Depsgraph *graph)
     queue.pop_front();
     while (op_node != nullptr) {
       /* Tag operation as required for update. */
-      op_node->flag |= DEPSOP_FLAG_NEEDS_UPDATE;
+      op_node->tag_needs_update(graph);
       /* Inform corresponding ID and component nodes about the change. */
       ComponentNode *comp_node = op_node->owner;
       IDNode *id_node = comp_node->owner;
       flush_handle_id_node(id_node);
-      flush_handle_component_node(id_node, comp_node, &queue);
+      flush_handle_component_node(graph, id_node, comp_node, &queue);
       /* Flush to nodes along links. */
       op_node = flush_schedule_children(op_node, &queue);
     }
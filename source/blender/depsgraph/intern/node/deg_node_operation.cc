@@ -209,7 +209,10 @@ const char *operationCodeAsString(OperationCode opcode)
   return "UNKNOWN";
 }
 
-OperationNode::OperationNode() : name_tag(-1), flag(0) {}
+OperationNode::OperationNode()
+    : in_updated_operations(false), cost_estimate(0.0f), priority(0.0f), name_tag(-1), flag(0)
+{
+}
 
 string OperationNode::identifier() const
 {
@@ -245,7 +248,8 @@ void OperationNode::tag_update(Depsgraph *graph, eUpdateSource source)
   }
 
   /* Tag for update, but also note that this was the source of an update. */
-  flag |= (DEPSOP_FLAG_NEEDS_UPDATE | DEPSOP_FLAG_DIRECTLY_MODIFIED);
+  this->tag_needs_update(graph);
+  flag |= DEPSOP_FLAG_DIRECTLY_MODIFIED;
   switch (source) {
     case DEG_UPDATE_SOURCE_TIME:
     case DEG_UPDATE_SOURCE_RELATIONS:
@@ -259,6 +263,15 @@ void OperationNode::tag_update(Depsgraph *graph, eUpdateSource source)
   }
 }
 
+void OperationNode::tag_needs_update(Depsgraph *graph)
+{
+  flag |= DEPSOP_FLAG_NEEDS_UPDATE;
+  if (!in_updated_operations) {
+    graph->updated_operations.append(this);
+    in_updated_operations = true;
+  }
+}
+
 void OperationNode::set_as_entry()
 {
   BLI_assert(owner != nullptr);
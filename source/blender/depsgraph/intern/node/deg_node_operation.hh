@@ -253,6 +253,9 @@ struct OperationNode : public Node {
 
   virtual void tag_update(Depsgraph *graph, eUpdateSource source) override;
 
+  /* Set DEPSOP_FLAG_NEEDS_UPDATE and add the operation to the updated operations of the graph. */
+  void tag_needs_update(Depsgraph *graph);
+
   bool is_noop() const
   {
     return (bool)evaluate == false;
@@ -280,6 +283,15 @@ struct OperationNode : public Node {
   /* How many inlinks are we still waiting on before we can be evaluated. */
   uint32_t num_links_pending;
   bool scheduled;
+  /* The operation is in the updated operations of the graph. */
+  bool in_updated_operations;
+
+  /* Evaluation time in seconds, averaged over the previous evaluations of this operation. */
+  float cost_estimate;
+  /* Estimated time to evaluate this operation and the most expensive chain of operations which
+   * depend on it. Operations with a higher priority are evaluated first, so that the critical
+   * path of the graph is started as early as possible. */
+  float priority;
 
   /* Identifier for the operation being performed. */
   OperationCode opcode;
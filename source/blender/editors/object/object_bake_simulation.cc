@@ -10,6 +10,7 @@
 #include "BLI_path_util.h"
 #include "BLI_serialize.hh"
 #include "BLI_string.h"
+#include "BLI_time.h"
 #include "BLI_vector.hh"
 
 #include "BLT_translation.hh"
@@ -220,7 +221,10 @@ struct NodeBakeRequest {
   bake::BakePath path;
   int frame_start;
   int frame_end;
+  bake::BlobCompression compression = bake::BlobCompression::None;
   std::unique_ptr<bake::BlobWriteSharing> blob_sharing;
+  /** Time spent writing the baked data to disk, in seconds. */
+  double write_time = 0.0;
 };
 
 struct BakeGeometryNodesJob {
@@ -231,6 +235,17 @@ struct BakeGeometryNodesJob {
   Vector<NodeBakeRequest> bake_requests;
 };
 
+static bake::BlobCompression get_blob_compression(const NodesModifierBake &bake)
+{
+  switch (NodesModifierBakeCompression(bake.compression)) {
+    case NODES_MODIFIER_BAKE_COMPRESSION_NONE:
+      break;
+    case NODES_MODIFIER_BAKE_COMPRESSION_ZSTD:
+      return bake::BlobCompression::Zstd;
+  }
+  return bake::BlobCompression::None;
+}
+
 static void request_bakes_in_modifier_cache(BakeGeometryNodesJob &job)
 {
   for (NodeBakeRequest &request : job.bake_requests) {
@@ -315,9 +330,11 @@ static void bake_geometry_nodes_startjob(void *customdata, wmJobWorkerStatus *wo
                     path.meta_dir.c_str(),
                     (frame_file_name + ".json").c_str());
       BLI_file_ensure_parent_dir_exists(meta_path);
-      bake::DiskBlobWriter blob_writer{path.blobs_dir, frame_file_name};
+      const double write_start_time = BLI_time_now_seconds();
+      bake::DiskBlobWriter blob_writer{path.blobs_dir, frame_file_name, request.compression};
       fstream meta_file{meta_path, std::ios::out};
-      bake::serialize_bake(frame_cache.state, blob_writer, *request.blob_sharing, meta_file);
+      bake::serialize_bake(*frame_cache.state, blob_writer, *request.blob_sharing, meta_file);
+      request.write_time += BLI_time_now_seconds() - write_start_time;
     }
 
     worker_status->progress += progress_per_frame;
@@ -348,9 +365,36 @@ static void bake_geometry_nodes_startjob(void *customdata, wmJobWorkerStatus *wo
   worker_status->do_update = true;
 }
 
+/** Report how much data has been written for each bake and how long that took. */
+static void report_bake_sizes(const BakeGeometryNodesJob &job)
+{
+  for (const NodeBakeRequest &request : job.bake_requests) {
+    const int64_t input_bytes = request.blob_sharing->total_input_bytes();
+    if (input_bytes == 0) {
+      continue;
+    }
+    const bNode *node = request.nmd->node_group->find_nested_node(request.bake_id);
+    char input_str[BLI_STR_FORMAT_INT64_BYTE_UNIT_SIZE];
+    char written_str[BLI_STR_FORMAT_INT64_BYTE_UNIT_SIZE];
+    char throughput_str[BLI_STR_FORMAT_INT64_BYTE_UNIT_SIZE];
+    BLI_str_format_byte_unit(input_str, input_bytes, false);
+    BLI_str_format_byte_unit(written_str, request.blob_sharing->total_written_bytes(), false);
+    BLI_str_format_byte_unit(
+        throughput_str, int64_t(input_bytes / std::max(request.write_time, 1e-6)), false);
+    WM_reportf(RPT_INFO,
+               "Baked \"%s\" in %s: %s of data stored in %s (%s/s)",
+               node ? node->name : "",
+               request.object->id.name + 2,
+               input_str,
+               written_str,
+               throughput_str);
+  }
+}
+
 static void bake_geometry_nodes_endjob(void *customdata)
 {
   BakeGeometryNodesJob &job = *static_cast<BakeGeometryNodesJob *>(customdata);
+  report_bake_sizes(job);
   WM_set_locked_interface(job.wm, false);
   G.is_rendering = false;
   WM_main_add_notifier(NC_OBJECT | ND_MODIFIER, nullptr);
@@ -481,6 +525,9 @@ static Vector<NodeBakeRequest> collect_simulations_to_bake(Main &bmain,
         request.path = std::move(*path);
         request.frame_start = frame_range->first();
         request.frame_end = frame_range->last();
+        if (const NodesModifierBake *bake = nmd->find_bake(id)) {
+          request.compression = get_blob_compression(*bake);
+        }
 
         requests.append(std::move(request));
       }
@@ -838,6 +885,7 @@ static Vector<NodeBakeRequest> bake_single_node_gather_bake_request(bContext *C,
     return {};
   }
   request.path = std::move(*bake_path);
+  request.compression = get_blob_compression(*bake);
 
   if (node->type == GEO_NODE_BAKE && bake->bake_mode == NODES_MODIFIER_BAKE_MODE_STILL) {
     const int current_frame = scene->r.cfra;
@@ -15,12 +15,15 @@
 
 #include "BLI_path_util.h"
 #include "BLI_string.h"
+#include "BLI_threads.h"
 
 #ifdef WIN32
 #  include "utfconv.hh"
 #endif
 
+#include <algorithm>
 #include <fstream>
+#include <memory>
 #include <vector>
 
 using Alembic::Abc::ErrorHandler;
@@ -30,6 +33,12 @@ using Alembic::Abc::kWrapExisting;
 
 namespace blender::io::alembic {
 
+/**
+ * Ogawa archives can read from multiple streams at the same time, which allows importing objects
+ * and evaluating cache modifiers from multiple threads without waiting on a single file handle.
+ */
+static constexpr int max_archive_streams_num = 8;
+
 static IArchive open_archive(const std::string &filename,
                              const std::vector<std::istream *> &input_streams)
 {
@@ -111,16 +120,25 @@ ArchiveReader::ArchiveReader(const Main *bmain, const char *filename)
   STRNCPY(abs_filepath, filename);
   BLI_path_abs(abs_filepath, BKE_main_blendfile_path(bmain));
 
+  const int streams_num = std::min(BLI_system_thread_count(), max_archive_streams_num);
+  for (int i = 0; i < streams_num; i++) {
+    std::unique_ptr<std::ifstream> infile = std::make_unique<std::ifstream>();
 #ifdef WIN32
-  UTF16_ENCODE(abs_filepath);
-  std::wstring wstr(abs_filepath_16);
-  m_infile.open(wstr.c_str(), std::ios::in | std::ios::binary);
-  UTF16_UN_ENCODE(abs_filepath);
+    UTF16_ENCODE(abs_filepath);
+    std::wstring wstr(abs_filepath_16);
+    infile->open(wstr.c_str(), std::ios::in | std::ios::binary);
+    UTF16_UN_ENCODE(abs_filepath);
 #else
-  m_infile.open(abs_filepath, std::ios::in | std::ios::binary);
+    infile->open(abs_filepath, std::ios::in | std::ios::binary);
 #endif
+    if (i > 0 && !infile->is_open()) {
+      /* Additional streams are optional, e.g. when running out of file handles. */
+      break;
+    }
 
-  m_streams.push_back(&m_infile);
+    m_streams.push_back(infile.get());
+    m_infiles.push_back(std::move(infile));
+  }
 
   m_archive = open_archive(abs_filepath, m_streams);
 }
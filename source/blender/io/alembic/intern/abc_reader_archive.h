@@ -11,6 +11,7 @@
 #include <Alembic/Abc/IObject.h>
 
 #include <fstream>
+#include <memory>
 #include <vector>
 
 struct Main;
@@ -24,7 +25,7 @@ namespace blender::io::alembic {
  */
 class ArchiveReader {
   Alembic::Abc::IArchive m_archive;
-  std::ifstream m_infile;
+  std::vector<std::unique_ptr<std::ifstream>> m_infiles;
   std::vector<std::istream *> m_streams;
 
   std::vector<ArchiveReader *> m_readers;
@@ -22,6 +22,7 @@
 #include "BLI_map.hh"
 #include "BLI_math_vector.h"
 #include "BLI_ordered_edge.hh"
+#include "BLI_task.hh"
 
 #include "BLT_translation.hh"
 
@@ -33,6 +34,8 @@
 #include "BKE_mesh.hh"
 #include "BKE_object.hh"
 
+#include <atomic>
+
 using Alembic::Abc::FloatArraySamplePtr;
 using Alembic::Abc::Int32ArraySamplePtr;
 using Alembic::Abc::P3fArraySamplePtr;
@@ -129,14 +132,16 @@ static void read_mverts_interp(float3 *vert_positions,
                                const P3fArraySamplePtr &ceil_positions,
                                const double weight)
 {
-  float tmp[3];
-  for (int i = 0; i < positions->size(); i++) {
-    const Imath::V3f &floor_pos = (*positions)[i];
-    const Imath::V3f &ceil_pos = (*ceil_positions)[i];
-
-    interp_v3_v3v3(tmp, floor_pos.getValue(), ceil_pos.getValue(), float(weight));
-    copy_zup_from_yup(vert_positions[i], tmp);
-  }
+  threading::parallel_for(IndexRange(positions->size()), 4096, [&](const IndexRange range) {
+    float tmp[3];
+    for (const int64_t i : range) {
+      const Imath::V3f &floor_pos = (*positions)[i];
+      const Imath::V3f &ceil_pos = (*ceil_positions)[i];
+
+      interp_v3_v3v3(tmp, floor_pos.getValue(), ceil_pos.getValue(), float(weight));
+      copy_zup_from_yup(vert_positions[i], tmp);
+    }
+  });
 }
 
 static void read_mverts(CDStreamConfig &config, const AbcMeshData &mesh_data)
@@ -161,42 +166,76 @@ static void read_mverts(CDStreamConfig &config, const AbcMeshData &mesh_data)
 void read_mverts(Mesh &mesh, const P3fArraySamplePtr positions, const N3fArraySamplePtr normals)
 {
   MutableSpan<float3> vert_positions = mesh.vert_positions_for_write();
-  for (int i = 0; i < positions->size(); i++) {
-    Imath::V3f pos_in = (*positions)[i];
+  threading::parallel_for(IndexRange(positions->size()), 4096, [&](const IndexRange range) {
+    for (const int64_t i : range) {
+      Imath::V3f pos_in = (*positions)[i];
 
-    copy_zup_from_yup(vert_positions[i], pos_in.getValue());
-  }
+      copy_zup_from_yup(vert_positions[i], pos_in.getValue());
+    }
+  });
   mesh.tag_positions_changed();
 
   if (normals) {
     Vector<float3> vert_normals(mesh.verts_num);
-    for (const int64_t i : IndexRange(normals->size())) {
-      Imath::V3f nor_in = (*normals)[i];
-      copy_zup_from_yup(vert_normals[i], nor_in.getValue());
-    }
+    threading::parallel_for(IndexRange(normals->size()), 4096, [&](const IndexRange range) {
+      for (const int64_t i : range) {
+        Imath::V3f nor_in = (*normals)[i];
+        copy_zup_from_yup(vert_normals[i], nor_in.getValue());
+      }
+    });
     bke::mesh_vert_normals_assign(mesh, std::move(vert_normals));
   }
 }
 
+/**
+ * Read the UVs of the sample. The faces of the mesh must already match the sample's topology.
+ */
+static void read_uvs(CDStreamConfig &config, const AbcMeshData &mesh_data)
+{
+  float2 *mloopuvs = config.mloopuv;
+  const V2fArraySamplePtr &uvs = mesh_data.uvs;
+  const UInt32ArraySamplePtr &uvs_indices = mesh_data.uvs_indices;
+  if (!(mloopuvs && uvs && uvs_indices)) {
+    return;
+  }
+  BLI_assert(mesh_data.uv_scope != ABC_UV_SCOPE_NONE);
+  const bool do_uvs_per_loop = mesh_data.uv_scope == ABC_UV_SCOPE_LOOP;
+  const size_t uvs_size = uvs->size();
+  const Int32ArraySamplePtr &face_indices = mesh_data.face_indices;
+
+  const OffsetIndices faces = config.mesh->faces();
+  threading::parallel_for(faces.index_range(), 1024, [&](const IndexRange range) {
+    for (const int i : range) {
+      const IndexRange face = faces[i];
+      for (const int f : IndexRange(face.size())) {
+        /* NOTE: Alembic data is stored in the reverse order. */
+        const int loop_index = face.start() + f;
+        const int rev_loop_index = face.last(f);
+        const int vert = (*face_indices)[loop_index];
+        const uint uv_index = (*uvs_indices)[do_uvs_per_loop ? loop_index : vert];
+
+        /* Some Alembic files are broken (or at least export UVs in a way we don't expect). */
+        if (uv_index >= uvs_size) {
+          continue;
+        }
+
+        mloopuvs[rev_loop_index][0] = (*uvs)[uv_index][0];
+        mloopuvs[rev_loop_index][1] = (*uvs)[uv_index][1];
+      }
+    }
+  });
+}
+
 static void read_mpolys(CDStreamConfig &config, const AbcMeshData &mesh_data)
 {
   int *face_offsets = config.face_offsets;
   int *corner_verts = config.corner_verts;
-  float2 *mloopuvs = config.mloopuv;
 
   const Int32ArraySamplePtr &face_indices = mesh_data.face_indices;
   const Int32ArraySamplePtr &face_counts = mesh_data.face_counts;
-  const V2fArraySamplePtr &uvs = mesh_data.uvs;
-  const size_t uvs_size = uvs == nullptr ? 0 : uvs->size();
-
-  const UInt32ArraySamplePtr &uvs_indices = mesh_data.uvs_indices;
 
-  const bool do_uvs = (mloopuvs && uvs && uvs_indices);
-  const bool do_uvs_per_loop = do_uvs && mesh_data.uv_scope == ABC_UV_SCOPE_LOOP;
-  BLI_assert(!do_uvs || mesh_data.uv_scope != ABC_UV_SCOPE_NONE);
   uint loop_index = 0;
   uint rev_loop_index = 0;
-  uint uv_index = 0;
   bool seen_invalid_geometry = false;
 
   for (int i = 0; i < face_counts->size(); i++) {
@@ -221,21 +260,11 @@ static void read_mpolys(CDStreamConfig &config, const AbcMeshData &mesh_data)
         seen_invalid_geometry = true;
       }
       last_vertex_index = vert;
-
-      if (do_uvs) {
-        uv_index = (*uvs_indices)[do_uvs_per_loop ? loop_index : last_vertex_index];
-
-        /* Some Alembic files are broken (or at least export UVs in a way we don't expect). */
-        if (uv_index >= uvs_size) {
-          continue;
-        }
-
-        mloopuvs[rev_loop_index][0] = (*uvs)[uv_index][0];
-        mloopuvs[rev_loop_index][1] = (*uvs)[uv_index][1];
-      }
     }
   }
 
+  read_uvs(config, mesh_data);
+
   bke::mesh_calc_edges(*config.mesh, false, false);
   if (seen_invalid_geometry) {
     if (config.modifier_error_message) {
@@ -274,15 +303,16 @@ static void process_loop_normals(CDStreamConfig &config, const N3fArraySamplePtr
 
   const OffsetIndices faces = mesh->faces();
   const N3fArraySample &loop_normals = *loop_normals_ptr;
-  int abc_index = 0;
-  for (int i = 0, e = mesh->faces_num; i < e; i++) {
-    const IndexRange face = faces[i];
-    /* As usual, ABC orders the loops in reverse. */
-    for (int j = face.size() - 1; j >= 0; j--, abc_index++) {
-      int blender_index = face[j];
-      copy_zup_from_yup(lnors[blender_index], loop_normals[abc_index].getValue());
+  threading::parallel_for(faces.index_range(), 1024, [&](const IndexRange range) {
+    for (const int i : range) {
+      const IndexRange face = faces[i];
+      /* As usual, ABC orders the loops in reverse. */
+      for (const int j : IndexRange(face.size())) {
+        const int abc_index = face.start() + j;
+        copy_zup_from_yup(lnors[face.last(j)], loop_normals[abc_index].getValue());
+      }
     }
-  }
+  });
 
   BKE_mesh_set_custom_normals(mesh, lnors);
 
@@ -302,9 +332,11 @@ static void process_vertex_normals(CDStreamConfig &config,
       MEM_malloc_arrayN(normals_count, sizeof(float[3]), "ABC::VertexNormals"));
 
   const N3fArraySample &vertex_normals = *vertex_normals_ptr;
-  for (int index = 0; index < normals_count; index++) {
-    copy_zup_from_yup(vert_normals[index], vertex_normals[index].getValue());
-  }
+  threading::parallel_for(IndexRange(normals_count), 4096, [&](const IndexRange range) {
+    for (const int64_t index : range) {
+      copy_zup_from_yup(vert_normals[index], vertex_normals[index].getValue());
+    }
+  });
 
   BKE_mesh_set_custom_normals_from_verts(config.mesh, vert_normals);
   MEM_freeN(vert_normals);
@@ -431,11 +463,16 @@ static bool samples_have_same_topology(const SampleType &sample, const SampleTyp
   return true;
 }
 
+/**
+ * \param use_existing_topology: The topology of the sample is known to match the mesh, so only
+ * data that may change between samples with the same topology is read.
+ */
 static void read_mesh_sample(const std::string &iobject_full_name,
                              ImportSettings *settings,
                              const IPolyMeshSchema &schema,
                              const ISampleSelector &selector,
-                             CDStreamConfig &config)
+                             CDStreamConfig &config,
+                             const bool use_existing_topology)
 {
   const IPolyMeshSchema::Sample sample = schema.getValue(selector);
 
@@ -469,7 +506,12 @@ static void read_mesh_sample(const std::string &iobject_full_name,
   }
 
   if ((settings->read_flag & MOD_MESHSEQ_READ_POLY) != 0) {
-    read_mpolys(config, abc_mesh_data);
+    if (use_existing_topology) {
+      read_uvs(config, abc_mesh_data);
+    }
+    else {
+      read_mpolys(config, abc_mesh_data);
+    }
     process_normals(config, schema.getNormalsParam(), selector);
   }
 
@@ -485,13 +527,23 @@ static void read_mesh_sample(const std::string &iobject_full_name,
   }
 }
 
-static CDStreamConfig get_config(Mesh *mesh)
+/**
+ * \param use_existing_topology: The topology of the mesh is only read and not written. It is not
+ * made mutable then, because that would copy arrays that are shared with other meshes.
+ */
+static CDStreamConfig get_config(Mesh *mesh, const bool use_existing_topology = false)
 {
   CDStreamConfig config;
   config.mesh = mesh;
   config.positions = mesh->vert_positions_for_write().data();
-  config.corner_verts = mesh->corner_verts_for_write().data();
-  config.face_offsets = mesh->face_offsets_for_write().data();
+  if (use_existing_topology) {
+    config.corner_verts = const_cast<int *>(mesh->corner_verts().data());
+    config.face_offsets = const_cast<int *>(mesh->face_offsets().data());
+  }
+  else {
+    config.corner_verts = mesh->corner_verts_for_write().data();
+    config.face_offsets = mesh->face_offsets_for_write().data();
+  }
   config.totvert = mesh->verts_num;
   config.totloop = mesh->corners_num;
   config.faces_num = mesh->faces_num;
@@ -514,6 +566,13 @@ AbcMeshReader::AbcMeshReader(const IObject &object, ImportSettings &settings)
   get_min_max_time(m_iobject, m_schema, m_min_time, m_max_time);
 }
 
+AbcMeshReader::~AbcMeshReader()
+{
+  if (m_prefetched_mesh) {
+    BKE_id_free(nullptr, m_prefetched_mesh);
+  }
+}
+
 bool AbcMeshReader::valid() const
 {
   return m_schema.valid();
@@ -577,6 +636,17 @@ template<> bool has_animations(Alembic::AbcGeom::IPolyMeshSchema &schema, Import
   return false;
 }
 
+void AbcMeshReader::prefetchObjectData(const Alembic::Abc::ISampleSelector &sample_sel)
+{
+  BLI_assert(m_prefetched_mesh == nullptr);
+  Mesh *template_mesh = BKE_mesh_new_nomain(0, 0, 0, 0);
+  m_prefetched_mesh = this->read_mesh(
+      template_mesh, sample_sel, MOD_MESHSEQ_READ_ALL, "", 0.0f, nullptr);
+  if (m_prefetched_mesh != template_mesh) {
+    BKE_id_free(nullptr, template_mesh);
+  }
+}
+
 void AbcMeshReader::readObjectData(Main *bmain, const Alembic::Abc::ISampleSelector &sample_sel)
 {
   Mesh *mesh = BKE_mesh_add(bmain, m_data_name.c_str());
@@ -584,9 +654,15 @@ void AbcMeshReader::readObjectData(Main *bmain, const Alembic::Abc::ISampleSelec
   m_object = BKE_object_add_only_object(bmain, OB_MESH, m_object_name.c_str());
   m_object->data = mesh;
 
-  Mesh *read_mesh = this->read_mesh(mesh, sample_sel, MOD_MESHSEQ_READ_ALL, "", 0.0f, nullptr);
-  if (read_mesh != mesh) {
-    BKE_mesh_nomain_to_mesh(read_mesh, mesh, m_object);
+  if (m_prefetched_mesh) {
+    BKE_mesh_nomain_to_mesh(m_prefetched_mesh, mesh, m_object);
+    m_prefetched_mesh = nullptr;
+  }
+  else {
+    Mesh *read_mesh = this->read_mesh(mesh, sample_sel, MOD_MESHSEQ_READ_ALL, "", 0.0f, nullptr);
+    if (read_mesh != mesh) {
+      BKE_mesh_nomain_to_mesh(read_mesh, mesh, m_object);
+    }
   }
 
   if (m_settings->validate_meshes) {
@@ -657,30 +733,34 @@ bool AbcMeshReader::topology_changed(const Mesh *existing_mesh, const ISampleSel
   }
 
   /* Otherwise, we need to check the connectivity as files from e.g. videogrammetry may have the
-   * same face count, but different connections between faces. */
-  uint abc_index = 0;
-
-  const int *mesh_corner_verts = existing_mesh->corner_verts().data();
-  const int *mesh_face_offsets = existing_mesh->face_offsets().data();
-
-  for (int i = 0; i < face_counts->size(); i++) {
-    if (mesh_face_offsets[i] != abc_index) {
-      return true;
+   * same face count, but different connections between faces.
+   * The face offsets always start at zero, so comparing the face sizes is enough to know that
+   * all offsets match. */
+  const OffsetIndices faces = existing_mesh->faces();
+  const Span<int> mesh_corner_verts = existing_mesh->corner_verts();
+
+  std::atomic<bool> changed = false;
+  threading::parallel_for(faces.index_range(), 4096, [&](const IndexRange range) {
+    if (changed.load(std::memory_order_relaxed)) {
+      return;
     }
-
-    const int abc_face_size = (*face_counts)[i];
-    /* NOTE: Alembic data is stored in the reverse order. */
-    uint rev_loop_index = abc_index + (abc_face_size - 1);
-    for (int f = 0; f < abc_face_size; f++, abc_index++, rev_loop_index--) {
-      const int mesh_vert = mesh_corner_verts[rev_loop_index];
-      const int abc_vert = (*face_indices)[abc_index];
-      if (mesh_vert != abc_vert) {
-        return true;
+    for (const int i : range) {
+      const IndexRange face = faces[i];
+      if (face.size() != (*face_counts)[i]) {
+        changed.store(true, std::memory_order_relaxed);
+        return;
+      }
+      /* NOTE: Alembic data is stored in the reverse order. */
+      for (const int f : IndexRange(face.size())) {
+        if (mesh_corner_verts[face.last(f)] != (*face_indices)[face.start() + f]) {
+          changed.store(true, std::memory_order_relaxed);
+          return;
+        }
       }
     }
-  }
+  });
 
-  return false;
+  return changed;
 }
 
 void AbcMeshReader::read_geometry(bke::GeometrySet &geometry_set,
@@ -774,12 +854,16 @@ Mesh *AbcMeshReader::read_mesh(Mesh *existing_mesh,
     }
   }
 
+  /* Samples with unchanged topology reuse the faces, corners and edges of the existing mesh. Only
+   * positions, normals and attributes are read then. */
+  const bool use_existing_topology = new_mesh == nullptr;
   Mesh *mesh_to_export = new_mesh ? new_mesh : existing_mesh;
-  CDStreamConfig config = get_config(mesh_to_export);
+  CDStreamConfig config = get_config(mesh_to_export, use_existing_topology);
   config.time = sample_sel.getRequestedTime();
   config.modifier_error_message = err_str;
 
-  read_mesh_sample(m_iobject.getFullName(), &settings, m_schema, sample_sel, config);
+  read_mesh_sample(
+      m_iobject.getFullName(), &settings, m_schema, sample_sel, config, use_existing_topology);
 
   if (new_mesh) {
     /* Here we assume that the number of materials doesn't change, i.e. that
@@ -983,6 +1067,13 @@ AbcSubDReader::AbcSubDReader(const IObject &object, ImportSettings &settings)
   get_min_max_time(m_iobject, m_schema, m_min_time, m_max_time);
 }
 
+AbcSubDReader::~AbcSubDReader()
+{
+  if (m_prefetched_mesh) {
+    BKE_id_free(nullptr, m_prefetched_mesh);
+  }
+}
+
 bool AbcSubDReader::valid() const
 {
   return m_schema.valid();
@@ -1008,6 +1099,17 @@ bool AbcSubDReader::accepts_object_type(
   return true;
 }
 
+void AbcSubDReader::prefetchObjectData(const Alembic::Abc::ISampleSelector &sample_sel)
+{
+  BLI_assert(m_prefetched_mesh == nullptr);
+  Mesh *template_mesh = BKE_mesh_new_nomain(0, 0, 0, 0);
+  m_prefetched_mesh = this->read_mesh(
+      template_mesh, sample_sel, MOD_MESHSEQ_READ_ALL, "", 0.0f, nullptr);
+  if (m_prefetched_mesh != template_mesh) {
+    BKE_id_free(nullptr, template_mesh);
+  }
+}
+
 void AbcSubDReader::readObjectData(Main *bmain, const Alembic::Abc::ISampleSelector &sample_sel)
 {
   Mesh *mesh = BKE_mesh_add(bmain, m_data_name.c_str());
@@ -1015,9 +1117,15 @@ void AbcSubDReader::readObjectData(Main *bmain, const Alembic::Abc::ISampleSelec
   m_object = BKE_object_add_only_object(bmain, OB_MESH, m_object_name.c_str());
   m_object->data = mesh;
 
-  Mesh *read_mesh = this->read_mesh(mesh, sample_sel, MOD_MESHSEQ_READ_ALL, "", 0.0f, nullptr);
-  if (read_mesh != mesh) {
-    BKE_mesh_nomain_to_mesh(read_mesh, mesh, m_object);
+  if (m_prefetched_mesh) {
+    BKE_mesh_nomain_to_mesh(m_prefetched_mesh, mesh, m_object);
+    m_prefetched_mesh = nullptr;
+  }
+  else {
+    Mesh *read_mesh = this->read_mesh(mesh, sample_sel, MOD_MESHSEQ_READ_ALL, "", 0.0f, nullptr);
+    if (read_mesh != mesh) {
+      BKE_mesh_nomain_to_mesh(read_mesh, mesh, m_object);
+    }
   }
 
   ISubDSchema::Sample sample;
@@ -20,14 +20,18 @@ namespace blender::io::alembic {
 
 class AbcMeshReader final : public AbcObjectReader {
   Alembic::AbcGeom::IPolyMeshSchema m_schema;
+  /** Mesh outside of the main database read by #prefetchObjectData(). */
+  Mesh *m_prefetched_mesh = nullptr;
 
  public:
   AbcMeshReader(const Alembic::Abc::IObject &object, ImportSettings &settings);
+  ~AbcMeshReader() override;
 
   bool valid() const override;
   bool accepts_object_type(const Alembic::AbcCoreAbstract::ObjectHeader &alembic_header,
                            const Object *const ob,
                            const char **err_str) const override;
+  void prefetchObjectData(const Alembic::Abc::ISampleSelector &sample_sel) override;
   void readObjectData(Main *bmain, const Alembic::Abc::ISampleSelector &sample_sel) override;
 
   struct Mesh *read_mesh(struct Mesh *existing_mesh,
@@ -59,14 +63,18 @@ class AbcMeshReader final : public AbcObjectReader {
 
 class AbcSubDReader final : public AbcObjectReader {
   Alembic::AbcGeom::ISubDSchema m_schema;
+  /** Mesh outside of the main database read by #prefetchObjectData(). */
+  Mesh *m_prefetched_mesh = nullptr;
 
  public:
   AbcSubDReader(const Alembic::Abc::IObject &object, ImportSettings &settings);
+  ~AbcSubDReader() override;
 
   bool valid() const override;
   bool accepts_object_type(const Alembic::AbcCoreAbstract::ObjectHeader &alembic_header,
                            const Object *const ob,
                            const char **err_str) const override;
+  void prefetchObjectData(const Alembic::Abc::ISampleSelector &sample_sel) override;
   void readObjectData(Main *bmain, const Alembic::Abc::ISampleSelector &sample_sel) override;
 
   void read_geometry(bke::GeometrySet &geometry_set,
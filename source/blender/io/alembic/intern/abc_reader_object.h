@@ -145,6 +145,13 @@ class AbcObjectReader {
                                    const Object *const ob,
                                    const char **err_str) const = 0;
 
+  /**
+   * Read the geometry that #readObjectData() will use, without accessing the main database.
+   * This is called for many readers concurrently before objects are created, so that only the
+   * creation of data-blocks has to happen on a single thread.
+   */
+  virtual void prefetchObjectData(const Alembic::Abc::ISampleSelector & /*sample_sel*/) {}
+
   virtual void readObjectData(Main *bmain, const Alembic::Abc::ISampleSelector &sample_sel) = 0;
 
   virtual void read_geometry(bke::GeometrySet &geometry_set,
@@ -12,6 +12,8 @@
 #include <Alembic/AbcGeom/ILight.h>
 #include <Alembic/AbcMaterial/IMaterial.h>
 
+#include <atomic>
+
 #include "abc_axis_conversion.h"
 #include "abc_reader_archive.h"
 #include "abc_reader_camera.h"
@@ -48,6 +50,7 @@
 #include "BLI_sort.hh"
 #include "BLI_span.hh"
 #include "BLI_string.h"
+#include "BLI_task.hh"
 #include "BLI_timeit.hh"
 
 #include "BLT_translation.hh"
@@ -526,6 +529,30 @@ static void import_startjob(void *user_data, wmJobWorkerStatus *worker_status)
   chrono_t max_time = std::numeric_limits<chrono_t>::min();
 
   ISampleSelector sample_sel(0.0);
+
+  /* Read the geometry of all objects in parallel. Only the creation of objects and object data
+   * below has to happen on a single thread since it changes the main database. */
+  std::atomic<int> prefetched_num = 0;
+  blender::threading::parallel_for(
+      blender::IndexRange(data->readers.size()), 1, [&](const blender::IndexRange range) {
+        for (const int64_t reader_i : range) {
+          if (G.is_break) {
+            return;
+          }
+          AbcObjectReader *reader = data->readers[reader_i];
+          if (reader->valid()) {
+            reader->prefetchObjectData(sample_sel);
+          }
+          *data->progress = 0.1f + 0.4f * (++prefetched_num / size);
+          *data->do_update = true;
+        }
+      });
+
+  if (G.is_break) {
+    data->was_cancelled = true;
+    return;
+  }
+
   std::vector<AbcObjectReader *>::iterator iter;
   for (iter = data->readers.begin(); iter != data->readers.end(); ++iter) {
     AbcObjectReader *reader = *iter;
@@ -541,7 +568,7 @@ static void import_startjob(void *user_data, wmJobWorkerStatus *worker_status)
                 << " is invalid.\n";
     }
 
-    *data->progress = 0.1f + 0.6f * (++i / size);
+    *data->progress = 0.5f + 0.2f * (++i / size);
     *data->do_update = true;
 
     if (G.is_break) {
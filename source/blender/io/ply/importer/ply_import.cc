@@ -180,7 +180,7 @@ void importer_main(Main *bmain,
   BLI_path_extension_strip(ob_name);
 
   /* Parse header. */
-  PlyReadBuffer file(import_params.filepath, 64 * 1024);
+  PlyReadBuffer file(import_params.filepath, 1024 * 1024);
 
   PlyHeader header;
   const char *err = read_header(file, header);
@@ -5,6 +5,7 @@
 #include "ply_import_buffer.hh"
 
 #include "BLI_fileops.h"
+#include "BLI_mmap.h"
 
 #include <cstdio>
 #include <cstring>
@@ -25,6 +26,9 @@ PlyReadBuffer::PlyReadBuffer(const char *file_path, size_t read_buffer_size)
 
 PlyReadBuffer::~PlyReadBuffer()
 {
+  if (mmap_file_ != nullptr) {
+    BLI_mmap_free(mmap_file_);
+  }
   if (file_ != nullptr) {
     fclose(file_);
   }
@@ -33,6 +37,19 @@ PlyReadBuffer::~PlyReadBuffer()
 void PlyReadBuffer::after_header(bool is_binary)
 {
   is_binary_ = is_binary;
+  if (!is_binary_ || file_ == nullptr) {
+    return;
+  }
+  /* The rest of the file is read through the mapping, starting right after the header
+   * that is still in the read buffer. */
+  const int64_t file_pos = BLI_ftell(file_);
+  if (file_pos < 0) {
+    return;
+  }
+  mmap_file_ = BLI_mmap_open(fileno(file_));
+  if (mmap_file_ != nullptr) {
+    mmap_pos_ = size_t(file_pos) - size_t(buf_used_ - pos_);
+  }
 }
 
 Span<char> PlyReadBuffer::read_line()
@@ -62,6 +79,13 @@ Span<char> PlyReadBuffer::read_line()
 
 bool PlyReadBuffer::read_bytes(void *dst, size_t size)
 {
+  if (mmap_file_ != nullptr) {
+    if (!BLI_mmap_read(mmap_file_, dst, mmap_pos_, size)) {
+      return false;
+    }
+    mmap_pos_ += size;
+    return true;
+  }
   while (size > 0) {
     if (pos_ + size > buf_used_) {
       if (!refill_buffer()) {
@@ -80,6 +104,32 @@ bool PlyReadBuffer::read_bytes(void *dst, size_t size)
   return true;
 }
 
+void PlyReadBuffer::read_lines(int64_t max_count, Vector<Span<char>> &r_lines)
+{
+  r_lines.clear();
+  do {
+    r_lines.append(read_line());
+  } while (r_lines.size() < max_count && pos_ < last_newline_);
+}
+
+Span<uint8_t> PlyReadBuffer::read_bytes_view(size_t size, Vector<uint8_t> &r_storage)
+{
+  if (mmap_file_ != nullptr) {
+    if (mmap_pos_ + size > BLI_mmap_get_length(mmap_file_)) {
+      return {};
+    }
+    const uint8_t *data = static_cast<const uint8_t *>(BLI_mmap_get_pointer(mmap_file_));
+    Span<uint8_t> result(data + mmap_pos_, int64_t(size));
+    mmap_pos_ += size;
+    return result;
+  }
+  r_storage.resize(int64_t(size));
+  if (!read_bytes(r_storage.data(), size)) {
+    return {};
+  }
+  return r_storage.as_span();
+}
+
 bool PlyReadBuffer::refill_buffer()
 {
   BLI_assert(pos_ <= buf_used_);
@@ -12,6 +12,9 @@
 
 #include "BLI_array.hh"
 #include "BLI_span.hh"
+#include "BLI_vector.hh"
+
+struct BLI_mmap_file;
 
 namespace blender::io::ply {
 
@@ -24,7 +27,10 @@ class PlyReadBuffer {
   PlyReadBuffer(const char *file_path, size_t read_buffer_size = 64 * 1024);
   ~PlyReadBuffer();
 
-  /** After header is parsed, indicate whether the rest of reading will be ascii or binary. */
+  /**
+   * After header is parsed, indicate whether the rest of reading will be ascii or binary.
+   * Binary data is read from a memory-mapped file when possible.
+   */
   void after_header(bool is_binary);
 
   /**
@@ -38,6 +44,25 @@ class PlyReadBuffer {
    */
   bool read_bytes(void *dst, size_t size);
 
+  /**
+   * Gets the next line like #read_line, followed by up to `max_count - 1` more lines that are
+   * already in the read buffer. The lines stay valid until the next read.
+   */
+  void read_lines(int64_t max_count, Vector<Span<char>> &r_lines);
+
+  /**
+   * Gets a number of bytes in binary mode. When the file is memory-mapped, this does not copy
+   * the data, otherwise it is read into the provided storage. The result stays valid until the
+   * next read. Returns an empty span if this amount of bytes can not be read.
+   */
+  Span<uint8_t> read_bytes_view(size_t size, Vector<uint8_t> &r_storage);
+
+  /** Whether binary data is read straight from a memory-mapped file. */
+  bool is_mapped() const
+  {
+    return mmap_file_ != nullptr;
+  }
+
  private:
   bool refill_buffer();
 
@@ -50,6 +75,8 @@ class PlyReadBuffer {
   size_t read_buffer_size_ = 0;
   bool at_eof_ = false;
   bool is_binary_ = false;
+  BLI_mmap_file *mmap_file_ = nullptr;
+  size_t mmap_pos_ = 0;
 };
 
 }  // namespace blender::io::ply
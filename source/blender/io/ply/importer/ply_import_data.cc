@@ -12,6 +12,7 @@
 
 #include "BLI_endian_switch.h"
 #include "BLI_string_ref.hh"
+#include "BLI_task.hh"
 
 #include "fast_float.h"
 
@@ -104,6 +105,9 @@ static const float data_type_normalizer[] = {
 static_assert(std::size(data_type_normalizer) == PLY_TYPE_COUNT,
               "PLY data type normalization factor table mismatch");
 
+/** Number of element rows that are read at once and then decoded in parallel. */
+static const int64_t rows_per_block = 256 * 1024;
+
 void PlyElement::calc_stride()
 {
   stride = 0;
@@ -127,9 +131,8 @@ static int get_index(const PlyElement &element, StringRef property)
   return -1;
 }
 
-static const char *parse_row_ascii(PlyReadBuffer &file, Vector<float> &r_values)
+static const char *parse_row_ascii(Span<char> line, MutableSpan<float> r_values)
 {
-  Span<char> line = file.read_line();
   if (line.is_empty()) {
     return "Could not read row of ascii property";
   }
@@ -190,6 +193,38 @@ template<typename T> static T get_binary_value(PlyDataTypes type, const uint8_t
   return val;
 }
 
+/**
+ * Convert one row of a binary element without list properties. The row data is not modified,
+ * so it can be read straight from a memory-mapped file.
+ */
+static void decode_row_binary(const uint8_t *ptr,
+                              const PlyHeader &header,
+                              const PlyElement &element,
+                              MutableSpan<float> r_values)
+{
+  if (header.type == PlyFormatType::BINARY_LE) {
+    /* Little endian: just read/convert the values. */
+    for (int i = 0, n = int(element.properties.size()); i != n; i++) {
+      const PlyProperty &prop = element.properties[i];
+      float val = get_binary_value<float>(prop.type, ptr);
+      r_values[i] = val;
+    }
+  }
+  else {
+    /* Big endian: read, switch endian of a copy, convert the values. */
+    for (int i = 0, n = int(element.properties.size()); i != n; i++) {
+      const PlyProperty &prop = element.properties[i];
+      const int size = data_type_size[prop.type];
+      uint8_t value[8];
+      memcpy(value, ptr, size);
+      endian_switch(value, size);
+      const uint8_t *value_ptr = value;
+      r_values[i] = get_binary_value<float>(prop.type, value_ptr);
+      ptr += size;
+    }
+  }
+}
+
 static const char *parse_row_binary(PlyReadBuffer &file,
                                     const PlyHeader &header,
                                     const PlyElement &element,
@@ -204,28 +239,10 @@ static const char *parse_row_binary(PlyReadBuffer &file,
   if (!file.read_bytes(r_scratch.data(), r_scratch.size())) {
     return "Could not read row of binary property";
   }
-
-  const uint8_t *ptr = r_scratch.data();
-  if (header.type == PlyFormatType::BINARY_LE) {
-    /* Little endian: just read/convert the values. */
-    for (int i = 0, n = int(element.properties.size()); i != n; i++) {
-      const PlyProperty &prop = element.properties[i];
-      float val = get_binary_value<float>(prop.type, ptr);
-      r_values[i] = val;
-    }
-  }
-  else if (header.type == PlyFormatType::BINARY_BE) {
-    /* Big endian: read, switch endian, convert the values. */
-    for (int i = 0, n = int(element.properties.size()); i != n; i++) {
-      const PlyProperty &prop = element.properties[i];
-      endian_switch((uint8_t *)ptr, data_type_size[prop.type]);
-      float val = get_binary_value<float>(prop.type, ptr);
-      r_values[i] = val;
-    }
-  }
-  else {
+  if (!ELEM(header.type, PlyFormatType::BINARY_LE, PlyFormatType::BINARY_BE)) {
     return "Unknown binary ply format for vertex element";
   }
+  decode_row_binary(r_scratch.data(), header, element, r_values);
   return nullptr;
 }
 
@@ -266,15 +283,16 @@ static const char *load_vertex_element(PlyReadBuffer &file,
     data->vertex_custom_attr.append(attr);
   }
 
-  data->vertices.reserve(element.count);
+  /* Allocate all the data up front, so that rows can be converted in parallel. */
+  data->vertices.resize(element.count);
   if (has_color) {
-    data->vertex_colors.reserve(element.count);
+    data->vertex_colors.resize(element.count);
   }
   if (has_normal) {
-    data->vertex_normals.reserve(element.count);
+    data->vertex_normals.resize(element.count);
   }
   if (has_uv) {
-    data->uv_coordinates.reserve(element.count);
+    data->uv_coordinates.resize(element.count);
   }
 
   float4 color_norm = {1, 1, 1, 1};
@@ -287,31 +305,13 @@ static const char *load_vertex_element(PlyReadBuffer &file,
     color_norm.w = data_type_normalizer[element.properties[alpha_index].type];
   }
 
-  Vector<float> value_vec(element.properties.size());
-  Vector<uint8_t> scratch;
-  if (header.type != PlyFormatType::ASCII) {
-    scratch.resize(element.stride);
-  }
-
-  for (int i = 0; i < element.count; i++) {
-
-    const char *error = nullptr;
-    if (header.type == PlyFormatType::ASCII) {
-      error = parse_row_ascii(file, value_vec);
-    }
-    else {
-      error = parse_row_binary(file, header, element, scratch, value_vec);
-    }
-    if (error != nullptr) {
-      return error;
-    }
-
+  auto store_row = [&](const int64_t i, const Span<float> value_vec) {
     /* Vertex coord */
     float3 vertex3;
     vertex3.x = value_vec[vertex_index.x];
     vertex3.y = value_vec[vertex_index.y];
     vertex3.z = value_vec[vertex_index.z];
-    data->vertices.append(vertex3);
+    data->vertices[i] = vertex3;
 
     /* Vertex color */
     if (has_color) {
@@ -325,7 +325,7 @@ static const char *load_vertex_element(PlyReadBuffer &file,
       else {
         colors4.w = 1.0f;
       }
-      data->vertex_colors.append(colors4);
+      data->vertex_colors[i] = colors4;
     }
 
     /* If normals */
@@ -334,7 +334,7 @@ static const char *load_vertex_element(PlyReadBuffer &file,
       normals3.x = value_vec[normal_index.x];
       normals3.y = value_vec[normal_index.y];
       normals3.z = value_vec[normal_index.z];
-      data->vertex_normals.append(normals3);
+      data->vertex_normals[i] = normals3;
     }
 
     /* If uv */
@@ -342,7 +342,7 @@ static const char *load_vertex_element(PlyReadBuffer &file,
       float2 uvmap;
       uvmap.x = value_vec[uv_index.x];
       uvmap.y = value_vec[uv_index.y];
-      data->uv_coordinates.append(uvmap);
+      data->uv_coordinates[i] = uvmap;
     }
 
     /* Custom attributes */
@@ -350,6 +350,51 @@ static const char *load_vertex_element(PlyReadBuffer &file,
       float value = value_vec[custom_attr_indices[ci]];
       data->vertex_custom_attr[ci].data[i] = value;
     }
+  };
+
+  if (header.type == PlyFormatType::ASCII) {
+    /* Gather the lines that are in the read buffer, then parse them in parallel. */
+    Vector<Span<char>> lines;
+    for (int64_t row = 0; row < element.count; row += lines.size()) {
+      file.read_lines(std::min<int64_t>(element.count - row, rows_per_block), lines);
+      for (const Span<char> line : lines) {
+        if (line.is_empty()) {
+          return "Could not read row of ascii property";
+        }
+      }
+      threading::parallel_for(lines.index_range(), 256, [&](const IndexRange range) {
+        Vector<float> value_vec(element.properties.size());
+        for (const int64_t i : range) {
+          parse_row_ascii(lines[i], value_vec);
+          store_row(row + i, value_vec);
+        }
+      });
+    }
+    return nullptr;
+  }
+
+  if (element.stride == 0) {
+    return "Vertex/Edge element contains list properties, this is not supported";
+  }
+  if (!ELEM(header.type, PlyFormatType::BINARY_LE, PlyFormatType::BINARY_BE)) {
+    return "Unknown binary ply format for vertex element";
+  }
+  /* Decode blocks of rows in parallel; when the file is memory-mapped they are read
+   * without any intermediate copy. */
+  Vector<uint8_t> storage;
+  for (int64_t row = 0; row < element.count; row += rows_per_block) {
+    const int64_t rows_num = std::min<int64_t>(element.count - row, rows_per_block);
+    const Span<uint8_t> rows = file.read_bytes_view(size_t(rows_num) * element.stride, storage);
+    if (rows.is_empty()) {
+      return "Could not read row of binary property";
+    }
+    threading::parallel_for(IndexRange(rows_num), 1024, [&](const IndexRange range) {
+      Vector<float> value_vec(element.properties.size());
+      for (const int64_t i : range) {
+        decode_row_binary(rows.data() + i * element.stride, header, element, value_vec);
+        store_row(row + i, value_vec);
+      }
+    });
   }
   return nullptr;
 }
@@ -452,6 +497,73 @@ static const char *load_face_element(PlyReadBuffer &file,
       data->face_sizes.append(count);
     }
   }
+  else if (file.is_mapped()) {
+    /* Find the vertex index lists of all faces first, then convert them in parallel
+     * straight from the memory-mapped file. */
+    const bool big_endian = header.type == PlyFormatType::BINARY_BE;
+    Vector<uint8_t> scratch(64);
+    Vector<const uint8_t *> face_indices;
+    Vector<int64_t> face_starts;
+    face_indices.reserve(element.count);
+    face_starts.reserve(element.count);
+    int64_t corners_num = 0;
+
+    for (int i = 0; i < element.count; i++) {
+      /* Skip any properties before vertex indices. */
+      for (int j = 0; j < prop_index; j++) {
+        skip_property(file, element.properties[j], scratch, big_endian);
+      }
+
+      /* Find vertex indices list. */
+      uint32_t count = read_list_count(file, prop, scratch, big_endian);
+      if (count < 1 || count > 255) {
+        return "Invalid face size, must be between 1 and 255";
+      }
+      const Span<uint8_t> indices = file.read_bytes_view(count * data_type_size[prop.type],
+                                                         scratch);
+      if (indices.is_empty()) {
+        return "Could not read face vertex indices";
+      }
+      /* Previous python based importer was accepting faces with fewer
+       * than 3 vertices, and silently dropping them. */
+      if (count < 3) {
+        fprintf(stderr, "PLY Importer: ignoring face %i (%i vertices)\n", i, int(count));
+      }
+      else {
+        face_indices.append(indices.data());
+        face_starts.append(corners_num);
+        data->face_sizes.append(count);
+        corners_num += count;
+      }
+
+      /* Skip any properties after vertex indices. */
+      for (int j = prop_index + 1; j < element.properties.size(); j++) {
+        skip_property(file, element.properties[j], scratch, big_endian);
+      }
+    }
+
+    data->face_vertices.resize(corners_num);
+    const int index_size = data_type_size[prop.type];
+    threading::parallel_for(face_indices.index_range(), 4096, [&](const IndexRange range) {
+      for (const int64_t i : range) {
+        const uint8_t *ptr = face_indices[i];
+        uint32_t *dst = &data->face_vertices[face_starts[i]];
+        for (int j = 0; j < data->face_sizes[i]; j++) {
+          if (big_endian) {
+            uint8_t value[8];
+            memcpy(value, ptr, index_size);
+            endian_switch(value, index_size);
+            const uint8_t *value_ptr = value;
+            dst[j] = get_binary_value<uint32_t>(prop.type, value_ptr);
+            ptr += index_size;
+          }
+          else {
+            dst[j] = get_binary_value<uint32_t>(prop.type, ptr);
+          }
+        }
+      }
+    });
+  }
   else {
     Vector<uint8_t> scratch(64);
 
@@ -601,7 +713,7 @@ static const char *load_edge_element(PlyReadBuffer &file,
   for (int i = 0; i < element.count; i++) {
     const char *error = nullptr;
     if (header.type == PlyFormatType::ASCII) {
-      error = parse_row_ascii(file, value_vec);
+      error = parse_row_ascii(file.read_line(), value_vec);
     }
     else {
       error = parse_row_binary(file, header, element, scratch, value_vec);
@@ -16,6 +16,7 @@
 #include "BLI_color.hh"
 #include "BLI_math_vector.h"
 #include "BLI_span.hh"
+#include "BLI_task.hh"
 
 #include "ply_import_mesh.hh"
 
@@ -75,14 +76,14 @@ Mesh *convert_ply_to_mesh(PlyData &data, const PLYImportParams &params)
         "Col", bke::AttrDomain::Point);
 
     if (params.vertex_colors == PLY_VERTEX_COLOR_SRGB) {
-      for (const int i : data.vertex_colors.index_range()) {
-        srgb_to_linearrgb_v4(colors.span[i], data.vertex_colors[i]);
-      }
+      threading::parallel_for(data.vertex_colors.index_range(), 4096, [&](IndexRange range) {
+        for (const int i : range) {
+          srgb_to_linearrgb_v4(colors.span[i], data.vertex_colors[i]);
+        }
+      });
     }
     else {
-      for (const int i : data.vertex_colors.index_range()) {
-        copy_v4_v4(colors.span[i], data.vertex_colors[i]);
-      }
+      colors.span.copy_from(data.vertex_colors.as_span().cast<ColorGeometry4f>());
     }
     colors.finish();
     BKE_id_attributes_active_color_set(&mesh->id, "Col");
@@ -93,9 +94,11 @@ Mesh *convert_ply_to_mesh(PlyData &data, const PLYImportParams &params)
   if (!data.uv_coordinates.is_empty()) {
     bke::SpanAttributeWriter<float2> uv_map = attributes.lookup_or_add_for_write_only_span<float2>(
         "UVMap", bke::AttrDomain::Corner);
-    for (const int i : data.face_vertices.index_range()) {
-      uv_map.span[i] = data.uv_coordinates[data.face_vertices[i]];
-    }
+    threading::parallel_for(data.face_vertices.index_range(), 4096, [&](IndexRange range) {
+      for (const int i : range) {
+        uv_map.span[i] = data.uv_coordinates[data.face_vertices[i]];
+      }
+    });
     uv_map.finish();
   }
 
@@ -10,8 +10,11 @@
 
 #include "BKE_mesh.hh"
 
-#include "BLI_array_utils.hh"
+#include "BLI_array.hh"
+#include "BLI_map.hh"
+#include "BLI_math_base.h"
 #include "BLI_span.hh"
+#include "BLI_task.hh"
 
 #include "DNA_mesh_types.h"
 
@@ -23,57 +26,192 @@ namespace blender::io::stl {
 STLMeshHelper::STLMeshHelper(int tris_num, bool use_custom_normals)
     : use_custom_normals_(use_custom_normals)
 {
-  degenerate_tris_num_ = 0;
-  duplicate_tris_num_ = 0;
   tris_.reserve(tris_num);
-  /* Upper bound (all vertices are unique). */
-  verts_.reserve(tris_num * 3);
-  if (use_custom_normals) {
-    loop_normals_.reserve(tris_num * 3);
+}
+
+void STLMeshHelper::add_triangle(const PackedTriangle &data)
+{
+  tris_.append(data);
+}
+
+Mesh *STLMeshHelper::to_mesh()
+{
+  return create_mesh_from_triangles(tris_, use_custom_normals_);
+}
+
+/**
+ * For every key, find the index of the first key that is equal to it. The keys are distributed
+ * over shards by their hash, and every shard is de-duplicated by a separate task in the original
+ * key order. That gives the same result as adding all keys to a single set one by one.
+ */
+template<typename T>
+static void find_first_occurrences(const Span<T> keys, MutableSpan<int> r_first)
+{
+  constexpr int shard_bits = 6;
+  constexpr int shards_num = 1 << shard_bits;
+  constexpr int64_t keys_per_task = 64 * 1024;
+  const int64_t tasks_num = std::max<int64_t>(1, divide_ceil_ul(keys.size(), keys_per_task));
+
+  /* Count the keys of every task that go into each shard. */
+  Array<uint8_t> key_shards(keys.size());
+  Array<int> shard_task_offsets(tasks_num * shards_num, 0);
+  threading::parallel_for(IndexRange(tasks_num), 1, [&](const IndexRange tasks) {
+    for (const int64_t task : tasks) {
+      MutableSpan<int> counts = shard_task_offsets.as_mutable_span().slice(task * shards_num,
+                                                                            shards_num);
+      const int64_t start = task * keys_per_task;
+      for (const int64_t i : IndexRange(start, std::min(keys_per_task, keys.size() - start))) {
+        /* The maps of the shards use the low bits of the hash to find slots. Use the high bits
+         * of the re-mixed hash for the shard, so that keys of a shard don't start probing at the
+         * same slots. Fibonacci hashing is used because the high bits of the default hash of
+         * floats are mostly zero. */
+        const uint64_t hash = get_default_hash(keys[i]) * 0x9E3779B97F4A7C15ull;
+        const int shard = int(hash >> (64 - shard_bits));
+        key_shards[i] = uint8_t(shard);
+        counts[shard]++;
+      }
+    }
+  });
+
+  /* Turn the counts into offsets, so that the keys of every shard end up in a contiguous range
+   * that is sorted by key index. */
+  Array<int> shard_offsets(shards_num + 1);
+  int offset = 0;
+  for (const int shard : IndexRange(shards_num)) {
+    shard_offsets[shard] = offset;
+    for (const int64_t task : IndexRange(tasks_num)) {
+      const int count = shard_task_offsets[task * shards_num + shard];
+      shard_task_offsets[task * shards_num + shard] = offset;
+      offset += count;
+    }
   }
+  shard_offsets[shards_num] = offset;
+
+  Array<int> sorted_keys(keys.size());
+  threading::parallel_for(IndexRange(tasks_num), 1, [&](const IndexRange tasks) {
+    for (const int64_t task : tasks) {
+      MutableSpan<int> offsets = shard_task_offsets.as_mutable_span().slice(task * shards_num,
+                                                                             shards_num);
+      const int64_t start = task * keys_per_task;
+      for (const int64_t i : IndexRange(start, std::min(keys_per_task, keys.size() - start))) {
+        sorted_keys[offsets[key_shards[i]]++] = int(i);
+      }
+    }
+  });
+
+  threading::parallel_for(IndexRange(shards_num), 1, [&](const IndexRange shards) {
+    for (const int shard : shards) {
+      const Span<int> shard_keys = sorted_keys.as_span().slice(
+          shard_offsets[shard], shard_offsets[shard + 1] - shard_offsets[shard]);
+      Map<T, int> first_indices;
+      first_indices.reserve(shard_keys.size());
+      for (const int i : shard_keys) {
+        r_first[i] = first_indices.lookup_or_add(keys[i], i);
+      }
+    }
+  });
 }
 
-bool STLMeshHelper::add_triangle(const PackedTriangle &data)
+Mesh *create_mesh_from_triangles(const Span<PackedTriangle> tris, const bool use_custom_normals)
 {
-  int v1_id = verts_.index_of_or_add(data.vertices[0]);
-  int v2_id = verts_.index_of_or_add(data.vertices[1]);
-  int v3_id = verts_.index_of_or_add(data.vertices[2]);
-  if ((v1_id == v2_id) || (v1_id == v3_id) || (v2_id == v3_id)) {
-    degenerate_tris_num_++;
-    return false;
+  /* Merge vertices at the same location, numbering them in order of their first use. */
+  const int64_t tri_corners_num = tris.size() * 3;
+  Array<float3> corner_positions(tri_corners_num);
+  threading::parallel_for(tris.index_range(), 4096, [&](const IndexRange range) {
+    for (const int64_t i : range) {
+      for (const int j : IndexRange(3)) {
+        corner_positions[i * 3 + j] = tris[i].vertices[j];
+      }
+    }
+  });
+  Array<int> first_corners(tri_corners_num);
+  find_first_occurrences(corner_positions.as_span(), first_corners);
+
+  Array<int> tri_corner_verts(tri_corners_num);
+  int verts_num = 0;
+  for (const int64_t i : first_corners.index_range()) {
+    if (first_corners[i] == i) {
+      tri_corner_verts[i] = verts_num++;
+    }
   }
-  if (!tris_.add({v1_id, v2_id, v3_id})) {
-    duplicate_tris_num_++;
-    return false;
+  threading::parallel_for(first_corners.index_range(), 4096, [&](const IndexRange range) {
+    for (const int64_t i : range) {
+      if (first_corners[i] != i) {
+        tri_corner_verts[i] = tri_corner_verts[first_corners[i]];
+      }
+    }
+  });
+
+  /* Remove degenerate triangles, then duplicate triangles. */
+  int degenerate_tris_num = 0;
+  Vector<Triangle> valid_tris;
+  Vector<int> valid_tri_indices;
+  valid_tris.reserve(tris.size());
+  valid_tri_indices.reserve(tris.size());
+  for (const int64_t i : tris.index_range()) {
+    const int v1_id = tri_corner_verts[i * 3];
+    const int v2_id = tri_corner_verts[i * 3 + 1];
+    const int v3_id = tri_corner_verts[i * 3 + 2];
+    if ((v1_id == v2_id) || (v1_id == v3_id) || (v2_id == v3_id)) {
+      degenerate_tris_num++;
+      continue;
+    }
+    valid_tris.append({v1_id, v2_id, v3_id});
+    valid_tri_indices.append(int(i));
   }
 
-  if (use_custom_normals_) {
-    loop_normals_.append_n_times(data.normal, 3);
+  Array<int> first_tris(valid_tris.size());
+  find_first_occurrences(valid_tris.as_span(), first_tris);
+  Vector<int> unique_tris;
+  unique_tris.reserve(valid_tris.size());
+  for (const int64_t i : first_tris.index_range()) {
+    if (first_tris[i] == i) {
+      unique_tris.append(int(i));
+    }
   }
-  return true;
-}
+  const int64_t duplicate_tris_num = valid_tris.size() - unique_tris.size();
 
-Mesh *STLMeshHelper::to_mesh()
-{
-  if (degenerate_tris_num_ > 0) {
-    std::cout << "STL Importer: " << degenerate_tris_num_ << " degenerate triangles were removed"
+  if (degenerate_tris_num > 0) {
+    std::cout << "STL Importer: " << degenerate_tris_num << " degenerate triangles were removed"
               << std::endl;
   }
-  if (duplicate_tris_num_ > 0) {
-    std::cout << "STL Importer: " << duplicate_tris_num_ << " duplicate triangles were removed"
+  if (duplicate_tris_num > 0) {
+    std::cout << "STL Importer: " << duplicate_tris_num << " duplicate triangles were removed"
               << std::endl;
   }
 
-  Mesh *mesh = BKE_mesh_new_nomain(verts_.size(), 0, tris_.size(), tris_.size() * 3);
-  mesh->vert_positions_for_write().copy_from(verts_);
+  Mesh *mesh = BKE_mesh_new_nomain(verts_num, 0, unique_tris.size(), unique_tris.size() * 3);
+  MutableSpan<float3> positions = mesh->vert_positions_for_write();
+  threading::parallel_for(first_corners.index_range(), 4096, [&](const IndexRange range) {
+    for (const int64_t i : range) {
+      if (first_corners[i] == i) {
+        positions[tri_corner_verts[i]] = corner_positions[i];
+      }
+    }
+  });
   offset_indices::fill_constant_group_size(3, 0, mesh->face_offsets_for_write());
-  array_utils::copy(tris_.as_span().cast<int>(), mesh->corner_verts_for_write());
+  MutableSpan<int> corner_verts = mesh->corner_verts_for_write();
+  threading::parallel_for(unique_tris.index_range(), 4096, [&](const IndexRange range) {
+    for (const int64_t i : range) {
+      const Triangle &tri = valid_tris[unique_tris[i]];
+      corner_verts[i * 3] = tri.v1;
+      corner_verts[i * 3 + 1] = tri.v2;
+      corner_verts[i * 3 + 2] = tri.v3;
+    }
+  });
 
   /* NOTE: edges must be calculated first before setting custom normals. */
   bke::mesh_calc_edges(*mesh, false, false);
 
-  if (use_custom_normals_ && loop_normals_.size() == mesh->corners_num) {
-    BKE_mesh_set_custom_normals(mesh, reinterpret_cast<float(*)[3]>(loop_normals_.data()));
+  if (use_custom_normals) {
+    Array<float3> corner_normals(mesh->corners_num);
+    threading::parallel_for(unique_tris.index_range(), 4096, [&](const IndexRange range) {
+      for (const int64_t i : range) {
+        const float3 &normal = tris[valid_tri_indices[unique_tris[i]]].normal;
+        corner_normals.as_mutable_span().slice(i * 3, 3).fill(normal);
+      }
+    });
+    BKE_mesh_set_custom_normals(mesh, reinterpret_cast<float(*)[3]>(corner_normals.data()));
   }
 
   return mesh;
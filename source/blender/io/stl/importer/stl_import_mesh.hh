@@ -11,8 +11,8 @@
 #include <cstdint>
 
 #include "BLI_math_vector_types.hh"
+#include "BLI_span.hh"
 #include "BLI_vector.hh"
-#include "BLI_vector_set.hh"
 #include "stl_data.hh"
 
 struct Mesh;
@@ -49,22 +49,25 @@ class Triangle {
 
 class STLMeshHelper {
  private:
-  VectorSet<float3> verts_;
-  VectorSet<Triangle> tris_;
-  Vector<float3> loop_normals_;
-  int degenerate_tris_num_;
-  int duplicate_tris_num_;
+  Vector<PackedTriangle> tris_;
   const bool use_custom_normals_;
 
  public:
   STLMeshHelper(int tris_num, bool use_custom_normals);
 
-  /* Creates a new triangle from specified vertex locations,
-   * duplicate vertices and triangles are merged.
+  /* Adds a new triangle from specified vertex locations,
+   * duplicate vertices and triangles are merged in #to_mesh.
    */
-  bool add_triangle(const PackedTriangle &data);
+  void add_triangle(const PackedTriangle &data);
 
   Mesh *to_mesh();
 };
 
+/**
+ * Create a mesh from triangles given by vertex locations. Vertices at the same location and
+ * duplicate triangles are merged, the result is the same as adding the triangles one by one,
+ * but the work is split over multiple threads.
+ */
+Mesh *create_mesh_from_triangles(Span<PackedTriangle> tris, bool use_custom_normals);
+
 }  // namespace blender::io::stl
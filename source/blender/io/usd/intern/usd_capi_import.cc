@@ -24,6 +24,7 @@
 #include "BLI_math_rotation.h"
 #include "BLI_path_util.h"
 #include "BLI_string.h"
+#include "BLI_task.hh"
 #include "BLI_timeit.hh"
 
 #include "BLT_translation.hh"
@@ -321,10 +322,28 @@ static void import_startjob(void *customdata, wmJobWorkerStatus *worker_status)
     reader->create_object(data->bmain, 0.0);
     if ((++i & 1023) == 0) {
       *data->do_update = true;
-      *data->progress = 0.25f + 0.25f * (i / size);
+      *data->progress = 0.25f + 0.15f * (i / size);
     }
   }
 
+  /* Read object data that doesn't depend on the main database (e.g. mesh geometry) for all prims
+   * in parallel, only the rest of the data is read sequentially below. */
+  const Span<USDPrimReader *> readers = archive->readers();
+  threading::parallel_for(readers.index_range(), 1, [&](const IndexRange range) {
+    for (USDPrimReader *reader : readers.slice(range)) {
+      if (reader && !G.is_break) {
+        reader->prefetch_object_data(0.0);
+      }
+    }
+  });
+  *data->do_update = true;
+  *data->progress = 0.5f;
+
+  if (G.is_break) {
+    data->was_canceled = true;
+    return;
+  }
+
   /* Setup parenthood and read actual object data. */
   i = 0;
   for (USDPrimReader *reader : archive->readers()) {
@@ -16,6 +16,7 @@ struct Main;
 namespace blender::io::usd {
 
 class USDHierarchyIterator;
+class USDMeshWriteQueue;
 
 struct USDExporterContext {
   Main *bmain;
@@ -31,6 +32,8 @@ struct USDExporterContext {
   std::function<pxr::UsdTimeCode()> get_time_code;
   const USDExportParams &export_params;
   std::string export_file_path;
+  /** When set, mesh writers add their meshes to this queue instead of writing them directly. */
+  USDMeshWriteQueue *mesh_write_queue = nullptr;
 };
 
 }  // namespace blender::io::usd
@@ -75,6 +75,12 @@ void USDHierarchyIterator::set_export_frame(float frame_nr)
   export_time_ = pxr::UsdTimeCode(frame_nr);
 }
 
+void USDHierarchyIterator::iterate_and_write()
+{
+  AbstractHierarchyIterator::iterate_and_write();
+  mesh_write_queue_.flush();
+}
+
 USDExporterContext USDHierarchyIterator::create_usd_export_context(const HierarchyContext *context)
 {
   pxr::SdfPath path;
@@ -91,8 +97,14 @@ USDExporterContext USDHierarchyIterator::create_usd_export_context(const Hierarc
   const std::string export_file_path = root_layer->GetRealPath();
   auto get_time_code = [this]() { return this->export_time_; };
 
-  return USDExporterContext{
-      bmain_, depsgraph_, stage_, path, get_time_code, params_, export_file_path};
+  return USDExporterContext{bmain_,
+                            depsgraph_,
+                            stage_,
+                            path,
+                            get_time_code,
+                            params_,
+                            export_file_path,
+                            &mesh_write_queue_};
 }
 
 AbstractHierarchyWriter *USDHierarchyIterator::create_transform_writer(
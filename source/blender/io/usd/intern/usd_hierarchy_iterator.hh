@@ -7,6 +7,7 @@
 #include "usd.hh"
 #include "usd_exporter_context.hh"
 #include "usd_skel_convert.hh"
+#include "usd_writer_mesh.hh"
 
 #include <string>
 
@@ -33,6 +34,8 @@ class USDHierarchyIterator : public AbstractHierarchyIterator {
   ObjExportMap skinned_mesh_export_map_;
   ObjExportMap shape_key_mesh_export_map_;
 
+  USDMeshWriteQueue mesh_write_queue_;
+
  public:
   USDHierarchyIterator(Main *bmain,
                        Depsgraph *depsgraph,
@@ -41,6 +44,9 @@ class USDHierarchyIterator : public AbstractHierarchyIterator {
 
   void set_export_frame(float frame_nr);
 
+  /** Also writes the meshes that were queued while iterating. */
+  virtual void iterate_and_write() override;
+
   virtual std::string make_valid_name(const std::string &name) const override;
 
   void process_usd_skel() const;
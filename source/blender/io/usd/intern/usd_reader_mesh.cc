@@ -14,6 +14,7 @@
 #include "BKE_attribute.hh"
 #include "BKE_customdata.hh"
 #include "BKE_geometry_set.hh"
+#include "BKE_lib_id.hh"
 #include "BKE_main.hh"
 #include "BKE_material.h"
 #include "BKE_mesh.hh"
@@ -155,10 +156,19 @@ USDMeshReader::USDMeshReader(const pxr::UsdPrim &prim,
       mesh_prim_(prim),
       is_left_handed_(false),
       is_time_varying_(false),
-      is_initial_load_(false)
+      is_initial_load_(false),
+      is_prefetched_(false),
+      prefetched_mesh_(nullptr)
 {
 }
 
+USDMeshReader::~USDMeshReader()
+{
+  if (prefetched_mesh_) {
+    BKE_id_free(nullptr, prefetched_mesh_);
+  }
+}
+
 static const std::optional<bke::AttrDomain> convert_usd_varying_to_blender(
     const pxr::TfToken usd_domain, ReportList *reports)
 {
@@ -195,7 +205,7 @@ void USDMeshReader::create_object(Main *bmain, const double /*motionSampleTime*/
   object_->data = mesh;
 }
 
-void USDMeshReader::read_object_data(Main *bmain, const double motionSampleTime)
+void USDMeshReader::prefetch_object_data(const double motionSampleTime)
 {
   Mesh *mesh = (Mesh *)object_->data;
 
@@ -203,11 +213,27 @@ void USDMeshReader::read_object_data(Main *bmain, const double motionSampleTime)
   const USDMeshReadParams params = create_mesh_read_params(motionSampleTime,
                                                            import_params_.mesh_read_flag);
 
+  /* Only the mesh owned by this reader is changed, which is safe to do from any thread. */
   Mesh *read_mesh = this->read_mesh(mesh, params, nullptr);
 
   is_initial_load_ = false;
+  is_prefetched_ = true;
   if (read_mesh != mesh) {
-    BKE_mesh_nomain_to_mesh(read_mesh, mesh, object_);
+    prefetched_mesh_ = read_mesh;
+  }
+}
+
+void USDMeshReader::read_object_data(Main *bmain, const double motionSampleTime)
+{
+  Mesh *mesh = (Mesh *)object_->data;
+
+  if (!is_prefetched_) {
+    this->prefetch_object_data(motionSampleTime);
+  }
+  is_prefetched_ = false;
+  if (prefetched_mesh_) {
+    BKE_mesh_nomain_to_mesh(prefetched_mesh_, mesh, object_);
+    prefetched_mesh_ = nullptr;
   }
 
   readFaceSetsSample(bmain, mesh, motionSampleTime);
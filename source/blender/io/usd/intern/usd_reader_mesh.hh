@@ -40,14 +40,21 @@ class USDMeshReader : public USDGeomReader {
    * implemented.  Note this will break if faces or positions vary. */
   bool is_initial_load_;
 
+  /** Set by #prefetch_object_data(), used by #read_object_data(). */
+  bool is_prefetched_;
+  /** Mesh outside of the main database read by #prefetch_object_data(), if any. */
+  Mesh *prefetched_mesh_;
+
  public:
   USDMeshReader(const pxr::UsdPrim &prim,
                 const USDImportParams &import_params,
                 const ImportSettings &settings);
+  ~USDMeshReader() override;
 
   bool valid() const override;
 
   void create_object(Main *bmain, double motionSampleTime) override;
+  void prefetch_object_data(double motionSampleTime) override;
   void read_object_data(Main *bmain, double motionSampleTime) override;
 
   void read_geometry(bke::GeometrySet &geometry_set,
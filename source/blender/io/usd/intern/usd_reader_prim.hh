@@ -109,6 +109,11 @@ class USDPrimReader {
   virtual bool valid() const;
 
   virtual void create_object(Main *bmain, double motionSampleTime) = 0;
+  /**
+   * Read data for #read_object_data() that doesn't require access to the main database. This is
+   * called for many readers concurrently after all objects have been created.
+   */
+  virtual void prefetch_object_data(double /*motionSampleTime*/){};
   virtual void read_object_data(Main * /*bmain*/, double /*motionSampleTime*/){};
 
   Object *object() const;
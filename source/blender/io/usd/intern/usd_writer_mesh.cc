@@ -13,11 +13,13 @@
 #include <pxr/usd/usdShade/materialBindingAPI.h>
 #include <pxr/usd/usdSkel/bindingAPI.h>
 
+#include "BLI_array.hh"
 #include "BLI_array_utils.hh"
 #include "BLI_assert.h"
 #include "BLI_color.hh"
 #include "BLI_math_quaternion_types.hh"
 #include "BLI_math_vector_types.hh"
+#include "BLI_task.hh"
 
 #include "BKE_attribute.hh"
 #include "BKE_customdata.hh"
@@ -95,15 +97,50 @@ void USDGenericMeshWriter::do_write(HierarchyContext &context)
     return;
   }
 
-  try {
-    /* Fetch the subdiv modifier, if one exists and it is the last modifier. */
-    const SubsurfModifierData *subsurfData = get_last_subdiv_modifier(
-        usd_export_context_.export_params.evaluation_mode, object_eval);
+  /* Fetch the subdiv modifier, if one exists and it is the last modifier. */
+  const SubsurfModifierData *subsurfData = get_last_subdiv_modifier(
+      usd_export_context_.export_params.evaluation_mode, object_eval);
+  const pxr::TfToken subdiv_scheme = get_subdiv_scheme(subsurfData);
 
-    write_mesh(context, mesh, subsurfData);
+  /* Ensure data exists if currently in edit mode. */
+  BKE_mesh_wrapper_ensure_mdata(mesh);
 
-    if (needsfree) {
-      free_export_mesh(mesh);
+  USDMeshWriteQueue *write_queue = usd_export_context_.mesh_write_queue;
+  if (write_queue && supports_deferred_write()) {
+    /* Define the prim right away, so that the order of prims in the stage doesn't depend on
+     * when the queue is flushed. */
+    pxr::UsdGeomMesh::Define(usd_export_context_.stage, usd_export_context_.usd_path);
+    write_queue->add(
+        {this, context, mesh, needsfree, subsurfData, subdiv_scheme, !frame_has_been_written_});
+    return;
+  }
+
+  USDMeshData usd_mesh_data;
+  get_mesh_data(mesh, subdiv_scheme, usd_mesh_data);
+  write_mesh_and_free(context,
+                      mesh,
+                      needsfree,
+                      subsurfData,
+                      subdiv_scheme,
+                      usd_mesh_data,
+                      !frame_has_been_written_);
+}
+
+void USDGenericMeshWriter::write_mesh_and_free(HierarchyContext &context,
+                                               Mesh *mesh,
+                                               const bool needsfree,
+                                               const SubsurfModifierData *subsurfData,
+                                               const pxr::TfToken &subdiv_scheme,
+                                               const USDMeshData &usd_mesh_data,
+                                               const bool is_first_frame)
+{
+  try {
+    write_mesh(context, mesh, subsurfData, subdiv_scheme, usd_mesh_data, is_first_frame);
+
+    auto prim = usd_export_context_.stage->GetPrimAtPath(usd_export_context_.usd_path);
+    if (prim.IsValid() && context.object) {
+      prim.SetActive((context.object->duplicator_visibility_flag & OB_DUPLI_FLAG_RENDER) != 0);
+      write_id_properties(prim, mesh->id, get_export_time_code());
     }
   }
   catch (...) {
@@ -113,10 +150,8 @@ void USDGenericMeshWriter::do_write(HierarchyContext &context)
     throw;
   }
 
-  auto prim = usd_export_context_.stage->GetPrimAtPath(usd_export_context_.usd_path);
-  if (prim.IsValid() && object_eval) {
-    prim.SetActive((object_eval->duplicator_visibility_flag & OB_DUPLI_FLAG_RENDER) != 0);
-    write_id_properties(prim, mesh->id, get_export_time_code());
+  if (needsfree) {
+    free_export_mesh(mesh);
   }
 }
 
@@ -267,9 +302,12 @@ void USDGenericMeshWriter::copy_blender_buffer_to_prim(const Span<BlenderT> buff
   }
   else {
     data.resize(buffer.size());
-    for (const int64_t i : buffer.index_range()) {
-      data[i] = convert_value<BlenderT, USDT>(buffer[i]);
-    }
+    USDT *dst = data.data();
+    threading::parallel_for(buffer.index_range(), 4096, [&](const IndexRange range) {
+      for (const int64_t i : range) {
+        dst[i] = convert_value<BlenderT, USDT>(buffer[i]);
+      }
+    });
   }
 
   if (!attribute_pv.HasValue() && timecode != pxr::UsdTimeCode::Default()) {
@@ -435,11 +473,64 @@ struct USDMeshData {
   pxr::VtIntArray corner_indices;
   /* The per-vertex sharpnesses. The lengths of this array must match that of `corner_indices`. */
   pxr::VtFloatArray corner_sharpnesses;
+
+  /* Face-varying normals, only filled when normals are exported. */
+  pxr::VtVec3fArray corner_normals;
 };
 
+static void get_normals(const Mesh *mesh, pxr::VtVec3fArray &loop_normals)
+{
+  loop_normals.resize(mesh->corners_num);
+
+  MutableSpan dst_normals(reinterpret_cast<float3 *>(loop_normals.data()), loop_normals.size());
+
+  switch (mesh->normals_domain()) {
+    case bke::MeshNormalDomain::Point: {
+      array_utils::gather(mesh->vert_normals(), mesh->corner_verts(), dst_normals);
+      break;
+    }
+    case bke::MeshNormalDomain::Face: {
+      const OffsetIndices faces = mesh->faces();
+      const Span<float3> face_normals = mesh->face_normals();
+      threading::parallel_for(faces.index_range(), 1024, [&](const IndexRange range) {
+        for (const int i : range) {
+          dst_normals.slice(faces[i]).fill(face_normals[i]);
+        }
+      });
+      break;
+    }
+    case bke::MeshNormalDomain::Corner: {
+      array_utils::copy(mesh->corner_normals(), dst_normals);
+      break;
+    }
+  }
+}
+
+bool USDGenericMeshWriter::export_normals(const pxr::TfToken &subdiv_scheme) const
+{
+  /* Normals can be animated, so ensure these are written for each frame,
+   * unless a subdiv modifier is used, in which case normals are computed,
+   * not stored with the mesh. */
+  return usd_export_context_.export_params.export_normals &&
+         subdiv_scheme == pxr::UsdGeomTokens->none;
+}
+
+void USDGenericMeshWriter::get_mesh_data(const Mesh *mesh,
+                                         const pxr::TfToken &subdiv_scheme,
+                                         USDMeshData &usd_mesh_data)
+{
+  get_geometry_data(mesh, usd_mesh_data);
+  if (export_normals(subdiv_scheme)) {
+    get_normals(mesh, usd_mesh_data.corner_normals);
+  }
+}
+
 void USDGenericMeshWriter::write_mesh(HierarchyContext &context,
                                       Mesh *mesh,
-                                      const SubsurfModifierData *subsurfData)
+                                      const SubsurfModifierData *subsurfData,
+                                      const pxr::TfToken &subdiv_scheme,
+                                      const USDMeshData &usd_mesh_data,
+                                      const bool is_first_frame)
 {
   pxr::UsdTimeCode timecode = get_export_time_code();
   pxr::UsdStageRefPtr stage = usd_export_context_.stage;
@@ -448,11 +539,6 @@ void USDGenericMeshWriter::write_mesh(HierarchyContext &context,
   pxr::UsdGeomMesh usd_mesh = pxr::UsdGeomMesh::Define(stage, usd_path);
   write_visibility(context, timecode, usd_mesh);
 
-  USDMeshData usd_mesh_data;
-  /* Ensure data exists if currently in edit mode. */
-  BKE_mesh_wrapper_ensure_mdata(mesh);
-  get_geometry_data(mesh, usd_mesh_data);
-
   if (usd_export_context_.export_params.use_instancing && context.is_instance()) {
     if (!mark_as_instance(context, usd_mesh.GetPrim())) {
       return;
@@ -530,19 +616,12 @@ void USDGenericMeshWriter::write_mesh(HierarchyContext &context,
   write_custom_data(context.object, mesh, usd_mesh);
   write_surface_velocity(mesh, usd_mesh);
 
-  const pxr::TfToken subdiv_scheme = get_subdiv_scheme(subsurfData);
-
-  /* Normals can be animated, so ensure these are written for each frame,
-   * unless a subdiv modifier is used, in which case normals are computed,
-   * not stored with the mesh. */
-  if (usd_export_context_.export_params.export_normals &&
-      subdiv_scheme == pxr::UsdGeomTokens->none)
-  {
-    write_normals(mesh, usd_mesh);
+  if (export_normals(subdiv_scheme)) {
+    write_normals(usd_mesh_data.corner_normals, usd_mesh);
   }
 
   /* TODO(Sybren): figure out what happens when the face groups change. */
-  if (frame_has_been_written_) {
+  if (!is_first_frame) {
     return;
   }
 
@@ -793,34 +872,11 @@ void USDGenericMeshWriter::assign_materials(const HierarchyContext &context,
   }
 }
 
-void USDGenericMeshWriter::write_normals(const Mesh *mesh, pxr::UsdGeomMesh usd_mesh)
+void USDGenericMeshWriter::write_normals(const pxr::VtVec3fArray &loop_normals,
+                                         pxr::UsdGeomMesh usd_mesh)
 {
   pxr::UsdTimeCode timecode = get_export_time_code();
 
-  pxr::VtVec3fArray loop_normals;
-  loop_normals.resize(mesh->corners_num);
-
-  MutableSpan dst_normals(reinterpret_cast<float3 *>(loop_normals.data()), loop_normals.size());
-
-  switch (mesh->normals_domain()) {
-    case bke::MeshNormalDomain::Point: {
-      array_utils::gather(mesh->vert_normals(), mesh->corner_verts(), dst_normals);
-      break;
-    }
-    case bke::MeshNormalDomain::Face: {
-      const OffsetIndices faces = mesh->faces();
-      const Span<float3> face_normals = mesh->face_normals();
-      for (const int i : faces.index_range()) {
-        dst_normals.slice(faces[i]).fill(face_normals[i]);
-      }
-      break;
-    }
-    case bke::MeshNormalDomain::Corner: {
-      array_utils::copy(mesh->corner_normals(), dst_normals);
-      break;
-    }
-  }
-
   pxr::UsdAttribute attr_normals = usd_mesh.CreateNormalsAttr(pxr::VtValue(), true);
   if (!attr_normals.HasValue()) {
     attr_normals.Set(loop_normals, pxr::UsdTimeCode::Default());
@@ -854,6 +910,36 @@ void USDGenericMeshWriter::write_surface_velocity(const Mesh *mesh, pxr::UsdGeom
   usd_mesh.CreateVelocitiesAttr().Set(usd_velocities, timecode);
 }
 
+void USDMeshWriteQueue::add(Item item)
+{
+  items_.append(std::move(item));
+}
+
+void USDMeshWriteQueue::flush()
+{
+  Array<USDMeshData> mesh_data(items_.size());
+  threading::parallel_for(items_.index_range(), 1, [&](const IndexRange range) {
+    for (const int64_t i : range) {
+      Item &item = items_[i];
+      item.writer->get_mesh_data(item.mesh, item.subdiv_scheme, mesh_data[i]);
+    }
+  });
+
+  /* Writing to the stage is not thread-safe, and the order of writes should not depend on
+   * scheduling. */
+  for (const int64_t i : items_.index_range()) {
+    Item &item = items_[i];
+    item.writer->write_mesh_and_free(item.context,
+                                     item.mesh,
+                                     item.needsfree,
+                                     item.subsurf_data,
+                                     item.subdiv_scheme,
+                                     mesh_data[i],
+                                     item.is_first_frame);
+  }
+  items_.clear();
+}
+
 USDMeshWriter::USDMeshWriter(const USDExporterContext &ctx)
     : USDGenericMeshWriter(ctx), write_skinned_mesh_(false), write_blend_shapes_(false)
 {
@@ -983,6 +1069,11 @@ void USDMeshWriter::do_write(HierarchyContext &context)
   }
 }
 
+bool USDMeshWriter::supports_deferred_write() const
+{
+  return !write_skinned_mesh_ && !write_blend_shapes_;
+}
+
 Mesh *USDMeshWriter::get_export_mesh(Object *object_eval, bool &r_needsfree)
 {
   if (write_blend_shapes_) {
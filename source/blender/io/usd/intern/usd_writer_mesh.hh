@@ -6,6 +6,7 @@
 #include "usd_writer_abstract.hh"
 
 #include "BLI_map.hh"
+#include "BLI_vector.hh"
 
 #include <pxr/usd/usdGeom/mesh.h>
 
@@ -21,8 +22,38 @@ namespace blender::io::usd {
 
 struct USDMeshData;
 
+class USDGenericMeshWriter;
+
+/**
+ * Mesh writes of one exported frame, collected while iterating over the export hierarchy. The
+ * arrays of all meshes are extracted in parallel when flushing, after which they are written to
+ * the USD stage in the order the meshes were added.
+ */
+class USDMeshWriteQueue {
+ public:
+  struct Item {
+    USDGenericMeshWriter *writer;
+    HierarchyContext context;
+    Mesh *mesh;
+    bool needsfree;
+    const SubsurfModifierData *subsurf_data;
+    pxr::TfToken subdiv_scheme;
+    bool is_first_frame;
+  };
+
+ private:
+  Vector<Item> items_;
+
+ public:
+  void add(Item item);
+  /** Write all queued meshes. Must be called before the evaluated meshes are freed. */
+  void flush();
+};
+
 /* Writer for USD geometry. Does not assume the object is a mesh object. */
 class USDGenericMeshWriter : public USDAbstractWriter {
+  friend class USDMeshWriteQueue;
+
  public:
   USDGenericMeshWriter(const USDExporterContext &ctx);
 
@@ -33,12 +64,38 @@ class USDGenericMeshWriter : public USDAbstractWriter {
   virtual Mesh *get_export_mesh(Object *object_eval, bool &r_needsfree) = 0;
   virtual void free_export_mesh(Mesh *mesh);
 
+  /**
+   * Whether the mesh can be written by the #USDMeshWriteQueue of the export context, after
+   * #do_write() has returned.
+   */
+  virtual bool supports_deferred_write() const
+  {
+    return true;
+  }
+
  private:
   /* Mapping from material slot number to array of face indices with that material. */
   using MaterialFaceGroups = Map<short, pxr::VtIntArray>;
 
-  void write_mesh(HierarchyContext &context, Mesh *mesh, const SubsurfModifierData *subsurfData);
+  /** Extract the data that is written to the stage. This can run on any thread. */
+  void get_mesh_data(const Mesh *mesh,
+                     const pxr::TfToken &subdiv_scheme,
+                     USDMeshData &usd_mesh_data);
+  void write_mesh_and_free(HierarchyContext &context,
+                           Mesh *mesh,
+                           bool needsfree,
+                           const SubsurfModifierData *subsurfData,
+                           const pxr::TfToken &subdiv_scheme,
+                           const USDMeshData &usd_mesh_data,
+                           bool is_first_frame);
+  void write_mesh(HierarchyContext &context,
+                  Mesh *mesh,
+                  const SubsurfModifierData *subsurfData,
+                  const pxr::TfToken &subdiv_scheme,
+                  const USDMeshData &usd_mesh_data,
+                  bool is_first_frame);
   pxr::TfToken get_subdiv_scheme(const SubsurfModifierData *subsurfData);
+  bool export_normals(const pxr::TfToken &subdiv_scheme) const;
   void write_subdiv(const pxr::TfToken &subdiv_scheme,
                     pxr::UsdGeomMesh &usd_mesh,
                     const SubsurfModifierData *subsurfData);
@@ -46,7 +103,7 @@ class USDGenericMeshWriter : public USDAbstractWriter {
   void assign_materials(const HierarchyContext &context,
                         pxr::UsdGeomMesh usd_mesh,
                         const MaterialFaceGroups &usd_face_groups);
-  void write_normals(const Mesh *mesh, pxr::UsdGeomMesh usd_mesh);
+  void write_normals(const pxr::VtVec3fArray &loop_normals, pxr::UsdGeomMesh usd_mesh);
   void write_surface_velocity(const Mesh *mesh, pxr::UsdGeomMesh usd_mesh);
 
   void write_custom_data(const Object *obj, const Mesh *mesh, pxr::UsdGeomMesh usd_mesh);
@@ -81,6 +138,9 @@ class USDMeshWriter : public USDGenericMeshWriter {
 
   virtual Mesh *get_export_mesh(Object *object_eval, bool &r_needsfree) override;
 
+  /* Skinned meshes and blend shapes are set up right after writing the mesh. */
+  virtual bool supports_deferred_write() const override;
+
   /**
    * Determine whether we should write skinned mesh or blend shape data
    * based on the export parameters and the modifiers enabled on the object.
@@ -19,6 +19,7 @@
 #include "DNA_image_types.h"
 #include "DNA_material_types.h"
 #include "DNA_node_types.h"
+#include "DNA_scene_types.h"
 
 #include "BKE_context.hh"
 #include "BKE_lib_id.hh"
@@ -177,7 +178,9 @@ class UsdExportTest : public BlendfileLoadingBaseTest {
    * Determine if a Blender Mesh matches a UsdGeomMesh prim by checking counts
    * on vertices, faces, face indices, and normals.
    */
-  const void compare_blender_mesh_to_usd_prim(const Mesh *mesh, const pxr::UsdGeomMesh &mesh_prim)
+  const void compare_blender_mesh_to_usd_prim(const Mesh *mesh,
+                                              const pxr::UsdGeomMesh &mesh_prim,
+                                              const double time = 0.0)
   {
     pxr::VtIntArray face_indices;
     pxr::VtIntArray face_counts;
@@ -186,10 +189,10 @@ class UsdExportTest : public BlendfileLoadingBaseTest {
 
     /* Our export doesn't use 'primvars:normals' so we're not
      * looking for that to be written here. */
-    mesh_prim.GetFaceVertexIndicesAttr().Get(&face_indices, 0.0);
-    mesh_prim.GetFaceVertexCountsAttr().Get(&face_counts, 0.0);
-    mesh_prim.GetPointsAttr().Get(&positions, 0.0);
-    mesh_prim.GetNormalsAttr().Get(&normals, 0.0);
+    mesh_prim.GetFaceVertexIndicesAttr().Get(&face_indices, time);
+    mesh_prim.GetFaceVertexCountsAttr().Get(&face_counts, time);
+    mesh_prim.GetPointsAttr().Get(&positions, time);
+    mesh_prim.GetNormalsAttr().Get(&normals, time);
 
     EXPECT_EQ(mesh->verts_num, positions.size());
     EXPECT_EQ(mesh->faces_num, face_counts.size());
@@ -238,6 +241,45 @@ TEST_F(UsdExportTest, usd_export_rain_mesh)
   }
 }
 
+/*
+ * Export a frame range. The meshes of the last frame are still expected to match the scene.
+ * The performance of animated exports is tracked in `tests/performance/tests/usd_export.py`.
+ */
+TEST_F(UsdExportTest, usd_export_frame_range)
+{
+  if (!load_file_and_depsgraph(simple_scene_filename)) {
+    FAIL() << "Unable to load file: " << simple_scene_filename;
+    return;
+  }
+
+  Scene *scene = bfile->curscene;
+  scene->r.sfra = 1;
+  scene->r.efra = 50;
+
+  USDExportParams params;
+  params.export_animation = true;
+  params.export_materials = false;
+  params.export_normals = true;
+  params.export_uvmaps = true;
+  params.visible_objects_only = true;
+
+  const bool result = USD_export(context, output_filename.c_str(), &params, false, nullptr);
+  ASSERT_TRUE(result) << "Writing to " << output_filename << " failed!";
+
+  pxr::UsdStageRefPtr stage = pxr::UsdStage::Open(output_filename);
+  ASSERT_TRUE(bool(stage)) << "Unable to load Stage from " << output_filename;
+
+  LISTBASE_FOREACH (Object *, object, &bfile->main->objects) {
+    const Mesh *mesh = static_cast<Mesh *>(object->data);
+    const StringRefNull object_name(object->id.name + 2);
+    const pxr::SdfPath sdf_path("/" + pxr::TfMakeValidIdentifier(object_name.c_str()));
+    const pxr::UsdGeomMesh mesh_prim(get_first_child_mesh(stage->GetPrimAtPath(sdf_path)));
+    EXPECT_TRUE(bool(mesh_prim));
+
+    compare_blender_mesh_to_usd_prim(mesh, mesh_prim, scene->r.efra);
+  }
+}
+
 static const bNode *find_node_for_type_in_graph(const bNodeTree *nodetree,
                                                 const blender::StringRefNull type_idname)
 {
@@ -6,8 +6,11 @@
  * \ingroup obj
  */
 
+#include <atomic>
+#include <condition_variable>
 #include <cstdio>
 #include <memory>
+#include <mutex>
 #include <system_error>
 
 #include "BKE_context.hh"
@@ -18,6 +21,7 @@
 #include "BLI_path_util.h"
 #include "BLI_string.h"
 #include "BLI_task.hh"
+#include "BLI_threads.h"
 #include "BLI_vector.hh"
 
 #include "DEG_depsgraph_query.hh"
@@ -158,9 +162,9 @@ static void write_mesh_objects(const Span<std::unique_ptr<OBJMesh>> exportable_a
                                const OBJExportParams &export_params)
 {
   /* Parallelization is over meshes/objects, which means
-   * we have to have the output text buffer for each object,
-   * and write them all into the file at the end. */
-  size_t count = exportable_as_mesh.size();
+   * we have to have the output text buffer for each object.
+   * The buffers are written into the file in order as soon as possible. */
+  const int64_t count = exportable_as_mesh.size();
   Array<FormatHandler> buffers(count);
 
   /* Serial: gather material indices, ensure normals & edges. */
@@ -178,7 +182,7 @@ static void write_mesh_objects(const Span<std::unique_ptr<OBJMesh>> exportable_a
 
   /* Parallel over meshes: store normal coords & indices, uv coords and indices. */
   threading::parallel_for(IndexRange(count), 1, [&](IndexRange range) {
-    for (const int i : range) {
+    for (const int64_t i : range) {
       OBJMesh &obj = *exportable_as_mesh[i];
       if (export_params.export_normals) {
         obj.store_normal_coords_and_indices();
@@ -202,52 +206,86 @@ static void write_mesh_objects(const Span<std::unique_ptr<OBJMesh>> exportable_a
     offsets.normal_offset += obj.get_normal_coords().size();
   }
 
-  /* Parallel over meshes: main result writing. */
-  threading::parallel_for(IndexRange(count), 1, [&](IndexRange range) {
-    for (const int i : range) {
-      OBJMesh &obj = *exportable_as_mesh[i];
-      auto &fh = buffers[i];
+  /* Parallel over meshes: main result writing. Objects are picked up in order, and the text of
+   * an object is written to the file once it and all objects before it are finished. Workers
+   * don't get further ahead of the file than a few objects per thread, so the text kept in
+   * memory is bounded even when an early object takes long. */
+  FILE *f = obj_writer.get_outfile();
+  std::atomic<int64_t> next_object = 0;
+  std::mutex write_mutex;
+  std::condition_variable write_cond;
+  Array<bool> finished_objects(count, false);
+  int64_t next_object_to_write = 0;
 
-      obj_writer.write_object_name(fh, obj);
-      obj_writer.write_vertex_coords(fh, obj, export_params.export_colors);
+  const int64_t workers_num = std::min<int64_t>(count, BLI_system_thread_count());
+  const int64_t objects_ahead_max = workers_num * 2;
 
-      if (obj.tot_faces() > 0) {
-        if (export_params.export_smooth_groups) {
-          obj.calc_smooth_groups(export_params.smooth_groups_bitflags);
-        }
-        if (export_params.export_materials) {
-          obj.calc_face_order();
-        }
-        if (export_params.export_normals) {
-          obj_writer.write_normals(fh, obj);
+  auto write_mesh_object = [&](const int64_t i) {
+    OBJMesh &obj = *exportable_as_mesh[i];
+    auto &fh = buffers[i];
+
+    obj_writer.write_object_name(fh, obj);
+    obj_writer.write_vertex_coords(fh, obj, export_params.export_colors);
+
+    if (obj.tot_faces() > 0) {
+      if (export_params.export_smooth_groups) {
+        obj.calc_smooth_groups(export_params.smooth_groups_bitflags);
+      }
+      if (export_params.export_materials) {
+        obj.calc_face_order();
+      }
+      if (export_params.export_normals) {
+        obj_writer.write_normals(fh, obj);
+      }
+      if (export_params.export_uv) {
+        obj_writer.write_uv_coords(fh, obj);
+      }
+      /* This function takes a 0-indexed slot index for the obj_mesh object and
+       * returns the material name that we are using in the `.obj` file for it. */
+      const auto *obj_mtlindices = mtlindices.is_empty() ? nullptr : &mtlindices[i];
+      auto matname_fn = [&](int s) -> const char * {
+        if (!obj_mtlindices || s < 0 || s >= obj_mtlindices->size()) {
+          return nullptr;
         }
-        if (export_params.export_uv) {
-          obj_writer.write_uv_coords(fh, obj);
+        return mtl_writer->mtlmaterial_name((*obj_mtlindices)[s]);
+      };
+      obj_writer.write_face_elements(fh, index_offsets[i], obj, matname_fn);
+    }
+    obj_writer.write_edges_indices(fh, index_offsets[i], obj);
+
+    /* Nothing will need this object's data after this point, release
+     * various arrays here. */
+    obj.clear();
+  };
+
+  threading::parallel_for(IndexRange(workers_num), 1, [&](IndexRange /*range*/) {
+    while (true) {
+      const int64_t i = next_object.fetch_add(1);
+      if (i >= count) {
+        break;
+      }
+      {
+        /* The object that is next in the file is always being processed by another worker. */
+        std::unique_lock lock{write_mutex};
+        write_cond.wait(lock, [&]() { return i < next_object_to_write + objects_ahead_max; });
+      }
+      /* Isolate, so that a waiting worker never runs while the nested parallel loops of an
+       * earlier object are on the stack of the same thread. */
+      threading::isolate_task([&]() { write_mesh_object(i); });
+
+      /* Write the text of all finished objects that are next in order. */
+      {
+        std::lock_guard lock{write_mutex};
+        finished_objects[i] = true;
+        while (next_object_to_write < count && finished_objects[next_object_to_write]) {
+          buffers[next_object_to_write].write_to_file(f);
+          next_object_to_write++;
         }
-        /* This function takes a 0-indexed slot index for the obj_mesh object and
-         * returns the material name that we are using in the `.obj` file for it. */
-        const auto *obj_mtlindices = mtlindices.is_empty() ? nullptr : &mtlindices[i];
-        auto matname_fn = [&](int s) -> const char * {
-          if (!obj_mtlindices || s < 0 || s >= obj_mtlindices->size()) {
-            return nullptr;
-          }
-          return mtl_writer->mtlmaterial_name((*obj_mtlindices)[s]);
-        };
-        obj_writer.write_face_elements(fh, index_offsets[i], obj, matname_fn);
       }
-      obj_writer.write_edges_indices(fh, index_offsets[i], obj);
-
-      /* Nothing will need this object's data after this point, release
-       * various arrays here. */
-      obj.clear();
+      write_cond.notify_all();
     }
   });
-
-  /* Write all the object text buffers into the output file. */
-  FILE *f = obj_writer.get_outfile();
-  for (auto &b : buffers) {
-    b.write_to_file(f);
-  }
+  BLI_assert(next_object_to_write == count);
 }
 
 /**
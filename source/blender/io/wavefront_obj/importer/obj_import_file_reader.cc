@@ -14,6 +14,8 @@
 #include "BLI_math_vector_types.hh"
 #include "BLI_string.h"
 #include "BLI_string_ref.hh"
+#include "BLI_task.hh"
+#include "BLI_threads.h"
 #include "BLI_vector.hh"
 
 #include "obj_export_mtl.hh"
@@ -71,6 +73,23 @@ static Geometry *create_geometry(Geometry *const prev_geometry,
   return new_geometry();
 }
 
+static void add_vertex_color(const int vertex_index,
+                             const float3 &linear,
+                             GlobalVertices &r_global_vertices)
+{
+  auto &blocks = r_global_vertices.vertex_colors;
+  /* If we don't have vertex colors yet, or the previous vertex
+   * was without color, we need to start a new vertex colors block. */
+  if (blocks.is_empty() ||
+      (blocks.last().start_vertex_index + blocks.last().colors.size() != vertex_index))
+  {
+    GlobalVertices::VertexColorsBlock block;
+    block.start_vertex_index = vertex_index;
+    blocks.append(block);
+  }
+  blocks.last().colors.append(linear);
+}
+
 static void geom_add_vertex(const char *p, const char *end, GlobalVertices &r_global_vertices)
 {
   float3 vert;
@@ -85,18 +104,7 @@ static void geom_add_vertex(const char *p, const char *end, GlobalVertices &r_gl
     if (srgb.x >= 0 && srgb.y >= 0 && srgb.z >= 0) {
       float3 linear;
       srgb_to_linearrgb_v3_v3(linear, srgb);
-
-      auto &blocks = r_global_vertices.vertex_colors;
-      /* If we don't have vertex colors yet, or the previous vertex
-       * was without color, we need to start a new vertex colors block. */
-      if (blocks.is_empty() || (blocks.last().start_vertex_index + blocks.last().colors.size() !=
-                                r_global_vertices.vertices.size() - 1))
-      {
-        GlobalVertices::VertexColorsBlock block;
-        block.start_vertex_index = r_global_vertices.vertices.size() - 1;
-        blocks.append(block);
-      }
-      blocks.last().colors.append(linear);
+      add_vertex_color(r_global_vertices.vertices.size() - 1, linear, r_global_vertices);
     }
   }
   UNUSED_VARS(p);
@@ -225,30 +233,24 @@ static void geom_add_polyline(Geometry *geom,
   }
 }
 
-static void geom_add_polygon(Geometry *geom,
-                             const char *p,
-                             const char *end,
-                             const GlobalVertices &global_vertices,
-                             const int material_index,
-                             const int group_index,
-                             const bool shaded_smooth)
-{
-  FaceElem curr_face;
-  curr_face.shaded_smooth = shaded_smooth;
-  curr_face.material_index = material_index;
-  if (group_index >= 0) {
-    curr_face.vertex_group_index = group_index;
-    geom->has_vertex_groups_ = true;
-  }
-
-  const int orig_corners_size = geom->face_corners_.size();
-  curr_face.start_index_ = orig_corners_size;
+/**
+ * Face corner indices as they are spelled out in the file, before they are
+ * resolved against the vertices, UVs and normals that have been read so far.
+ */
+struct FaceCornerTokens {
+  FaceCorner corner;
+  bool got_uv = false;
+  bool got_normal = false;
+};
 
-  bool face_valid = true;
+static void parse_face_corners(const char *p,
+                               const char *end,
+                               Vector<FaceCornerTokens> &r_corners)
+{
   p = drop_whitespace(p, end);
-  while (p < end && face_valid) {
-    FaceCorner corner;
-    bool got_uv = false, got_normal = false;
+  while (p < end) {
+    FaceCornerTokens tokens;
+    FaceCorner &corner = tokens.corner;
     /* Parse vertex index. */
     p = parse_int(p, end, INT32_MAX, corner.vert_index, false);
 
@@ -257,21 +259,58 @@ static void geom_add_polygon(Geometry *geom,
       break;
     }
 
-    face_valid &= corner.vert_index != INT32_MAX;
     if (p < end && *p == '/') {
       /* Parse UV index. */
       ++p;
       if (p < end && *p != '/') {
         p = parse_int(p, end, INT32_MAX, corner.uv_vert_index, false);
-        got_uv = corner.uv_vert_index != INT32_MAX;
+        tokens.got_uv = corner.uv_vert_index != INT32_MAX;
       }
       /* Parse normal index. */
       if (p < end && *p == '/') {
         ++p;
         p = parse_int(p, end, INT32_MAX, corner.vertex_normal_index, false);
-        got_normal = corner.vertex_normal_index != INT32_MAX;
+        tokens.got_normal = corner.vertex_normal_index != INT32_MAX;
       }
     }
+    r_corners.append(tokens);
+    if (corner.vert_index == INT32_MAX) {
+      /* The face is invalid, there is no need to look at the remaining corners. */
+      break;
+    }
+
+    /* Some files contain extra stuff per face (e.g. 4 indices); skip any remainder (#103441). */
+    p = drop_non_whitespace(p, end);
+    /* Skip whitespace to get to the next face corner. */
+    p = drop_whitespace(p, end);
+  }
+}
+
+static void geom_add_polygon(Geometry *geom,
+                             const Span<FaceCornerTokens> corner_tokens,
+                             const GlobalVertices &global_vertices,
+                             const int material_index,
+                             const int group_index,
+                             const bool shaded_smooth)
+{
+  FaceElem curr_face;
+  curr_face.shaded_smooth = shaded_smooth;
+  curr_face.material_index = material_index;
+  if (group_index >= 0) {
+    curr_face.vertex_group_index = group_index;
+    geom->has_vertex_groups_ = true;
+  }
+
+  const int orig_corners_size = geom->face_corners_.size();
+  curr_face.start_index_ = orig_corners_size;
+
+  bool face_valid = true;
+  for (const FaceCornerTokens &tokens : corner_tokens) {
+    if (!face_valid) {
+      break;
+    }
+    FaceCorner corner = tokens.corner;
+    face_valid &= corner.vert_index != INT32_MAX;
     /* Always keep stored indices non-negative and zero-based. */
     corner.vert_index += corner.vert_index < 0 ? global_vertices.vertices.size() : -1;
     if (corner.vert_index < 0 || corner.vert_index >= global_vertices.vertices.size()) {
@@ -285,7 +324,7 @@ static void geom_add_polygon(Geometry *geom,
       geom->track_vertex_index(corner.vert_index);
     }
     /* Ignore UV index, if the geometry does not have any UVs (#103212). */
-    if (got_uv && !global_vertices.uv_vertices.is_empty()) {
+    if (tokens.got_uv && !global_vertices.uv_vertices.is_empty()) {
       corner.uv_vert_index += corner.uv_vert_index < 0 ? global_vertices.uv_vertices.size() : -1;
       if (corner.uv_vert_index < 0 || corner.uv_vert_index >= global_vertices.uv_vertices.size()) {
         fprintf(stderr,
@@ -298,7 +337,7 @@ static void geom_add_polygon(Geometry *geom,
     /* Ignore corner normal index, if the geometry does not have any normals.
      * Some obj files out there do have face definitions that refer to normal indices,
      * without any normals being present (#98782). */
-    if (got_normal && !global_vertices.vert_normals.is_empty()) {
+    if (tokens.got_normal && !global_vertices.vert_normals.is_empty()) {
       corner.vertex_normal_index += corner.vertex_normal_index < 0 ?
                                         global_vertices.vert_normals.size() :
                                         -1;
@@ -314,11 +353,6 @@ static void geom_add_polygon(Geometry *geom,
     }
     geom->face_corners_.append(corner);
     curr_face.corner_count_++;
-
-    /* Some files contain extra stuff per face (e.g. 4 indices); skip any remainder (#103441). */
-    p = drop_non_whitespace(p, end);
-    /* Skip whitespace to get to the next face corner. */
-    p = drop_whitespace(p, end);
   }
 
   if (face_valid) {
@@ -501,6 +535,151 @@ static void use_all_vertices_if_no_faces(Geometry *geom,
   }
 }
 
+/**
+ * A line that has to be handled in file order once the chunk it belongs to is merged, together
+ * with the number of vertices, UVs and normals the chunk had read before it.
+ */
+struct DeferredLine {
+  /* Line contents with leading whitespace removed; empty for faces. */
+  StringRef line;
+  /* Range into #ParsedChunk::face_corners, only used for faces. */
+  IndexRange face_corners;
+  bool is_face = false;
+  int vertices_num = 0;
+  int uv_vertices_num = 0;
+  int vert_normals_num = 0;
+};
+
+/**
+ * Result of tokenizing a newline-terminated part of the input, which happens in parallel with
+ * the other parts. Vertex data is stored chunk-local; everything that depends on parser state or
+ * on previously read vertices is deferred until the chunks are merged in order.
+ */
+struct ParsedChunk {
+  StringRef text;
+  GlobalVertices vertices;
+  Vector<FaceCornerTokens> face_corners;
+  Vector<DeferredLine> lines;
+  size_t line_count = 0;
+};
+
+/** Amount of chunk-local vertex data that has been appended to the global vertices so far. */
+struct ChunkMergeState {
+  int vertices_offset;
+  int vertices_num = 0;
+  int uv_vertices_num = 0;
+  int vert_normals_num = 0;
+  int color_block = 0;
+  int color_index = 0;
+};
+
+static void parse_chunk(ParsedChunk &chunk)
+{
+  StringRef buffer_str = chunk.text;
+  while (!buffer_str.is_empty()) {
+    StringRef line = read_next_line(buffer_str);
+    const char *p = line.begin(), *end = line.end();
+    p = drop_whitespace(p, end);
+    ++chunk.line_count;
+    if (p == end) {
+      continue;
+    }
+    /* Most common things that start with 'v': vertices, normals, UVs. */
+    if (*p == 'v') {
+      if (parse_keyword(p, end, "v")) {
+        geom_add_vertex(p, end, chunk.vertices);
+      }
+      else if (parse_keyword(p, end, "vn")) {
+        geom_add_vertex_normal(p, end, chunk.vertices);
+      }
+      else if (parse_keyword(p, end, "vt")) {
+        geom_add_uv_vertex(p, end, chunk.vertices);
+      }
+      continue;
+    }
+    /* Comments, except for the ones carrying vertex colors. */
+    if (*p == '#' && !StringRef(p, end).startswith("#MRGB")) {
+      continue;
+    }
+
+    DeferredLine deferred;
+    deferred.vertices_num = chunk.vertices.vertices.size();
+    deferred.uv_vertices_num = chunk.vertices.uv_vertices.size();
+    deferred.vert_normals_num = chunk.vertices.vert_normals.size();
+    if (parse_keyword(p, end, "f")) {
+      const int corners_start = chunk.face_corners.size();
+      parse_face_corners(p, end, chunk.face_corners);
+      deferred.face_corners = IndexRange(corners_start,
+                                         chunk.face_corners.size() - corners_start);
+      deferred.is_face = true;
+    }
+    else {
+      deferred.line = StringRef(p, end);
+    }
+    chunk.lines.append(deferred);
+  }
+}
+
+/**
+ * Append the chunk-local vertex data up to the given counts to the global vertices,
+ * so that they look exactly like they would when reading the file line by line.
+ */
+static void merge_chunk_vertices(const ParsedChunk &chunk,
+                                 const int vertices_num,
+                                 const int uv_vertices_num,
+                                 const int vert_normals_num,
+                                 ChunkMergeState &state,
+                                 GlobalVertices &r_global_vertices)
+{
+  const GlobalVertices &src = chunk.vertices;
+  r_global_vertices.vertices.extend(
+      src.vertices.as_span().slice(state.vertices_num, vertices_num - state.vertices_num));
+  r_global_vertices.uv_vertices.extend(src.uv_vertices.as_span().slice(
+      state.uv_vertices_num, uv_vertices_num - state.uv_vertices_num));
+  r_global_vertices.vert_normals.extend(src.vert_normals.as_span().slice(
+      state.vert_normals_num, vert_normals_num - state.vert_normals_num));
+  state.vertices_num = vertices_num;
+  state.uv_vertices_num = uv_vertices_num;
+  state.vert_normals_num = vert_normals_num;
+
+  /* Vertex color blocks are re-built per color, since a block can continue
+   * from the previous chunk and "#MRGB" lines can modify the latest block. */
+  while (state.color_block < src.vertex_colors.size()) {
+    const GlobalVertices::VertexColorsBlock &block = src.vertex_colors[state.color_block];
+    const int vertex_index = block.start_vertex_index + state.color_index;
+    if (vertex_index >= vertices_num) {
+      break;
+    }
+    add_vertex_color(state.vertices_offset + vertex_index,
+                     block.colors[state.color_index],
+                     r_global_vertices);
+    if (++state.color_index == block.colors.size()) {
+      state.color_block++;
+      state.color_index = 0;
+    }
+  }
+}
+
+/**
+ * Split the buffer into newline-terminated chunks of roughly the given size.
+ * The buffer must end with a newline.
+ */
+static void split_into_chunks(const StringRef buffer,
+                              const size_t chunk_size,
+                              Vector<ParsedChunk> &r_chunks)
+{
+  int64_t start = 0;
+  while (start < buffer.size()) {
+    const int64_t min_end = std::min<int64_t>(start + chunk_size, buffer.size());
+    int64_t chunk_end = buffer.find('\n', min_end - 1);
+    BLI_assert(chunk_end != StringRef::not_found);
+    chunk_end++;
+    r_chunks.append_as();
+    r_chunks.last().text = buffer.substr(start, chunk_end - start);
+    start = chunk_end;
+  }
+}
+
 void OBJParser::parse(Vector<std::unique_ptr<Geometry>> &r_all_geometries,
                       GlobalVertices &r_global_vertices)
 {
@@ -523,12 +702,158 @@ void OBJParser::parse(Vector<std::unique_ptr<Geometry>> &r_all_geometries,
   string state_material_name;
   int state_material_index = -1;
 
-  /* Read the input file in chunks. We need up to twice the possible chunk size,
-   * to possibly store remainder of the previous input line that got broken mid-chunk. */
+  auto add_polygon = [&](const Span<FaceCornerTokens> corner_tokens) {
+    /* If we don't have a material index assigned yet, get one.
+     * It means "usemtl" state came from the previous object. */
+    if (state_material_index == -1 && !state_material_name.empty() &&
+        curr_geom->material_indices_.is_empty())
+    {
+      curr_geom->material_indices_.add_new(state_material_name, 0);
+      curr_geom->material_order_.append(state_material_name);
+      state_material_index = 0;
+    }
+
+    geom_add_polygon(curr_geom,
+                     corner_tokens,
+                     r_global_vertices,
+                     state_material_index,
+                     state_group_index,
+                     state_shaded_smooth);
+  };
+
+  /* Handle a line that is not a vertex, normal, UV, face or regular comment. */
+  auto parse_deferred_line = [&](const char *p, const char *end) {
+    /* Faces. */
+    if (parse_keyword(p, end, "l")) {
+      geom_add_polyline(curr_geom, p, end, r_global_vertices);
+    }
+    /* Objects. */
+    else if (parse_keyword(p, end, "o")) {
+      if (import_params_.use_split_objects) {
+        geom_new_object(p,
+                        end,
+                        state_shaded_smooth,
+                        state_group_name,
+                        state_material_index,
+                        curr_geom,
+                        r_all_geometries);
+      }
+    }
+    /* Groups. */
+    else if (parse_keyword(p, end, "g")) {
+      if (import_params_.use_split_groups) {
+        geom_new_object(p,
+                        end,
+                        state_shaded_smooth,
+                        state_group_name,
+                        state_material_index,
+                        curr_geom,
+                        r_all_geometries);
+      }
+      else {
+        geom_update_group(StringRef(p, end).trim(), state_group_name);
+        int new_index = curr_geom->group_indices_.size();
+        state_group_index = curr_geom->group_indices_.lookup_or_add(state_group_name, new_index);
+        if (new_index == state_group_index) {
+          curr_geom->group_order_.append(state_group_name);
+        }
+      }
+    }
+    /* Smoothing groups. */
+    else if (parse_keyword(p, end, "s")) {
+      geom_update_smooth_group(p, end, state_shaded_smooth);
+    }
+    /* Materials and their libraries. */
+    else if (parse_keyword(p, end, "usemtl")) {
+      state_material_name = StringRef(p, end).trim();
+      int new_mat_index = curr_geom->material_indices_.size();
+      state_material_index = curr_geom->material_indices_.lookup_or_add(state_material_name,
+                                                                        new_mat_index);
+      if (new_mat_index == state_material_index) {
+        curr_geom->material_order_.append(state_material_name);
+      }
+    }
+    else if (parse_keyword(p, end, "mtllib")) {
+      add_mtl_library(StringRef(p, end).trim());
+    }
+    else if (parse_keyword(p, end, "#MRGB")) {
+      geom_add_mrgb_colors(p, end, r_global_vertices);
+    }
+    /* Comments. */
+    else if (*p == '#') {
+      /* Nothing to do. */
+    }
+    /* Curve related things. */
+    else if (parse_keyword(p, end, "cstype")) {
+      curr_geom = geom_set_curve_type(curr_geom, p, end, state_group_name, r_all_geometries);
+    }
+    else if (parse_keyword(p, end, "deg")) {
+      geom_set_curve_degree(curr_geom, p, end);
+    }
+    else if (parse_keyword(p, end, "curv")) {
+      geom_add_curve_vertex_indices(curr_geom, p, end, r_global_vertices);
+    }
+    else if (parse_keyword(p, end, "parm")) {
+      geom_add_curve_parameters(curr_geom, p, end);
+    }
+    else if (StringRef(p, end).startswith("end")) {
+      /* End of curve definition, nothing else to do. */
+    }
+    else {
+      std::cout << "OBJ element not recognized: '" << std::string(p, end) << "'" << std::endl;
+    }
+  };
+
+  /* The complete lines of several input blocks are gathered in a batch, which is tokenized in
+   * parallel chunks and then merged in file order. */
+  Vector<char> batch;
+  int batch_blocks_num = 0;
+  const int batch_blocks_max = BLI_system_thread_count();
+  size_t line_number = 0;
+  auto parse_batch = [&]() {
+    Vector<ParsedChunk> chunks;
+    split_into_chunks(StringRef(batch.data(), batch.size()), read_buffer_size_, chunks);
+    threading::parallel_for(chunks.index_range(), 1, [&](const IndexRange range) {
+      for (const int i : range) {
+        parse_chunk(chunks[i]);
+      }
+    });
+
+    for (const ParsedChunk &chunk : chunks) {
+      ChunkMergeState state;
+      state.vertices_offset = r_global_vertices.vertices.size();
+      for (const DeferredLine &deferred : chunk.lines) {
+        merge_chunk_vertices(chunk,
+                             deferred.vertices_num,
+                             deferred.uv_vertices_num,
+                             deferred.vert_normals_num,
+                             state,
+                             r_global_vertices);
+        if (deferred.is_face) {
+          add_polygon(chunk.face_corners.as_span().slice(deferred.face_corners));
+        }
+        else {
+          parse_deferred_line(deferred.line.begin(), deferred.line.end());
+        }
+      }
+      merge_chunk_vertices(chunk,
+                           chunk.vertices.vertices.size(),
+                           chunk.vertices.uv_vertices.size(),
+                           chunk.vertices.vert_normals.size(),
+                           state,
+                           r_global_vertices);
+      line_number += chunk.line_count;
+    }
+    batch.clear();
+    batch_blocks_num = 0;
+  };
+
+  /* Read the input file in blocks of #read_buffer_size_, which is also the maximum line length.
+   * We need up to twice the possible block size, to possibly store remainder of the previous
+   * input line that got broken mid-block. */
   Array<char> buffer(read_buffer_size_ * 2);
 
   size_t buffer_offset = 0;
-  size_t line_number = 0;
   while (true) {
     /* Read a chunk of input from the file. */
     size_t bytes_read = fread(buffer.data() + buffer_offset, 1, read_buffer_size_, obj_file_);
@@ -564,6 +889,7 @@ void OBJParser::parse(Vector<std::unique_ptr<Geometry>> &r_all_geometries,
     }
     if (buffer[last_nl] != '\n') {
       /* Whole line did not fit into our read buffer. Warn and exit. */
+      parse_batch();
       fprintf(stderr,
               "OBJ file contains a line #%zu that is too long (max. length %zu)\n",
               line_number,
@@ -572,128 +898,11 @@ void OBJParser::parse(Vector<std::unique_ptr<Geometry>> &r_all_geometries,
     }
     ++last_nl;
 
-    /* Parse the buffer (until last newline) that we have so far,
-     * line by line. */
-    StringRef buffer_str{buffer.data(), int64_t(last_nl)};
-    while (!buffer_str.is_empty()) {
-      StringRef line = read_next_line(buffer_str);
-      const char *p = line.begin(), *end = line.end();
-      p = drop_whitespace(p, end);
-      ++line_number;
-      if (p == end) {
-        continue;
-      }
-      /* Most common things that start with 'v': vertices, normals, UVs. */
-      if (*p == 'v') {
-        if (parse_keyword(p, end, "v")) {
-          geom_add_vertex(p, end, r_global_vertices);
-        }
-        else if (parse_keyword(p, end, "vn")) {
-          geom_add_vertex_normal(p, end, r_global_vertices);
-        }
-        else if (parse_keyword(p, end, "vt")) {
-          geom_add_uv_vertex(p, end, r_global_vertices);
-        }
-      }
-      /* Faces. */
-      else if (parse_keyword(p, end, "f")) {
-        /* If we don't have a material index assigned yet, get one.
-         * It means "usemtl" state came from the previous object. */
-        if (state_material_index == -1 && !state_material_name.empty() &&
-            curr_geom->material_indices_.is_empty())
-        {
-          curr_geom->material_indices_.add_new(state_material_name, 0);
-          curr_geom->material_order_.append(state_material_name);
-          state_material_index = 0;
-        }
-
-        geom_add_polygon(curr_geom,
-                         p,
-                         end,
-                         r_global_vertices,
-                         state_material_index,
-                         state_group_index,
-                         state_shaded_smooth);
-      }
-      /* Faces. */
-      else if (parse_keyword(p, end, "l")) {
-        geom_add_polyline(curr_geom, p, end, r_global_vertices);
-      }
-      /* Objects. */
-      else if (parse_keyword(p, end, "o")) {
-        if (import_params_.use_split_objects) {
-          geom_new_object(p,
-                          end,
-                          state_shaded_smooth,
-                          state_group_name,
-                          state_material_index,
-                          curr_geom,
-                          r_all_geometries);
-        }
-      }
-      /* Groups. */
-      else if (parse_keyword(p, end, "g")) {
-        if (import_params_.use_split_groups) {
-          geom_new_object(p,
-                          end,
-                          state_shaded_smooth,
-                          state_group_name,
-                          state_material_index,
-                          curr_geom,
-                          r_all_geometries);
-        }
-        else {
-          geom_update_group(StringRef(p, end).trim(), state_group_name);
-          int new_index = curr_geom->group_indices_.size();
-          state_group_index = curr_geom->group_indices_.lookup_or_add(state_group_name, new_index);
-          if (new_index == state_group_index) {
-            curr_geom->group_order_.append(state_group_name);
-          }
-        }
-      }
-      /* Smoothing groups. */
-      else if (parse_keyword(p, end, "s")) {
-        geom_update_smooth_group(p, end, state_shaded_smooth);
-      }
-      /* Materials and their libraries. */
-      else if (parse_keyword(p, end, "usemtl")) {
-        state_material_name = StringRef(p, end).trim();
-        int new_mat_index = curr_geom->material_indices_.size();
-        state_material_index = curr_geom->material_indices_.lookup_or_add(state_material_name,
-                                                                          new_mat_index);
-        if (new_mat_index == state_material_index) {
-          curr_geom->material_order_.append(state_material_name);
-        }
-      }
-      else if (parse_keyword(p, end, "mtllib")) {
-        add_mtl_library(StringRef(p, end).trim());
-      }
-      else if (parse_keyword(p, end, "#MRGB")) {
-        geom_add_mrgb_colors(p, end, r_global_vertices);
-      }
-      /* Comments. */
-      else if (*p == '#') {
-        /* Nothing to do. */
-      }
-      /* Curve related things. */
-      else if (parse_keyword(p, end, "cstype")) {
-        curr_geom = geom_set_curve_type(curr_geom, p, end, state_group_name, r_all_geometries);
-      }
-      else if (parse_keyword(p, end, "deg")) {
-        geom_set_curve_degree(curr_geom, p, end);
-      }
-      else if (parse_keyword(p, end, "curv")) {
-        geom_add_curve_vertex_indices(curr_geom, p, end, r_global_vertices);
-      }
-      else if (parse_keyword(p, end, "parm")) {
-        geom_add_curve_parameters(curr_geom, p, end);
-      }
-      else if (StringRef(p, end).startswith("end")) {
-        /* End of curve definition, nothing else to do. */
-      }
-      else {
-        std::cout << "OBJ element not recognized: '" << std::string(p, end) << "'" << std::endl;
-      }
+    /* Add the buffer (until last newline) that we have so far to the batch. */
+    batch.extend(Span<char>(buffer.data(), int64_t(last_nl)));
+    batch_blocks_num++;
+    if (batch_blocks_num >= batch_blocks_max) {
+      parse_batch();
     }
 
     /* We might have a line that was cut in the middle by the previous buffer;
@@ -702,6 +911,7 @@ void OBJParser::parse(Vector<std::unique_ptr<Geometry>> &r_all_geometries,
     memmove(buffer.data(), buffer.data() + last_nl, left_size);
     buffer_offset = left_size;
   }
+  parse_batch();
 
   use_all_vertices_if_no_faces(curr_geom, r_all_geometries, r_global_vertices);
   add_default_mtl_library();
@@ -36,8 +36,12 @@ class OBJParser {
   ~OBJParser();
 
   /**
-   * Read the OBJ file line by line and create OBJ Geometry instances. Also store all the vertex
+   * Read the OBJ file and create OBJ Geometry instances. Also store all the vertex
    * and UV vertex coordinates in a struct accessible by all objects.
+   *
+   * The file is read in blocks that are split at line boundaries and tokenized on multiple
+   * threads; the results are then merged in file order, giving the same result as reading
+   * the file line by line.
    */
   void parse(Vector<std::unique_ptr<Geometry>> &r_all_geometries,
              GlobalVertices &r_global_vertices);
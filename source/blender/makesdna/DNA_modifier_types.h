@@ -2406,7 +2406,9 @@ typedef struct NodesModifierBake {
   uint32_t flag;
   /** #NodesModifierBakeMode. */
   uint8_t bake_mode;
-  char _pad[7];
+  /** #NodesModifierBakeCompression. */
+  uint8_t compression;
+  char _pad[6];
   /**
    * Directory where the baked data should be stored. This is only used when
    * `NODES_MODIFIER_BAKE_CUSTOM_PATH` is set.
@@ -2452,6 +2454,11 @@ typedef enum NodesModifierBakeMode {
   NODES_MODIFIER_BAKE_MODE_STILL = 1,
 } NodesModifierBakeMode;
 
+typedef enum NodesModifierBakeCompression {
+  NODES_MODIFIER_BAKE_COMPRESSION_NONE = 0,
+  NODES_MODIFIER_BAKE_COMPRESSION_ZSTD = 1,
+} NodesModifierBakeCompression;
+
 typedef struct NodesModifierData {
   ModifierData modifier;
   struct bNodeTree *node_group;
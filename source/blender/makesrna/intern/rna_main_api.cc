@@ -807,6 +807,12 @@ static Volume *rna_Main_volumes_new(Main *bmain, const char *name)
   return volume;
 }
 
+static PointerRNA rna_Main_volumes_file_cache_get(PointerRNA *ptr)
+{
+  /* The cache is global, the pointer to main is only used so that the pointer is not null. */
+  return RNA_pointer_create(nullptr, &RNA_VolumeFileCache, ptr->data);
+}
+
 /* tag functions, all the same */
 #  define RNA_MAIN_ID_TAG_FUNCS_DEF(_func_name, _listbase_name, _id_type) \
     static void rna_Main_##_func_name##_tag(Main *bmain, bool value) \
@@ -2408,12 +2414,21 @@ void RNA_def_main_volumes(BlenderRNA *brna, PropertyRNA *cprop)
   StructRNA *srna;
   FunctionRNA *func;
   PropertyRNA *parm;
+  PropertyRNA *prop;
 
   RNA_def_property_srna(cprop, "BlendDataVolumes");
   srna = RNA_def_struct(brna, "BlendDataVolumes", nullptr);
   RNA_def_struct_sdna(srna, "Main");
   RNA_def_struct_ui_text(srna, "Main Volumes", "Collection of volumes");
 
+  prop = RNA_def_property(srna, "file_cache", PROP_POINTER, PROP_NONE);
+  RNA_def_property_struct_type(prop, "VolumeFileCache");
+  RNA_def_property_flag(prop, PROP_NEVER_NULL);
+  RNA_def_property_pointer_funcs(
+      prop, "rna_Main_volumes_file_cache_get", nullptr, nullptr, nullptr);
+  RNA_def_property_ui_text(
+      prop, "File Cache", "Cache of grids loaded from OpenVDB files, shared by all volumes");
+
   func = RNA_def_function(srna, "new", "rna_Main_volumes_new");
   RNA_def_function_ui_description(func, "Add a new volume to the main database");
   parm = RNA_def_string(func, "name", "Volume", 0, "", "New name for the data-block");
@@ -7741,6 +7741,20 @@ static void rna_def_modifier_nodes_bake(BlenderRNA *brna)
       {0, nullptr, 0, nullptr, nullptr},
   };
 
+  static EnumPropertyItem compression_items[] = {
+      {NODES_MODIFIER_BAKE_COMPRESSION_NONE,
+       "NONE",
+       0,
+       "None",
+       "Store data uncompressed, which allows loading it without copying"},
+      {NODES_MODIFIER_BAKE_COMPRESSION_ZSTD,
+       "ZSTD",
+       0,
+       "Zstandard",
+       "Compress data with Zstandard, which is slower to bake but uses less disk space"},
+      {0, nullptr, 0, nullptr, nullptr},
+  };
+
   StructRNA *srna;
   PropertyRNA *prop;
 
@@ -7779,6 +7793,11 @@ static void rna_def_modifier_nodes_bake(BlenderRNA *brna)
   RNA_def_property_ui_text(prop, "Bake Mode", "");
   RNA_def_property_update(prop, 0, "rna_Modifier_update");
 
+  prop = RNA_def_property(srna, "compression", PROP_ENUM, PROP_NONE);
+  RNA_def_property_enum_items(prop, compression_items);
+  RNA_def_property_ui_text(prop, "Compression", "How the baked data is stored on disk");
+  RNA_def_property_update(prop, 0, "rna_Modifier_update");
+
   prop = RNA_def_property(srna, "bake_id", PROP_INT, PROP_NONE);
   RNA_def_property_ui_text(prop,
                            "Bake ID",
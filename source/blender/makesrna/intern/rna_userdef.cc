@@ -7242,6 +7242,26 @@ static void rna_def_userdef_experimental(BlenderRNA *brna)
       "Forces all linked data to be considered as directly linked. Workaround for current "
       "issues/limitations in BAT (Blender studio pipeline tool)");
 
+  prop = RNA_def_property(srna, "use_blend_file_mmap_sharing", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_ui_text(
+      prop,
+      "Memory-Mapped Blend Data",
+      "Reference large geometry arrays directly in the memory-mapped file when loading "
+      "uncompressed blend-files, instead of copying them (not supported on Windows)");
+
+  prop = RNA_def_property(srna, "use_lazy_linked_data", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_ui_text(
+      prop,
+      "Lazy Linked Data",
+      "Only load the geometry of linked data-blocks from uncompressed library files when it is "
+      "first used, by referencing it in the memory-mapped file (not supported on Windows)");
+
+  prop = RNA_def_property(srna, "use_incremental_autosave", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_ui_text(prop,
+                           "Incremental Auto Save",
+                           "Only write the data that changed since the previous auto-save. "
+                           "Such auto-save files cannot be opened by older Blender versions");
+
   prop = RNA_def_property(srna, "use_new_volume_nodes", PROP_BOOLEAN, PROP_NONE);
   RNA_def_property_ui_text(
       prop, "New Volume Nodes", "Enables visibility of the new Volume nodes in the UI");
@@ -6,6 +6,8 @@
  * \ingroup RNA
  */
 
+#include <algorithm>
+#include <climits>
 #include <cstdlib>
 
 #include "RNA_access.hh"
@@ -18,6 +20,7 @@
 #include "DNA_volume_types.h"
 
 #include "BKE_volume.hh"
+#include "BKE_volume_grid_file_cache.hh"
 
 #include "BLI_math_base.h"
 #include "BLI_string_utf8_symbols.h"
@@ -256,6 +259,71 @@ static bool rna_Volume_save(Volume *volume, Main *bmain, ReportList *reports, co
   return BKE_volume_save(volume, bmain, reports, filepath);
 }
 
+/* File Cache */
+
+static int rna_VolumeFileCache_int_from_int64(const int64_t value)
+{
+  return int(std::min<int64_t>(value, INT_MAX));
+}
+
+static int rna_VolumeFileCache_memory_budget_get(PointerRNA * /*ptr*/)
+{
+  return rna_VolumeFileCache_int_from_int64(BKE_volumes_file_cache_stats_get().memory_budget /
+                                            (1024 * 1024));
+}
+
+static void rna_VolumeFileCache_memory_budget_set(PointerRNA * /*ptr*/, const int value)
+{
+  BKE_volumes_file_cache_memory_budget_set(int64_t(value) * 1024 * 1024);
+}
+
+static bool rna_VolumeFileCache_use_delay_load_get(PointerRNA * /*ptr*/)
+{
+  return BKE_volumes_file_cache_delay_load_get();
+}
+
+static void rna_VolumeFileCache_use_delay_load_set(PointerRNA * /*ptr*/, const bool value)
+{
+  BKE_volumes_file_cache_delay_load_set(value);
+}
+
+static int rna_VolumeFileCache_memory_usage_get(PointerRNA * /*ptr*/)
+{
+  return rna_VolumeFileCache_int_from_int64(BKE_volumes_file_cache_stats_get().memory_usage /
+                                            (1024 * 1024));
+}
+
+static int rna_VolumeFileCache_cached_grids_get(PointerRNA * /*ptr*/)
+{
+  return rna_VolumeFileCache_int_from_int64(BKE_volumes_file_cache_stats_get().cached_grids_num);
+}
+
+static int rna_VolumeFileCache_loaded_grids_get(PointerRNA * /*ptr*/)
+{
+  return rna_VolumeFileCache_int_from_int64(BKE_volumes_file_cache_stats_get().loaded_grids_num);
+}
+
+static int rna_VolumeFileCache_hits_get(PointerRNA * /*ptr*/)
+{
+  return rna_VolumeFileCache_int_from_int64(BKE_volumes_file_cache_stats_get().hits_num);
+}
+
+static int rna_VolumeFileCache_misses_get(PointerRNA * /*ptr*/)
+{
+  return rna_VolumeFileCache_int_from_int64(BKE_volumes_file_cache_stats_get().misses_num);
+}
+
+static int rna_VolumeFileCache_evicted_grids_get(PointerRNA * /*ptr*/)
+{
+  return rna_VolumeFileCache_int_from_int64(BKE_volumes_file_cache_stats_get().evicted_grids_num);
+}
+
+static int rna_VolumeFileCache_prefetched_files_get(PointerRNA * /*ptr*/)
+{
+  return rna_VolumeFileCache_int_from_int64(
+      BKE_volumes_file_cache_stats_get().prefetched_files_num);
+}
+
 #else
 
 static void rna_def_volume_grid(BlenderRNA *brna)
@@ -723,8 +791,84 @@ static void rna_def_volume(BlenderRNA *brna)
   rna_def_animdata_common(srna);
 }
 
+static void rna_def_volume_file_cache(BlenderRNA *brna)
+{
+  StructRNA *srna;
+  PropertyRNA *prop;
+
+  srna = RNA_def_struct(brna, "VolumeFileCache", nullptr);
+  RNA_def_struct_ui_text(srna,
+                         "Volume File Cache",
+                         "Grids loaded from OpenVDB files, shared by all volumes. The statistics "
+                         "are zero when Blender is built without OpenVDB");
+
+  prop = RNA_def_property(srna, "memory_budget", PROP_INT, PROP_NONE);
+  RNA_def_property_int_funcs(prop,
+                             "rna_VolumeFileCache_memory_budget_get",
+                             "rna_VolumeFileCache_memory_budget_set",
+                             nullptr);
+  RNA_def_property_range(prop, 0, INT_MAX);
+  RNA_def_property_ui_text(prop,
+                           "Memory Budget",
+                           "Memory in megabytes that may be used by loaded grids before unused "
+                           "grids are freed, least recently used first (0 for no limit)");
+
+  prop = RNA_def_property(srna, "use_delay_load", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_boolean_funcs(prop,
+                                 "rna_VolumeFileCache_use_delay_load_get",
+                                 "rna_VolumeFileCache_use_delay_load_set");
+  RNA_def_property_ui_text(prop,
+                           "Delay Load",
+                           "Only read voxels from files when they are accessed, for grids that "
+                           "are loaded afterwards. This can be slow on network drives");
+
+  prop = RNA_def_property(srna, "memory_usage", PROP_INT, PROP_NONE);
+  RNA_def_property_int_funcs(prop, "rna_VolumeFileCache_memory_usage_get", nullptr, nullptr);
+  RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+  RNA_def_property_ui_text(
+      prop, "Memory Usage", "Memory in megabytes used by loaded grids, including grids in use");
+
+  prop = RNA_def_property(srna, "cached_grids", PROP_INT, PROP_NONE);
+  RNA_def_property_int_funcs(prop, "rna_VolumeFileCache_cached_grids_get", nullptr, nullptr);
+  RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+  RNA_def_property_ui_text(prop, "Cached Grids", "Number of grids in the cache");
+
+  prop = RNA_def_property(srna, "loaded_grids", PROP_INT, PROP_NONE);
+  RNA_def_property_int_funcs(prop, "rna_VolumeFileCache_loaded_grids_get", nullptr, nullptr);
+  RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+  RNA_def_property_ui_text(
+      prop, "Loaded Grids", "Number of grids in the cache whose voxels have been loaded");
+
+  prop = RNA_def_property(srna, "hits", PROP_INT, PROP_NONE);
+  RNA_def_property_int_funcs(prop, "rna_VolumeFileCache_hits_get", nullptr, nullptr);
+  RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+  RNA_def_property_ui_text(prop, "Hits", "Number of requested grids that were cached already");
+
+  prop = RNA_def_property(srna, "misses", PROP_INT, PROP_NONE);
+  RNA_def_property_int_funcs(prop, "rna_VolumeFileCache_misses_get", nullptr, nullptr);
+  RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+  RNA_def_property_ui_text(
+      prop, "Misses", "Number of requested grids that had to be added to the cache");
+
+  prop = RNA_def_property(srna, "evicted_grids", PROP_INT, PROP_NONE);
+  RNA_def_property_int_funcs(prop, "rna_VolumeFileCache_evicted_grids_get", nullptr, nullptr);
+  RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+  RNA_def_property_ui_text(prop,
+                           "Evicted Grids",
+                           "Number of grids that have been freed to stay within the memory budget");
+
+  prop = RNA_def_property(srna, "prefetched_files", PROP_INT, PROP_NONE);
+  RNA_def_property_int_funcs(prop, "rna_VolumeFileCache_prefetched_files_get", nullptr, nullptr);
+  RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+  RNA_def_property_ui_text(prop,
+                           "Prefetched Files",
+                           "Number of files of volume sequences that have been loaded in the "
+                           "background");
+}
+
 void RNA_def_volume(BlenderRNA *brna)
 {
+  rna_def_volume_file_cache(brna);
   rna_def_volume_grid(brna);
   rna_def_volume_display(brna);
   rna_def_volume_render(brna);
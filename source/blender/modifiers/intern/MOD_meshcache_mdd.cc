@@ -7,20 +7,15 @@
  */
 
 #include <algorithm>
-#include <cerrno>
-#include <cstdio>
-#include <cstring>
 
 #include "BLI_utildefines.h"
 
-#include "BLI_fileops.h"
+#include "BLI_array.hh"
 #include "BLI_math_base.h"
 #ifdef __LITTLE_ENDIAN__
 #  include "BLI_endian_switch.h"
 #endif
-#ifdef WIN32
-#  include "BLI_winstuff.h"
-#endif
+#include "BLI_mmap.h"
 
 #include "BLT_translation.hh"
 
@@ -33,12 +28,12 @@ struct MDDHead {
   int verts_tot;
 }; /* frames, verts */
 
-static bool meshcache_read_mdd_head(FILE *fp,
+static bool meshcache_read_mdd_head(BLI_mmap_file *file,
                                     const int verts_tot,
                                     MDDHead *mdd_head,
                                     const char **err_str)
 {
-  if (!fread(mdd_head, sizeof(*mdd_head), 1, fp)) {
+  if (!BLI_mmap_read(file, mdd_head, 0, sizeof(*mdd_head))) {
     *err_str = RPT_("Missing header");
     return false;
   }
@@ -56,15 +51,13 @@ static bool meshcache_read_mdd_head(FILE *fp,
     *err_str = RPT_("Invalid frame total");
     return false;
   }
-  /* Intentionally don't seek back. */
-
   return true;
 }
 
 /**
  * Gets the index range and factor.
  */
-static bool meshcache_read_mdd_range(FILE *fp,
+static bool meshcache_read_mdd_range(BLI_mmap_file *file,
                                      const int verts_tot,
                                      const float frame,
                                      const char interp,
@@ -76,7 +69,7 @@ static bool meshcache_read_mdd_range(FILE *fp,
 
   /* first check interpolation and get the vert locations */
 
-  if (meshcache_read_mdd_head(fp, verts_tot, &mdd_head, err_str) == false) {
+  if (meshcache_read_mdd_head(file, verts_tot, &mdd_head, err_str) == false) {
     return false;
   }
 
@@ -85,7 +78,7 @@ static bool meshcache_read_mdd_range(FILE *fp,
   return true;
 }
 
-static bool meshcache_read_mdd_range_from_time(FILE *fp,
+static bool meshcache_read_mdd_range_from_time(BLI_mmap_file *file,
                                                const int verts_tot,
                                                const float time,
                                                const float /*fps*/,
@@ -97,30 +90,29 @@ static bool meshcache_read_mdd_range_from_time(FILE *fp,
   float f_time, f_time_prev = FLT_MAX;
   float frame;
 
-  if (meshcache_read_mdd_head(fp, verts_tot, &mdd_head, err_str) == false) {
+  if (meshcache_read_mdd_head(file, verts_tot, &mdd_head, err_str) == false) {
     return false;
   }
 
-  size_t frames_num_read = 0;
-  size_t frames_num_expect = mdd_head.frame_tot;
-  errno = 0;
-  for (i = 0; i < mdd_head.frame_tot; i++) {
-    frames_num_read += fread(&f_time, sizeof(float), 1, fp);
+  blender::Array<float> frame_times(mdd_head.frame_tot);
+  if (!BLI_mmap_read(
+          file, frame_times.data(), sizeof(mdd_head), sizeof(float) * frame_times.size()))
+  {
+    *err_str = RPT_("Timestamp read failed");
+    return false;
+  }
 #ifdef __LITTLE_ENDIAN__
-    BLI_endian_switch_float(&f_time);
+  BLI_endian_switch_float_array(frame_times.data(), frame_times.size());
 #endif
+
+  for (i = 0; i < mdd_head.frame_tot; i++) {
+    f_time = frame_times[i];
     if (f_time >= time) {
-      frames_num_expect = i + 1;
       break;
     }
     f_time_prev = f_time;
   }
 
-  if (frames_num_read != frames_num_expect) {
-    *err_str = errno ? strerror(errno) : RPT_("Timestamp read failed");
-    return false;
-  }
-
   if (UNLIKELY(f_time_prev == FLT_MAX)) {
     frame = 0.0f;
   }
@@ -139,7 +131,7 @@ static bool meshcache_read_mdd_range_from_time(FILE *fp,
   return true;
 }
 
-bool MOD_meshcache_read_mdd_index(FILE *fp,
+bool MOD_meshcache_read_mdd_index(BLI_mmap_file *file,
                                   float (*vertexCos)[3],
                                   const int verts_tot,
                                   const int index,
@@ -148,75 +140,23 @@ bool MOD_meshcache_read_mdd_index(FILE *fp,
 {
   MDDHead mdd_head;
 
-  if (meshcache_read_mdd_head(fp, verts_tot, &mdd_head, err_str) == false) {
-    return false;
-  }
-
-  if (BLI_fseek(fp, mdd_head.frame_tot * sizeof(int), SEEK_CUR) != 0) {
-    *err_str = RPT_("Header seek failed");
+  if (meshcache_read_mdd_head(file, verts_tot, &mdd_head, err_str) == false) {
     return false;
   }
 
-  if (BLI_fseek(fp, sizeof(float[3]) * index * mdd_head.verts_tot, SEEK_CUR) != 0) {
-    *err_str = RPT_("Failed to seek frame");
-    return false;
-  }
-
-  size_t verts_read_num = 0;
-  errno = 0;
-  if (factor >= 1.0f) {
-#if 1
-    float *vco = *vertexCos;
-    uint i;
-    for (i = mdd_head.verts_tot; i != 0; i--, vco += 3) {
-      verts_read_num += fread(vco, sizeof(float[3]), 1, fp);
-
-#  ifdef __LITTLE_ENDIAN__
-      BLI_endian_switch_float(vco + 0);
-      BLI_endian_switch_float(vco + 1);
-      BLI_endian_switch_float(vco + 2);
-#  endif /* __LITTLE_ENDIAN__ */
-    }
-#else
-    /* no blending */
-    if (!fread(vertexCos, sizeof(float[3]), mdd_head.verts_tot, f)) {
-      *err_str = errno ? strerror(errno) : RPT_("Failed to read frame");
-      return false;
-    }
-#  ifdef __LITTLE_ENDIAN__
-    BLI_endian_switch_float_array(vertexCos[0], mdd_head.verts_tot * 3);
-#  endif
-#endif
-  }
-  else {
-    const float ifactor = 1.0f - factor;
-    float *vco = *vertexCos;
-    uint i;
-    for (i = mdd_head.verts_tot; i != 0; i--, vco += 3) {
-      float tvec[3];
-      verts_read_num += fread(tvec, sizeof(float[3]), 1, fp);
-
+  /* Skip the header and the time of every frame. */
+  const size_t offset = sizeof(mdd_head) + sizeof(float) * size_t(mdd_head.frame_tot) +
+                        sizeof(float[3]) * size_t(index) * mdd_head.verts_tot;
 #ifdef __LITTLE_ENDIAN__
-      BLI_endian_switch_float(tvec + 0);
-      BLI_endian_switch_float(tvec + 1);
-      BLI_endian_switch_float(tvec + 2);
+  const bool swap_endian = true;
+#else
+  const bool swap_endian = false;
 #endif
-
-      vco[0] = (vco[0] * ifactor) + (tvec[0] * factor);
-      vco[1] = (vco[1] * ifactor) + (tvec[1] * factor);
-      vco[2] = (vco[2] * ifactor) + (tvec[2] * factor);
-    }
-  }
-
-  if (verts_read_num != mdd_head.verts_tot) {
-    *err_str = errno ? strerror(errno) : RPT_("Vertex coordinate read failed");
-    return false;
-  }
-
-  return true;
+  return MOD_meshcache_read_coords(
+      file, offset, vertexCos, mdd_head.verts_tot, factor, swap_endian, err_str);
 }
 
-bool MOD_meshcache_read_mdd_frame(FILE *fp,
+bool MOD_meshcache_read_mdd_frame(BLI_mmap_file *file,
                                   float (*vertexCos)[3],
                                   const int verts_tot,
                                   const char interp,
@@ -226,7 +166,7 @@ bool MOD_meshcache_read_mdd_frame(FILE *fp,
   int index_range[2];
   float factor;
 
-  if (meshcache_read_mdd_range(fp,
+  if (meshcache_read_mdd_range(file,
                                verts_tot,
                                frame,
                                interp,
@@ -239,20 +179,12 @@ bool MOD_meshcache_read_mdd_frame(FILE *fp,
 
   if (index_range[0] == index_range[1]) {
     /* read single */
-    if ((BLI_fseek(fp, 0, SEEK_SET) == 0) &&
-        MOD_meshcache_read_mdd_index(fp, vertexCos, verts_tot, index_range[0], 1.0f, err_str))
-    {
-      return true;
-    }
-
-    return false;
+    return MOD_meshcache_read_mdd_index(file, vertexCos, verts_tot, index_range[0], 1.0f, err_str);
   }
 
   /* read both and interpolate */
-  if ((BLI_fseek(fp, 0, SEEK_SET) == 0) &&
-      MOD_meshcache_read_mdd_index(fp, vertexCos, verts_tot, index_range[0], 1.0f, err_str) &&
-      (BLI_fseek(fp, 0, SEEK_SET) == 0) &&
-      MOD_meshcache_read_mdd_index(fp, vertexCos, verts_tot, index_range[1], factor, err_str))
+  if (MOD_meshcache_read_mdd_index(file, vertexCos, verts_tot, index_range[0], 1.0f, err_str) &&
+      MOD_meshcache_read_mdd_index(file, vertexCos, verts_tot, index_range[1], factor, err_str))
   {
     return true;
   }
@@ -271,11 +203,10 @@ bool MOD_meshcache_read_mdd_times(const char *filepath,
 {
   float frame;
 
-  FILE *fp = BLI_fopen(filepath, "rb");
+  BLI_mmap_file *file = MOD_meshcache_file_open(filepath, err_str);
   bool ok;
 
-  if (fp == nullptr) {
-    *err_str = errno ? strerror(errno) : RPT_("Unknown error opening file");
+  if (file == nullptr) {
     return false;
   }
 
@@ -286,29 +217,29 @@ bool MOD_meshcache_read_mdd_times(const char *filepath,
     }
     case MOD_MESHCACHE_TIME_SECONDS: {
       /* we need to find the closest time */
-      if (meshcache_read_mdd_range_from_time(fp, verts_tot, time, fps, &frame, err_str) == false) {
-        fclose(fp);
+      if (meshcache_read_mdd_range_from_time(file, verts_tot, time, fps, &frame, err_str) ==
+          false)
+      {
+        MOD_meshcache_file_close(file);
         return false;
       }
-      rewind(fp);
       break;
     }
     case MOD_MESHCACHE_TIME_FACTOR:
     default: {
       MDDHead mdd_head;
-      if (meshcache_read_mdd_head(fp, verts_tot, &mdd_head, err_str) == false) {
-        fclose(fp);
+      if (meshcache_read_mdd_head(file, verts_tot, &mdd_head, err_str) == false) {
+        MOD_meshcache_file_close(file);
         return false;
       }
 
       frame = std::clamp(time, 0.0f, 1.0f) * float(mdd_head.frame_tot);
-      rewind(fp);
       break;
     }
   }
 
-  ok = MOD_meshcache_read_mdd_frame(fp, vertexCos, verts_tot, interp, frame, err_str);
+  ok = MOD_meshcache_read_mdd_frame(file, vertexCos, verts_tot, interp, frame, err_str);
 
-  fclose(fp);
+  MOD_meshcache_file_close(file);
   return ok;
 }
@@ -7,20 +7,13 @@
  */
 
 #include <algorithm>
-#include <cerrno>
-#include <cstdio>
-#include <cstring>
 
 #include "BLI_utildefines.h"
 
-#include "BLI_fileops.h"
 #ifdef __BIG_ENDIAN__
 #  include "BLI_endian_switch.h"
 #endif
-
-#ifdef WIN32
-#  include "BLI_winstuff.h"
-#endif
+#include "BLI_mmap.h"
 
 #include "BLT_translation.hh"
 
@@ -37,12 +30,12 @@ struct PC2Head {
   int frame_tot;
 }; /* frames, verts */
 
-static bool meshcache_read_pc2_head(FILE *fp,
+static bool meshcache_read_pc2_head(BLI_mmap_file *file,
                                     const int verts_tot,
                                     PC2Head *pc2_head,
                                     const char **err_str)
 {
-  if (!fread(pc2_head, sizeof(*pc2_head), 1, fp)) {
+  if (!BLI_mmap_read(file, pc2_head, 0, sizeof(*pc2_head))) {
     *err_str = RPT_("Missing header");
     return false;
   }
@@ -66,8 +59,6 @@ static bool meshcache_read_pc2_head(FILE *fp,
     *err_str = RPT_("Invalid frame total");
     return false;
   }
-  /* Intentionally don't seek back. */
-
   return true;
 }
 
@@ -76,7 +67,7 @@ static bool meshcache_read_pc2_head(FILE *fp,
  *
  * currently same as for MDD
  */
-static bool meshcache_read_pc2_range(FILE *fp,
+static bool meshcache_read_pc2_range(BLI_mmap_file *file,
                                      const int verts_tot,
                                      const float frame,
                                      const char interp,
@@ -88,7 +79,7 @@ static bool meshcache_read_pc2_range(FILE *fp,
 
   /* first check interpolation and get the vert locations */
 
-  if (meshcache_read_pc2_head(fp, verts_tot, &pc2_head, err_str) == false) {
+  if (meshcache_read_pc2_head(file, verts_tot, &pc2_head, err_str) == false) {
     return false;
   }
 
@@ -97,7 +88,7 @@ static bool meshcache_read_pc2_range(FILE *fp,
   return true;
 }
 
-static bool meshcache_read_pc2_range_from_time(FILE *fp,
+static bool meshcache_read_pc2_range_from_time(BLI_mmap_file *file,
                                                const int verts_tot,
                                                const float time,
                                                const float fps,
@@ -107,7 +98,7 @@ static bool meshcache_read_pc2_range_from_time(FILE *fp,
   PC2Head pc2_head;
   float frame;
 
-  if (meshcache_read_pc2_head(fp, verts_tot, &pc2_head, err_str) == false) {
+  if (meshcache_read_pc2_head(file, verts_tot, &pc2_head, err_str) == false) {
     return false;
   }
 
@@ -124,7 +115,7 @@ static bool meshcache_read_pc2_range_from_time(FILE *fp,
   return true;
 }
 
-bool MOD_meshcache_read_pc2_index(FILE *fp,
+bool MOD_meshcache_read_pc2_index(BLI_mmap_file *file,
                                   float (*vertexCos)[3],
                                   const int verts_tot,
                                   const int index,
@@ -133,59 +124,21 @@ bool MOD_meshcache_read_pc2_index(FILE *fp,
 {
   PC2Head pc2_head;
 
-  if (meshcache_read_pc2_head(fp, verts_tot, &pc2_head, err_str) == false) {
-    return false;
-  }
-
-  if (BLI_fseek(fp, sizeof(float[3]) * index * pc2_head.verts_tot, SEEK_CUR) != 0) {
-    *err_str = RPT_("Failed to seek frame");
+  if (meshcache_read_pc2_head(file, verts_tot, &pc2_head, err_str) == false) {
     return false;
   }
 
-  size_t verts_read_num = 0;
-  errno = 0;
-  if (factor >= 1.0f) {
-    float *vco = *vertexCos;
-    uint i;
-    for (i = pc2_head.verts_tot; i != 0; i--, vco += 3) {
-      verts_read_num += fread(vco, sizeof(float[3]), 1, fp);
-
-#ifdef __BIG_ENDIAN__
-      BLI_endian_switch_float(vco + 0);
-      BLI_endian_switch_float(vco + 1);
-      BLI_endian_switch_float(vco + 2);
-#endif /* __BIG_ENDIAN__ */
-    }
-  }
-  else {
-    const float ifactor = 1.0f - factor;
-    float *vco = *vertexCos;
-    uint i;
-    for (i = pc2_head.verts_tot; i != 0; i--, vco += 3) {
-      float tvec[3];
-      verts_read_num += fread(tvec, sizeof(float[3]), 1, fp);
-
+  const size_t offset = sizeof(pc2_head) + sizeof(float[3]) * size_t(index) * pc2_head.verts_tot;
 #ifdef __BIG_ENDIAN__
-      BLI_endian_switch_float(tvec + 0);
-      BLI_endian_switch_float(tvec + 1);
-      BLI_endian_switch_float(tvec + 2);
-#endif /* __BIG_ENDIAN__ */
-
-      vco[0] = (vco[0] * ifactor) + (tvec[0] * factor);
-      vco[1] = (vco[1] * ifactor) + (tvec[1] * factor);
-      vco[2] = (vco[2] * ifactor) + (tvec[2] * factor);
-    }
-  }
-
-  if (verts_read_num != pc2_head.verts_tot) {
-    *err_str = errno ? strerror(errno) : RPT_("Vertex coordinate read failed");
-    return false;
-  }
-
-  return true;
+  const bool swap_endian = true;
+#else
+  const bool swap_endian = false;
+#endif
+  return MOD_meshcache_read_coords(
+      file, offset, vertexCos, pc2_head.verts_tot, factor, swap_endian, err_str);
 }
 
-bool MOD_meshcache_read_pc2_frame(FILE *fp,
+bool MOD_meshcache_read_pc2_frame(BLI_mmap_file *file,
                                   float (*vertexCos)[3],
                                   const int verts_tot,
                                   const char interp,
@@ -195,7 +148,7 @@ bool MOD_meshcache_read_pc2_frame(FILE *fp,
   int index_range[2];
   float factor;
 
-  if (meshcache_read_pc2_range(fp,
+  if (meshcache_read_pc2_range(file,
                                verts_tot,
                                frame,
                                interp,
@@ -208,20 +161,12 @@ bool MOD_meshcache_read_pc2_frame(FILE *fp,
 
   if (index_range[0] == index_range[1]) {
     /* read single */
-    if ((BLI_fseek(fp, 0, SEEK_SET) == 0) &&
-        MOD_meshcache_read_pc2_index(fp, vertexCos, verts_tot, index_range[0], 1.0f, err_str))
-    {
-      return true;
-    }
-
-    return false;
+    return MOD_meshcache_read_pc2_index(file, vertexCos, verts_tot, index_range[0], 1.0f, err_str);
   }
 
   /* read both and interpolate */
-  if ((BLI_fseek(fp, 0, SEEK_SET) == 0) &&
-      MOD_meshcache_read_pc2_index(fp, vertexCos, verts_tot, index_range[0], 1.0f, err_str) &&
-      (BLI_fseek(fp, 0, SEEK_SET) == 0) &&
-      MOD_meshcache_read_pc2_index(fp, vertexCos, verts_tot, index_range[1], factor, err_str))
+  if (MOD_meshcache_read_pc2_index(file, vertexCos, verts_tot, index_range[0], 1.0f, err_str) &&
+      MOD_meshcache_read_pc2_index(file, vertexCos, verts_tot, index_range[1], factor, err_str))
   {
     return true;
   }
@@ -240,11 +185,10 @@ bool MOD_meshcache_read_pc2_times(const char *filepath,
 {
   float frame;
 
-  FILE *fp = BLI_fopen(filepath, "rb");
+  BLI_mmap_file *file = MOD_meshcache_file_open(filepath, err_str);
   bool ok;
 
-  if (fp == nullptr) {
-    *err_str = errno ? strerror(errno) : RPT_("Unknown error opening file");
+  if (file == nullptr) {
     return false;
   }
 
@@ -255,29 +199,29 @@ bool MOD_meshcache_read_pc2_times(const char *filepath,
     }
     case MOD_MESHCACHE_TIME_SECONDS: {
       /* we need to find the closest time */
-      if (meshcache_read_pc2_range_from_time(fp, verts_tot, time, fps, &frame, err_str) == false) {
-        fclose(fp);
+      if (meshcache_read_pc2_range_from_time(file, verts_tot, time, fps, &frame, err_str) ==
+          false)
+      {
+        MOD_meshcache_file_close(file);
         return false;
       }
-      rewind(fp);
       break;
     }
     case MOD_MESHCACHE_TIME_FACTOR:
     default: {
       PC2Head pc2_head;
-      if (meshcache_read_pc2_head(fp, verts_tot, &pc2_head, err_str) == false) {
-        fclose(fp);
+      if (meshcache_read_pc2_head(file, verts_tot, &pc2_head, err_str) == false) {
+        MOD_meshcache_file_close(file);
         return false;
       }
 
       frame = std::clamp(time, 0.0f, 1.0f) * float(pc2_head.frame_tot);
-      rewind(fp);
       break;
     }
   }
 
-  ok = MOD_meshcache_read_pc2_frame(fp, vertexCos, verts_tot, interp, frame, err_str);
+  ok = MOD_meshcache_read_pc2_frame(file, vertexCos, verts_tot, interp, frame, err_str);
 
-  fclose(fp);
+  MOD_meshcache_file_close(file);
   return ok;
 }
@@ -6,13 +6,32 @@
  * \ingroup modifiers
  */
 
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+
+#include "BLI_array.hh"
+#include "BLI_endian_switch.h"
+#include "BLI_fileops.h"
 #include "BLI_math_base.h"
+#include "BLI_mmap.h"
+#include "BLI_task.hh"
 #include "BLI_utildefines.h"
 
+#include "BLT_translation.hh"
+
 #include "DNA_modifier_types.h"
 
 #include "MOD_meshcache_util.hh"
 
+#ifdef WIN32
+#  include "BLI_winstuff.h"
+#  include <io.h>
+#else
+#  include <unistd.h>
+#endif
+
 void MOD_meshcache_calc_range(const float frame,
                               const char interp,
                               const int frame_tot,
@@ -49,3 +68,74 @@ void MOD_meshcache_calc_range(const float frame,
     }
   }
 }
+
+BLI_mmap_file *MOD_meshcache_file_open(const char *filepath, const char **err_str)
+{
+  errno = 0;
+  const int file = BLI_open(filepath, O_BINARY | O_RDONLY, 0);
+  if (file == -1) {
+    *err_str = errno ? strerror(errno) : RPT_("Unknown error opening file");
+    return nullptr;
+  }
+
+  BLI_mmap_file *mmap_file = BLI_mmap_open(file);
+  /* The mapping stays valid after the file is closed. */
+  close(file);
+
+  if (mmap_file == nullptr) {
+    *err_str = RPT_("Failed to map file");
+  }
+  return mmap_file;
+}
+
+void MOD_meshcache_file_close(BLI_mmap_file *file)
+{
+  BLI_mmap_free(file);
+}
+
+bool MOD_meshcache_read_coords(BLI_mmap_file *file,
+                               const size_t offset,
+                               float (*vertexCos)[3],
+                               const int verts_tot,
+                               const float factor,
+                               const bool swap_endian,
+                               const char **err_str)
+{
+  using namespace blender;
+  std::atomic<bool> read_failed = false;
+  threading::parallel_for(IndexRange(verts_tot), 4096, [&](const IndexRange range) {
+    const size_t range_offset = offset + sizeof(float[3]) * range.start();
+    const size_t range_len = sizeof(float[3]) * range.size();
+    float *co = vertexCos[range.start()];
+    if (factor >= 1.0f) {
+      if (!BLI_mmap_read(file, co, range_offset, range_len)) {
+        read_failed = true;
+        return;
+      }
+      if (swap_endian) {
+        BLI_endian_switch_float_array(co, range.size() * 3);
+      }
+      return;
+    }
+
+    Array<float> frame_co(range.size() * 3, NoInitialization());
+    if (!BLI_mmap_read(file, frame_co.data(), range_offset, range_len)) {
+      read_failed = true;
+      return;
+    }
+    if (swap_endian) {
+      BLI_endian_switch_float_array(frame_co.data(), frame_co.size());
+    }
+    /* Blend the flat arrays of floats, which the compiler can vectorize. */
+    const float ifactor = 1.0f - factor;
+    for (const int64_t i : frame_co.index_range()) {
+      co[i] = (co[i] * ifactor) + (frame_co[i] * factor);
+    }
+  });
+
+  if (read_failed) {
+    *err_str = RPT_("Vertex coordinate read failed");
+    return false;
+  }
+  return true;
+}
@@ -8,11 +8,17 @@
 
 #pragma once
 
+struct BLI_mmap_file;
+
 /* `MOD_meshcache_mdd.cc` */
 
-bool MOD_meshcache_read_mdd_index(
-    FILE *fp, float (*vertexCos)[3], int verts_tot, int index, float factor, const char **err_str);
-bool MOD_meshcache_read_mdd_frame(FILE *fp,
+bool MOD_meshcache_read_mdd_index(BLI_mmap_file *file,
+                                  float (*vertexCos)[3],
+                                  int verts_tot,
+                                  int index,
+                                  float factor,
+                                  const char **err_str);
+bool MOD_meshcache_read_mdd_frame(BLI_mmap_file *file,
                                   float (*vertexCos)[3],
                                   int verts_tot,
                                   char interp,
@@ -29,9 +35,13 @@ bool MOD_meshcache_read_mdd_times(const char *filepath,
 
 /* `MOD_meshcache_pc2.cc` */
 
-bool MOD_meshcache_read_pc2_index(
-    FILE *fp, float (*vertexCos)[3], int verts_tot, int index, float factor, const char **err_str);
-bool MOD_meshcache_read_pc2_frame(FILE *fp,
+bool MOD_meshcache_read_pc2_index(BLI_mmap_file *file,
+                                  float (*vertexCos)[3],
+                                  int verts_tot,
+                                  int index,
+                                  float factor,
+                                  const char **err_str);
+bool MOD_meshcache_read_pc2_frame(BLI_mmap_file *file,
                                   float (*vertexCos)[3],
                                   int verts_tot,
                                   char interp,
@@ -51,4 +61,22 @@ bool MOD_meshcache_read_pc2_times(const char *filepath,
 void MOD_meshcache_calc_range(
     float frame, char interp, int frame_tot, int r_index_range[2], float *r_factor);
 
+/**
+ * Memory-map a cache file, so that frames can be read without seeking and from multiple threads.
+ */
+BLI_mmap_file *MOD_meshcache_file_open(const char *filepath, const char **err_str);
+void MOD_meshcache_file_close(BLI_mmap_file *file);
+
+/**
+ * Read the coordinates of all vertices of a frame stored at \a offset in the file. When
+ * \a factor is below one, the coordinates are blended with the values in \a vertexCos.
+ */
+bool MOD_meshcache_read_coords(BLI_mmap_file *file,
+                               size_t offset,
+                               float (*vertexCos)[3],
+                               int verts_tot,
+                               float factor,
+                               bool swap_endian,
+                               const char **err_str);
+
 #define FRAME_SNAP_EPS 0.0001f
@@ -926,25 +926,22 @@ static BakeFrameIndices get_bake_frame_indices(
   return frame_indices;
 }
 
-static void ensure_bake_loaded(bake::NodeBakeCache &bake_cache, bake::FrameCache &frame_cache)
+/**
+ * Start loading the baked frames around the evaluated frame in the background, so that playback
+ * does not have to wait for them to be read from disk.
+ */
+static void prefetch_bake_frames(bake::NodeBakeCache &bake_cache,
+                                 const BakeFrameIndices &frame_indices)
 {
-  if (!frame_cache.state.items_by_id.is_empty()) {
-    return;
+  if (frame_indices.current) {
+    bake_cache.prefetch_frames(*frame_indices.current);
   }
-  if (!bake_cache.blobs_dir) {
-    return;
+  else if (frame_indices.prev) {
+    bake_cache.prefetch_frames(*frame_indices.prev);
   }
-  if (!frame_cache.meta_path) {
-    return;
-  }
-  bke::bake::DiskBlobReader blob_reader{*bake_cache.blobs_dir};
-  fstream meta_file{*frame_cache.meta_path};
-  std::optional<bke::bake::BakeState> bake_state = bke::bake::deserialize_bake(
-      meta_file, blob_reader, *bake_cache.blob_sharing);
-  if (!bake_state.has_value()) {
-    return;
+  else if (frame_indices.next) {
+    bake_cache.prefetch_frames(*frame_indices.next);
   }
-  frame_cache.state = std::move(*bake_state);
 }
 
 static bool try_find_baked_data(bake::NodeBakeCache &bake,
@@ -1116,6 +1113,7 @@ class NodesModifierSimulationParams : public nodes::GeoNodesSimulationParams {
     const BakeFrameIndices frame_indices = get_bake_frame_indices(node_cache.bake.frames,
                                                                   current_frame_);
     if (node_cache.cache_status == bake::CacheStatus::Baked) {
+      prefetch_bake_frames(node_cache.bake, frame_indices);
       this->read_from_cache(frame_indices, node_cache, zone_behavior);
       return;
     }
@@ -1220,7 +1218,7 @@ class NodesModifierSimulationParams : public nodes::GeoNodesSimulationParams {
       std::lock_guard lock{simulation_cache->mutex};
       auto frame_cache = std::make_unique<bake::FrameCache>();
       frame_cache->frame = current_frame;
-      frame_cache->state = std::move(state);
+      frame_cache->state = std::make_shared<const bake::BakeState>(std::move(state));
       node_cache->bake.frames.append(std::move(frame_cache));
     };
   }
@@ -1251,7 +1249,7 @@ class NodesModifierSimulationParams : public nodes::GeoNodesSimulationParams {
       const float delta_frames = std::min(max_delta_frames,
                                           float(current_frame_) - float(frame_cache.frame));
       output_copy_info.delta_time = delta_frames / fps_;
-      output_copy_info.state = frame_cache.state;
+      output_copy_info.state = node_cache.bake.ensure_frame_loaded(frame_cache);
     }
     else {
       zone_behavior.input.emplace<sim_input::PassThrough>();
@@ -1281,9 +1279,8 @@ class NodesModifierSimulationParams : public nodes::GeoNodesSimulationParams {
                    nodes::SimulationZoneBehavior &zone_behavior) const
   {
     bake::FrameCache &frame_cache = *node_cache.bake.frames[frame_index];
-    ensure_bake_loaded(node_cache.bake, frame_cache);
     auto &read_single_info = zone_behavior.output.emplace<sim_output::ReadSingle>();
-    read_single_info.state = frame_cache.state;
+    read_single_info.state = node_cache.bake.ensure_frame_loaded(frame_cache);
   }
 
   void read_interpolated(const int prev_frame_index,
@@ -1293,14 +1290,12 @@ class NodesModifierSimulationParams : public nodes::GeoNodesSimulationParams {
   {
     bake::FrameCache &prev_frame_cache = *node_cache.bake.frames[prev_frame_index];
     bake::FrameCache &next_frame_cache = *node_cache.bake.frames[next_frame_index];
-    ensure_bake_loaded(node_cache.bake, prev_frame_cache);
-    ensure_bake_loaded(node_cache.bake, next_frame_cache);
     auto &read_interpolated_info = zone_behavior.output.emplace<sim_output::ReadInterpolated>();
     read_interpolated_info.mix_factor = (float(current_frame_) - float(prev_frame_cache.frame)) /
                                         (float(next_frame_cache.frame) -
                                          float(prev_frame_cache.frame));
-    read_interpolated_info.prev_state = prev_frame_cache.state;
-    read_interpolated_info.next_state = next_frame_cache.state;
+    read_interpolated_info.prev_state = node_cache.bake.ensure_frame_loaded(prev_frame_cache);
+    read_interpolated_info.next_state = node_cache.bake.ensure_frame_loaded(next_frame_cache);
   }
 };
 
@@ -1373,7 +1368,7 @@ class NodesModifierBakeParams : public nodes::GeoNodesBakeParams {
           std::lock_guard lock{modifier_cache->mutex};
           auto frame_cache = std::make_unique<bake::FrameCache>();
           frame_cache->frame = current_frame;
-          frame_cache->state = std::move(state);
+          frame_cache->state = std::make_shared<const bake::BakeState>(std::move(state));
           auto &frames = node_cache->bake.frames;
           const int insert_index = binary_search::find_predicate_begin(
               frames, [&](const std::unique_ptr<bake::FrameCache> &frame_cache) {
@@ -1400,6 +1395,7 @@ class NodesModifierBakeParams : public nodes::GeoNodesBakeParams {
     }
     const BakeFrameIndices frame_indices = get_bake_frame_indices(node_cache.bake.frames,
                                                                   current_frame_);
+    prefetch_bake_frames(node_cache.bake, frame_indices);
     if (frame_indices.current) {
       this->read_single(*frame_indices.current, node_cache, behavior);
       return;
@@ -1424,12 +1420,13 @@ class NodesModifierBakeParams : public nodes::GeoNodesBakeParams {
                    nodes::BakeNodeBehavior &behavior) const
   {
     bake::FrameCache &frame_cache = *node_cache.bake.frames[frame_index];
-    ensure_bake_loaded(node_cache.bake, frame_cache);
-    if (this->check_read_error(frame_cache, behavior)) {
+    std::shared_ptr<const bake::BakeState> state = node_cache.bake.ensure_frame_loaded(
+        frame_cache);
+    if (this->check_read_error(frame_cache, state, behavior)) {
       return;
     }
     auto &read_single_info = behavior.behavior.emplace<sim_output::ReadSingle>();
-    read_single_info.state = frame_cache.state;
+    read_single_info.state = std::move(state);
   }
 
   void read_interpolated(const int prev_frame_index,
@@ -1439,10 +1436,12 @@ class NodesModifierBakeParams : public nodes::GeoNodesBakeParams {
   {
     bake::FrameCache &prev_frame_cache = *node_cache.bake.frames[prev_frame_index];
     bake::FrameCache &next_frame_cache = *node_cache.bake.frames[next_frame_index];
-    ensure_bake_loaded(node_cache.bake, prev_frame_cache);
-    ensure_bake_loaded(node_cache.bake, next_frame_cache);
-    if (this->check_read_error(prev_frame_cache, behavior) ||
-        this->check_read_error(next_frame_cache, behavior))
+    std::shared_ptr<const bake::BakeState> prev_state = node_cache.bake.ensure_frame_loaded(
+        prev_frame_cache);
+    std::shared_ptr<const bake::BakeState> next_state = node_cache.bake.ensure_frame_loaded(
+        next_frame_cache);
+    if (this->check_read_error(prev_frame_cache, prev_state, behavior) ||
+        this->check_read_error(next_frame_cache, next_state, behavior))
     {
       return;
     }
@@ -1450,14 +1449,15 @@ class NodesModifierBakeParams : public nodes::GeoNodesBakeParams {
     read_interpolated_info.mix_factor = (float(current_frame_) - float(prev_frame_cache.frame)) /
                                         (float(next_frame_cache.frame) -
                                          float(prev_frame_cache.frame));
-    read_interpolated_info.prev_state = prev_frame_cache.state;
-    read_interpolated_info.next_state = next_frame_cache.state;
+    read_interpolated_info.prev_state = std::move(prev_state);
+    read_interpolated_info.next_state = std::move(next_state);
   }
 
   [[nodiscard]] bool check_read_error(const bake::FrameCache &frame_cache,
+                                      const std::shared_ptr<const bake::BakeState> &state,
                                       nodes::BakeNodeBehavior &behavior) const
   {
-    if (frame_cache.meta_path && frame_cache.state.items_by_id.is_empty()) {
+    if (frame_cache.meta_path && !state) {
       auto &read_error_info = behavior.behavior.emplace<sim_output::ReadError>();
       read_error_info.message = RPT_("Cannot load the baked data");
       return true;
@@ -631,6 +631,7 @@ static void node_layout_ex(uiLayout *layout, bContext *C, PointerRNA *ptr)
       uiLayoutSetActive(subcol, ctx.bake->flag & NODES_MODIFIER_BAKE_CUSTOM_PATH);
       uiItemR(subcol, &ctx.bake_rna, "directory", UI_ITEM_NONE, "Path", ICON_NONE);
     }
+    uiItemR(settings_col, &ctx.bake_rna, "compression", UI_ITEM_NONE, "Compression", ICON_NONE);
     if (!ctx.bake_still) {
       uiLayout *col = uiLayoutColumn(settings_col, true);
       uiItemR(col,
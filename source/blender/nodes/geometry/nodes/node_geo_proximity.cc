@@ -2,6 +2,9 @@
  *
  * SPDX-License-Identifier: GPL-2.0-or-later */
 
+#include <array>
+
+#include "BLI_kdopbvh.h"
 #include "BLI_math_vector.h"
 #include "BLI_task.hh"
 
@@ -213,8 +216,63 @@ class ProximityFunction : public mf::MultiFunction {
     MutableSpan<bool> is_valid_span = params.uninitialized_single_output_if_required<bool>(
         4, "Is Valid");
 
+    /* Samples are gathered in batches that are queried together, so that nearby samples are
+     * traversed through the tree in packets. All samples of a batch are in the same group. */
+    constexpr int batch_size = BVH_RAYCAST_PACKET_SIZE * 32;
+    std::array<int, batch_size> batch_indices;
+    std::array<float3, batch_size> batch_positions;
+    std::array<BVHTreeNearest, batch_size> batch_nearest;
+    int batch_num = 0;
+    int batch_group_index = -1;
+
+    const auto query_batch = [&]() {
+      if (batch_num == 0) {
+        return;
+      }
+      const BVHTrees &trees = bvh_trees_[batch_group_index];
+      /* Take mesh and pointcloud bvh tree into account. The final result is the closer of the two.
+       * First first bvhtree query will set `nearest.dist_sq` which is then passed into the second
+       * query as a maximum distance. */
+      for (const int i : IndexRange(batch_num)) {
+        batch_nearest[i].index = -1;
+        batch_nearest[i].dist_sq = FLT_MAX;
+      }
+      const float(*co)[3] = reinterpret_cast<const float(*)[3]>(batch_positions.data());
+      if (trees.mesh_bvh.tree != nullptr) {
+        BLI_bvhtree_find_nearest_packet(trees.mesh_bvh.tree,
+                                        co,
+                                        batch_num,
+                                        batch_nearest.data(),
+                                        trees.mesh_bvh.nearest_callback,
+                                        const_cast<BVHTreeFromMesh *>(&trees.mesh_bvh));
+      }
+      if (trees.pointcloud_bvh.tree != nullptr) {
+        BLI_bvhtree_find_nearest_packet(
+            trees.pointcloud_bvh.tree,
+            co,
+            batch_num,
+            batch_nearest.data(),
+            trees.pointcloud_bvh.nearest_callback,
+            const_cast<BVHTreeFromPointCloud *>(&trees.pointcloud_bvh));
+      }
+
+      for (const int batch_i : IndexRange(batch_num)) {
+        const int i = batch_indices[batch_i];
+        const BVHTreeNearest &nearest = batch_nearest[batch_i];
+        if (!positions.is_empty()) {
+          positions[i] = nearest.co;
+        }
+        if (!is_valid_span.is_empty()) {
+          is_valid_span[i] = true;
+        }
+        if (!distances.is_empty()) {
+          distances[i] = std::sqrt(nearest.dist_sq);
+        }
+      }
+      batch_num = 0;
+    };
+
     mask.foreach_index([&](const int i) {
-      const float3 sample_position = sample_positions[i];
       const int sample_id = sample_ids[i];
       const int group_index = group_indices_.index_of_try(sample_id);
       if (group_index == -1) {
@@ -229,37 +287,15 @@ class ProximityFunction : public mf::MultiFunction {
         }
         return;
       }
-      const BVHTrees &trees = bvh_trees_[group_index];
-      BVHTreeNearest nearest;
-      /* Take mesh and pointcloud bvh tree into account. The final result is the closer of the two.
-       * First first bvhtree query will set `nearest.dist_sq` which is then passed into the second
-       * query as a maximum distance. */
-      nearest.dist_sq = FLT_MAX;
-      if (trees.mesh_bvh.tree != nullptr) {
-        BLI_bvhtree_find_nearest(trees.mesh_bvh.tree,
-                                 sample_position,
-                                 &nearest,
-                                 trees.mesh_bvh.nearest_callback,
-                                 const_cast<BVHTreeFromMesh *>(&trees.mesh_bvh));
-      }
-      if (trees.pointcloud_bvh.tree != nullptr) {
-        BLI_bvhtree_find_nearest(trees.pointcloud_bvh.tree,
-                                 sample_position,
-                                 &nearest,
-                                 trees.pointcloud_bvh.nearest_callback,
-                                 const_cast<BVHTreeFromPointCloud *>(&trees.pointcloud_bvh));
-      }
-
-      if (!positions.is_empty()) {
-        positions[i] = nearest.co;
-      }
-      if (!is_valid_span.is_empty()) {
-        is_valid_span[i] = true;
-      }
-      if (!distances.is_empty()) {
-        distances[i] = std::sqrt(nearest.dist_sq);
+      if (batch_num == batch_size || group_index != batch_group_index) {
+        query_batch();
+        batch_group_index = group_index;
       }
+      batch_indices[batch_num] = i;
+      batch_positions[batch_num] = sample_positions[i];
+      batch_num++;
     });
+    query_batch();
   }
 };
 
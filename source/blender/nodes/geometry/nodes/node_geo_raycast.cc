@@ -2,6 +2,8 @@
  *
  * SPDX-License-Identifier: GPL-2.0-or-later */
 
+#include <array>
+
 #include "DNA_mesh_types.h"
 
 #include "BKE_attribute_math.hh"
@@ -109,57 +111,82 @@ static void raycast_to_mesh(const IndexMask &mask,
   /* We shouldn't be rebuilding the BVH tree when calling this function in parallel. */
   BLI_assert(tree_data.cached);
 
-  mask.foreach_index([&](const int i) {
-    const float ray_length = ray_lengths[i];
-    const float3 ray_origin = ray_origins[i];
-    const float3 ray_direction = ray_directions[i];
-
-    BVHTreeRayHit hit;
-    hit.index = -1;
-    hit.dist = ray_length;
-    if (BLI_bvhtree_ray_cast(tree_data.tree,
-                             ray_origin,
-                             ray_direction,
-                             0.0f,
-                             &hit,
-                             tree_data.raycast_callback,
-                             &tree_data) != -1)
-    {
-      if (!r_hit.is_empty()) {
-        r_hit[i] = hit.index >= 0;
-      }
-      if (!r_hit_indices.is_empty()) {
-        /* The caller must be able to handle invalid indices anyway, so don't clamp this value. */
-        r_hit_indices[i] = hit.index;
-      }
-      if (!r_hit_positions.is_empty()) {
-        r_hit_positions[i] = hit.co;
+  /* Cast the rays in packets, which are traversed through the tree together. Neighboring
+   * rays usually have similar origins and directions, so most nodes are shared in a packet. */
+  constexpr int packet_size = BVH_RAYCAST_PACKET_SIZE;
+  std::array<int, packet_size> packet_indices;
+  std::array<float3, packet_size> packet_origins;
+  std::array<float3, packet_size> packet_directions;
+  std::array<BVHTreeRayHit, packet_size> packet_hits;
+  int packet_num = 0;
+
+  auto cast_packet = [&]() {
+    BLI_bvhtree_ray_cast_packet(tree_data.tree,
+                                reinterpret_cast<const float(*)[3]>(packet_origins.data()),
+                                reinterpret_cast<const float(*)[3]>(packet_directions.data()),
+                                packet_num,
+                                0.0f,
+                                packet_hits.data(),
+                                tree_data.raycast_callback,
+                                &tree_data,
+                                BVH_RAYCAST_DEFAULT);
+
+    for (const int packet_i : IndexRange(packet_num)) {
+      const int i = packet_indices[packet_i];
+      const BVHTreeRayHit &hit = packet_hits[packet_i];
+      if (hit.index != -1) {
+        if (!r_hit.is_empty()) {
+          r_hit[i] = hit.index >= 0;
+        }
+        if (!r_hit_indices.is_empty()) {
+          /* The caller must handle invalid indices anyway, so don't clamp this value. */
+          r_hit_indices[i] = hit.index;
+        }
+        if (!r_hit_positions.is_empty()) {
+          r_hit_positions[i] = hit.co;
+        }
+        if (!r_hit_normals.is_empty()) {
+          r_hit_normals[i] = hit.no;
+        }
+        if (!r_hit_distances.is_empty()) {
+          r_hit_distances[i] = hit.dist;
+        }
       }
-      if (!r_hit_normals.is_empty()) {
-        r_hit_normals[i] = hit.no;
-      }
-      if (!r_hit_distances.is_empty()) {
-        r_hit_distances[i] = hit.dist;
+      else {
+        if (!r_hit.is_empty()) {
+          r_hit[i] = false;
+        }
+        if (!r_hit_indices.is_empty()) {
+          r_hit_indices[i] = -1;
+        }
+        if (!r_hit_positions.is_empty()) {
+          r_hit_positions[i] = float3(0.0f, 0.0f, 0.0f);
+        }
+        if (!r_hit_normals.is_empty()) {
+          r_hit_normals[i] = float3(0.0f, 0.0f, 0.0f);
+        }
+        if (!r_hit_distances.is_empty()) {
+          r_hit_distances[i] = ray_lengths[i];
+        }
       }
     }
-    else {
-      if (!r_hit.is_empty()) {
-        r_hit[i] = false;
-      }
-      if (!r_hit_indices.is_empty()) {
-        r_hit_indices[i] = -1;
-      }
-      if (!r_hit_positions.is_empty()) {
-        r_hit_positions[i] = float3(0.0f, 0.0f, 0.0f);
-      }
-      if (!r_hit_normals.is_empty()) {
-        r_hit_normals[i] = float3(0.0f, 0.0f, 0.0f);
-      }
-      if (!r_hit_distances.is_empty()) {
-        r_hit_distances[i] = ray_length;
-      }
+    packet_num = 0;
+  };
+
+  mask.foreach_index([&](const int i) {
+    packet_indices[packet_num] = i;
+    packet_origins[packet_num] = ray_origins[i];
+    packet_directions[packet_num] = ray_directions[i];
+    packet_hits[packet_num].index = -1;
+    packet_hits[packet_num].dist = ray_lengths[i];
+    packet_num++;
+    if (packet_num == packet_size) {
+      cast_packet();
     }
   });
+  if (packet_num > 0) {
+    cast_packet();
+  }
 }
 
 class RaycastFunction : public mf::MultiFunction {
@@ -579,6 +579,49 @@ static PyObject *bpy_app_help_text(PyObject * /*self*/, PyObject *args, PyObject
   return result;
 }
 
+PyDoc_STRVAR(
+    /* Wrap. */
+    bpy_app_memory_snapshot_doc,
+    ".. staticmethod:: memory_snapshot(filepath=None)\n"
+    "\n"
+    "   Write the estimated memory used per allocation name, as a tab separated table.\n"
+    "   Requires allocation sampling to be enabled with ``--debug-memory-sampling``.\n"
+    "\n"
+    "   :arg filepath: File path, print to the standard output when None.\n"
+    "   :type filepath: str | bytes | None\n");
+static PyObject *bpy_app_memory_snapshot(PyObject * /*self*/, PyObject *args, PyObject *kwds)
+{
+  PyC_UnicodeAsBytesAndSize_Data filepath_data = {nullptr};
+  static const char *_keywords[] = {"filepath", nullptr};
+  static _PyArg_Parser _parser = {
+      PY_ARG_PARSER_HEAD_COMPAT()
+      "|"  /* Optional arguments. */
+      "O&" /* `filepath` */
+      ":memory_snapshot",
+      _keywords,
+      nullptr,
+  };
+  if (!_PyArg_ParseTupleAndKeywordsFast(
+          args, kwds, &_parser, PyC_ParseUnicodeAsBytesAndSize_OrNone, &filepath_data))
+  {
+    return nullptr;
+  }
+
+  if (!MEM_allocation_sampling_is_enabled()) {
+    Py_XDECREF(filepath_data.value_coerce);
+    PyErr_SetString(PyExc_RuntimeError,
+                    "Allocation sampling is not enabled, use '--debug-memory-sampling'");
+    return nullptr;
+  }
+  const bool success = MEM_allocation_sampling_write(filepath_data.value);
+  Py_XDECREF(filepath_data.value_coerce);
+  if (!success) {
+    PyErr_SetString(PyExc_OSError, "Unable to write the memory snapshot");
+    return nullptr;
+  }
+  Py_RETURN_NONE;
+}
+
 #if (defined(__GNUC__) && !defined(__clang__))
 #  pragma GCC diagnostic push
 #  pragma GCC diagnostic ignored "-Wcast-function-type"
@@ -593,6 +636,10 @@ static PyMethodDef bpy_app_methods[] = {
      (PyCFunction)bpy_app_help_text,
      METH_VARARGS | METH_KEYWORDS | METH_STATIC,
      bpy_app_help_text_doc},
+    {"memory_snapshot",
+     (PyCFunction)bpy_app_memory_snapshot,
+     METH_VARARGS | METH_KEYWORDS | METH_STATIC,
+     bpy_app_memory_snapshot_doc},
     {nullptr, nullptr, 0, nullptr},
 };
 
@@ -2078,6 +2078,20 @@ static bool wm_file_write(bContext *C,
 /** \name Auto-Save API
  * \{ */
 
+/**
+ * Data of the previous auto-save, used to only write the data that changed since then
+ * (see the "Incremental Auto Save" experimental option).
+ */
+static BlendFileIncrementalStore *wm_autosave_incremental_store = nullptr;
+
+static void wm_autosave_incremental_store_free()
+{
+  if (wm_autosave_incremental_store) {
+    BLO_write_incremental_store_free(wm_autosave_incremental_store);
+    wm_autosave_incremental_store = nullptr;
+  }
+}
+
 static void wm_autosave_location(char filepath[FILE_MAX])
 {
   const int pid = abs(getpid());
@@ -2138,8 +2152,20 @@ void WM_autosave_write(wmWindowManager *wm, Main *bmain)
   const int fileflags = (G.fileflags & ~G_FILE_COMPRESS) | G_FILE_RECOVER_WRITE;
 
   /* Error reporting into console. */
-  BlendFileWriteParams params{};
-  BLO_write_file(bmain, filepath, fileflags, &params, nullptr);
+  if (USER_EXPERIMENTAL_TEST(&U, use_incremental_autosave)) {
+    if (wm_autosave_incremental_store == nullptr) {
+      wm_autosave_incremental_store = BLO_write_incremental_store_new();
+    }
+    BLO_write_file_incremental(
+        bmain, filepath, fileflags, wm_autosave_incremental_store, nullptr);
+  }
+  else {
+    /* Release the memory used by incremental auto-save when it gets disabled. */
+    wm_autosave_incremental_store_free();
+
+    BlendFileWriteParams params{};
+    BLO_write_file(bmain, filepath, fileflags, &params, nullptr);
+  }
 
   /* Restart auto-save timer. */
   wm_autosave_timer_end(wm);
@@ -2203,6 +2229,8 @@ void wm_autosave_timer(Main *bmain, wmWindowManager *wm, wmTimer * /*wt*/)
 
 void wm_autosave_delete()
 {
+  wm_autosave_incremental_store_free();
+
   char filepath[FILE_MAX];
 
   wm_autosave_location(filepath);
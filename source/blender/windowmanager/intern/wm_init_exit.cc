@@ -48,6 +48,7 @@
 #include "BKE_screen.hh"
 #include "BKE_sound.h"
 #include "BKE_vfont.hh"
+#include "BKE_volume.hh"
 
 #include "BKE_addon.h"
 #include "BKE_appdir.hh"
@@ -590,6 +591,7 @@ void WM_exit_ex(bContext *C, const bool do_python_exit, const bool do_user_exit_
 #endif
 
   bke::subdiv::exit();
+  BKE_volumes_exit();
 
   if (gpu_is_init) {
     BKE_image_free_unused_gpu_textures();
@@ -35,6 +35,7 @@
 #  endif
 
 #  include "BKE_appdir.hh"
+#  include "BKE_blender.hh"
 #  include "BKE_blender_cli_command.hh"
 #  include "BKE_blender_version.h"
 #  include "BKE_blendfile.hh"
@@ -47,6 +48,7 @@
 #  include "BKE_report.hh"
 #  include "BKE_scene.hh"
 #  include "BKE_sound.h"
+#  include "BKE_volume.hh"
 
 #  include "GPU_context.hh"
 
@@ -653,6 +655,7 @@ static void print_help(bArgs *ba, bool all)
   BLI_args_print_arg_doc(ba, "--render-output");
   BLI_args_print_arg_doc(ba, "--engine");
   BLI_args_print_arg_doc(ba, "--threads");
+  BLI_args_print_arg_doc(ba, "--volume-cache-limit");
 
   if (defs.with_cycles) {
     PRINT("Cycles Render Options:\n");
@@ -731,6 +734,8 @@ static void print_help(bArgs *ba, bool all)
     BLI_args_print_arg_doc(ba, "--debug-cycles");
   }
   BLI_args_print_arg_doc(ba, "--debug-memory");
+  BLI_args_print_arg_doc(ba, "--debug-memory-sampling");
+  BLI_args_print_arg_doc(ba, "--debug-memory-snapshot");
   BLI_args_print_arg_doc(ba, "--debug-jobs");
   BLI_args_print_arg_doc(ba, "--debug-python");
   BLI_args_print_arg_doc(ba, "--debug-depsgraph");
@@ -1331,6 +1336,65 @@ static int arg_handle_debug_mode_memory_set(int /*argc*/, const char ** /*argv*/
   return 0;
 }
 
+/** Sampling interval used when a snapshot is requested without setting an interval. */
+#  define MEMORY_SAMPLING_INTERVAL_DEFAULT (512 * 1024)
+
+static const char arg_handle_debug_mode_memory_sampling_set_doc[] =
+    "<kilobytes>\n"
+    "\tSample allocations to estimate the memory used per allocation name,\n"
+    "\ttaking one sample every <kilobytes> allocated on average.\n"
+    "\tUse '--debug-memory-snapshot' or 'bpy.app.memory_snapshot' to write the result.";
+static int arg_handle_debug_mode_memory_sampling_set(int argc,
+                                                     const char **argv,
+                                                     void * /*data*/)
+{
+  const char *arg_id = "--debug-memory-sampling";
+  if (argc > 1) {
+    const char *err_msg = nullptr;
+    int kilobytes;
+    if (!parse_int_strict_range(argv[1], nullptr, 1, INT_MAX, &kilobytes, &err_msg)) {
+      fprintf(stderr, "\nError: %s '%s %s'.\n", err_msg, arg_id, argv[1]);
+      return 1;
+    }
+
+    MEM_allocation_sampling_set(size_t(kilobytes) * 1024);
+    return 1;
+  }
+  fprintf(stderr, "\nError: you must specify a number of kilobytes '%s'.\n", arg_id);
+  return 0;
+}
+
+static void memory_snapshot_write_atexit(void *user_data)
+{
+  char *filepath = static_cast<char *>(user_data);
+  if (!MEM_allocation_sampling_write(filepath)) {
+    fprintf(stderr, "Unable to write memory snapshot to '%s'\n", filepath);
+  }
+  MEM_freeN(filepath);
+}
+
+static const char arg_handle_debug_mode_memory_snapshot_set_doc[] =
+    "<filepath>\n"
+    "\tWrite the memory used per allocation name to <filepath> on exit,\n"
+    "\tenabling allocation sampling when '--debug-memory-sampling' is not used.\n"
+    "\tThe live memory at exit is mostly freed already, the peak per name is kept.";
+static int arg_handle_debug_mode_memory_snapshot_set(int argc,
+                                                     const char **argv,
+                                                     void * /*data*/)
+{
+  const char *arg_id = "--debug-memory-snapshot";
+  if (argc > 1) {
+    if (!MEM_allocation_sampling_is_enabled()) {
+      MEM_allocation_sampling_set(MEMORY_SAMPLING_INTERVAL_DEFAULT);
+    }
+    /* The arguments may be freed before the exit callbacks run. */
+    BKE_blender_atexit_register(memory_snapshot_write_atexit, BLI_strdup(argv[1]));
+    return 1;
+  }
+  fprintf(stderr, "\nError: you must specify a filepath '%s'.\n", arg_id);
+  return 0;
+}
+
 static const char arg_handle_debug_value_set_doc[] =
     "<value>\n"
     "\tSet debug value of <value> on startup.";
@@ -1908,6 +1972,28 @@ static int arg_handle_threads_set(int argc, const char **argv, void * /*data*/)
   return 0;
 }
 
+static const char arg_handle_volume_cache_limit_set_doc[] =
+    "<megabytes>\n"
+    "\tLimit the memory used by volume grids loaded from OpenVDB files,\n"
+    "\t0 to disable the limit (defaults to half of the system memory).";
+static int arg_handle_volume_cache_limit_set(int argc, const char **argv, void * /*data*/)
+{
+  const char *arg_id = "--volume-cache-limit";
+  if (argc > 1) {
+    const char *err_msg = nullptr;
+    int megabytes;
+    if (!parse_int_strict_range(argv[1], nullptr, 0, INT_MAX, &megabytes, &err_msg)) {
+      fprintf(stderr, "\nError: %s '%s %s'.\n", err_msg, arg_id, argv[1]);
+      return 1;
+    }
+
+    BKE_volumes_file_cache_memory_budget_set(int64_t(megabytes) * 1024 * 1024);
+    return 1;
+  }
+  fprintf(stderr, "\nError: you must specify a number of megabytes '%s'.\n", arg_id);
+  return 0;
+}
+
 static const char arg_handle_verbosity_set_doc[] =
     "<verbose>\n"
     "\tSet the logging verbosity level for debug messages that support it.";
@@ -2509,6 +2595,8 @@ void main_args_setup(bContext *C, bArgs *ba, bool all)
       ba, nullptr, "--env-system-python", CB_EX(arg_handle_env_system_set, python), nullptr);
 
   BLI_args_add(ba, "-t", "--threads", CB(arg_handle_threads_set), nullptr);
+  BLI_args_add(
+      ba, nullptr, "--volume-cache-limit", CB(arg_handle_volume_cache_limit_set), nullptr);
 
   /* Include in the environment pass so it's possible display errors initializing subsystems,
    * especially `bpy.appdir` since it's useful to show errors finding paths on startup. */
@@ -2617,6 +2705,16 @@ void main_args_setup(bContext *C, bArgs *ba, bool all)
     BLI_args_add(ba, nullptr, "--debug-cycles", CB(arg_handle_debug_mode_cycles), nullptr);
   }
   BLI_args_add(ba, nullptr, "--debug-memory", CB(arg_handle_debug_mode_memory_set), nullptr);
+  BLI_args_add(ba,
+               nullptr,
+               "--debug-memory-sampling",
+               CB(arg_handle_debug_mode_memory_sampling_set),
+               nullptr);
+  BLI_args_add(ba,
+               nullptr,
+               "--debug-memory-snapshot",
+               CB(arg_handle_debug_mode_memory_snapshot_set),
+               nullptr);
 
   BLI_args_add(ba, nullptr, "--debug-value", CB(arg_handle_debug_value_set), nullptr);
   BLI_args_add(ba,
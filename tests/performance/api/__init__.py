@@ -5,5 +5,5 @@
 from .environment import TestEnvironment
 from .device import TestDevice, TestMachine
 from .config import TestEntry, TestQueue, TestConfig
-from .test import Test, TestCollection
+from .test import Test, TestCollection, thread_counts
 from .graph import TestGraph
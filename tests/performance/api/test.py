@@ -4,6 +4,7 @@
 
 import abc
 import fnmatch
+import multiprocessing
 from typing import Dict, List
 
 
@@ -39,6 +40,21 @@ class Test:
         """
 
 
+def thread_counts() -> List[int]:
+    """
+    Powers of two up to the number of available cores, for tests that show
+    how performance scales with the number of threads.
+    """
+    num_cores = multiprocessing.cpu_count()
+    counts = []
+    num_threads = 1
+    while num_threads < num_cores:
+        counts.append(num_threads)
+        num_threads *= 2
+    counts.append(num_cores)
+    return counts
+
+
 class TestCollection:
     def __init__(self, env, names_filter: List = ['*'], categories_filter: List = ['*'], background: bool = False):
         import importlib
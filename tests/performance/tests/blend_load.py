@@ -23,20 +23,33 @@ def _run(filepath):
 
 
 class BlendLoadTest(api.Test):
-    def __init__(self, filepath):
+    def __init__(self, filepath, num_threads=0):
         self.filepath = filepath
+        self.num_threads = num_threads
 
     def name(self):
+        if self.num_threads:
+            return f"{self.filepath.stem}_threads_{self.num_threads}"
         return self.filepath.stem
 
     def category(self):
         return "blend_load"
 
     def run(self, env, device_id):
-        result, _ = env.run_in_blender(_run, str(self.filepath))
+        blender_args = ['--threads', str(self.num_threads)] if self.num_threads else []
+        result, _ = env.run_in_blender(_run, str(self.filepath), blender_args)
         return result
 
 
+def _is_zstd_compressed(filepath):
+    with open(filepath, 'rb') as f:
+        return f.read(4) == b'\x28\xb5\x2f\xfd'
+
+
 def generate(env):
     filepaths = env.find_blend_files('*/*')
-    return [BlendLoadTest(filepath) for filepath in filepaths]
+    tests = [BlendLoadTest(filepath) for filepath in filepaths]
+    for filepath in filepaths:
+        if _is_zstd_compressed(filepath):
+            tests += [BlendLoadTest(filepath, num_threads) for num_threads in api.thread_counts()]
+    return tests
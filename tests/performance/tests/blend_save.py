@@ -0,0 +1,63 @@
+# SPDX-FileCopyrightText: 2024 Blender Authors
+#
+# SPDX-License-Identifier: Apache-2.0
+
+import api
+
+
+def _run(args):
+    import bpy
+    import os
+    import tempfile
+    import time
+
+    bpy.ops.wm.open_mainfile(filepath=args['filepath'])
+
+    with tempfile.TemporaryDirectory() as tempdir:
+        filepath = os.path.join(tempdir, "save.blend")
+
+        # Save once to warm up caches and allocations.
+        bpy.ops.wm.save_as_mainfile(filepath=filepath, copy=True, compress=args['compress'])
+
+        # Measure saving the second time.
+        start_time = time.time()
+        bpy.ops.wm.save_as_mainfile(filepath=filepath, copy=True, compress=args['compress'])
+        elapsed_time = time.time() - start_time
+
+    result = {'time': elapsed_time}
+    return result
+
+
+class BlendSaveTest(api.Test):
+    def __init__(self, filepath, compress=False, num_threads=0):
+        self.filepath = filepath
+        self.compress = compress
+        self.num_threads = num_threads
+
+    def name(self):
+        name = self.filepath.stem
+        if self.compress:
+            name += "_compressed"
+        if self.num_threads:
+            name += f"_threads_{self.num_threads}"
+        return name
+
+    def category(self):
+        return "blend_save"
+
+    def run(self, env, device_id):
+        args = {'filepath': str(self.filepath), 'compress': self.compress}
+        blender_args = ['--threads', str(self.num_threads)] if self.num_threads else []
+        result, _ = env.run_in_blender(_run, args, blender_args)
+        return result
+
+
+def generate(env):
+    filepaths = env.find_blend_files('*/*')
+    tests = []
+    for filepath in filepaths:
+        for compress in (False, True):
+            tests.append(BlendSaveTest(filepath, compress))
+            tests += [BlendSaveTest(filepath, compress, num_threads)
+                      for num_threads in api.thread_counts()]
+    return tests
@@ -0,0 +1,103 @@
+# SPDX-FileCopyrightText: 2024 Blender Authors
+#
+# SPDX-License-Identifier: Apache-2.0
+
+import api
+
+
+def _run(args):
+    import bpy
+    import time
+
+    num_rigs = args['num_rigs']
+    num_bones = args['num_bones']
+
+    # Start from an empty scene.
+    bpy.ops.wm.read_factory_settings(use_empty=True)
+    scene = bpy.context.scene
+    scene.frame_start = 1
+    scene.frame_end = 10
+
+    for rig_index in range(num_rigs):
+        # Armature with a chain of animated bones.
+        armature = bpy.data.armatures.new("Rig")
+        rig = bpy.data.objects.new("Rig", armature)
+        rig.location.x = rig_index * 3.0
+        scene.collection.objects.link(rig)
+        bpy.context.view_layer.objects.active = rig
+        bpy.ops.object.mode_set(mode='EDIT')
+        parent = None
+        for bone_index in range(num_bones):
+            bone = armature.edit_bones.new("Bone{:d}".format(bone_index))
+            bone.head = (0.0, 0.0, bone_index * 0.1)
+            bone.tail = (0.0, 0.0, (bone_index + 1) * 0.1)
+            bone.parent = parent
+            bone.use_connect = parent is not None
+            parent = bone
+        bpy.ops.object.mode_set(mode='OBJECT')
+
+        for pose_bone in rig.pose.bones:
+            pose_bone.rotation_mode = 'XYZ'
+            for frame in (scene.frame_start, scene.frame_end):
+                pose_bone.rotation_euler.x = 0.0 if frame == scene.frame_start else 0.1
+                pose_bone.keyframe_insert("rotation_euler", frame=frame)
+
+        # Mesh deformed by the rig. The first one is much more expensive to evaluate than the
+        # others, so it should be started as early as possible.
+        mesh = bpy.data.meshes.new("Body")
+        body = bpy.data.objects.new("Body", mesh)
+        body.parent = rig
+        scene.collection.objects.link(body)
+        bpy.context.view_layer.objects.active = body
+        bpy.ops.object.mode_set(mode='EDIT')
+        bpy.ops.mesh.primitive_cylinder_add(
+            depth=num_bones * 0.1,
+            location=(0.0, 0.0, num_bones * 0.05),
+        )
+        bpy.ops.object.mode_set(mode='OBJECT')
+        modifier = body.modifiers.new("Armature", 'ARMATURE')
+        modifier.object = rig
+        modifier.use_bone_envelopes = True
+        modifier.use_vertex_groups = False
+        modifier = body.modifiers.new("Subdivision", 'SUBSURF')
+        modifier.levels = 5 if rig_index == 0 else 2
+
+    start_time = time.time()
+    elapsed_time = 0.0
+    num_frames = 0
+
+    while elapsed_time < 10.0:
+        for i in range(scene.frame_start, scene.frame_end + 1):
+            scene.frame_set(i)
+
+        num_frames += scene.frame_end + 1 - scene.frame_start
+        elapsed_time = time.time() - start_time
+
+    time_per_frame = elapsed_time / num_frames
+
+    result = {'time': time_per_frame}
+    return result
+
+
+class DepsgraphTest(api.Test):
+    def __init__(self, num_rigs, num_bones):
+        self.num_rigs = num_rigs
+        self.num_bones = num_bones
+
+    def name(self):
+        return "multi_rig_{:d}x{:d}".format(self.num_rigs, self.num_bones)
+
+    def category(self):
+        return "depsgraph"
+
+    def run(self, env, device_id):
+        args = {
+            'num_rigs': self.num_rigs,
+            'num_bones': self.num_bones,
+        }
+        result, _ = env.run_in_blender(_run, args)
+        return result
+
+
+def generate(env):
+    return [DepsgraphTest(32, 32), DepsgraphTest(128, 16)]
@@ -0,0 +1,62 @@
+# SPDX-FileCopyrightText: 2024 Blender Authors
+#
+# SPDX-License-Identifier: Apache-2.0
+
+import api
+
+
+def _run(args):
+    import bpy
+    import os
+    import tempfile
+    import time
+
+    # Export the scene of the benchmark file, to get an OBJ file of realistic size.
+    bpy.ops.wm.open_mainfile(filepath=args['filepath'])
+
+    with tempfile.TemporaryDirectory() as tempdir:
+        filepath = os.path.join(tempdir, "import.obj")
+        bpy.ops.wm.obj_export(filepath=filepath, export_materials=False)
+
+        # Import once to ensure the file is cached by OS.
+        bpy.ops.wm.read_homefile(use_empty=True, use_factory_startup=True)
+        bpy.ops.wm.obj_import(filepath=filepath)
+        bpy.ops.wm.read_homefile(use_empty=True, use_factory_startup=True)
+
+        # Measure importing the second time.
+        start_time = time.time()
+        bpy.ops.wm.obj_import(filepath=filepath)
+        elapsed_time = time.time() - start_time
+
+    result = {'time': elapsed_time}
+    return result
+
+
+class OBJImportTest(api.Test):
+    def __init__(self, filepath, num_threads=0):
+        self.filepath = filepath
+        self.num_threads = num_threads
+
+    def name(self):
+        name = self.filepath.stem
+        if self.num_threads:
+            name += f"_threads_{self.num_threads}"
+        return name
+
+    def category(self):
+        return "obj_import"
+
+    def run(self, env, device_id):
+        args = {'filepath': str(self.filepath)}
+        blender_args = ['--threads', str(self.num_threads)] if self.num_threads else []
+        result, _ = env.run_in_blender(_run, args, blender_args)
+        return result
+
+
+def generate(env):
+    filepaths = env.find_blend_files('*/*')
+    tests = []
+    for filepath in filepaths:
+        tests.append(OBJImportTest(filepath))
+        tests += [OBJImportTest(filepath, num_threads) for num_threads in api.thread_counts()]
+    return tests
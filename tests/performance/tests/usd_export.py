@@ -0,0 +1,56 @@
+# SPDX-FileCopyrightText: 2024 Blender Authors
+#
+# SPDX-License-Identifier: Apache-2.0
+
+import api
+
+
+def _run(args):
+    import bpy
+    import os
+    import tempfile
+    import time
+
+    bpy.ops.wm.open_mainfile(filepath=args['filepath'])
+    scene = bpy.context.scene
+    scene.frame_end = scene.frame_start + args['num_frames'] - 1
+
+    with tempfile.TemporaryDirectory() as tempdir:
+        filepath = os.path.join(tempdir, "export.usd")
+        start_time = time.time()
+        bpy.ops.wm.usd_export(
+            filepath=filepath,
+            export_animation=True,
+            export_materials=False,
+            export_normals=True,
+            export_uvmaps=True,
+        )
+        elapsed_time = time.time() - start_time
+
+    result = {'time': elapsed_time / args['num_frames']}
+    return result
+
+
+class USDExportTest(api.Test):
+    def __init__(self, filepath, num_frames):
+        self.filepath = filepath
+        self.num_frames = num_frames
+
+    def name(self):
+        return self.filepath.stem
+
+    def category(self):
+        return "usd_export"
+
+    def run(self, env, device_id):
+        args = {
+            'filepath': str(self.filepath),
+            'num_frames': self.num_frames,
+        }
+        result, _ = env.run_in_blender(_run, args)
+        return result
+
+
+def generate(env):
+    filepaths = env.find_blend_files('*/*')
+    return [USDExportTest(filepath, 50) for filepath in filepaths]